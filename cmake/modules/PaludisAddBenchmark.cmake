@@ -0,0 +1,30 @@
+
+include(CMakeParseArguments)
+
+# Benchmarks are standalone programs which report timings on stdout. They are
+# deliberately not registered with ctest, since their results depend upon the
+# machine (and often the input) they are run with.
+function(paludis_add_benchmark benchmark_name)
+  set(multiple_value_args LINK_LIBRARIES)
+
+  cmake_parse_arguments(PAB "" "" "${multiple_value_args}" ${ARGN})
+
+  if(NOT ENABLE_BENCHMARKS)
+    return()
+  endif()
+
+  string(REGEX MATCH "_BENCHMARK" has_BENCHMARK ${benchmark_name})
+  if(NOT has_BENCHMARK)
+    set(benchmark_name ${benchmark_name}_BENCHMARK)
+  endif()
+
+  add_executable(${benchmark_name}
+                   "${CMAKE_CURRENT_SOURCE_DIR}/${benchmark_name}.cc")
+  target_link_libraries(${benchmark_name}
+                        PRIVATE
+                          libpaludis
+                          libpaludisutil
+                          Threads::Threads
+                          ${PAB_LINK_LIBRARIES})
+endfunction()
+
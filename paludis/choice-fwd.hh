@@ -46,6 +46,7 @@ namespace paludis
 
     template <> struct WrappedValueTraits<ChoicePrefixNameTag>;
     template <> struct WrappedValueTraits<ChoiceNameWithPrefixTag>;
+    template <> struct WrappedValueInterned<ChoiceNameWithPrefixTag>;
     template <> struct WrappedValueTraits<UnprefixedChoiceNameTag>;
 
     /**
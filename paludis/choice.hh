@@ -135,6 +135,12 @@ namespace paludis
         static bool validate(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    template <>
+    struct WrappedValueInterned<ChoiceNameWithPrefixTag> :
+        std::true_type
+    {
+    };
+
     extern template class PALUDIS_VISIBLE WrappedValue<ChoiceNameWithPrefixTag>;
 
     /**
@@ -514,6 +514,16 @@ namespace paludis
                     const std::shared_ptr<OutputManager> & optional_output_manager) const
                 PALUDIS_ATTRIBUTE((warn_unused_result)) = 0;
 
+            /**
+             * Might performing a hook with this name do anything? If not,
+             * callers may skip building the Hook, which is worth doing for
+             * hooks which are run once per file.
+             *
+             * \since 3.0
+             */
+            virtual bool want_hook(const std::string & name) const
+                PALUDIS_ATTRIBUTE((warn_unused_result)) = 0;
+
             ///\}
 
             ///\name Distribution information
@@ -184,6 +184,12 @@ EnvironmentImplementation::distribution() const
     return result;
 }
 
+bool
+EnvironmentImplementation::want_hook(const std::string &) const
+{
+    return true;
+}
+
 bool
 EnvironmentImplementation::is_paludis_package(const QualifiedPackageName & n) const
 {
@@ -81,6 +81,9 @@ namespace paludis
             virtual std::string distribution() const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            virtual bool want_hook(const std::string &) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             virtual bool is_paludis_package(const QualifiedPackageName &) const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
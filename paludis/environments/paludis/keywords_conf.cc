@@ -24,6 +24,7 @@
 #include <paludis/spec_tree.hh>
 #include <paludis/user_dep_spec.hh>
 #include <paludis/match_package.hh>
+#include <paludis/package_dep_spec_index.hh>
 #include <paludis/util/config_file.hh>
 #include <paludis/util/options.hh>
 #include <paludis/package_id.hh>
@@ -37,7 +38,6 @@
 #include <paludis/util/set.hh>
 #include <paludis/util/hashes.hh>
 #include <list>
-#include <map>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -46,11 +46,9 @@ using namespace paludis;
 using namespace paludis::paludis_environment;
 
 typedef std::list<KeywordName> KeywordsList;
-typedef std::map<std::shared_ptr<const PackageDepSpec>, KeywordsList> PDSToKeywordsList;
+typedef std::vector<std::pair<std::shared_ptr<const PackageDepSpec>, KeywordsList> > PDSToKeywordsList;
 typedef std::pair<std::shared_ptr<const SetSpecTree>, KeywordsList> SetNameEntry;
 
-typedef std::unordered_map<QualifiedPackageName, PDSToKeywordsList, Hash<QualifiedPackageName> > SpecificMap;
-typedef PDSToKeywordsList UnspecificMap;
 typedef std::unordered_map<SetName, SetNameEntry, Hash<SetName> > NamedSetMap;
 
 namespace paludis
@@ -60,8 +58,10 @@ namespace paludis
     {
         const PaludisEnvironment * const env;
 
-        SpecificMap qualified;
-        UnspecificMap unqualified;
+        PackageDepSpecIndex qualified_index;
+        PDSToKeywordsList qualified;
+        PackageDepSpecIndex unqualified_index;
+        PDSToKeywordsList unqualified;
         mutable NamedSetMap set;
         mutable std::mutex set_mutex;
 
@@ -101,20 +101,14 @@ KeywordsConf::add(const FSPath & filename)
         {
             std::shared_ptr<PackageDepSpec> d(std::make_shared<PackageDepSpec>(parse_user_package_dep_spec(
                             tokens.at(0), _imp->env, { updso_allow_wildcards, updso_no_disambiguation, updso_throw_if_set })));
-            if (d->package_ptr())
-            {
-                KeywordsList & k(_imp->qualified[*d->package_ptr()][d]);
-                for (std::vector<std::string>::const_iterator t(next(tokens.begin())), t_end(tokens.end()) ;
-                        t != t_end ; ++t)
-                    k.push_back(KeywordName(*t));
-            }
-            else
-            {
-                KeywordsList & k(_imp->unqualified[d]);
-                for (std::vector<std::string>::const_iterator t(next(tokens.begin())), t_end(tokens.end()) ;
-                        t != t_end ; ++t)
-                    k.push_back(KeywordName(*t));
-            }
+            PDSToKeywordsList & list(d->package_ptr() ? _imp->qualified : _imp->unqualified);
+            PackageDepSpecIndex & index(d->package_ptr() ? _imp->qualified_index : _imp->unqualified_index);
+
+            index.insert(*d);
+            KeywordsList & k(list.insert(list.end(), std::make_pair(d, KeywordsList()))->second);
+            for (std::vector<std::string>::const_iterator t(next(tokens.begin())), t_end(tokens.end()) ;
+                    t != t_end ; ++t)
+                k.push_back(KeywordName(*t));
         }
         catch (const GotASetNotAPackageDepSpec &)
         {
@@ -139,27 +133,22 @@ KeywordsConf::query(const std::shared_ptr<const KeywordNameSet> & k, const std::
 
     /* highest priority: specific */
     bool break_when_done(false);
+    for (auto c : _imp->qualified_index.candidates(*e))
     {
-        SpecificMap::const_iterator i(_imp->qualified.find(e->name()));
-        if (i != _imp->qualified.end())
-        {
-            for (const auto & j : i->second)
-            {
-                if (! match_package(*_imp->env, *j.first, e, nullptr, { }))
-                    continue;
+        const auto & j(_imp->qualified[c]);
+        if (! match_package(*_imp->env, *j.first, e, nullptr, { }))
+            continue;
 
-                for (const auto & l : j.second)
-                {
-                    if (l == star_keyword)
-                        return true;
+        for (const auto & l : j.second)
+        {
+            if (l == star_keyword)
+                return true;
 
-                    else if (l == minus_star_keyword)
-                        break_when_done = true;
+            else if (l == minus_star_keyword)
+                break_when_done = true;
 
-                    else if (k->end() != k->find(l))
-                        return true;
-                }
-            }
+            else if (k->end() != k->find(l))
+                return true;
         }
     }
 
@@ -207,13 +196,13 @@ KeywordsConf::query(const std::shared_ptr<const KeywordNameSet> & k, const std::
         return false;
 
     /* last: unspecific */
-    for (PDSToKeywordsList::const_iterator j(_imp->unqualified.begin()), j_end(_imp->unqualified.end()) ;
-            j != j_end ; ++j)
+    for (auto c : _imp->unqualified_index.candidates(*e))
     {
-        if (! match_package(*_imp->env, *j->first, e, nullptr, { }))
+        const auto & j(_imp->unqualified[c]);
+        if (! match_package(*_imp->env, *j.first, e, nullptr, { }))
             continue;
 
-        for (const auto & l : j->second)
+        for (const auto & l : j.second)
         {
             if (k->end() != k->find(l))
                 return true;
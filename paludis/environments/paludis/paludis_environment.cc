@@ -36,6 +36,7 @@
 #include <paludis/mask.hh>
 #include <paludis/user_dep_spec.hh>
 #include <paludis/literal_metadata_key.hh>
+#include <paludis/repository.hh>
 #include <paludis/repository_factory.hh>
 #include <paludis/standard_output_manager.hh>
 
@@ -143,6 +144,18 @@ namespace paludis
                 done_hooks = true;
             }
         }
+
+        void need_hooker(const Environment * const env) const
+        {
+            if (! hooker)
+            {
+                need_hook_dirs(FSPath(config->config_dir()));
+                hooker = std::make_shared<Hooker>(env);
+                for (std::list<std::pair<FSPath, bool> >::const_iterator h(hook_dirs.begin()),
+                        h_end(hook_dirs.end()) ; h != h_end ; ++h)
+                    hooker->add_dir(h->first, h->second);
+            }
+        }
     };
 }
 
@@ -205,17 +218,20 @@ PaludisEnvironment::perform_hook(
         const std::shared_ptr<OutputManager> & optional_output_manager) const
 {
     std::unique_lock<std::mutex> lock(_imp->hook_mutex);
+    _imp->need_hooker(this);
+    return _imp->hooker->perform_hook(hook, optional_output_manager);
+}
 
-    if (! _imp->hooker)
-    {
-        _imp->need_hook_dirs(FSPath(_imp->config->config_dir()));
-        _imp->hooker = std::make_shared<Hooker>(this);
-        for (std::list<std::pair<FSPath, bool> >::const_iterator h(_imp->hook_dirs.begin()),
-                h_end(_imp->hook_dirs.end()) ; h != h_end ; ++h)
-            _imp->hooker->add_dir(h->first, h->second);
-    }
+bool
+PaludisEnvironment::want_hook(const std::string & name) const
+{
+    for (const auto & repository : repositories())
+        if (repository->want_hook(name))
+            return true;
 
-    return _imp->hooker->perform_hook(hook, optional_output_manager);
+    std::unique_lock<std::mutex> lock(_imp->hook_mutex);
+    _imp->need_hooker(this);
+    return _imp->hooker->has_hooks(name);
 }
 
 std::shared_ptr<const FSPathSequence>
@@ -102,6 +102,9 @@ namespace paludis
                     const std::shared_ptr<OutputManager> &) const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            virtual bool want_hook(const std::string &) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             virtual std::string distribution() const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
@@ -43,6 +43,7 @@
 #include <paludis/util/env_var_names.hh>
 #include <paludis/util/join.hh>
 #include <paludis/util/upper_lower.hh>
+#include <paludis/util/hashes.hh>
 
 #include <paludis/standard_output_manager.hh>
 #include <paludis/hooker.hh>
@@ -53,9 +54,11 @@
 #include <paludis/user_dep_spec.hh>
 #include <paludis/set_file.hh>
 #include <paludis/literal_metadata_key.hh>
+#include <paludis/repository.hh>
 #include <paludis/repository_factory.hh>
 #include <paludis/choice.hh>
 #include <paludis/partially_made_package_dep_spec.hh>
+#include <paludis/name.hh>
 
 #include <functional>
 #include <algorithm>
@@ -64,6 +67,7 @@
 #include <vector>
 #include <list>
 #include <mutex>
+#include <unordered_map>
 
 #include <unistd.h>
 #include <sys/types.h>
@@ -75,10 +79,78 @@
 using namespace paludis;
 using namespace paludis::portage_environment;
 
-typedef std::list<std::pair<std::shared_ptr<const PackageDepSpec>, std::string> > PackageUse;
-typedef std::list<std::pair<std::shared_ptr<const PackageDepSpec>, std::string> > PackageKeywords;
-typedef std::list<std::shared_ptr<const PackageDepSpec> > PackageMask;
-typedef std::list<std::shared_ptr<const PackageDepSpec> > PackageUnmask;
+typedef std::pair<std::shared_ptr<const PackageDepSpec>, std::string> SpecAndValue;
+typedef std::list<SpecAndValue> SpecAndValueList;
+typedef std::list<std::shared_ptr<const PackageDepSpec> > SpecList;
+
+namespace
+{
+    typedef std::list<std::pair<unsigned, SpecAndValue> > NumberedSpecAndValueList;
+    typedef std::unordered_map<QualifiedPackageName, NumberedSpecAndValueList, Hash<QualifiedPackageName> > SpecificMap;
+
+    /**
+     * Holds the lines of a package.* file, indexed by qualified package name
+     * where the spec has one, and remembering the order in which lines were
+     * added so that later lines can still override earlier ones.
+     */
+    class IndexedSpecs
+    {
+        private:
+            unsigned _count;
+            SpecificMap _qualified;
+            NumberedSpecAndValueList _unqualified;
+
+        public:
+            IndexedSpecs() :
+                _count(0)
+            {
+            }
+
+            void add(const SpecAndValue & s)
+            {
+                if (s.first->package_ptr())
+                    _qualified[*s.first->package_ptr()].push_back(std::make_pair(_count++, s));
+                else
+                    _unqualified.push_back(std::make_pair(_count++, s));
+            }
+
+            void add(const std::shared_ptr<const PackageDepSpec> & s)
+            {
+                add(std::make_pair(s, std::string()));
+            }
+
+            template <typename I_>
+            void add(I_ i, const I_ i_end)
+            {
+                for ( ; i != i_end ; ++i)
+                    add(*i);
+            }
+
+            /**
+             * Call f for every entry which could match something named q, in
+             * the order the entries were added, until f returns true.
+             */
+            template <typename F_>
+            bool find_if(const QualifiedPackageName & q, const F_ & f) const
+            {
+                static const NumberedSpecAndValueList no_entries;
+
+                SpecificMap::const_iterator m(_qualified.find(q));
+                const NumberedSpecAndValueList & qualified(m == _qualified.end() ? no_entries : m->second);
+
+                NumberedSpecAndValueList::const_iterator a(qualified.begin()), a_end(qualified.end()),
+                    b(_unqualified.begin()), b_end(_unqualified.end());
+                while (a != a_end || b != b_end)
+                {
+                    const SpecAndValue & s((b == b_end || (a != a_end && a->first < b->first)) ? (a++)->second : (b++)->second);
+                    if (f(s))
+                        return true;
+                }
+
+                return false;
+            }
+    };
+}
 
 PortageEnvironmentConfigurationError::PortageEnvironmentConfigurationError(const std::string & s) noexcept :
     ConfigurationError(s)
@@ -99,10 +171,10 @@ namespace paludis
         std::set<std::string> accept_keywords;
         std::multimap<std::string, std::string> mirrors;
 
-        PackageUse package_use;
-        PackageKeywords package_keywords;
-        PackageMask package_mask;
-        PackageUnmask package_unmask;
+        IndexedSpecs package_use;
+        IndexedSpecs package_keywords;
+        IndexedSpecs package_mask;
+        IndexedSpecs package_unmask;
 
         mutable std::mutex reduced_mutex;
         bool userpriv_enabled;
@@ -171,6 +243,18 @@ namespace paludis
             }
         }
 
+        void need_hooker(const Environment * const env) const
+        {
+            using namespace std::placeholders;
+
+            if (! hooker)
+            {
+                need_hook_dirs();
+                hooker = std::make_shared<Hooker>(env);
+                std::for_each(hook_dirs.begin(), hook_dirs.end(),
+                        std::bind(std::mem_fn(&Hooker::add_dir), hooker.get(), _1, false));
+            }
+        }
     };
 }
 
@@ -327,14 +411,26 @@ PortageEnvironment::PortageEnvironment(const std::string & s) :
 
     /* files */
 
-    _load_atom_file(_imp->conf_dir / "portage" / "package.use", std::back_inserter(_imp->package_use), "", true);
-    _load_atom_file(_imp->conf_dir / "portage" / "package.keywords", std::back_inserter(_imp->package_keywords),
-            "~" + _imp->vars->get("ARCH"), false);
-    _load_atom_file(_imp->conf_dir / "portage" / "package.accept_keywords", std::back_inserter(_imp->package_keywords),
-            "~" + _imp->vars->get("ARCH"), false);
-
-    _load_lined_file(_imp->conf_dir / "portage" / "package.mask", std::back_inserter(_imp->package_mask));
-    _load_lined_file(_imp->conf_dir / "portage" / "package.unmask", std::back_inserter(_imp->package_unmask));
+    {
+        SpecAndValueList package_use;
+        _load_atom_file(_imp->conf_dir / "portage" / "package.use", std::back_inserter(package_use), "", true);
+        _imp->package_use.add(package_use.begin(), package_use.end());
+
+        SpecAndValueList package_keywords;
+        _load_atom_file(_imp->conf_dir / "portage" / "package.keywords", std::back_inserter(package_keywords),
+                "~" + _imp->vars->get("ARCH"), false);
+        _load_atom_file(_imp->conf_dir / "portage" / "package.accept_keywords", std::back_inserter(package_keywords),
+                "~" + _imp->vars->get("ARCH"), false);
+        _imp->package_keywords.add(package_keywords.begin(), package_keywords.end());
+
+        SpecList package_mask;
+        _load_lined_file(_imp->conf_dir / "portage" / "package.mask", std::back_inserter(package_mask));
+        _imp->package_mask.add(package_mask.begin(), package_mask.end());
+
+        SpecList package_unmask;
+        _load_lined_file(_imp->conf_dir / "portage" / "package.unmask", std::back_inserter(package_unmask));
+        _imp->package_unmask.add(package_unmask.begin(), package_unmask.end());
+    }
 
     /* mirrors */
     std::list<std::string> gentoo_mirrors;
@@ -563,17 +659,17 @@ PortageEnvironment::want_choice_enabled(
     ChoiceNameWithPrefix f(stringify(choice->prefix()) + (stringify(choice->prefix()).empty() ? "" : "_") + stringify(suffix));
 
     /* check use: per package config */
-    for (PackageUse::const_iterator i(_imp->package_use.begin()), i_end(_imp->package_use.end()) ;
-            i != i_end ; ++i)
-    {
-        if (! match_package(*this, *i->first, id, nullptr, { }))
-            continue;
+    _imp->package_use.find_if(id->name(), [&] (const SpecAndValue & i) {
+            if (! match_package(*this, *i.first, id, nullptr, { }))
+                return false;
 
-        if (i->second == stringify(f))
-            state = true;
-        else if (i->second == "-" + stringify(f))
-            state = false;
-    }
+            if (i.second == stringify(f))
+                state = true;
+            else if (i.second == "-" + stringify(f))
+                state = false;
+
+            return false;
+        });
 
     return state;
 }
@@ -607,23 +703,23 @@ PortageEnvironment::accept_keywords(const std::shared_ptr <const KeywordNameSet>
     bool accept_star_star(false), accept_tilde_star(false);
 
     std::copy(_imp->accept_keywords.begin(), _imp->accept_keywords.end(), std::inserter(accepted, accepted.begin()));
-    for (PackageKeywords::const_iterator it(_imp->package_keywords.begin()),
-             it_end(_imp->package_keywords.end()); it_end != it; ++it)
-    {
-        if (! match_package(*this, *it->first, d, nullptr, { }))
-            continue;
-
-        if ("-*" == it->second)
-            accepted.clear();
-        else if ('-' == it->second.at(0))
-            accepted.erase(it->second.substr(1));
-        else if ("**" == it->second)
-            accept_star_star = true;
-        else if ("~*" == it->second)
-            accept_tilde_star = true;
-        else
-            accepted.insert(it->second);
-    }
+    _imp->package_keywords.find_if(d->name(), [&] (const SpecAndValue & it) {
+            if (! match_package(*this, *it.first, d, nullptr, { }))
+                return false;
+
+            if ("-*" == it.second)
+                accepted.clear();
+            else if ('-' == it.second.at(0))
+                accepted.erase(it.second.substr(1));
+            else if ("**" == it.second)
+                accept_star_star = true;
+            else if ("~*" == it.second)
+                accept_tilde_star = true;
+            else
+                accepted.insert(it.second);
+
+            return false;
+        });
 
     if (accept_star_star)
         return true;
@@ -643,12 +739,9 @@ PortageEnvironment::accept_keywords(const std::shared_ptr <const KeywordNameSet>
 bool
 PortageEnvironment::unmasked_by_user(const std::shared_ptr<const PackageID> & e, const std::string &) const
 {
-    for (PackageUnmask::const_iterator i(_imp->package_unmask.begin()), i_end(_imp->package_unmask.end()) ;
-            i != i_end ; ++i)
-        if (match_package(*this, **i, e, nullptr, { }))
-            return true;
-
-    return false;
+    return _imp->package_unmask.find_if(e->name(), [&] (const SpecAndValue & i) {
+            return match_package(*this, *i.first, e, nullptr, { });
+        });
 }
 
 std::shared_ptr<const Set<UnprefixedChoiceName> >
@@ -667,15 +760,15 @@ PortageEnvironment::known_choice_value_names(const std::shared_ptr<const Package
         if ('-' != i->second.at(0))
             result->insert(UnprefixedChoiceName(i->second));
 
-    for (PackageUse::const_iterator i(_imp->package_use.begin()), i_end(_imp->package_use.end()) ;
-            i != i_end ; ++i)
-    {
-        if (! match_package(*this, *i->first, id, nullptr, { }))
-            continue;
+    _imp->package_use.find_if(id->name(), [&] (const SpecAndValue & i) {
+            if (! match_package(*this, *i.first, id, nullptr, { }))
+                return false;
 
-        if (0 == i->second.compare(0, prefix_lower.length(), prefix_lower, 0, prefix_lower.length()))
-            result->insert(UnprefixedChoiceName(i->second.substr(prefix_lower.length())));
-    }
+            if (0 == i.second.compare(0, prefix_lower.length(), prefix_lower, 0, prefix_lower.length()))
+                result->insert(UnprefixedChoiceName(i.second.substr(prefix_lower.length())));
+
+            return false;
+        });
 
     return result;
 }
@@ -685,20 +778,23 @@ PortageEnvironment::perform_hook(
         const Hook & hook,
         const std::shared_ptr<OutputManager> & optional_output_manager) const
 {
-    using namespace std::placeholders;
-
     std::unique_lock<std::mutex> l(_imp->hook_mutex);
-    if (! _imp->hooker)
-    {
-        _imp->need_hook_dirs();
-        _imp->hooker = std::make_shared<Hooker>(this);
-        std::for_each(_imp->hook_dirs.begin(), _imp->hook_dirs.end(),
-                std::bind(std::mem_fn(&Hooker::add_dir), _imp->hooker.get(), _1, false));
-    }
-
+    _imp->need_hooker(this);
     return _imp->hooker->perform_hook(hook, optional_output_manager);
 }
 
+bool
+PortageEnvironment::want_hook(const std::string & name) const
+{
+    for (const auto & repository : repositories())
+        if (repository->want_hook(name))
+            return true;
+
+    std::unique_lock<std::mutex> l(_imp->hook_mutex);
+    _imp->need_hooker(this);
+    return _imp->hooker->has_hooks(name);
+}
+
 std::shared_ptr<const FSPathSequence>
 PortageEnvironment::hook_dirs() const
 {
@@ -797,10 +893,10 @@ namespace
 const std::shared_ptr<const Mask>
 PortageEnvironment::mask_for_user(const std::shared_ptr<const PackageID> & d, const bool o) const
 {
-    for (PackageMask::const_iterator i(_imp->package_mask.begin()), i_end(_imp->package_mask.end()) ;
-            i != i_end ; ++i)
-        if (match_package(*this, **i, d, nullptr, { }))
-            return std::make_shared<UserConfigMask>(o);
+    if (_imp->package_mask.find_if(d->name(), [&] (const SpecAndValue & i) {
+                return match_package(*this, *i.first, d, nullptr, { });
+            }))
+        return std::make_shared<UserConfigMask>(o);
 
     return std::shared_ptr<const Mask>();
 }
@@ -129,6 +129,9 @@ namespace paludis
                     const std::shared_ptr<OutputManager> &) const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            virtual bool want_hook(const std::string &) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             virtual bool accept_license(const std::string &, const std::shared_ptr<const PackageID> &) const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
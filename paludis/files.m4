@@ -77,6 +77,7 @@ add(`output_manager',                              `hh', `fwd', `cc', `se')
 add(`output_manager_factory',                      `hh', `fwd', `cc')
 add(`output_manager_from_environment',             `hh', `fwd', `cc')
 add(`package_dep_spec_collection',                 `hh', `cc', `fwd')
+add(`package_dep_spec_index',                      `hh', `cc', `fwd', `gtest')
 add(`package_dep_spec_properties',                 `hh', `cc', `fwd')
 add(`package_id',                                  `hh', `cc', `fwd', `se')
 add(`paludis',                                     `hh')
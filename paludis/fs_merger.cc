@@ -32,6 +32,11 @@
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_error.hh>
+#include <paludis/util/ordered_work_queue.hh>
+#include <paludis/util/env_var_names.hh>
+#include <paludis/util/system.hh>
+#include <paludis/util/destringify.hh>
+#include <paludis/util/md5.hh>
 #include <paludis/selinux/security_context.hh>
 #include <paludis/environment.hh>
 #include <paludis/hook.hh>
@@ -43,8 +48,16 @@
 #include <errno.h>
 #include <cstring>
 #include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
 #include <list>
+#include <map>
+#include <memory>
 #include <set>
+#include <sstream>
+#include <tuple>
 #include <unordered_map>
 
 #include "config.h"
@@ -57,12 +70,220 @@
 #  include <linux/falloc.h>
 #endif
 
+#ifdef HAVE_FICLONE
+#  include <sys/ioctl.h>
+#  include <linux/fs.h>
+#endif
+
+#ifdef HAVE_SENDFILE
+#  include <sys/sendfile.h>
+#endif
+
 using namespace paludis;
 
 #include <paludis/fs_merger-se.cc>
 
 typedef std::unordered_map<std::pair<dev_t, ino_t>, std::string, Hash<std::pair<dev_t, ino_t> > > MergedMap;
 
+namespace
+{
+    /* the most we ask copy_file_range or sendfile for in one go */
+    const std::size_t kernel_copy_chunk_size(1 << 30);
+
+    /* used when neither can help us, e.g. on old kernels */
+    const std::size_t copy_buffer_size(1 << 17);
+
+    bool kernel_copy_not_possible(const int e)
+    {
+        switch (e)
+        {
+            case EXDEV:
+            case EINVAL:
+            case ENOSYS:
+            case EOPNOTSUPP:
+            case EBADF:
+                return true;
+        }
+
+        return false;
+    }
+
+    bool try_to_reflink(const int input_fd, const int output_fd, const FSPath & dst)
+    {
+#ifdef HAVE_FICLONE
+        if (0 == ::ioctl(output_fd, FICLONE, input_fd))
+            return true;
+
+        Log::get_instance()->message("merger.file.reflink_failed", ll_debug, lc_context)
+            << "FICLONE to '" << dst << "' failed: " << ::strerror(errno);
+#else
+        (void) input_fd;
+        (void) output_fd;
+        (void) dst;
+#endif
+        return false;
+    }
+
+    /* Copy everything from input_fd's current offset, which must be the
+     * start, onwards, preferring ways of doing so that don't bounce the data
+     * through userspace. If one of them gives up part way through, the file
+     * offsets tell the next one where to carry on from. If we want the
+     * digest, we have to read the data anyway, so we copy it ourselves and
+     * hash it as we go. */
+    FSMergerStatusFlags copy_file_data(const int input_fd, const int output_fd, const FSPath & src, const FSPath & dst,
+            MD5 * const md5)
+    {
+#ifdef HAVE_COPY_FILE_RANGE
+        for (bool any(false) ; ! md5 ; )
+        {
+            ssize_t count(::copy_file_range(input_fd, nullptr, output_fd, nullptr, kernel_copy_chunk_size, 0));
+            if (count > 0)
+                any = true;
+            else if (0 == count && any)
+                return { msi_copy_file_range };
+            else if (0 == count)
+                break;
+            else if (EINTR == errno)
+                continue;
+            else if (kernel_copy_not_possible(errno))
+            {
+                Log::get_instance()->message("merger.file.copy_file_range_failed", ll_debug, lc_context)
+                    << "copy_file_range from '" << src << "' to '" << dst << "' failed: " << ::strerror(errno);
+                break;
+            }
+            else
+                throw FSMergerError("copy_file_range from '" + stringify(src) + "' to '" + stringify(dst) + "' failed: "
+                        + stringify(::strerror(errno)));
+        }
+#endif
+
+#ifdef HAVE_SENDFILE
+        for (bool any(false) ; ! md5 ; )
+        {
+            ssize_t count(::sendfile(output_fd, input_fd, nullptr, kernel_copy_chunk_size));
+            if (count > 0)
+                any = true;
+            else if (0 == count && any)
+                return { msi_sendfile };
+            else if (0 == count)
+                break;
+            else if (EINTR == errno)
+                continue;
+            else if (kernel_copy_not_possible(errno))
+            {
+                Log::get_instance()->message("merger.file.sendfile_failed", ll_debug, lc_context)
+                    << "sendfile from '" << src << "' to '" << dst << "' failed: " << ::strerror(errno);
+                break;
+            }
+            else
+                throw FSMergerError("sendfile from '" + stringify(src) + "' to '" + stringify(dst) + "' failed: "
+                        + stringify(::strerror(errno)));
+        }
+#endif
+
+        std::unique_ptr<char[]> buf(new char[copy_buffer_size]);
+        while (true)
+        {
+            ssize_t count(::read(input_fd, buf.get(), copy_buffer_size));
+            if (0 == count)
+                break;
+            else if (-1 == count)
+            {
+                if (EINTR == errno)
+                    continue;
+                throw FSMergerError("read failed: " + stringify(::strerror(errno)));
+            }
+
+            if (md5)
+                md5->update(buf.get(), count);
+
+            for (ssize_t done(0) ; done < count ; )
+            {
+                ssize_t written(::write(output_fd, buf.get() + done, count - done));
+                if (-1 == written)
+                {
+                    if (EINTR == errno)
+                        continue;
+                    throw FSMergerError("write failed: " + stringify(::strerror(errno)));
+                }
+                done += written;
+            }
+        }
+
+        return { };
+    }
+
+    /* ask for the file to start being written out, but don't wait for it */
+    void start_writeback(const int fd, const FSPath & f)
+    {
+#ifdef HAVE_SYNC_FILE_RANGE
+        if (0 != ::sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE))
+            Log::get_instance()->message("merger.file.sync_file_range_failed", ll_debug, lc_context)
+                << "sync_file_range on '" << f << "' failed: " << ::strerror(errno);
+#else
+        (void) fd;
+        (void) f;
+#endif
+    }
+
+    void sync_file_data(const int fd, const FSPath & f)
+    {
+        if (0 != ::fdatasync(fd))
+            throw FSMergerError("fdatasync '" + stringify(f) + "' failed: " + stringify(::strerror(errno)));
+    }
+
+    void sync_filesystem(const FSPath & d)
+    {
+        FDHolder fd(::open(stringify(d).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC), false);
+        if (-1 == fd)
+            throw FSMergerError("Cannot open '" + stringify(d) + "': " + stringify(::strerror(errno)));
+
+#ifdef HAVE_SYNCFS
+        if (0 != ::syncfs(fd))
+            throw FSMergerError("syncfs '" + stringify(d) + "' failed: " + stringify(::strerror(errno)));
+#else
+        ::sync();
+#endif
+    }
+
+    std::string seconds(const std::chrono::steady_clock::duration & d)
+    {
+        std::stringstream result;
+        result << std::fixed << std::setprecision(3) << std::chrono::duration<double>(d).count() << "s";
+        return result.str();
+    }
+
+    std::string md5_of_fd(const int fd, const FSPath & f)
+    {
+        MD5 md5;
+        std::unique_ptr<char[]> buf(new char[copy_buffer_size]);
+        while (true)
+        {
+            ssize_t count(::read(fd, buf.get(), copy_buffer_size));
+            if (0 == count)
+                break;
+            else if (-1 == count)
+            {
+                if (EINTR == errno)
+                    continue;
+                throw FSMergerError("Cannot read '" + stringify(f) + "': " + stringify(::strerror(errno)));
+            }
+            md5.update(buf.get(), count);
+        }
+
+        md5.finish();
+        return md5.hexsum();
+    }
+
+    std::string md5_of_file(const FSPath & f)
+    {
+        FDHolder fd(::open(stringify(f).c_str(), O_RDONLY), false);
+        if (-1 == fd)
+            throw FSMergerError("Cannot read '" + stringify(f) + "': " + stringify(::strerror(errno)));
+        return md5_of_fd(fd, f);
+    }
+}
+
 namespace paludis
 {
     template <>
@@ -72,11 +293,35 @@ namespace paludis
         FSMergerParams params;
         std::set<FSPath, FSPathComparator> elided_paths;
 
+        std::unique_ptr<OrderedWorkQueue> install_queue;
+        std::set<std::pair<dev_t, ino_t> > queued_ids;
+
+        std::unordered_map<std::string, std::string> md5s;
+
+        /* digests of image files worked out during the check, for files we
+         * expect to reflink rather than read, along with the mtime and size
+         * they had then */
+        std::unordered_map<std::string, std::tuple<Timestamp, off_t, std::string> > image_md5s;
+
+        std::chrono::steady_clock::time_point merge_start;
+        std::chrono::steady_clock::duration file_sync_time;
+        unsigned long files_copied;
+        unsigned long long bytes_copied;
+        std::set<std::string> dirs_written;
+        std::map<dev_t, FSPath> filesystems_written;
+
         Imp(const FSMergerParams & p) :
             params(p)
         {
         }
 
+        /* so that we know which filesystems to sync */
+        void note_written(const FSPath & dir)
+        {
+            if (fsmd_none != params.durability() && dirs_written.insert(stringify(dir)).second)
+                filesystems_written.insert(std::make_pair(dir.stat().lowlevel_id().first, dir));
+        }
+
         bool is_elided_directory(const FSPath & dir) const
         {
             for (FSIterator dentry(dir, { fsio_include_dotfiles }), invalid;
@@ -141,9 +386,152 @@ FSMerger::merge()
         }
     } old_umask(::umask(0000));
 
+    unsigned jobs(1);
+    std::string jobs_str(getenv_with_default(env_vars::merge_jobs, "1"));
+    try
+    {
+        jobs = destringify<unsigned>(jobs_str);
+    }
+    catch (const DestringifyError &)
+    {
+        Log::get_instance()->message("merger.jobs.bad", ll_warning, lc_context)
+            << "Ignoring bad value '" << jobs_str << "' for " << env_vars::merge_jobs;
+    }
+
+    /* hooks see each entry's pre and post together, in image order, which we
+     * can't do if a file's copy finishes on another thread after later
+     * entries have been started */
+    if (jobs > 1)
+        for (auto & h : { "merger_install_file_pre", "merger_install_file_post", "merger_install_dir_pre",
+                "merger_install_dir_post", "merger_install_sym_pre", "merger_install_sym_post" })
+            if (want_hook(h))
+            {
+                Log::get_instance()->message("merger.jobs.hooks", ll_debug, lc_context)
+                    << "Ignoring " << env_vars::merge_jobs << " because '" << h << "' hooks are installed";
+                jobs = 1;
+                break;
+            }
+
+    struct StopInstallQueue
+    {
+        std::unique_ptr<OrderedWorkQueue> & q;
+
+        StopInstallQueue(std::unique_ptr<OrderedWorkQueue> & qq) :
+            q(qq)
+        {
+        }
+
+        ~StopInstallQueue()
+        {
+            q.reset();
+        }
+    } stop_install_queue(_imp->install_queue);
+
+    if (jobs > 1)
+        _imp->install_queue.reset(new OrderedWorkQueue(jobs));
+    _imp->queued_ids.clear();
+    _imp->md5s.clear();
+    _imp->merge_start = std::chrono::steady_clock::now();
+    _imp->file_sync_time = std::chrono::steady_clock::duration::zero();
+    _imp->files_copied = 0;
+    _imp->bytes_copied = 0;
+    _imp->dirs_written.clear();
+    _imp->filesystems_written.clear();
+
     Merger::merge();
 }
 
+void
+FSMerger::on_done_merge()
+{
+    if (_imp->install_queue)
+        _imp->install_queue->finish(0);
+
+    auto sync_start(std::chrono::steady_clock::now());
+    if (fsmd_none != _imp->params.durability())
+        for (const auto & f : _imp->filesystems_written)
+            sync_filesystem(f.second);
+    auto sync_end(std::chrono::steady_clock::now());
+
+    Log::get_instance()->message("merger.timing", ll_debug, lc_context)
+        << "Merged in " << seconds(sync_end - _imp->merge_start) << " with durability '" << _imp->params.durability()
+        << "', copying " << _imp->files_copied << " files of " << _imp->bytes_copied << " bytes, spending "
+        << seconds(_imp->file_sync_time) << " syncing files and " << seconds(sync_end - sync_start) << " syncing "
+        << _imp->filesystems_written.size() << " filesystems";
+
+    if (fsmd_none != _imp->params.durability())
+        display_override(">>> Synced " + stringify(_imp->filesystems_written.size()) + " filesystems in "
+                + seconds(sync_end - sync_start) + " (" + seconds(_imp->file_sync_time) + " syncing files, merge took "
+                + seconds(sync_end - _imp->merge_start) + ")");
+
+    Merger::on_done_merge();
+}
+
+void
+FSMerger::make_durable(const FSPath & f)
+{
+    if (fsmd_none == _imp->params.durability())
+        return;
+
+    Context context("When syncing '" + stringify(f) + "':");
+
+    {
+        FDHolder fd(::open(stringify(f).c_str(), O_RDONLY | O_CLOEXEC), false);
+        if (-1 == fd)
+            throw FSMergerError("Cannot open '" + stringify(f) + "': " + stringify(::strerror(errno)));
+        if (0 != ::fsync(fd))
+            throw FSMergerError("fsync '" + stringify(f) + "' failed: " + stringify(::strerror(errno)));
+    }
+
+    FDHolder dir_fd(::open(stringify(f.dirname()).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC), false);
+    if (-1 == dir_fd)
+        throw FSMergerError("Cannot open '" + stringify(f.dirname()) + "': " + stringify(::strerror(errno)));
+    if (0 != ::fsync(dir_fd))
+        throw FSMergerError("fsync '" + stringify(f.dirname()) + "' failed: " + stringify(::strerror(errno)));
+}
+
+bool
+FSMerger::want_file_md5s() const
+{
+    return false;
+}
+
+std::string
+FSMerger::file_md5(const FSPath & f)
+{
+    auto i(_imp->md5s.find(stringify(f)));
+    if (_imp->md5s.end() == i)
+        i = _imp->md5s.insert(std::make_pair(stringify(f), md5_of_file(f))).first;
+    return i->second;
+}
+
+void
+FSMerger::note_image_md5(const FSPath & src)
+{
+#ifdef HAVE_FICLONE
+    /* a reflink never reads the data, so if that's how we're likely to copy
+     * it, work the digest out now, leaving the copy free to use whichever
+     * way is cheapest */
+    if (! (want_file_md5s() && _imp->params.options()[mo_nondestructive]))
+        return;
+
+    FSStat src_stat(src);
+    _imp->image_md5s.erase(stringify(src));
+    _imp->image_md5s.insert(std::make_pair(stringify(src), std::make_tuple(src_stat.mtim(), src_stat.file_size(), md5_of_file(src))));
+#else
+    (void) src;
+#endif
+}
+
+void
+FSMerger::in_order(const std::function<void ()> & f)
+{
+    if (_imp->install_queue)
+        _imp->install_queue->add(nullptr, f);
+    else
+        f();
+}
+
 void
 FSMerger::prepare_install_under()
 {
@@ -168,24 +556,24 @@ void
 FSMerger::on_file_over_nothing(bool is_check, const FSPath & src, const FSPath & dst)
 {
     if (is_check)
-        return;
+        return note_image_md5(src);
 
-    track_install_file(src, dst, src.basename(), install_file(src, dst, src.basename()));
+    install_and_track_file(src, dst, src.basename(), { });
 }
 
 void
 FSMerger::on_file_over_file(bool is_check, const FSPath & src, const FSPath & dst)
 {
     if (is_check)
-        return;
+        return note_image_md5(src);
 
     if (config_protected(src, dst))
     {
         std::string cfgpro_name(make_config_protect_name(src, dst));
-        track_install_file(src, dst, cfgpro_name, install_file(src, dst, cfgpro_name));
+        install_and_track_file(src, dst, cfgpro_name, { });
     }
     else
-        track_install_file(src, dst, src.basename(), install_file(src, dst, src.basename()) + msi_unlinked_first);
+        install_and_track_file(src, dst, src.basename(), { msi_unlinked_first });
 }
 
 void
@@ -199,18 +587,18 @@ void
 FSMerger::on_file_over_sym(bool is_check, const FSPath & src, const FSPath & dst)
 {
     if (is_check)
-        return;
+        return note_image_md5(src);
 
-    track_install_file(src, dst, src.basename(), install_file(src, dst, src.basename()) + msi_unlinked_first);
+    install_and_track_file(src, dst, src.basename(), { msi_unlinked_first });
 }
 
 void
 FSMerger::on_file_over_misc(bool is_check, const FSPath & src, const FSPath & dst)
 {
     if (is_check)
-        return;
+        return note_image_md5(src);
 
-    track_install_file(src, dst, src.basename(), install_file(src, dst, src.basename()) + msi_unlinked_first);
+    install_and_track_file(src, dst, src.basename(), { msi_unlinked_first });
 }
 
 void
@@ -324,161 +712,337 @@ FSMerger::on_sym_over_misc(bool is_check, const FSPath & src, const FSPath & dst
     track_install_sym(src, dst, install_sym(src, dst) + msi_unlinked_first);
 }
 
+struct FSMerger::FileInstall
+{
+    const FSPath src;
+    const FSPath dst_dir;
+    const std::string dst_name;
+    const FSPath dst_real;
+    const FSPath dst;
+    const FSStat src_stat;
+
+    std::shared_ptr<const SecurityContext> secctx;
+    FSMergerStatusFlags result;
+    bool needs_copy;
+    bool needs_md5;
+    std::string md5;
+    std::chrono::steady_clock::duration sync_time;
+
+    FileInstall(const FSPath & s, const FSPath & d, const std::string & n) :
+        src(s),
+        dst_dir(d),
+        dst_name(n),
+        dst_real(d / n),
+        dst(d / (n + "|paludis-midmerge")),
+        src_stat(s),
+        needs_copy(false),
+        needs_md5(false),
+        sync_time(std::chrono::steady_clock::duration::zero())
+    {
+    }
+};
+
 FSMergerStatusFlags
 FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::string & dst_name)
 {
     Context context("When installing file '" + stringify(src) + "' to '" + stringify(dst_dir) + "' with protection '"
             + stringify(dst_name) + "':");
 
-    FSPath dst_real(dst_dir / dst_name);
+    FileInstall f(src, dst_dir, dst_name);
+    if (! start_install_file(f))
+        return f.result;
+
+    if (f.needs_copy)
+        copy_installed_file(f);
+
+    return finish_install_file(f);
+}
+
+void
+FSMerger::install_and_track_file(const FSPath & src, const FSPath & dst_dir, const std::string & dst_name,
+        const FSMergerStatusFlags & extra_flags)
+{
+    if (! _imp->install_queue)
+        return track_install_file(src, dst_dir, dst_name, install_file(src, dst_dir, dst_name) | extra_flags);
+
+    Context context("When installing file '" + stringify(src) + "' to '" + stringify(dst_dir) + "' with protection '"
+            + stringify(dst_name) + "':");
+
+    std::shared_ptr<FileInstall> f(std::make_shared<FileInstall>(src, dst_dir, dst_name));
+
+    /* if another link to this file is still being copied, we need it to be
+     * finished so that we can hardlink to it */
+    if (_imp->queued_ids.end() != _imp->queued_ids.find(f->src_stat.lowlevel_id()))
+        _imp->install_queue->finish(0);
 
+    if (! start_install_file(*f))
+        return track_install_file(src, dst_dir, dst_name, f->result | extra_flags);
+
+    if ((! f->needs_copy) && f->needs_md5)
+    {
+        /* it was renamed into place, so we've not read it yet */
+        _imp->install_queue->add(
+                [f] () { f->md5 = md5_of_file(f->dst_real); },
+                [this, f, extra_flags] () {
+                    Context local_context("When finishing installing file '" + stringify(f->src) + "' to '" + stringify(f->dst_dir) + "':");
+                    track_install_file(f->src, f->dst_dir, f->dst_name, finish_install_file(*f) | extra_flags);
+                });
+        return;
+    }
+
+    if (! f->needs_copy)
+        return in_order([this, f, extra_flags] () {
+                Context local_context("When finishing installing file '" + stringify(f->src) + "' to '" + stringify(f->dst_dir) + "':");
+                track_install_file(f->src, f->dst_dir, f->dst_name, finish_install_file(*f) | extra_flags);
+                });
+
+    _imp->queued_ids.insert(f->src_stat.lowlevel_id());
+    _imp->install_queue->add(
+            [this, f] () {
+                Context local_context("When copying file '" + stringify(f->src) + "' to '" + stringify(f->dst) + "':");
+                copy_installed_file(*f);
+            },
+            [this, f, extra_flags] () {
+                Context local_context("When finishing installing file '" + stringify(f->src) + "' to '" + stringify(f->dst_dir) + "':");
+                _imp->queued_ids.erase(f->src_stat.lowlevel_id());
+                track_install_file(f->src, f->dst_dir, f->dst_name, finish_install_file(*f) | extra_flags);
+            });
+}
+
+bool
+FSMerger::start_install_file(FileInstall & f)
+{
     if (_imp->params.should_merge() &&
-            ! _imp->params.should_merge()(dst_real.strip_leading(_imp->params.root().realpath())))
-        return { msi_unselected_part };
+            ! _imp->params.should_merge()(f.dst_real.strip_leading(_imp->params.root().realpath())))
+    {
+        f.result += msi_unselected_part;
+        return false;
+    }
 
-    FSMergerStatusFlags result;
-    FSStat src_stat(src);
-    FSStat dst_real_stat(dst_real);
-    FSPath dst(dst_dir / (stringify(dst_name) + "|paludis-midmerge"));
+    FSStat dst_real_stat(f.dst_real);
 
     if (dst_real_stat.is_regular_file())
-        dst_real.chmod(0);
+        f.dst_real.chmod(0);
 
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_install_file_pre") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_install_file_pre")
-                        ("INSTALL_SOURCE", stringify(src))
-                        ("INSTALL_DESTINATION", stringify(dst_dir / src.basename()))
-                        ("REAL_DESTINATION", stringify(dst_real))),
+                        ("INSTALL_SOURCE", stringify(f.src))
+                        ("INSTALL_DESTINATION", stringify(f.dst_dir / f.src.basename()))
+                        ("REAL_DESTINATION", stringify(f.dst_real))),
                 _imp->params.maybe_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.file.pre_hooks.failure", ll_warning, lc_context) <<
-                "Merge of '" << src << "' to '" << dst_dir << "' pre hooks returned non-zero";
+                "Merge of '" << f.src << "' to '" << f.dst_dir << "' pre hooks returned non-zero";
 
-    std::shared_ptr<const SecurityContext> secctx(MatchPathCon::get_instance()->match(stringify(dst_real), src_stat.permissions()));
-    FSCreateCon createcon(secctx);
-    if (0 != paludis::setfilecon(src, secctx))
+    f.secctx = MatchPathCon::get_instance()->match(stringify(f.dst_real), f.src_stat.permissions());
+    if (0 != paludis::setfilecon(f.src, f.secctx))
         throw FSMergerError("Could not set SELinux context on '"
-                + stringify(src) + "': " + stringify(::strerror(errno)));
+                + stringify(f.src) + "': " + stringify(::strerror(errno)));
 
-    mode_t src_perms(src_stat.permissions());
+    mode_t src_perms(f.src_stat.permissions());
     if (0 != (src_perms & (S_ISVTX | S_ISUID | S_ISGID)))
-        result += msi_setid_bits;
+        f.result += msi_setid_bits;
 
-    bool do_copy(false);
+    if (want_file_md5s())
+    {
+        /* we might have needed it for config protection */
+        auto m(_imp->md5s.find(stringify(f.src)));
+        if (_imp->md5s.end() != m)
+            f.md5 = m->second;
+
+        /* only if it hasn't changed since the check */
+        auto i(_imp->image_md5s.find(stringify(f.src)));
+        if (f.md5.empty() && _imp->image_md5s.end() != i && std::get<0>(i->second) == f.src_stat.mtim()
+                && std::get<1>(i->second) == f.src_stat.file_size())
+            f.md5 = std::get<2>(i->second);
+
+        f.needs_md5 = f.md5.empty();
+    }
 
     if ((! _imp->params.options()[mo_nondestructive]) &&
-            0 == std::rename(stringify(src).c_str(), stringify(dst_real).c_str()))
+            0 == std::rename(stringify(f.src).c_str(), stringify(f.dst_real).c_str()))
     {
-        result += msi_rename;
+        f.result += msi_rename;
 
-        bool touch(_imp->merged_ids.end() == _imp->merged_ids.find(src_stat.lowlevel_id()));
-        _imp->merged_ids.insert(make_pair(src_stat.lowlevel_id(), stringify(dst_real)));
+        bool touch(_imp->merged_ids.end() == _imp->merged_ids.find(f.src_stat.lowlevel_id()));
+        _imp->merged_ids.insert(make_pair(f.src_stat.lowlevel_id(), stringify(f.dst_real)));
 
-        FSPath d(stringify(dst_real));
+        FSPath d(stringify(f.dst_real));
         if (touch && ! _imp->params.options()[mo_preserve_mtimes])
             if (! d.utime(Timestamp::now()))
-                throw FSMergerError("utime(" + stringify(dst_real) + ", 0) failed: " + stringify(::strerror(errno)));
+                throw FSMergerError("utime(" + stringify(f.dst_real) + ", 0) failed: " + stringify(::strerror(errno)));
 
         /* set*id bits get partially clobbered on a rename on linux */
-        dst_real.chmod(src_perms);
+        f.dst_real.chmod(src_perms);
+
+        if (fsmd_per_file == _imp->params.durability())
+        {
+            auto sync_start(std::chrono::steady_clock::now());
+            FDHolder fd(::open(stringify(f.dst_real).c_str(), O_RDONLY | O_CLOEXEC), false);
+            if (-1 == fd)
+                throw FSMergerError("Cannot open '" + stringify(f.dst_real) + "': " + stringify(::strerror(errno)));
+            sync_file_data(fd, f.dst_real);
+            f.sync_time += std::chrono::steady_clock::now() - sync_start;
+        }
     }
     else
     {
-        do_copy = true;
-        std::pair<MergedMap::const_iterator, MergedMap::const_iterator> ii(_imp->merged_ids.equal_range(src_stat.lowlevel_id()));
+        f.needs_copy = true;
+        std::pair<MergedMap::const_iterator, MergedMap::const_iterator> ii(_imp->merged_ids.equal_range(f.src_stat.lowlevel_id()));
         for (MergedMap::const_iterator i = ii.first ; i != ii.second ; ++i)
         {
-            if (0 == ::link(i->second.c_str(), stringify(dst).c_str()))
+            if (0 == ::link(i->second.c_str(), stringify(f.dst).c_str()))
             {
-                if (0 != std::rename(stringify(dst).c_str(), stringify(dst_real).c_str()))
-                    throw FSMergerError("rename(" + stringify(dst) + ", " + stringify(dst_real) + ") failed: " + stringify(::strerror(errno)));
-                do_copy = false;
-                result += msi_as_hardlink;
+                if (0 != std::rename(stringify(f.dst).c_str(), stringify(f.dst_real).c_str()))
+                    throw FSMergerError("rename(" + stringify(f.dst) + ", " + stringify(f.dst_real) + ") failed: " + stringify(::strerror(errno)));
+                f.needs_copy = false;
+                f.result += msi_as_hardlink;
+
+                auto m(_imp->md5s.find(i->second));
+                if (_imp->md5s.end() != m)
+                {
+                    f.md5 = m->second;
+                    f.needs_md5 = false;
+                }
                 break;
             }
             Log::get_instance()->message("merger.file.link_failed", ll_debug, lc_context)
-                    << "link(" << i->second << ", " << dst_real << ") failed: "
+                    << "link(" << i->second << ", " << f.dst_real << ") failed: "
                     << ::strerror(errno);
         }
     }
 
-    if (do_copy)
-    {
+    if (f.needs_copy)
         Log::get_instance()->message("merger.file.will_copy", ll_debug, lc_context) <<
-            "rename/link failed: " << ::strerror(errno) << ". Falling back to regular read/write copy";
+            "rename/link failed: " << ::strerror(errno) << ". Falling back to copying";
 
-        FDHolder input_fd(::open(stringify(src).c_str(), O_RDONLY), false);
-        if (-1 == input_fd)
-            throw FSMergerError("Cannot read '" + stringify(src) + "': " + stringify(::strerror(errno)));
+    return true;
+}
 
-        FDHolder output_fd(::open(stringify(dst).c_str(), O_WRONLY | O_CREAT, src_perms), false);
-        if (-1 == output_fd)
-            throw FSMergerError("Cannot write '" + stringify(dst) + "': " + stringify(::strerror(errno)));
+void
+FSMerger::copy_installed_file(FileInstall & f)
+{
+    FSCreateCon createcon(f.secctx);
+    mode_t src_perms(f.src_stat.permissions());
 
-        if (! _imp->params.no_chown())
-            if (0 != ::fchown(output_fd, src_stat.owner(), src_stat.group()))
-                throw FSMergerError("Cannot fchown '" + stringify(dst) + "': " + stringify(::strerror(errno)));
+    FDHolder input_fd(::open(stringify(f.src).c_str(), O_RDONLY), false);
+    if (-1 == input_fd)
+        throw FSMergerError("Cannot read '" + stringify(f.src) + "': " + stringify(::strerror(errno)));
+
+    FDHolder output_fd(::open(stringify(f.dst).c_str(), O_WRONLY | O_CREAT, src_perms), false);
+    if (-1 == output_fd)
+        throw FSMergerError("Cannot write '" + stringify(f.dst) + "': " + stringify(::strerror(errno)));
+
+    if (! _imp->params.no_chown())
+        if (0 != ::fchown(output_fd, f.src_stat.owner(), f.src_stat.group()))
+            throw FSMergerError("Cannot fchown '" + stringify(f.dst) + "': " + stringify(::strerror(errno)));
+
+    bool reflinked(try_to_reflink(input_fd, output_fd, f.dst));
+    if (reflinked)
+    {
+        f.result += msi_reflinked;
+        if (f.needs_md5)
+            f.md5 = md5_of_fd(input_fd, f.src);
+    }
 
 #ifdef HAVE_FALLOCATE
-        if (0 != ::fallocate(output_fd, FALLOC_FL_KEEP_SIZE, 0, src_stat.file_size()))
-            switch (errno)
-            {
-                case EOPNOTSUPP:
-                case ENOSYS:
-                    break;
+    if ((! reflinked) && 0 != ::fallocate(output_fd, FALLOC_FL_KEEP_SIZE, 0, f.src_stat.file_size()))
+        switch (errno)
+        {
+            case EOPNOTSUPP:
+            case ENOSYS:
+                break;
 
-                case ENOSPC:
-                    throw FSMergerError("fallocate '" + stringify(dst) + "' returned " + stringify(::strerror(errno)));
+            case ENOSPC:
+                throw FSMergerError("fallocate '" + stringify(f.dst) + "' returned " + stringify(::strerror(errno)));
 
-                default:
-                    Log::get_instance()->message("merger.file.fallocate_failed", ll_debug, lc_context) <<
-                        "fallocate '" + stringify(dst) + "' returned " + stringify(::strerror(errno));
-                    break;
-            }
+            default:
+                Log::get_instance()->message("merger.file.fallocate_failed", ll_debug, lc_context) <<
+                    "fallocate '" + stringify(f.dst) + "' returned " + stringify(::strerror(errno));
+                break;
+        }
 #endif
 
-        /* set*id bits, after fallocate because xfs is weird */
-        if (0 != ::fchmod(output_fd, src_perms))
-            throw FSMergerError("Cannot fchmod '" + stringify(dst) + "': " + stringify(::strerror(errno)));
-        try_to_copy_xattrs(src, output_fd, result);
-
-        char buf[4096];
-        ssize_t count;
-        while ((count = read(input_fd, buf, 4096)) > 0)
-            if (-1 == write(output_fd, buf, count))
-                throw FSMergerError("write failed: " + stringify(::strerror(errno)));
-        if (-1 == count)
-            throw FSMergerError("read failed: " + stringify(::strerror(errno)));
-
-        /* might need to copy mtime */
-        if (_imp->params.options()[mo_preserve_mtimes])
+    /* set*id bits, after fallocate because xfs is weird */
+    if (0 != ::fchmod(output_fd, src_perms))
+        throw FSMergerError("Cannot fchmod '" + stringify(f.dst) + "': " + stringify(::strerror(errno)));
+    try_to_copy_xattrs(f.src, output_fd, f.result);
+
+    if (! reflinked)
+    {
+        MD5 md5;
+        f.result |= copy_file_data(input_fd, output_fd, f.src, f.dst, f.needs_md5 ? &md5 : nullptr);
+        if (f.needs_md5)
         {
-            Timestamp timestamp(src_stat.mtim());
-            struct timespec ts[2];
-            ts[0] = ts[1] = timestamp.as_timespec();
-            if (0 != ::futimens(output_fd, ts))
-                throw FSMergerError("Cannot futimens '" + stringify(dst) + "': " + stringify(::strerror(errno)));
+            md5.finish();
+            f.md5 = md5.hexsum();
         }
+    }
+
+    /* might need to copy mtime */
+    if (_imp->params.options()[mo_preserve_mtimes])
+    {
+        Timestamp timestamp(f.src_stat.mtim());
+        struct timespec ts[2];
+        ts[0] = ts[1] = timestamp.as_timespec();
+        if (0 != ::futimens(output_fd, ts))
+            throw FSMergerError("Cannot futimens '" + stringify(f.dst) + "': " + stringify(::strerror(errno)));
+    }
+
+    switch (_imp->params.durability())
+    {
+        case fsmd_none:
+            break;
+
+        case fsmd_batched:
+            start_writeback(output_fd, f.dst);
+            break;
 
-        if (0 != std::rename(stringify(dst).c_str(), stringify(dst_real).c_str()))
-            throw FSMergerError(
-                    "rename(" + stringify(dst) + ", " + stringify(dst_real) + ") failed: " + stringify(::strerror(errno)));
+        case fsmd_per_file:
+            {
+                auto sync_start(std::chrono::steady_clock::now());
+                sync_file_data(output_fd, f.dst);
+                f.sync_time += std::chrono::steady_clock::now() - sync_start;
+            }
+            break;
 
-        _imp->merged_ids.insert(make_pair(src_stat.lowlevel_id(), stringify(dst_real)));
+        case last_fsmd:
+            break;
     }
 
-    if (fixed_ownership_for(src))
-        result += msi_fixed_ownership;
+    if (0 != std::rename(stringify(f.dst).c_str(), stringify(f.dst_real).c_str()))
+        throw FSMergerError(
+                "rename(" + stringify(f.dst) + ", " + stringify(f.dst_real) + ") failed: " + stringify(::strerror(errno)));
+}
+
+FSMergerStatusFlags
+FSMerger::finish_install_file(FileInstall & f)
+{
+    if (f.needs_copy)
+    {
+        _imp->merged_ids.insert(make_pair(f.src_stat.lowlevel_id(), stringify(f.dst_real)));
+        ++_imp->files_copied;
+        _imp->bytes_copied += f.src_stat.file_size();
+    }
 
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    _imp->file_sync_time += f.sync_time;
+    _imp->note_written(f.dst_dir);
+
+    if (! f.md5.empty())
+        _imp->md5s[stringify(f.dst_real)] = f.md5;
+
+    if (fixed_ownership_for(f.src))
+        f.result += msi_fixed_ownership;
+
+    if (want_hook("merger_install_file_post") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_install_file_post")
-                         ("INSTALL_SOURCE", stringify(src))
-                         ("INSTALL_DESTINATION", stringify(dst_dir / src.basename()))
-                         ("REAL_DESTINATION", stringify(dst_real))),
+                         ("INSTALL_SOURCE", stringify(f.src))
+                         ("INSTALL_DESTINATION", stringify(f.dst_dir / f.src.basename()))
+                         ("REAL_DESTINATION", stringify(f.dst_real))),
                 _imp->params.maybe_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.file.post_hooks.failed", ll_warning, lc_context) <<
-            "Merge of '" << src << "' to '" << dst_dir << "' post hooks returned non-zero";
+            "Merge of '" << f.src << "' to '" << f.dst_dir << "' post hooks returned non-zero";
 
-    return result;
+    return f.result;
 }
 
 void
@@ -565,7 +1129,7 @@ FSMerger::install_dir(const FSPath & src, const FSPath & dst_dir)
         }
     }
 
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_install_dir_pre") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_install_dir_pre")
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(dst_dir / src.basename()))),
@@ -625,7 +1189,7 @@ FSMerger::install_dir(const FSPath & src, const FSPath & dst_dir)
     if (fixed_ownership_for(src))
         result += msi_fixed_ownership;
 
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_install_dir_post") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_install_dir_post")
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(dst_dir / src.basename()))),
@@ -650,7 +1214,7 @@ FSMerger::install_sym(const FSPath & src, const FSPath & dst_dir)
     FSMergerStatusFlags result;
     FSStat src_stat(src);
 
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_install_sym_pre") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_install_sym_pre")
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(dst))),
@@ -694,7 +1258,7 @@ FSMerger::install_sym(const FSPath & src, const FSPath & dst_dir)
             result += msi_fixed_ownership;
     }
 
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_install_sym_post") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_install_sym_post")
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(dst))),
@@ -708,7 +1272,7 @@ FSMerger::install_sym(const FSPath & src, const FSPath & dst_dir)
 void
 FSMerger::unlink_file(FSPath d)
 {
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_unlink_file_pre") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_file_pre")
                          ("UNLINK_TARGET", stringify(d))),
                 _imp->params.maybe_output_manager()).max_exit_status())
@@ -718,7 +1282,7 @@ FSMerger::unlink_file(FSPath d)
     d.chmod(0);
     d.unlink();
 
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_unlink_file_post") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_file_post")
                          ("UNLINK_TARGET", stringify(d))),
                 _imp->params.maybe_output_manager()).max_exit_status())
@@ -729,7 +1293,7 @@ FSMerger::unlink_file(FSPath d)
 void
 FSMerger::unlink_sym(FSPath d)
 {
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_unlink_sym_pre") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_sym_pre")
                          ("UNLINK_TARGET", stringify(d))),
                 _imp->params.maybe_output_manager()).max_exit_status())
@@ -738,7 +1302,7 @@ FSMerger::unlink_sym(FSPath d)
 
     d.unlink();
 
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_unlink_sym_post") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_sym_post")
                          ("UNLINK_TARGET", stringify(d))),
                 _imp->params.maybe_output_manager()).max_exit_status())
@@ -749,7 +1313,7 @@ FSMerger::unlink_sym(FSPath d)
 void
 FSMerger::unlink_dir(FSPath d)
 {
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_unlink_dir_pre") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_dir_pre")
                          ("UNLINK_TARGET", stringify(d))),
                 _imp->params.maybe_output_manager()).max_exit_status())
@@ -758,7 +1322,7 @@ FSMerger::unlink_dir(FSPath d)
 
     d.rmdir();
 
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_unlink_dir_post") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_dir_post")
                          ("UNLINK_TARGET", stringify(d))),
                 _imp->params.maybe_output_manager()).max_exit_status())
@@ -769,7 +1333,7 @@ FSMerger::unlink_dir(FSPath d)
 void
 FSMerger::unlink_misc(FSPath d)
 {
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_unlink_misc_pre") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_misc_pre")
                          ("UNLINK_TARGET", stringify(d))),
                 _imp->params.maybe_output_manager()).max_exit_status())
@@ -778,7 +1342,7 @@ FSMerger::unlink_misc(FSPath d)
 
     d.unlink();
 
-    if (0 != _imp->params.environment()->perform_hook(extend_hook(
+    if (want_hook("merger_unlink_misc_post") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_misc_post")
                          ("UNLINK_TARGET", stringify(d))),
                 _imp->params.maybe_output_manager()).max_exit_status())
@@ -892,39 +1456,49 @@ FSMerger::try_to_copy_xattrs(const FSPath &, int, FSMergerStatusFlags &)
 void
 FSMerger::track_install_file(const FSPath & src, const FSPath & dst_dir, const std::string & dst_name, const FSMergerStatusFlags & flags)
 {
-    if (flags[msi_unselected_part])
-        return display_merge(et_file, dst_dir / src.basename(), flags,
-                             src.basename() == dst_name ? "" : dst_name);
-
-    _imp->params.merged_entries()->insert(dst_dir / dst_name);
-    record_install_file(src, dst_dir, dst_name, flags);
+    in_order([this, src, dst_dir, dst_name, flags] () {
+            if (flags[msi_unselected_part])
+                return display_merge(et_file, dst_dir / src.basename(), flags,
+                                     src.basename() == dst_name ? "" : dst_name);
+
+            _imp->params.merged_entries()->insert(dst_dir / dst_name);
+            record_install_file(src, dst_dir, dst_name, flags);
+            });
 }
 
 void
 FSMerger::track_install_dir(const FSPath & src, const FSPath & dst_dir, const FSMergerStatusFlags & flags)
 {
-    if (flags[msi_unselected_part])
-        return display_merge(et_dir, dst_dir / src.basename(), flags);
-
-    _imp->params.merged_entries()->insert(dst_dir / src.basename());
-    record_install_dir(src, dst_dir, flags);
+    in_order([this, src, dst_dir, flags] () {
+            if (flags[msi_unselected_part])
+                return display_merge(et_dir, dst_dir / src.basename(), flags);
+
+            _imp->params.merged_entries()->insert(dst_dir / src.basename());
+            _imp->note_written(dst_dir);
+            record_install_dir(src, dst_dir, flags);
+            });
 }
 
 void
 FSMerger::track_install_under_dir(const FSPath & dst, const FSMergerStatusFlags & flags)
 {
-    _imp->params.merged_entries()->insert(dst);
-    record_install_under_dir(dst, flags);
+    in_order([this, dst, flags] () {
+            _imp->params.merged_entries()->insert(dst);
+            record_install_under_dir(dst, flags);
+            });
 }
 
 void
 FSMerger::track_install_sym(const FSPath & src, const FSPath & dst_dir, const FSMergerStatusFlags & flags)
 {
-    if (flags[msi_unselected_part])
-        return display_merge(et_sym, dst_dir / src.basename(), flags);
-
-    _imp->params.merged_entries()->insert(dst_dir / src.basename());
-    record_install_sym(src, dst_dir, flags);
+    in_order([this, src, dst_dir, flags] () {
+            if (flags[msi_unselected_part])
+                return display_merge(et_sym, dst_dir / src.basename(), flags);
+
+            _imp->params.merged_entries()->insert(dst_dir / src.basename());
+            _imp->note_written(dst_dir);
+            record_install_sym(src, dst_dir, flags);
+            });
 }
 
 void
@@ -1104,6 +1678,18 @@ FSMerger::make_arrows(const FSMergerStatusFlags & flags) const
                 result[1] = '&';
                 continue;
 
+            case msi_reflinked:
+                result[1] = '=';
+                continue;
+
+            case msi_copy_file_range:
+                result[1] = ':';
+                continue;
+
+            case msi_sendfile:
+                result[1] = '.';
+                continue;
+
             case msi_fixed_ownership:
                 result[2] = '~';
                 continue;
@@ -30,6 +30,7 @@
 #include <paludis/environment-fwd.hh>
 #include <paludis/hook-fwd.hh>
 #include <paludis/partitioning-fwd.hh>
+#include <functional>
 #include <iosfwd>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -49,6 +50,7 @@ namespace paludis
 {
     namespace n
     {
+        typedef Name<struct name_durability> durability;
         typedef Name<struct name_environment> environment;
         typedef Name<struct name_fix_mtimes_before> fix_mtimes_before;
         typedef Name<struct name_fs_merger_options> fs_merger_options;
@@ -76,6 +78,13 @@ namespace paludis
      */
     struct FSMergerParams
     {
+        /**
+         * Whether to sync what we merge, and how.
+         *
+         * \since 3.0
+         */
+        NamedValue<n::durability, FSMergerDurability> durability;
+
         NamedValue<n::environment, Environment *> environment;
 
         /**
@@ -156,6 +165,14 @@ namespace paludis
             void relabel_dir_recursive(const FSPath &, const FSPath &);
             void try_to_copy_xattrs(const FSPath &, int, FSMergerStatusFlags &);
 
+            struct FileInstall;
+            bool start_install_file(FileInstall &);
+            void copy_installed_file(FileInstall &);
+            FSMergerStatusFlags finish_install_file(FileInstall &);
+            void install_and_track_file(const FSPath &, const FSPath &, const std::string &, const FSMergerStatusFlags &);
+            void in_order(const std::function<void ()> &);
+            void note_image_md5(const FSPath &);
+
             Pimp<FSMerger> _imp;
 
         protected:
@@ -225,8 +242,20 @@ namespace paludis
 
             virtual void do_dir_recursive(bool is_check, const FSPath &, const FSPath &);
 
+            virtual void on_done_merge();
+
             ///\}
 
+            /**
+             * Sync a file that describes what we merged, such as a contents
+             * file, or the directory holding it, if our durability policy says
+             * that we should. Call this once it is complete, and after merge()
+             * has synced the things it describes.
+             *
+             * \since 3.0
+             */
+            void make_durable(const FSPath &);
+
             ///\name Configuration protection
             ///\{
 
@@ -235,6 +264,27 @@ namespace paludis
 
             ///\}
 
+            ///\name File digests
+            ///\{
+
+            /**
+             * Will record_install_file want the MD5 of every file? If so, we
+             * work it out whilst we're copying the file, where we can.
+             *
+             * \since 3.0
+             */
+            virtual bool want_file_md5s() const;
+
+            /**
+             * The MD5 of a file in the image or one that we have installed,
+             * which is only read if we don't already know its digest.
+             *
+             * \since 3.0
+             */
+            std::string file_md5(const FSPath &);
+
+            ///\}
+
             virtual std::string make_arrows(const FSMergerStatusFlags & flags) const;
             virtual void display_merge(const EntryType &, const FSPath &,
                                        const FSMergerStatusFlags &,
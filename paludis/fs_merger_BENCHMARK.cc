@@ -0,0 +1,312 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/*
+ * Times FSMerger installing a synthetic image, in the case where the image
+ * cannot simply be renamed into place, and reports how each file's data was
+ * copied. For comparison, it also times copying the same image with a plain
+ * 4096 byte read and write loop, which is what FSMerger used to do.
+ *
+ * Usage:
+ *
+ *     fs_merger_BENCHMARK [megabytes [image-parent [root-parent]]]
+ *
+ * The default is a 256 MiB image, with the image and root created in the
+ * current directory. To see the behaviour which matters most, use an image
+ * of several GiB, and put the image and root on different filesystems, for
+ * example with a root on btrfs or xfs to try reflinking, or an image on a
+ * tmpfs. Times for the default durability policy do not include writing the
+ * copied data back to disk, since that depends upon the disk rather than on
+ * how we copied. The merge is then repeated with each of the other
+ * durability policies, whose times do include it.
+ */
+
+#include <paludis/fs_merger.hh>
+#include <paludis/merger.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_iterator.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/fd_holder.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/return_literal_function.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/timestamp.hh>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace paludis;
+
+namespace
+{
+    const std::size_t mib(1024 * 1024);
+
+    template <typename F_>
+    double time_ms(const F_ & f)
+    {
+        auto start(std::chrono::steady_clock::now());
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::pair<uid_t, gid_t> get_new_ids_or_minus_one(const FSPath &)
+    {
+        return std::make_pair(-1, -1);
+    }
+
+    struct CountingMerger :
+        FSMerger
+    {
+        int reflinked, copy_file_range, sendfile, read_write;
+
+        CountingMerger(const FSMergerParams & p) :
+            FSMerger(p),
+            reflinked(0),
+            copy_file_range(0),
+            sendfile(0),
+            read_write(0)
+        {
+        }
+
+        void record_install_file(const FSPath &, const FSPath &, const std::string &, const FSMergerStatusFlags & flags) override
+        {
+            if (flags[msi_reflinked])
+                ++reflinked;
+            else if (flags[msi_copy_file_range])
+                ++copy_file_range;
+            else if (flags[msi_sendfile])
+                ++sendfile;
+            else
+                ++read_write;
+        }
+
+        void record_install_dir(const FSPath &, const FSPath &, const FSMergerStatusFlags &) override
+        {
+        }
+
+        void record_install_sym(const FSPath &, const FSPath &, const FSMergerStatusFlags &) override
+        {
+        }
+
+        void record_install_under_dir(const FSPath &, const FSMergerStatusFlags &) override
+        {
+        }
+
+        void on_error(bool, const std::string & s) override
+        {
+            throw FSMergerError(s);
+        }
+
+        void on_warn(bool, const std::string &) override
+        {
+        }
+
+        void display_override(const std::string &) const override
+        {
+        }
+
+        bool config_protected(const FSPath &, const FSPath &) override
+        {
+            return false;
+        }
+
+        std::string make_config_protect_name(const FSPath & src, const FSPath &) override
+        {
+            return src.basename() + ".cfgpro";
+        }
+    };
+
+    void write_file(const FSPath & f, const std::vector<char> & data, std::size_t size)
+    {
+        FDHolder fd(::open(stringify(f).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644), false);
+        if (-1 == fd)
+            throw FSError("Cannot create '" + stringify(f) + "': " + ::strerror(errno));
+
+        while (size > 0)
+        {
+            ssize_t count(::write(fd, data.data(), std::min(size, data.size())));
+            if (-1 == count)
+                throw FSError("Cannot write '" + stringify(f) + "': " + ::strerror(errno));
+            size -= count;
+        }
+    }
+
+    /* half of the image is in a few large files, and half is in many small
+     * files in a few directories, which is roughly what a big package with
+     * lots of headers or data files looks like */
+    std::size_t make_image(const FSPath & image, const std::size_t size)
+    {
+        std::vector<char> data(mib);
+        std::mt19937 random(0);
+        for (auto & c : data)
+            c = static_cast<char>(random());
+
+        image.mkdir(0755, { fspmkdo_ok_if_exists });
+        FSPath big(image / "big"), small(image / "small");
+        big.mkdir(0755, { });
+        small.mkdir(0755, { });
+
+        std::size_t done(0), big_size(std::max(mib, std::min(64 * mib, size / 8))), n(0);
+        for ( ; done < size / 2 ; done += big_size)
+            write_file(big / ("file" + stringify(n++)), data, big_size);
+
+        const std::size_t small_size(16 * 1024);
+        for (n = 0 ; done < size ; done += small_size, ++n)
+        {
+            FSPath dir(small / ("dir" + stringify(n / 100)));
+            if (0 == n % 100)
+                dir.mkdir(0755, { });
+            write_file(dir / ("file" + stringify(n % 100)), data, small_size);
+        }
+
+        return done;
+    }
+
+    void remove_recursive(const FSPath & f)
+    {
+        FSStat f_stat(f);
+        if (f_stat.is_directory())
+        {
+            for (FSIterator d(f, { fsio_include_dotfiles }), d_end ; d != d_end ; ++d)
+                remove_recursive(*d);
+            f.rmdir();
+        }
+        else if (f_stat.exists())
+            f.unlink();
+    }
+
+    void copy_with_small_buffer(const FSPath & src, const FSPath & dst)
+    {
+        for (FSIterator d(src, { fsio_include_dotfiles }), d_end ; d != d_end ; ++d)
+        {
+            FSPath target(dst / d->basename());
+            if (d->stat().is_directory())
+            {
+                target.mkdir(0755, { });
+                copy_with_small_buffer(*d, target);
+                continue;
+            }
+
+            FDHolder input_fd(::open(stringify(*d).c_str(), O_RDONLY), false);
+            FDHolder output_fd(::open(stringify(target).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644), false);
+            if (-1 == input_fd || -1 == output_fd)
+                throw FSError("Cannot copy '" + stringify(*d) + "': " + ::strerror(errno));
+
+            char buf[4096];
+            ssize_t count;
+            while ((count = ::read(input_fd, buf, 4096)) > 0)
+                if (-1 == ::write(output_fd, buf, count))
+                    throw FSError("Cannot write '" + stringify(target) + "': " + ::strerror(errno));
+        }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    std::size_t size((argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256) * mib);
+    FSPath image_parent(argc > 2 ? argv[2] : "."), root_parent(argc > 3 ? argv[3] : ".");
+
+    FSPath image(image_parent.realpath() / ("fs_merger_BENCHMARK_image." + stringify(::getpid())));
+    FSPath root(root_parent.realpath() / ("fs_merger_BENCHMARK_root." + stringify(::getpid())));
+
+    std::cout << "Creating image in " << image << "..." << std::endl;
+    size = make_image(image, size);
+    ::sync();
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    try
+    {
+        root.mkdir(0755, { });
+
+        double read_write_ms(time_ms([&] () { copy_with_small_buffer(image, root); }));
+        std::cout << "4096 byte read/write:  " << std::setw(9) << read_write_ms << " ms, "
+            << std::setw(8) << (size / mib) / (read_write_ms / 1000) << " MiB/s" << std::endl;
+
+        TestEnvironment env;
+        for (FSMergerDurability d(fsmd_none) ; d != last_fsmd ; d = FSMergerDurability(d + 1))
+        {
+            remove_recursive(root);
+            root.mkdir(0755, { });
+            ::sync();
+
+            CountingMerger merger(make_named_values<FSMergerParams>(
+                        n::durability() = d,
+                        n::environment() = &env,
+                        n::fix_mtimes_before() = Timestamp(0, 0),
+                        n::fs_merger_options() = FSMergerOptions(),
+                        n::get_new_ids_or_minus_one() = &get_new_ids_or_minus_one,
+                        n::image() = image,
+                        n::install_under() = FSPath("/"),
+                        n::maybe_output_manager() = nullptr,
+                        n::merged_entries() = std::make_shared<FSPathSet>(),
+                        n::no_chown() = true,
+                        n::options() = MergerOptions() + mo_nondestructive,
+                        n::parts() = nullptr,
+                        n::permit_destination() = std::bind(return_literal_function(true)),
+                        n::root() = root,
+                        n::should_merge() = nullptr
+                        ));
+
+            double merge_ms(time_ms([&] () {
+                        if (! merger.check())
+                            throw FSMergerError("Merge check failed");
+                        merger.merge();
+                        }));
+
+            std::cout << "FSMerger, " << std::left << std::setw(13) << (stringify(d) + ":") << std::right
+                << std::setw(9) << merge_ms << " ms, " << std::setw(8) << (size / mib) / (merge_ms / 1000) << " MiB/s" << std::endl;
+
+            if (fsmd_none == d)
+            {
+                std::cout << "    files reflinked:       " << merger.reflinked << std::endl;
+                std::cout << "    files copy_file_range: " << merger.copy_file_range << std::endl;
+                std::cout << "    files sendfile:        " << merger.sendfile << std::endl;
+                std::cout << "    files read/write:      " << merger.read_write << std::endl;
+            }
+        }
+    }
+    catch (...)
+    {
+        remove_recursive(root);
+        remove_recursive(image);
+        throw;
+    }
+
+    remove_recursive(root);
+    remove_recursive(image);
+
+    return EXIT_SUCCESS;
+}
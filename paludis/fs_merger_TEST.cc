@@ -26,6 +26,7 @@
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
 #include <paludis/util/set.hh>
 #include <paludis/util/timestamp.hh>
 #include <paludis/util/fs_stat.hh>
@@ -34,10 +35,16 @@
 #include <paludis/util/fs_error.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/return_literal_function.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/md5.hh>
 
+#include <cstdlib>
+#include <unistd.h>
 #include <functional>
 #include <iterator>
 #include <list>
+#include <map>
+#include <sstream>
 
 #include <gtest/gtest.h>
 
@@ -51,6 +58,12 @@ namespace
         return std::make_pair(-1, -1);
     }
 
+    std::pair<uid_t, gid_t>
+    get_own_ids(const FSPath &)
+    {
+        return std::make_pair(::getuid(), ::getgid());
+    }
+
     bool
     timestamps_nearly_equal(const Timestamp & i_set, const Timestamp & reference)
     {
@@ -105,16 +118,31 @@ namespace
         {
         }
 
-        void record_install_file(const FSPath &, const FSPath &, const std::string &, const FSMergerStatusFlags &) override
+        std::list<std::string> recorded;
+        mutable std::list<std::string> displayed;
+        bool want_md5s = false;
+        std::map<std::string, std::string> md5s;
+
+        bool want_file_md5s() const override
+        {
+            return want_md5s;
+        }
+
+        void record_install_file(const FSPath &, const FSPath & dst_dir, const std::string & dst_name, const FSMergerStatusFlags &) override
         {
+            recorded.push_back(stringify(dst_dir / dst_name));
+            if (want_md5s)
+                md5s[stringify(dst_dir / dst_name)] = file_md5(dst_dir / dst_name);
         }
 
-        void record_install_dir(const FSPath &, const FSPath &, const FSMergerStatusFlags &) override
+        void record_install_dir(const FSPath & src, const FSPath & dst_dir, const FSMergerStatusFlags &) override
         {
+            recorded.push_back(stringify(dst_dir / src.basename()));
         }
 
-        void record_install_sym(const FSPath &, const FSPath &, const FSMergerStatusFlags &) override
+        void record_install_sym(const FSPath & src, const FSPath & dst_dir, const FSMergerStatusFlags &) override
         {
+            recorded.push_back(stringify(dst_dir / src.basename()));
         }
 
         void record_install_under_dir(const FSPath &, const FSMergerStatusFlags &) override
@@ -133,8 +161,9 @@ namespace
         {
         }
 
-        void display_override(const std::string &) const override
+        void display_override(const std::string & message) const override
         {
+            displayed.push_back(stringify(recorded.size()) + " " + message.substr(0, message.find(" in ")));
         }
 
         bool config_protected(const FSPath &, const FSPath &) override
@@ -162,6 +191,7 @@ namespace
                     + (0 == n ? "" : "_" + stringify(n)) + "_dir/root"),
             env(FSPath("fs_merger_TEST_dir/hooks")),
             merger(make_named_values<FSMergerParams>(
+                        n::durability() = fsmd_none,
                         n::environment() = &env,
                         n::fix_mtimes_before() = Timestamp(0, 0),
                         n::fs_merger_options() = FSMergerOptions(),
@@ -182,20 +212,24 @@ namespace
 
         MergerAndFriends(const std::string & custom_test,
                 const MergerOptions & o = MergerOptions() + mo_rewrite_symlinks + mo_allow_empty_dirs,
-                const bool fix = false) :
+                const bool fix = false,
+                const FSMergerDurability durability = fsmd_none,
+                const bool chown = false,
+                const std::string & hooks = "hooks") :
             image_dir("fs_merger_TEST_dir/" + custom_test + "/image"),
             root_dir("fs_merger_TEST_dir/" + custom_test + "/root"),
-            env(FSPath("fs_merger_TEST_dir/hooks")),
+            env(FSPath("fs_merger_TEST_dir/" + hooks)),
             merger(make_named_values<FSMergerParams>(
+                    n::durability() = durability,
                     n::environment() = &env,
                     n::fix_mtimes_before() = fix ? FSPath("fs_merger_TEST_dir/reference").stat().mtim() : Timestamp(0, 0),
                     n::fs_merger_options() = FSMergerOptions(),
-                    n::get_new_ids_or_minus_one() = &get_new_ids_or_minus_one,
+                    n::get_new_ids_or_minus_one() = chown ? &get_own_ids : &get_new_ids_or_minus_one,
                     n::image() = image_dir,
                     n::install_under() = FSPath("/"),
                     n::maybe_output_manager() = nullptr,
                     n::merged_entries() = std::make_shared<FSPathSet>(),
-                    n::no_chown() = true,
+                    n::no_chown() = ! chown,
                     n::options() = o,
                     n::parts() = nullptr,
                     n::permit_destination() = std::bind(return_literal_function(true)),
@@ -213,9 +247,12 @@ namespace
 
     std::shared_ptr<MergerAndFriends> make_merger(const std::string & custom_test,
                 const MergerOptions & o = MergerOptions() + mo_rewrite_symlinks + mo_allow_empty_dirs,
-                const bool fix = false)
+                const bool fix = false,
+                const FSMergerDurability durability = fsmd_none,
+                const bool chown = false,
+                const std::string & hooks = "hooks")
     {
-        return std::make_shared<MergerAndFriends>(custom_test, o, fix);
+        return std::make_shared<MergerAndFriends>(custom_test, o, fix, durability, chown, hooks);
     }
 }
 
@@ -444,6 +481,22 @@ TEST(Merger, Override)
     ASSERT_TRUE((data->root_dir / "sym_install_me").stat().is_symlink());
 }
 
+TEST(Merger, OverrideBatch)
+{
+    auto data(make_merger("batch_override"));
+
+    ASSERT_TRUE(data->merger.check());
+    data->merger.merge();
+
+    ASSERT_TRUE(! (data->root_dir / "batch_skip_me").stat().exists());
+    ASSERT_TRUE((data->root_dir / "file_install_me").stat().is_regular_file());
+    ASSERT_TRUE(! (data->root_dir / "sym_batch_skip_me").stat().exists());
+    ASSERT_TRUE(! (data->root_dir / "dir_batch_skip_me").stat().exists());
+    ASSERT_TRUE((data->root_dir / "dir").stat().is_directory());
+    ASSERT_TRUE(! (data->root_dir / "dir" / "batch_skip_me").stat().exists());
+    ASSERT_TRUE((data->root_dir / "dir" / "file_install_me").stat().is_regular_file());
+}
+
 TEST(Merger, EmptyDirAllowed)
 {
     auto data(make_merger("empty_dir_allowed", { mo_allow_empty_dirs }));
@@ -512,3 +565,134 @@ TEST(Merger, MtimesFixes)
     ASSERT_TRUE(timestamps_nearly_equal((data->root_dir / "dir" / "dodgy_file").stat().mtim(), FSPath("fs_merger_TEST_dir/reference").stat().mtim()));
 }
 
+TEST(Merger, OwnershipFixesUseCurrentMode)
+{
+    auto data(make_merger("ownership_mode", { mo_allow_empty_dirs }, false, fsmd_none, true));
+
+    ASSERT_TRUE(data->merger.check());
+
+    /* this doesn't change the directory's mtime, so the merge reuses what
+     * check saw of it */
+    (data->image_dir / "file").chmod(0755);
+    data->merger.merge();
+
+    EXPECT_EQ(mode_t(0755), (data->root_dir / "file").stat().permissions() & 07777);
+}
+
+namespace
+{
+    void expected_merge_order(const FSPath & src, const FSPath & dst, std::list<std::string> & result)
+    {
+        for (FSIterator d(src, { fsio_include_dotfiles, fsio_inode_sort }), d_end ; d != d_end ; ++d)
+        {
+            result.push_back(stringify(dst / d->basename()));
+            if (d->stat().is_directory())
+                expected_merge_order(*d, dst / d->basename(), result);
+        }
+    }
+
+    std::string file_contents(const FSPath & f)
+    {
+        SafeIFStream s(f);
+        return std::string((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
+    }
+}
+
+TEST(Merger, Jobs)
+{
+    auto data(make_merger("jobs", { mo_nondestructive, mo_allow_empty_dirs }));
+
+    std::list<std::string> expected;
+    expected_merge_order(data->image_dir, data->root_dir.realpath(), expected);
+
+    data->merger.want_md5s = true;
+    ::setenv("PALUDIS_MERGE_JOBS", "4", 1);
+    ASSERT_TRUE(data->merger.check());
+    data->merger.merge();
+    ::unsetenv("PALUDIS_MERGE_JOBS");
+
+    EXPECT_EQ(join(expected.begin(), expected.end(), " "), join(data->merger.recorded.begin(), data->merger.recorded.end(), " "));
+
+    for (int n(1) ; n <= 20 ; ++n)
+    {
+        EXPECT_EQ("file " + stringify(n) + "\n", file_contents(data->root_dir / ("file_" + stringify(n))));
+        EXPECT_EQ("dir file " + stringify(n) + "\n", file_contents(data->root_dir / "dir" / ("file_" + stringify(n))));
+    }
+
+    EXPECT_EQ(41u, data->merger.md5s.size());
+    for (const auto & m : data->merger.md5s)
+    {
+        std::stringstream contents(file_contents(FSPath(m.first)));
+        EXPECT_EQ(MD5(contents).hexsum(), m.second);
+    }
+
+    EXPECT_TRUE((data->root_dir / "sym").stat().is_symlink());
+    EXPECT_TRUE((data->root_dir / "file_1").stat().lowlevel_id() == (data->root_dir / "dir" / "link").stat().lowlevel_id());
+}
+
+TEST(Merger, MD5sAfterImageChange)
+{
+    auto data(make_merger("md5_changed", { mo_nondestructive, mo_allow_empty_dirs }));
+
+    data->merger.want_md5s = true;
+    ASSERT_TRUE(data->merger.check());
+
+    /* a digest worked out during the check mustn't be used if the image
+     * changed afterwards */
+    {
+        SafeOFStream f(data->image_dir / "file", -1, true);
+        f << "changed since the check" << std::endl;
+    }
+    data->merger.merge();
+
+    std::stringstream unchanged(file_contents(data->root_dir / "unchanged")), changed(file_contents(data->root_dir / "file"));
+    EXPECT_EQ(MD5(unchanged).hexsum(), data->merger.md5s[stringify(data->root_dir.realpath() / "unchanged")]);
+    EXPECT_EQ(MD5(changed).hexsum(), data->merger.md5s[stringify(data->root_dir.realpath() / "file")]);
+    EXPECT_EQ("changed since the check\n", file_contents(data->root_dir / "file"));
+}
+
+TEST(Merger, JobsHooks)
+{
+    auto data(make_merger("jobs_hooks", { mo_nondestructive, mo_allow_empty_dirs }, false, fsmd_none, false, "jobs_hooks/hooks"));
+
+    ::setenv("JOBS_HOOKS_LOG", stringify(FSPath("fs_merger_TEST_dir/jobs_hooks").realpath() / "log").c_str(), 1);
+    ::setenv("PALUDIS_MERGE_JOBS", "4", 1);
+    ASSERT_TRUE(data->merger.check());
+    data->merger.merge();
+    ::unsetenv("PALUDIS_MERGE_JOBS");
+    ::unsetenv("JOBS_HOOKS_LOG");
+
+    /* each entry's post hook has to come straight after its pre hook */
+    std::stringstream log(file_contents(FSPath("fs_merger_TEST_dir/jobs_hooks/log")));
+    std::string pre, post;
+    int n(0);
+    while (std::getline(log, pre))
+    {
+        ASSERT_TRUE(bool(std::getline(log, post)));
+        ASSERT_EQ(0u, pre.find("pre "));
+        EXPECT_EQ("post " + pre.substr(4), post);
+        ++n;
+    }
+    EXPECT_EQ(42, n);
+}
+
+TEST(Merger, Durability)
+{
+    for (FSMergerDurability d(fsmd_none) ; d != last_fsmd ; d = FSMergerDurability(d + 1))
+    {
+        auto data(make_merger("durability_" + stringify(d), { mo_nondestructive, mo_allow_empty_dirs }, false, d));
+
+        ASSERT_TRUE(data->merger.check());
+        data->merger.merge();
+
+        EXPECT_EQ("file\n", file_contents(data->root_dir / "file"));
+        EXPECT_EQ("dir file\n", file_contents(data->root_dir / "dir" / "file"));
+
+        /* the sync has to come after everything has been installed, and
+         * before merge() returns, so that callers can rely upon it */
+        if (fsmd_none == d)
+            EXPECT_EQ("", join(data->merger.displayed.begin(), data->merger.displayed.end(), ", "));
+        else
+            EXPECT_EQ("3 >>> Synced 1 filesystems", join(data->merger.displayed.begin(), data->merger.displayed.end(), ", "));
+    }
+}
@@ -110,12 +110,63 @@ touch -d '3 years ago' mtimes_fix/image/dodgy_file
 touch -d '3 years ago' mtimes_fix/image/dir/dodgy_file
 > mtimes_fix/root/existing_file
 
+mkdir -p jobs/{image/dir,root}
+for n in $(seq 1 20); do
+    echo "file ${n}" > jobs/image/file_${n}
+    echo "dir file ${n}" > jobs/image/dir/file_${n}
+done
+ln jobs/image/file_1 jobs/image/dir/link
+ln -s file_2 jobs/image/sym
+
+mkdir -p md5_changed/{image,root}
+echo "file" > md5_changed/image/file
+echo "unchanged" > md5_changed/image/unchanged
+
+mkdir -p jobs_hooks/{image/dir,root,hooks}
+for n in $(seq 1 20); do
+    echo "file ${n}" > jobs_hooks/image/file_${n}
+    echo "dir file ${n}" > jobs_hooks/image/dir/file_${n}
+done
+ln -s file_2 jobs_hooks/image/sym
+cat <<"END" > jobs_hooks/hooks/log.bash
+#!/usr/bin/env bash
+echo "${HOOK##*_} ${INSTALL_DESTINATION}" >> "${JOBS_HOOKS_LOG}"
+END
+chmod +x jobs_hooks/hooks/log.bash
+for h in merger_install_{file,dir,sym}_{pre,post}; do
+    mkdir jobs_hooks/hooks/${h}
+    ln -s ../log.bash jobs_hooks/hooks/${h}/log.bash
+done
+
+for d in none batched per_file; do
+    mkdir -p durability_${d}/{image/dir,root}
+    echo "file" > durability_${d}/image/file
+    echo "dir file" > durability_${d}/image/dir/file
+done
+
+mkdir -p ownership_mode/{image,root}
+echo "file" > ownership_mode/image/file
+chmod 0644 ownership_mode/image/file
+touch -d '1 hour ago' ownership_mode/image
+
+mkdir -p batch_override/{image/dir,root}
+> batch_override/image/batch_skip_me
+> batch_override/image/file_install_me
+ln -s file_install_me batch_override/image/sym_batch_skip_me
+mkdir batch_override/image/dir_batch_skip_me
+> batch_override/image/dir_batch_skip_me/file
+> batch_override/image/dir/batch_skip_me
+> batch_override/image/dir/file_install_me
+mkdir batch_override/root/dir
+> batch_override/root/dir/existing
+
 mkdir hooks
 cd hooks
 mkdir \
 merger_install_file_override \
 merger_install_sym_override \
-merger_install_dir_override
+merger_install_dir_override \
+merger_install_override_batch
 
 cat <<"END" > universal_override.hook
 hook_run_merger_install_file_override() {
@@ -140,3 +191,13 @@ chmod +x universal_override.hook
 for dir in merger_install_*_override; do
     ln -s ../universal_override.hook  ${dir}
 done
+
+cat <<"END" > merger_install_override_batch/batch_override.bash
+while read -r type path ; do
+    if [[ "${path}" == *"/batch_skip_me" ]] || [[ "${path}" == *"_batch_skip_me" ]]; then
+        echo "skip ${path}"
+    fi
+done
+true
+END
+chmod +x merger_install_override_batch/batch_override.bash
@@ -39,12 +39,14 @@ namespace paludis
         std::string name;
         std::map<std::string, std::string> extra_env;
         std::set<std::string> allowed_values;
+        std::string input;
 
         Imp(const std::string & n, const std::map<std::string, std::string> & e,
-                const std::set<std::string> & av) :
+                const std::set<std::string> & av, const std::string & i) :
             name(n),
             extra_env(e),
-            allowed_values(av)
+            allowed_values(av),
+            input(i)
         {
         }
     };
@@ -84,13 +86,13 @@ Hook::AllowedOutputValues::operator() (const std::string & v) const
 }
 
 Hook::Hook(const std::string & n) :
-    _imp(n, std::map<std::string, std::string>(), std::set<std::string>()),
+    _imp(n, std::map<std::string, std::string>(), std::set<std::string>(), ""),
     output_dest(hod_stdout)
 {
 }
 
 Hook::Hook(const Hook & h) :
-    _imp(h._imp->name, h._imp->extra_env, h._imp->allowed_values),
+    _imp(h._imp->name, h._imp->extra_env, h._imp->allowed_values, h._imp->input),
     output_dest(h.output_dest)
 {
 }
@@ -124,6 +126,29 @@ Hook::grab_output(const AllowedOutputValues & av)
     return result;
 }
 
+Hook
+Hook::grab_output_lines(const AllowedOutputValues & av)
+{
+    Hook result(*this);
+    result.output_dest = hod_grab_lines;
+    result._imp->allowed_values = av._imp->allowed_values;
+    return result;
+}
+
+Hook
+Hook::input(const std::string & i) const
+{
+    Hook result(*this);
+    result._imp->input = i;
+    return result;
+}
+
+const std::string
+Hook::input() const
+{
+    return _imp->input;
+}
+
 bool
 Hook::validate_value(const std::string & v) const
 {
@@ -133,6 +158,15 @@ Hook::validate_value(const std::string & v) const
         return (_imp->allowed_values.find(v) != _imp->allowed_values.end());
 }
 
+bool
+Hook::validate_line(const std::string & l) const
+{
+    std::string::size_type p(l.find(' '));
+    if (std::string::npos == p || 0 == p || l.length() == p + 1)
+        return false;
+    return validate_value(l.substr(0, p));
+}
+
 Hook::ConstIterator
 Hook::begin() const
 {
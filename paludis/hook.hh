@@ -102,8 +102,37 @@ namespace paludis
 
             Hook grab_output(const AllowedOutputValues & av);
 
+            /**
+             * Grab output as a number of lines, each of the form "value
+             * path", for hooks that are asked about many paths at once.
+             *
+             * \since 3.0
+             */
+            Hook grab_output_lines(const AllowedOutputValues & av);
+
+            /**
+             * Add data to be sent to the hook on standard input.
+             *
+             * \since 3.0
+             */
+            Hook input(const std::string &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Data to be sent to the hook on standard input.
+             *
+             * \since 3.0
+             */
+            const std::string input() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
             bool validate_value(const std::string & value) const;
 
+            /**
+             * Is a line of output from a hook using grab_output_lines valid?
+             *
+             * \since 3.0
+             */
+            bool validate_line(const std::string & line) const;
+
             ///\name Iterate over environment data
             ///\{
 
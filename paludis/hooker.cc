@@ -43,6 +43,9 @@
 #include <paludis/util/env_var_names.hh>
 
 #include <list>
+#include <map>
+#include <set>
+#include <sstream>
 #include <iterator>
 #include <mutex>
 #include <dlfcn.h>
@@ -184,6 +187,10 @@ BashHookFile::run(
     for (Hook::ConstIterator x(hook.begin()), x_end(hook.end()) ; x != x_end ; ++x)
         process.setenv(x->first, x->second);
 
+    std::istringstream input(hook.input());
+    if (! hook.input().empty())
+        process.send_input_to_fd(input, 0, "");
+
     if (optional_output_manager)
     {
         /* hod_grab can override this later */
@@ -193,7 +200,7 @@ BashHookFile::run(
 
     int exit_status(0);
     std::string output("");
-    if (hook.output_dest == hod_grab)
+    if (hook.output_dest == hod_grab || hook.output_dest == hod_grab_lines)
     {
         std::stringstream s;
         process.capture_stdout(s);
@@ -245,6 +252,10 @@ FancyHookFile::run(const Hook & hook,
     for (Hook::ConstIterator x(hook.begin()), x_end(hook.end()) ; x != x_end ; ++x)
         process.setenv(x->first, x->second);
 
+    std::istringstream input(hook.input());
+    if (! hook.input().empty())
+        process.send_input_to_fd(input, 0, "");
+
     if (optional_output_manager)
     {
         /* hod_grab can override this later */
@@ -254,7 +265,7 @@ FancyHookFile::run(const Hook & hook,
 
     int exit_status(0);
     std::string output("");
-    if (hook.output_dest == hod_grab)
+    if (hook.output_dest == hod_grab || hook.output_dest == hod_grab_lines)
     {
         std::stringstream s;
         process.capture_stdout(s);
@@ -470,6 +481,7 @@ namespace paludis
         mutable std::map<std::string, std::shared_ptr<Sequence<std::shared_ptr<HookFile> > > > hook_files;
         mutable std::map<std::string, std::map<std::string, std::shared_ptr<HookFile> > > auto_hook_files;
         mutable bool has_auto_hook_files;
+        mutable std::map<std::string, bool> has_hook_files;
 
         Imp(const Environment * const e) :
             env(e),
@@ -540,6 +552,8 @@ Hooker::add_dir(const FSPath & dir, const bool v)
     std::unique_lock<std::recursive_mutex> l(_imp->hook_files_mutex);
     _imp->hook_files.clear();
     _imp->auto_hook_files.clear();
+    _imp->has_auto_hook_files = false;
+    _imp->has_hook_files.clear();
     _imp->dirs.push_back(std::make_pair(dir, v));
 }
 
@@ -568,13 +582,47 @@ namespace
     };
 }
 
+namespace
+{
+    std::set<std::string> get_ignore_hooks()
+    {
+        std::set<std::string> result;
+        tokenise<delim_kind::AnyOfTag, delim_mode::DelimiterTag>(getenv_with_default(env_vars::ignore_hooks_named, ""),
+                ":", "", std::inserter(result, result.begin()));
+        return result;
+    }
+
+    bool is_hook_file(const FSPath & f)
+    {
+        return is_file_with_extension(f, ".bash", { }) || is_file_with_extension(f, ".hook", { }) ||
+            is_file_with_extension(f, so_suffix, { }) || is_file_with_extension(f, ".py", { });
+    }
+}
+
+namespace
+{
+    void add_output_lines(const Hook & hook, HookResult & result, const HookResult & tmp)
+    {
+        result.max_exit_status() = std::max(result.max_exit_status(), tmp.max_exit_status());
+        if (0 != tmp.max_exit_status())
+            return;
+
+        std::list<std::string> lines;
+        tokenise<delim_kind::AnyOfTag, delim_mode::DelimiterTag>(tmp.output(), "\n", "", std::back_inserter(lines));
+        for (const auto & line : lines)
+            if (hook.validate_line(line))
+                result.output().append(line + "\n");
+            else
+                Log::get_instance()->message("hook.bad_output", ll_warning, lc_context)
+                    << "Hook returned invalid output line: '" << line << "'";
+    }
+}
+
 std::shared_ptr<Sequence<std::shared_ptr<HookFile> > >
 Hooker::_find_hooks(const Hook & hook) const
 {
     std::map<std::string, std::shared_ptr<HookFile> > hook_files;
-    std::set<std::string> ignore_hooks;
-    tokenise<delim_kind::AnyOfTag, delim_mode::DelimiterTag>(getenv_with_default(env_vars::ignore_hooks_named, ""),
-            ":", "", std::inserter(ignore_hooks, ignore_hooks.begin()));
+    std::set<std::string> ignore_hooks(get_ignore_hooks());
 
     {
         _imp->need_auto_hook_files();
@@ -721,6 +769,47 @@ Hooker::_find_hooks(const Hook & hook) const
     return result;
 }
 
+bool
+Hooker::has_hooks(const std::string & name) const
+{
+    std::unique_lock<std::recursive_mutex> l(_imp->hook_files_mutex);
+
+    auto c(_imp->has_hook_files.find(name));
+    if (c != _imp->has_hook_files.end())
+        return c->second;
+
+    Context context("When looking for hooks named '" + name + "':");
+
+    bool result(false);
+
+    _imp->need_auto_hook_files();
+    auto a(_imp->auto_hook_files.find(name));
+    if (_imp->auto_hook_files.end() != a && ! a->second.empty())
+        result = true;
+
+    /* just look at names, since making HookFiles is more work than we need
+     * to know whether there are any */
+    if (! result)
+    {
+        std::set<std::string> ignore_hooks(get_ignore_hooks());
+        for (auto d(_imp->dirs.begin()), d_end(_imp->dirs.end()) ; d != d_end && ! result ; ++d)
+        {
+            if (! (d->first / name).stat().is_directory())
+                continue;
+
+            for (FSIterator e(d->first / name, { }), e_end ; e != e_end ; ++e)
+                if (ignore_hooks.end() == ignore_hooks.find(e->basename()) && is_hook_file(*e))
+                {
+                    result = true;
+                    break;
+                }
+        }
+    }
+
+    _imp->has_hook_files.insert(std::make_pair(name, result));
+    return result;
+}
+
 HookResult
 Hooker::perform_hook(
         const Hook & hook,
@@ -766,6 +855,11 @@ Hooker::perform_hook(
                 }
                 continue;
 
+            case hod_grab_lines:
+                for (const auto & repository : _imp->env->repositories())
+                    add_output_lines(hook, result, repository->perform_hook(hook, optional_output_manager));
+                continue;
+
             case last_hod:
                 ;
         }
@@ -825,6 +919,16 @@ Hooker::perform_hook(
                     }
                     continue;
 
+                case hod_grab_lines:
+                    for (Sequence<std::shared_ptr<HookFile> >::ConstIterator f(h->second->begin()),
+                            f_end(h->second->end()) ; f != f_end ; ++f)
+                        if ((*f)->file_name().stat().is_regular_file_or_symlink_to_regular_file())
+                            add_output_lines(hook, result, (*f)->run(hook, optional_output_manager));
+                        else
+                            Log::get_instance()->message("hook.not_regular_file", ll_warning, lc_context) << "Hook file '" <<
+                                (*f)->file_name() << "' is not a regular file or has been removed";
+                    continue;
+
                 case last_hod:
                     ;
             }
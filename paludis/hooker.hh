@@ -113,6 +113,16 @@ namespace paludis
                     const Hook &,
                     const std::shared_ptr<OutputManager> & optional_output_manager) const PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            /**
+             * Are there any hook files for hooks with this name? If not,
+             * perform_hook will only run repository hooks.
+             *
+             * The answer is cached until add_dir is next called.
+             *
+             * \since 3.0
+             */
+            bool has_hooks(const std::string & name) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
             /**
              * Add a new hook directory.
              */
@@ -24,8 +24,12 @@
 
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/tokeniser.hh>
 
 #include <iterator>
+#include <set>
+#include <cstdlib>
 
 #include <gtest/gtest.h>
 
@@ -63,6 +67,26 @@ TEST(Hooker, Works)
 
 }
 
+TEST(Hooker, HasHooks)
+{
+    TestEnvironment env;
+    Hooker hooker(&env);
+
+    hooker.add_dir(FSPath("hooker_TEST_dir/"), false);
+    EXPECT_TRUE(hooker.has_hooks("simple_hook"));
+    EXPECT_TRUE(hooker.has_hooks("fancy_hook"));
+    EXPECT_TRUE(hooker.has_hooks("so_hook"));
+    EXPECT_TRUE(hooker.has_hooks("several_hooks"));
+    EXPECT_FALSE(hooker.has_hooks("no_such_hook"));
+
+    ::setenv("PALUDIS_IGNORE_HOOKS_NAMED", "one.bash", 1);
+    Hooker ignoring_hooker(&env);
+    ignoring_hooker.add_dir(FSPath("hooker_TEST_dir/"), false);
+    EXPECT_FALSE(ignoring_hooker.has_hooks("simple_hook"));
+    EXPECT_TRUE(ignoring_hooker.has_hooks("fancy_hook"));
+    ::unsetenv("PALUDIS_IGNORE_HOOKS_NAMED");
+}
+
 TEST(Hooker, Ordering)
 {
     TestEnvironment env;
@@ -192,6 +216,51 @@ TEST(Hooker, Output)
 
 }
 
+TEST(Hooker, OutputLines)
+{
+    TestEnvironment env;
+    Hooker hooker(&env);
+
+    hooker.add_dir(FSPath("hooker_TEST_dir/"), false);
+    HookResult result(hooker.perform_hook(Hook("batch_hook")
+                .input("file /a/skip_me\nfile /a/force_me\nfile /a/leave_me\n")
+                .grab_output_lines(Hook::AllowedOutputValues()("skip")("force")),
+                nullptr));
+    EXPECT_EQ(0, result.max_exit_status());
+
+    std::set<std::string> lines;
+    tokenise<delim_kind::AnyOfTag, delim_mode::DelimiterTag>(result.output(), "\n", "", std::inserter(lines, lines.begin()));
+    EXPECT_EQ(2u, lines.size());
+    EXPECT_TRUE(lines.end() != lines.find("skip /a/skip_me"));
+    EXPECT_TRUE(lines.end() != lines.find("force /a/force_me"));
+}
+
+TEST(Hooker, UnreadInput)
+{
+    TestEnvironment env;
+    Hooker hooker(&env);
+
+    /* far more than fits in a pipe, so that we're still writing when the
+     * hooks exit without having read it */
+    std::string input;
+    for (int n(0) ; n < 20000 ; ++n)
+        input.append("file /a/some/rather/long/path/to/file_" + stringify(n) + "\n");
+    ASSERT_GT(input.length(), 65536u);
+
+    hooker.add_dir(FSPath("hooker_TEST_dir/"), false);
+    HookResult result(hooker.perform_hook(Hook("unread_input_hook")
+                .input(input)
+                .grab_output_lines(Hook::AllowedOutputValues()("skip")),
+                nullptr));
+    EXPECT_EQ(0, result.max_exit_status());
+
+    std::set<std::string> lines;
+    tokenise<delim_kind::AnyOfTag, delim_mode::DelimiterTag>(result.output(), "\n", "", std::inserter(lines, lines.begin()));
+    EXPECT_EQ(2u, lines.size());
+    EXPECT_TRUE(lines.end() != lines.find("skip /a/one"));
+    EXPECT_TRUE(lines.end() != lines.find("skip /a/two"));
+}
+
 TEST(Hooker, BadOutput)
 {
     TestEnvironment env;
@@ -289,6 +289,43 @@ hook_after_cycles() {
 END
 chmod +x cycles.common
 
+mkdir batch_hook
+cat <<"END" > batch_hook/one.bash
+while read -r type path ; do
+    if [[ "${path}" == */skip_* ]]; then
+        echo "skip ${path}"
+    fi
+done
+echo "nonsense"
+echo "monkey /a/leave_me"
+END
+chmod +x batch_hook/one.bash
+
+cat <<"END" > batch_hook/two.hook
+hook_run_batch_hook() {
+    while read -r type path ; do
+        if [[ "${path}" == */force_* ]]; then
+            echo "force ${path}"
+        fi
+    done
+}
+END
+chmod +x batch_hook/two.hook
+
+mkdir unread_input_hook
+cat <<"END" > unread_input_hook/one.bash
+echo "skip /a/one"
+END
+chmod +x unread_input_hook/one.bash
+
+cat <<"END" > unread_input_hook/two.hook
+hook_run_unread_input_hook() {
+    read -r type path
+    echo "skip /a/two"
+}
+END
+chmod +x unread_input_hook/two.hook
+
 for a in a b c d e f g h i ; do
     ln -s ../cycles.common cycles/${a}.hook
 done
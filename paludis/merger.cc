@@ -25,10 +25,15 @@
 #include <paludis/util/timestamp.hh>
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_stat.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/tokeniser.hh>
 #include <paludis/selinux/security_context.hh>
 #include <paludis/environment.hh>
 #include <paludis/hook.hh>
+#include <list>
+#include <map>
 #include <set>
+#include <vector>
 #include <istream>
 #include <ostream>
 
@@ -39,6 +44,53 @@ MergerError::MergerError(const std::string & m) noexcept :
 {
 }
 
+namespace
+{
+    EntryType entry_type_from_stat(const FSStat & f_stat)
+    {
+        if (! f_stat.exists())
+            return et_nothing;
+
+        if (f_stat.is_symlink())
+            return et_sym;
+
+        if (f_stat.is_regular_file())
+            return et_file;
+
+        if (f_stat.is_directory())
+            return et_dir;
+
+        return et_misc;
+    }
+
+    struct ImageEntry
+    {
+        FSPath path;
+        EntryType type;
+
+        ImageEntry(const FSPath & p) :
+            path(p),
+            type(entry_type_from_stat(FSStat(p)))
+        {
+        }
+    };
+
+    struct ImageDirectory
+    {
+        Timestamp mtime;
+        bool reusable;
+        std::vector<ImageEntry> entries;
+
+        ImageDirectory() :
+            mtime(0, 0),
+            reusable(false)
+        {
+        }
+    };
+
+    typedef std::map<FSPath, ImageDirectory, FSPathComparator> ImageManifest;
+}
+
 namespace paludis
 {
     template <>
@@ -50,12 +102,70 @@ namespace paludis
 
         std::set<FSPath, FSPathComparator> fixed_entries;
 
+        /* check, the ownership fixes and merge each walk the whole image, so
+         * we only read each directory once, unless it changes in between
+         * (for example, because we rewrote a symlink in it, or because a hook
+         * did something) */
+        ImageManifest manifest;
+
+        /* per-entry hooks are looked up once per merge, rather than once per
+         * entry */
+        std::map<std::string, bool> wanted_hooks;
+
+        /* what merger_install_override_batch said about the entries of the
+         * directories we're in the middle of */
+        std::map<std::string, std::string> batch_verdicts;
+
         Imp(const MergerParams & p) :
             params(p),
             result(true),
             skip_dir(false)
         {
         }
+
+        void add_batch_verdicts(const std::string & output)
+        {
+            std::list<std::string> lines;
+            tokenise<delim_kind::AnyOfTag, delim_mode::DelimiterTag>(output, "\n", "", std::back_inserter(lines));
+            for (const auto & line : lines)
+            {
+                std::string::size_type p(line.find(' '));
+                batch_verdicts.insert(std::make_pair(line.substr(p + 1), line.substr(0, p)));
+            }
+        }
+
+        std::string batch_verdict(const FSPath & staged)
+        {
+            auto i(batch_verdicts.find(stringify(staged)));
+            if (batch_verdicts.end() == i)
+                return "";
+
+            std::string verdict(i->second);
+            batch_verdicts.erase(i);
+            return verdict;
+        }
+
+        const std::vector<ImageEntry> & image_entries(const FSPath & dir, const FSStat & dir_stat)
+        {
+            auto i(manifest.find(dir));
+            if (manifest.end() != i && i->second.reusable && i->second.mtime == dir_stat.mtim())
+                return i->second.entries;
+
+            if (manifest.end() == i)
+                i = manifest.insert(std::make_pair(dir, ImageDirectory())).first;
+
+            /* if the directory was modified very recently, a further change
+             * might not give it a different mtime, so we can't trust it
+             * next time */
+            Timestamp now(Timestamp::now());
+            i->second.mtime = dir_stat.mtim();
+            i->second.reusable = i->second.mtime.seconds() + 2 < now.seconds();
+            i->second.entries.clear();
+            for (FSIterator d(dir, { fsio_include_dotfiles, fsio_inode_sort }), d_end ; d != d_end ; ++d)
+                i->second.entries.push_back(ImageEntry(*d));
+
+            return i->second.entries;
+        }
     };
 }
 
@@ -74,6 +184,15 @@ Merger::extend_hook(const Hook & h)
     return h;
 }
 
+bool
+Merger::want_hook(const std::string & name)
+{
+    auto i(_imp->wanted_hooks.find(name));
+    if (_imp->wanted_hooks.end() == i)
+        i = _imp->wanted_hooks.insert(std::make_pair(name, _imp->params.environment()->want_hook(name))).first;
+    return i->second;
+}
+
 bool
 Merger::check()
 {
@@ -119,6 +238,7 @@ Merger::merge()
         do_ownership_fixes_recursive(_imp->params.image());
 
     do_dir_recursive(false, _imp->params.image(), canonicalise_root_path(_imp->params.root() / _imp->params.install_under()));
+    _imp->manifest.clear();
     on_done_merge();
 
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
@@ -143,16 +263,17 @@ Merger::do_dir_recursive(bool is_check, const FSPath & src, const FSPath & dst)
     Context context("When " + stringify(is_check ? "checking" : "performing") + " merge from '" +
             stringify(src) + "' to '" + stringify(dst) + "':");
 
-    if (! src.stat().is_directory())
+    FSStat src_stat(src);
+    if (! src_stat.is_directory())
         throw MergerError("Source directory '" + stringify(src) + "' is not a directory");
 
     on_enter_dir(is_check, src);
 
-    FSIterator d(src, { fsio_include_dotfiles, fsio_inode_sort }), d_end;
+    const std::vector<ImageEntry> & entries(_imp->image_entries(src, src_stat));
 
     if (is_check)
     {
-        if (d == d_end && dst != _imp->params.root().realpath())
+        if (entries.empty() && dst != _imp->params.root().realpath())
         {
             if (_imp->params.options()[mo_allow_empty_dirs])
                 Log::get_instance()->message("merger.empty_directory", ll_warning, lc_context) << "Installing empty directory '"
@@ -162,33 +283,64 @@ Merger::do_dir_recursive(bool is_check, const FSPath & src, const FSPath & dst)
         }
     }
 
-    for ( ; d != d_end ; ++d)
+    /* ask batched override hooks about everything in this directory at once,
+     * which is much cheaper than starting a hook for each entry */
+    if ((! is_check) && want_hook("merger_install_override_batch"))
+    {
+        std::string input;
+        for (const auto & e : entries)
+        {
+            std::string staged(stringify(dst / e.path.basename()));
+            if ((et_file == e.type || et_dir == e.type || et_sym == e.type) && std::string::npos == staged.find('\n'))
+                input.append(stringify(e.type) + " " + staged + "\n");
+        }
+
+        if (! input.empty())
+        {
+            HookResult hr(_imp->params.environment()->perform_hook(extend_hook(
+                            Hook("merger_install_override_batch")
+                            ("INSTALL_SOURCE", stringify(src))
+                            ("INSTALL_DESTINATION", stringify(dst))
+                            .input(input)
+                            .grab_output_lines(Hook::AllowedOutputValues()("skip"))),
+                        _imp->params.maybe_output_manager()));
+
+            if (hr.max_exit_status() != 0)
+                Log::get_instance()->message("merger.skip_batch_hooks.failure", ll_warning, lc_context) << "Merge of '"
+                    << stringify(src) << "' to '" << stringify(dst) << "' batched skip hooks returned non-zero";
+            else
+                _imp->add_batch_verdicts(hr.output());
+        }
+    }
+
+    for (const auto & e : entries)
     {
-        EntryType m(entry_type(*d));
+        const FSPath & d(e.path);
+        EntryType m(e.type);
         switch (m)
         {
             case et_sym:
-                on_sym(is_check, *d, dst);
+                on_sym(is_check, d, dst);
                 continue;
 
             case et_file:
-                on_file(is_check, *d, dst);
+                on_file(is_check, d, dst);
                 continue;
 
             case et_dir:
-                on_dir(is_check, *d, dst);
+                on_dir(is_check, d, dst);
                 if (_imp->result)
                 {
                     if (! _imp->skip_dir)
-                        do_dir_recursive(is_check, *d,
-                                is_check ? (dst / d->basename()) : canonicalise_root_path(dst / d->basename()));
+                        do_dir_recursive(is_check, d,
+                                is_check ? (dst / d.basename()) : canonicalise_root_path(dst / d.basename()));
                     else
                         _imp->skip_dir = false;
                 }
                 continue;
 
             case et_misc:
-                on_misc(is_check, *d, dst);
+                on_misc(is_check, d, dst);
                 continue;
 
             case et_nothing:
@@ -217,21 +369,7 @@ Merger::entry_type(const FSPath & f)
 {
     Context context("When checking type of '" + stringify(f) + "':");
 
-    FSStat f_stat(f);
-
-    if (! f_stat.exists())
-        return et_nothing;
-
-    if (f_stat.is_symlink())
-        return et_sym;
-
-    if (f_stat.is_regular_file())
-        return et_file;
-
-    if (f_stat.is_directory())
-        return et_dir;
-
-    return et_misc;
+    return entry_type_from_stat(FSStat(f));
 }
 
 void
@@ -242,7 +380,7 @@ Merger::on_file(bool is_check, const FSPath & src, const FSPath & dst)
 
     if (is_check)
     {
-        if (0 != _imp->params.environment()->perform_hook(extend_hook(
+        if (want_hook("merger_check_file_pre") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_check_file_pre")
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(staged))),
@@ -255,12 +393,17 @@ Merger::on_file(bool is_check, const FSPath & src, const FSPath & dst)
 
     if (! is_check)
     {
-        HookResult hr(_imp->params.environment()->perform_hook(extend_hook(
+        HookResult hr(make_named_values<HookResult>(
+                    n::max_exit_status() = 0,
+                    n::output() = _imp->batch_verdict(staged)
+                    ));
+        if (hr.output().empty() && want_hook("merger_install_file_override"))
+            hr = _imp->params.environment()->perform_hook(extend_hook(
                         Hook("merger_install_file_override")
                         ("INSTALL_SOURCE", stringify(src))
                         ("INSTALL_DESTINATION", stringify(staged))
                         .grab_output(Hook::AllowedOutputValues()("skip"))),
-                    _imp->params.maybe_output_manager()));
+                    _imp->params.maybe_output_manager());
 
         if (hr.max_exit_status() != 0)
             Log::get_instance()->message("merger.file.skip_hooks.failure", ll_warning, lc_context) << "Merge of '"
@@ -279,7 +422,7 @@ Merger::on_file(bool is_check, const FSPath & src, const FSPath & dst)
 
     on_file_main(is_check, FSPath(stringify(src)), dst);
 
-    if (is_check &&
+    if (is_check && want_hook("merger_check_file_post") &&
         0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_check_file_post")
                          ("INSTALL_SOURCE", stringify(src))
@@ -294,7 +437,7 @@ Merger::on_dir(bool is_check, const FSPath & src, const FSPath & dst)
     Context context("When handling dir '" + stringify(src) + "' to '" + stringify(dst) + "':");
     const auto staged(dst / src.basename());
 
-    if (is_check &&
+    if (is_check && want_hook("merger_check_dir_pre") &&
         0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_check_dir_pre")
                          ("INSTALL_SOURCE", stringify(src))
@@ -304,12 +447,17 @@ Merger::on_dir(bool is_check, const FSPath & src, const FSPath & dst)
 
     if (! is_check)
     {
-        HookResult hr(_imp->params.environment()->perform_hook(extend_hook(
+        HookResult hr(make_named_values<HookResult>(
+                    n::max_exit_status() = 0,
+                    n::output() = _imp->batch_verdict(staged)
+                    ));
+        if (hr.output().empty() && want_hook("merger_install_dir_override"))
+            hr = _imp->params.environment()->perform_hook(extend_hook(
                         Hook("merger_install_dir_override")
                         ("INSTALL_SOURCE", stringify(src))
                         ("INSTALL_DESTINATION", stringify(staged))
                         .grab_output(Hook::AllowedOutputValues()("skip"))),
-                    _imp->params.maybe_output_manager()));
+                    _imp->params.maybe_output_manager());
 
         if (hr.max_exit_status() != 0)
             Log::get_instance()->message("merger.dir.skip_hooks.failure", ll_warning, lc_context) << "Merge of '"
@@ -325,7 +473,7 @@ Merger::on_dir(bool is_check, const FSPath & src, const FSPath & dst)
 
     on_dir_main(is_check, src, dst);
 
-    if (is_check &&
+    if (is_check && want_hook("merger_check_dir_post") &&
         0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_check_dir_post")
                          ("INSTALL_SOURCE", stringify(src))
@@ -342,7 +490,7 @@ Merger::on_sym(bool is_check, const FSPath & src, const FSPath & dst)
 
     if (is_check)
     {
-        if (0 != _imp->params.environment()->perform_hook(extend_hook(
+        if (want_hook("merger_check_sym_pre") && 0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_check_sym_pre")
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(staged))),
@@ -355,12 +503,17 @@ Merger::on_sym(bool is_check, const FSPath & src, const FSPath & dst)
 
     if (! is_check)
     {
-        HookResult hr(_imp->params.environment()->perform_hook(extend_hook(
+        HookResult hr(make_named_values<HookResult>(
+                    n::max_exit_status() = 0,
+                    n::output() = _imp->batch_verdict(staged)
+                    ));
+        if (hr.output().empty() && want_hook("merger_install_sym_override"))
+            hr = _imp->params.environment()->perform_hook(extend_hook(
                         Hook("merger_install_sym_override")
                         ("INSTALL_SOURCE", stringify(src))
                         ("INSTALL_DESTINATION", stringify(staged))
                         .grab_output(Hook::AllowedOutputValues()("skip"))),
-                    _imp->params.maybe_output_manager()));
+                    _imp->params.maybe_output_manager());
 
         if (hr.max_exit_status() != 0)
             Log::get_instance()->message("merger.sym.skip_hooks.failure", ll_warning, lc_context) << "Merge of '"
@@ -383,7 +536,7 @@ Merger::on_sym(bool is_check, const FSPath & src, const FSPath & dst)
 
     on_sym_main(is_check, FSPath(stringify(src)), dst);
 
-    if (is_check &&
+    if (is_check && want_hook("merger_check_sym_post") &&
         0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_check_sym_post")
                          ("INSTALL_SOURCE", stringify(src))
@@ -419,20 +572,24 @@ Merger::set_skipped_dir(const bool value)
 void
 Merger::do_ownership_fixes_recursive(const FSPath & dir)
 {
-    for (FSIterator d(dir, { fsio_include_dotfiles, fsio_inode_sort }), d_end ; d != d_end ; ++d)
+    for (const auto & e : _imp->image_entries(dir, FSStat(dir)))
     {
-        std::pair<uid_t, gid_t> new_ids(_imp->params.get_new_ids_or_minus_one()(*d));
+        const FSPath & f(e.path);
+        EntryType m(e.type);
+
+        std::pair<uid_t, gid_t> new_ids(_imp->params.get_new_ids_or_minus_one()(f));
         if (uid_t(-1) != new_ids.first || gid_t(-1) != new_ids.second)
         {
-            FSPath f(*d);
+            /* the manifest is only as new as the directory's mtime, which
+             * a chmod doesn't touch, so the mode has to be looked at again */
             FSStat f_stat(f);
             f.lchown(new_ids.first, new_ids.second);
 
-            if (et_sym != entry_type(*d))
+            if (et_sym != m)
             {
                 mode_t mode(f_stat.permissions());
 
-                if (et_dir == entry_type(*d))
+                if (et_dir == m)
                 {
                     if (uid_t(-1) != new_ids.first)
                         mode &= ~S_ISUID;
@@ -446,7 +603,6 @@ Merger::do_ownership_fixes_recursive(const FSPath & dir)
             _imp->fixed_entries.insert(f);
         }
 
-        EntryType m(entry_type(*d));
         switch (m)
         {
             case et_sym:
@@ -454,11 +610,11 @@ Merger::do_ownership_fixes_recursive(const FSPath & dir)
                 continue;
 
             case et_dir:
-                do_ownership_fixes_recursive(*d);
+                do_ownership_fixes_recursive(f);
                 continue;
 
             case et_misc:
-                throw MergerError("Unexpected 'et_misc' entry found at: " + stringify(*d));
+                throw MergerError("Unexpected 'et_misc' entry found at: " + stringify(f));
 
             case et_nothing:
             case last_et:
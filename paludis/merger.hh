@@ -97,6 +97,14 @@ namespace paludis
              */
             virtual Hook extend_hook(const Hook &);
 
+            /**
+             * Is anything interested in the named per-entry hook? If not,
+             * there is no need to build and run it.
+             *
+             * \since 3.0
+             */
+            bool want_hook(const std::string &);
+
             /**
              * When called, makes check()'s result a failure.
              */
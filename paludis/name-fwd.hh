@@ -37,6 +37,7 @@ namespace paludis
     class PackageNamePartTag;
     class PackageNamePartError;
     template <> struct WrappedValueTraits<PackageNamePartTag>;
+    template <> struct WrappedValueInterned<PackageNamePartTag>;
 
     /**
      * A PackageNamePart holds a std::string that is a valid name for the
@@ -51,6 +52,7 @@ namespace paludis
     class CategoryNamePartTag;
     class CategoryNamePartError;
     template <> struct WrappedValueTraits<CategoryNamePartTag>;
+    template <> struct WrappedValueInterned<CategoryNamePartTag>;
 
     /**
      * A CategoryNamePart holds a std::string that is a valid name for the
@@ -82,6 +84,7 @@ namespace paludis
     class SlotNameTag;
     class SlotNameError;
     template <> struct WrappedValueTraits<SlotNameTag>;
+    template <> struct WrappedValueInterned<SlotNameTag>;
 
     typedef Set<QualifiedPackageName> QualifiedPackageNameSet;
 
@@ -95,6 +98,7 @@ namespace paludis
     class RepositoryNameTag;
     class RepositoryNameError;
     template <> struct WrappedValueTraits<RepositoryNameTag>;
+    template <> struct WrappedValueInterned<RepositoryNameTag>;
 
     /**
      * A RepositoryName holds a std::string that is a valid name for a
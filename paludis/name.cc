@@ -358,6 +358,6 @@ WrappedValueTraits<PartNameTag>::validate(const std::string & name)
 std::size_t
 QualifiedPackageName::hash() const
 {
-    return Hash<std::string>()(stringify(*this));
+    return (_cat.hash() << 5) ^ _pkg.hash();
 }
 
@@ -70,6 +70,12 @@ namespace paludis
         static bool validate(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    template <>
+    struct WrappedValueInterned<PackageNamePartTag> :
+        std::true_type
+    {
+    };
+
     extern template class PALUDIS_VISIBLE WrappedValue<PackageNamePartTag>;
 
     /**
@@ -99,6 +105,12 @@ namespace paludis
         static bool validate(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    template <>
+    struct WrappedValueInterned<CategoryNamePartTag> :
+        std::true_type
+    {
+    };
+
     extern template class PALUDIS_VISIBLE WrappedValue<CategoryNamePartTag>;
 
     /**
@@ -166,6 +178,12 @@ namespace paludis
         static bool validate(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    template <>
+    struct WrappedValueInterned<SlotNameTag> :
+        std::true_type
+    {
+    };
+
     /**
      * A RepositoryNameError is thrown if an invalid value is assigned to
      * a RepositoryName.
@@ -192,6 +210,12 @@ namespace paludis
         static bool validate(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    template <>
+    struct WrappedValueInterned<RepositoryNameTag> :
+        std::true_type
+    {
+    };
+
     /**
      * A KeywordNameError is thrown if an invalid value is assigned to
      * a KeywordName.
@@ -59,12 +59,16 @@ namespace paludis
         FSPath realroot;
         std::shared_ptr<SafeOFStream> contents_file;
 
+        /* where we write the contents file until it can be trusted */
+        FSPath partial_contents_file;
+
         std::list<std::string> config_protect;
         std::list<std::string> config_protect_mask;
 
         Imp(const NDBAMMergerParams & p) :
             params(p),
-            realroot(params.root().realpath())
+            realroot(params.root().realpath()),
+            partial_contents_file(params.contents_file().dirname() / ("-merging-" + params.contents_file().basename()))
         {
             tokenise_whitespace(p.config_protect(), std::back_inserter(config_protect));
             tokenise_whitespace(p.config_protect_mask(), std::back_inserter(config_protect_mask));
@@ -74,6 +78,7 @@ namespace paludis
 
 NDBAMMerger::NDBAMMerger(const NDBAMMergerParams & p) :
     FSMerger(make_named_values<FSMergerParams>(
+                n::durability() = p.durability(),
                 n::environment() = p.environment(),
                 n::fix_mtimes_before() = p.fix_mtimes_before(),
                 n::fs_merger_options() = p.fs_merger_options(),
@@ -168,11 +173,7 @@ NDBAMMerger::record_install_file(const FSPath & src, const FSPath & dst_dir, con
 
     time_t timestamp(dst_dir_name_stat.mtim().seconds());
 
-    SafeIFStream infile(renamed_file);
-    if (! infile)
-        throw FSMergerError("Cannot read '" + stringify(renamed_file) + "'");
-
-    MD5 md5(infile);
+    const std::string md5(file_md5(renamed_file));
 
     display_merge(et_file, file, flags,
                   src.basename() == dst_name ? "" : dst_name);
@@ -183,7 +184,7 @@ NDBAMMerger::record_install_file(const FSPath & src, const FSPath & dst_dir, con
 
     *_imp->contents_file << "type=file";
     *_imp->contents_file << " path=" << escape(tidy_real);
-    *_imp->contents_file << " md5=" << md5.hexsum();
+    *_imp->contents_file << " md5=" << md5;
     *_imp->contents_file << " mtime=" << timestamp;
     if (!part.empty())
         *_imp->contents_file << " part=" << part;
@@ -280,10 +281,7 @@ NDBAMMerger::make_config_protect_name(const FSPath & src, const FSPath & dst)
     std::string result_name(src.basename());
     int n(0);
 
-    SafeIFStream our_md5_file(src);
-    if (! our_md5_file)
-        throw FSMergerError("Could not get md5 for '" + stringify((dst / src.basename()).strip_leading(_imp->realroot)) + "'");
-    MD5 our_md5(our_md5_file);
+    const std::string our_md5(file_md5(src));
 
     while (true)
     {
@@ -299,7 +297,7 @@ NDBAMMerger::make_config_protect_name(const FSPath & src, const FSPath & dst)
             if (other_md5_file)
             {
                 MD5 other_md5(other_md5_file);
-                if (our_md5.hexsum() == other_md5.hexsum())
+                if (our_md5 == other_md5.hexsum())
                     break;
             }
         }
@@ -312,12 +310,45 @@ NDBAMMerger::make_config_protect_name(const FSPath & src, const FSPath & dst)
     return result_name;
 }
 
+bool
+NDBAMMerger::want_file_md5s() const
+{
+    return true;
+}
+
 void
 NDBAMMerger::merge()
 {
     display_override(">>> Merging to " + stringify(_imp->params.root()));
-    _imp->contents_file = std::make_shared<SafeOFStream>(_imp->params.contents_file(), -1, false);
-    FSMerger::merge();
+
+    /* the contents file only gets its real name once everything it lists has
+     * been synced, or if the merge fails part way through, so that whatever
+     * did get merged can still be uninstalled */
+    _imp->contents_file = std::make_shared<SafeOFStream>(_imp->partial_contents_file, -1, false);
+    try
+    {
+        FSMerger::merge();
+    }
+    catch (...)
+    {
+        if (_imp->contents_file)
+        {
+            _imp->contents_file.reset();
+            _imp->partial_contents_file.rename(_imp->params.contents_file());
+        }
+        throw;
+    }
+}
+
+void
+NDBAMMerger::on_done_merge()
+{
+    FSMerger::on_done_merge();
+
+    _imp->contents_file.reset();
+    make_durable(_imp->partial_contents_file);
+    _imp->partial_contents_file.rename(_imp->params.contents_file());
+    make_durable(_imp->params.contents_file().dirname());
 }
 
 bool
@@ -34,6 +34,7 @@ namespace paludis
         typedef Name<struct name_config_protect> config_protect;
         typedef Name<struct name_config_protect_mask> config_protect_mask;
         typedef Name<struct name_contents_file> contents_file;
+        typedef Name<struct name_durability> durability;
         typedef Name<struct name_environment> environment;
         typedef Name<struct name_fix_mtimes_before> fix_mtimes_before;
         typedef Name<struct name_fs_merger_options> fs_merger_options;
@@ -56,6 +57,7 @@ namespace paludis
         NamedValue<n::config_protect, std::string> config_protect;
         NamedValue<n::config_protect_mask, std::string> config_protect_mask;
         NamedValue<n::contents_file, FSPath> contents_file;
+        NamedValue<n::durability, FSMergerDurability> durability;
         NamedValue<n::environment, Environment *> environment;
         NamedValue<n::fix_mtimes_before, Timestamp> fix_mtimes_before;
         NamedValue<n::fs_merger_options, FSMergerOptions> fs_merger_options;
@@ -101,10 +103,13 @@ namespace paludis
             virtual void on_error(bool is_check, const std::string &);
             virtual void on_warn(bool is_check, const std::string &);
             virtual void on_enter_dir(bool is_check, const FSPath);
+            virtual void on_done_merge();
 
             virtual bool config_protected(const FSPath &, const FSPath &);
             virtual std::string make_config_protect_name(const FSPath &, const FSPath &);
 
+            virtual bool want_file_md5s() const;
+
             virtual void merge();
             virtual bool check();
     };
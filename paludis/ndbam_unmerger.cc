@@ -29,7 +29,6 @@
 #include <paludis/slot.hh>
 
 #include <paludis/util/destringify.hh>
-#include <paludis/util/md5.hh>
 #include <paludis/util/join.hh>
 #include <paludis/util/log.hh>
 #include <paludis/util/pimp-impl.hh>
@@ -232,18 +231,20 @@ NDBAMUnmerger::check_file(const std::shared_ptr<const ContentsEntry> & e) const
         display("--- [!time] " + stringify(f));
     else
     {
-        SafeIFStream md5_file(root_f);
-        if (! md5_file)
+        try
+        {
+            if (file_md5(root_f) != require_key<MetadataValueKey<std::string> >(*e, "md5").parse_value())
+                display("--- [!md5 ] " + stringify(f));
+            else if (config_protected(root_f))
+                display("--- [cfgpr] " + stringify(f));
+            else
+                return true;
+        }
+        catch (const SafeIFStreamError &)
         {
             Log::get_instance()->message("ndbam.unmerger.md5_failed", ll_warning, lc_no_context) << "Cannot get md5 for '" << root_f << "'";
             display("--- [!md5?] " + stringify(f));
         }
-        else if (MD5(md5_file).hexsum() != require_key<MetadataValueKey<std::string> >(*e, "md5").parse_value())
-            display("--- [!md5 ] " + stringify(f));
-        else if (config_protected(root_f))
-            display("--- [cfgpr] " + stringify(f));
-        else
-            return true;
     }
 
     return false;
@@ -0,0 +1,219 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/package_dep_spec_index.hh>
+#include <paludis/dep_spec.hh>
+#include <paludis/name.hh>
+#include <paludis/package_id.hh>
+#include <paludis/version_spec.hh>
+#include <paludis/version_operator.hh>
+#include <paludis/version_requirements.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/hashes.hh>
+#include <paludis/util/iterator_funcs.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <algorithm>
+#include <unordered_map>
+
+using namespace paludis;
+
+namespace
+{
+    /* A version range worked out from a spec's version requirements, if they
+     * are simple enough. Anything we don't understand leaves the range
+     * unbounded, and is left for match_package to deal with. */
+    struct VersionInterval
+    {
+        std::shared_ptr<const VersionSpec> lower;
+        bool lower_inclusive;
+        std::shared_ptr<const VersionSpec> upper;
+        bool upper_inclusive;
+
+        VersionInterval() :
+            lower_inclusive(true),
+            upper_inclusive(true)
+        {
+        }
+
+        void restrict_lower(const VersionSpec & v, const bool inclusive)
+        {
+            if ((! lower) || (*lower < v) || (*lower == v && ! inclusive))
+            {
+                lower = std::make_shared<VersionSpec>(v);
+                lower_inclusive = inclusive;
+            }
+        }
+
+        void restrict_upper(const VersionSpec & v, const bool inclusive)
+        {
+            if ((! upper) || (v < *upper) || (*upper == v && ! inclusive))
+            {
+                upper = std::make_shared<VersionSpec>(v);
+                upper_inclusive = inclusive;
+            }
+        }
+
+        bool contains(const VersionSpec & v) const
+        {
+            if (lower && (lower_inclusive ? v < *lower : v <= *lower))
+                return false;
+            if (upper && (upper_inclusive ? *upper < v : *upper <= v))
+                return false;
+            return true;
+        }
+    };
+
+    VersionInterval make_interval(const PackageDepSpec & spec)
+    {
+        VersionInterval result;
+
+        auto requirements(spec.version_requirements_ptr());
+        if (! requirements || requirements->empty())
+            return result;
+
+        /* a single requirement means the same thing whatever the mode says */
+        if (vr_and != spec.version_requirements_mode() && next(requirements->begin()) != requirements->end())
+            return result;
+
+        for (VersionRequirements::ConstIterator r(requirements->begin()), r_end(requirements->end()) ;
+                r != r_end ; ++r)
+            switch (r->version_operator().value())
+            {
+                case vo_equal:
+                    result.restrict_lower(r->version_spec(), true);
+                    result.restrict_upper(r->version_spec(), true);
+                    continue;
+
+                case vo_greater_equal:
+                    result.restrict_lower(r->version_spec(), true);
+                    continue;
+
+                case vo_greater:
+                    result.restrict_lower(r->version_spec(), false);
+                    continue;
+
+                case vo_less_equal:
+                    result.restrict_upper(r->version_spec(), true);
+                    continue;
+
+                case vo_less:
+                    result.restrict_upper(r->version_spec(), false);
+                    continue;
+
+                case vo_tilde:
+                case vo_equal_star:
+                case vo_tilde_greater:
+                case last_vo:
+                    continue;
+            }
+
+        return result;
+    }
+
+    struct Entry
+    {
+        unsigned position;
+        VersionInterval interval;
+    };
+
+    typedef std::vector<Entry> Entries;
+
+    void add_candidates(const Entries & entries, const PackageID & id, std::vector<unsigned> & result)
+    {
+        auto old_end(result.size());
+
+        for (const auto & e : entries)
+            if (e.interval.contains(id.version()))
+                result.push_back(e.position);
+
+        if (0 != old_end)
+            std::inplace_merge(result.begin(), result.begin() + old_end, result.end());
+    }
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<PackageDepSpecIndex>
+    {
+        unsigned size;
+
+        std::unordered_map<QualifiedPackageName, Entries, Hash<QualifiedPackageName> > by_name;
+        std::unordered_map<CategoryNamePart, Entries, Hash<CategoryNamePart> > by_category_name_part;
+        std::unordered_map<PackageNamePart, Entries, Hash<PackageNamePart> > by_package_name_part;
+        Entries others;
+
+        Imp() :
+            size(0)
+        {
+        }
+    };
+}
+
+PackageDepSpecIndex::PackageDepSpecIndex() :
+    _imp()
+{
+}
+
+PackageDepSpecIndex::~PackageDepSpecIndex() = default;
+
+unsigned
+PackageDepSpecIndex::insert(const PackageDepSpec & spec)
+{
+    Entry entry{ _imp->size++, make_interval(spec) };
+
+    if (spec.package_ptr())
+        _imp->by_name[*spec.package_ptr()].push_back(entry);
+    else if (spec.category_name_part_ptr())
+        _imp->by_category_name_part[*spec.category_name_part_ptr()].push_back(entry);
+    else if (spec.package_name_part_ptr())
+        _imp->by_package_name_part[*spec.package_name_part_ptr()].push_back(entry);
+    else
+        _imp->others.push_back(entry);
+
+    return entry.position;
+}
+
+const std::vector<unsigned>
+PackageDepSpecIndex::candidates(const PackageID & id) const
+{
+    std::vector<unsigned> result;
+
+    auto n(_imp->by_name.find(id.name()));
+    if (n != _imp->by_name.end())
+        add_candidates(n->second, id, result);
+
+    auto c(_imp->by_category_name_part.find(id.name().category()));
+    if (c != _imp->by_category_name_part.end())
+        add_candidates(c->second, id, result);
+
+    auto p(_imp->by_package_name_part.find(id.name().package()));
+    if (p != _imp->by_package_name_part.end())
+        add_candidates(p->second, id, result);
+
+    add_candidates(_imp->others, id, result);
+
+    return result;
+}
+
+namespace paludis
+{
+    template class Pimp<PackageDepSpecIndex>;
+}
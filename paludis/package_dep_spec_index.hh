@@ -0,0 +1,73 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_PACKAGE_DEP_SPEC_INDEX_HH
+#define PALUDIS_GUARD_PALUDIS_PACKAGE_DEP_SPEC_INDEX_HH 1
+
+#include <paludis/package_dep_spec_index-fwd.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/dep_spec-fwd.hh>
+#include <paludis/package_id-fwd.hh>
+#include <vector>
+
+namespace paludis
+{
+    /**
+     * Finds which of a list of PackageDepSpec instances could possibly match
+     * a given PackageID, without trying every one.
+     *
+     * Specs are bucketed by package name, or for wildcards by category or
+     * package name part, and specs with simple version ranges are also
+     * filtered on version. Anything returned by candidates() still needs to
+     * be checked with match_package, but anything not returned definitely
+     * does not match.
+     *
+     * \since 3.0
+     * \ingroup g_dep_spec
+     */
+    class PALUDIS_VISIBLE PackageDepSpecIndex
+    {
+        private:
+            Pimp<PackageDepSpecIndex> _imp;
+
+        public:
+            PackageDepSpecIndex();
+            ~PackageDepSpecIndex();
+
+            PackageDepSpecIndex(const PackageDepSpecIndex &) = delete;
+            PackageDepSpecIndex & operator= (const PackageDepSpecIndex &) = delete;
+
+            /**
+             * Add a spec, returning its position. Positions are allocated
+             * sequentially from zero.
+             */
+            unsigned insert(const PackageDepSpec &);
+
+            /**
+             * The positions of every spec that might match the ID, in the
+             * order they were inserted.
+             */
+            const std::vector<unsigned> candidates(const PackageID &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+    };
+
+    extern template class Pimp<PackageDepSpecIndex>;
+}
+
+#endif
@@ -0,0 +1,101 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/package_dep_spec_index.hh>
+#include <paludis/user_dep_spec.hh>
+#include <paludis/dep_spec.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/repositories/fake/fake_repository.hh>
+#include <paludis/repositories/fake/fake_package_id.hh>
+
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/join.hh>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    struct PackageDepSpecIndexTest :
+        testing::Test
+    {
+        TestEnvironment env;
+        std::shared_ptr<FakeRepository> repo;
+        PackageDepSpecIndex index;
+
+        void SetUp() override
+        {
+            repo = std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                        n::environment() = &env,
+                        n::name() = RepositoryName("repo")
+                        ));
+            env.add_repository(1, repo);
+        }
+
+        void add(const std::string & s)
+        {
+            index.insert(parse_user_package_dep_spec(s, &env, { updso_allow_wildcards }));
+        }
+
+        std::string candidates(const std::string & c, const std::string & p, const std::string & v)
+        {
+            auto result(index.candidates(*repo->add_version(c, p, v)));
+            return join(result.begin(), result.end(), " ");
+        }
+    };
+}
+
+TEST_F(PackageDepSpecIndexTest, Names)
+{
+    add("*/*");
+    add("cat/*");
+    add("*/pkg");
+    add("cat/pkg");
+    add("other/*");
+    add("*/other");
+    add("other/pkg");
+    add("cat/pkg:1");
+    add("*/*");
+
+    EXPECT_EQ("0 1 2 3 7 8", candidates("cat", "pkg", "1"));
+    EXPECT_EQ("0 1 8", candidates("cat", "foo", "1"));
+    EXPECT_EQ("0 2 4 6 8", candidates("other", "pkg", "1"));
+    EXPECT_EQ("0 8", candidates("foo", "bar", "1"));
+}
+
+TEST_F(PackageDepSpecIndexTest, Versions)
+{
+    add(">=cat/pkg-2");
+    add("<cat/pkg-2");
+    add("=cat/pkg-2");
+    add("cat/pkg[>1.5&<3]");
+    add("cat/pkg[<1|>3]");
+    add("~cat/pkg-2");
+    add("=cat/pkg-2*");
+    add(">cat/pkg-2");
+    add("<=cat/pkg-2");
+
+    EXPECT_EQ("1 4 5 6 8", candidates("cat", "pkg", "1"));
+    EXPECT_EQ("0 2 3 4 5 6 8", candidates("cat", "pkg", "2"));
+    EXPECT_EQ("0 3 4 5 6 7", candidates("cat", "pkg", "2-r1"));
+    EXPECT_EQ("0 4 5 6 7", candidates("cat", "pkg", "3"));
+}
@@ -41,6 +41,7 @@
 #include <paludis/environment.hh>
 #include <paludis/spec_tree.hh>
 #include <paludis/package_dep_spec_properties.hh>
+#include <paludis/package_dep_spec_index.hh>
 #include <unordered_map>
 #include <unordered_set>
 #include <list>
@@ -117,7 +118,27 @@ namespace
         NamedValue<n::values_groups, ValuesGroups> values_groups;
     };
 
-    typedef std::list<SpecWithValuesGroups> SpecsWithValuesGroups;
+    /* Specs in the order they were added, with an index so that we only
+     * need to try matching the ones that could apply to a given ID. */
+    struct SpecsWithValuesGroups
+    {
+        PackageDepSpecIndex index;
+        std::vector<SpecWithValuesGroups> specs;
+
+        ValuesGroups & add(const PackageDepSpec & spec)
+        {
+            index.insert(spec);
+            specs.push_back(make_named_values<SpecWithValuesGroups>(
+                        n::spec() = spec,
+                        n::values_groups() = ValuesGroups()
+                        ));
+            return specs.back().values_groups();
+        }
+
+        const std::vector<const SpecWithValuesGroups *> matching(
+                const Environment * const env,
+                const std::shared_ptr<const PackageID> & maybe_id) const;
+    };
 
     struct SetNameWithValuesGroups
     {
@@ -128,8 +149,6 @@ namespace
 
     typedef std::list<SetNameWithValuesGroups> SetNamesWithValuesGroups;
 
-    typedef std::unordered_map<QualifiedPackageName, SpecsWithValuesGroups, Hash<QualifiedPackageName> > SpecificSpecs;
-
     const std::shared_ptr<const SetSpecTree> make_set_value(
             const Environment * const env,
             const FSPath & from,
@@ -154,7 +173,7 @@ namespace paludis
     {
         const PaludisLikeOptionsConfParams params;
 
-        SpecificSpecs specific_specs;
+        SpecsWithValuesGroups specific_specs;
         SetNamesWithValuesGroups set_specs;
         SpecsWithValuesGroups wildcard_specs;
 
@@ -206,24 +225,9 @@ PaludisLikeOptionsConf::add_file(const FSPath & f)
             }
 
             if (d->package_ptr())
-            {
-                SpecificSpecs::iterator i(_imp->specific_specs.insert(std::make_pair(
-                                *d->package_ptr(),
-                                SpecsWithValuesGroups())).first);
-                values_groups = &i->second.insert(i->second.end(),
-                        make_named_values<SpecWithValuesGroups>(
-                            n::spec() = *d,
-                            n::values_groups() = ValuesGroups()
-                            ))->values_groups();
-            }
+                values_groups = &_imp->specific_specs.add(*d);
             else
-            {
-                values_groups = &_imp->wildcard_specs.insert(_imp->wildcard_specs.end(),
-                        make_named_values<SpecWithValuesGroups>(
-                            n::spec() = *d,
-                            n::values_groups() = ValuesGroups()
-                            ))->values_groups();
-            }
+                values_groups = &_imp->wildcard_specs.add(*d);
         }
         catch (const GotASetNotAPackageDepSpec &)
         {
@@ -405,6 +409,29 @@ namespace
         }
     }
 
+    const std::vector<const SpecWithValuesGroups *>
+    SpecsWithValuesGroups::matching(
+            const Environment * const env,
+            const std::shared_ptr<const PackageID> & maybe_id) const
+    {
+        std::vector<const SpecWithValuesGroups *> result;
+
+        if (maybe_id)
+        {
+            for (auto c : index.candidates(*maybe_id))
+                if (match_package(*env, specs[c].spec(), maybe_id, nullptr, { }))
+                    result.push_back(&specs[c]);
+        }
+        else
+        {
+            for (const auto & s : specs)
+                if (match_anything(s.spec()))
+                    result.push_back(&s);
+        }
+
+        return result;
+    }
+
     void check_specs_with_values_groups(
             const Environment * const env,
             const std::shared_ptr<const PackageID> & maybe_id,
@@ -415,22 +442,9 @@ namespace
             std::pair<Tribool, bool> & result_state,
             std::string & result_value)
     {
-        for (const auto & specs_with_values_group : specs_with_values_groups)
-        {
-            if (maybe_id)
-            {
-                if (! match_package(*env, specs_with_values_group.spec(), maybe_id, nullptr, { }))
-                    continue;
-            }
-            else
-            {
-                if (! match_anything(specs_with_values_group.spec()))
-                    continue;
-            }
-
-            check_values_groups(env, maybe_id, prefix, unprefixed_name, specs_with_values_group.values_groups(),
+        for (const auto & specs_with_values_group : specs_with_values_groups.matching(env, maybe_id))
+            check_values_groups(env, maybe_id, prefix, unprefixed_name, specs_with_values_group->values_groups(),
                     seen_minus_star, result_state, result_value);
-        }
     }
 
     void collect_known_from_specs_with_values_groups(
@@ -440,21 +454,8 @@ namespace
             const SpecsWithValuesGroups & specs_with_values_groups,
             const std::shared_ptr<Set<UnprefixedChoiceName> > & known)
     {
-        for (const auto & specs_with_values_group : specs_with_values_groups)
-        {
-            if (maybe_id)
-            {
-                if (! match_package(*env, specs_with_values_group.spec(), maybe_id, nullptr, { }))
-                    continue;
-            }
-            else
-            {
-                if (! match_anything(specs_with_values_group.spec()))
-                    continue;
-            }
-
-            collect_known_from_values_groups(env, maybe_id, prefix, specs_with_values_group.values_groups(), known);
-        }
+        for (const auto & specs_with_values_group : specs_with_values_groups.matching(env, maybe_id))
+            collect_known_from_values_groups(env, maybe_id, prefix, specs_with_values_group->values_groups(), known);
     }
 }
 
@@ -476,14 +477,10 @@ PaludisLikeOptionsConf::want_choice_enabled_locked(
     /* Any specific matches? */
     if (maybe_id)
     {
-        SpecificSpecs::const_iterator i(_imp->specific_specs.find(maybe_id->name()));
-        if (i != _imp->specific_specs.end())
-        {
-            check_specs_with_values_groups(_imp->params.environment(), maybe_id, prefix, unprefixed_name, i->second,
-                    seen_minus_star, result, dummy);
-            if (! result.first.is_indeterminate())
-                return result;
-        }
+        check_specs_with_values_groups(_imp->params.environment(), maybe_id, prefix, unprefixed_name,
+                _imp->specific_specs, seen_minus_star, result, dummy);
+        if (! result.first.is_indeterminate())
+            return result;
     }
 
     /* Any set matches? */
@@ -536,15 +533,11 @@ PaludisLikeOptionsConf::value_for_choice_parameter(
 
     /* Any specific matches? */
     {
-        SpecificSpecs::const_iterator i(_imp->specific_specs.find(id->name()));
-        if (i != _imp->specific_specs.end())
-        {
-            check_specs_with_values_groups(_imp->params.environment(), id, prefix, unprefixed_name, i->second,
-                    dummy_seen_minus_star, dummy_result, equals_value);
+        check_specs_with_values_groups(_imp->params.environment(), id, prefix, unprefixed_name, _imp->specific_specs,
+                dummy_seen_minus_star, dummy_result, equals_value);
 
-            if (! equals_value.empty())
-                return equals_value;
-        }
+        if (! equals_value.empty())
+            return equals_value;
     }
 
     /* Any set matches? */
@@ -585,11 +578,8 @@ PaludisLikeOptionsConf::known_choice_value_names(
 
     /* Any specific matches? */
     if (maybe_id)
-    {
-        SpecificSpecs::const_iterator i(_imp->specific_specs.find(maybe_id->name()));
-        if (i != _imp->specific_specs.end())
-            collect_known_from_specs_with_values_groups(_imp->params.environment(), maybe_id, prefix, i->second, result);
-    }
+        collect_known_from_specs_with_values_groups(_imp->params.environment(), maybe_id, prefix,
+                _imp->specific_specs, result);
 
     /* Any set matches? */
     if (maybe_id)
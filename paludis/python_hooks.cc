@@ -197,6 +197,11 @@ PyHookFile::run(const Hook & hook, const std::shared_ptr<OutputManager> &) const
     for (Hook::ConstIterator x(hook.begin()), x_end(hook.end()) ; x != x_end ; ++x)
         hook_env[x->first] = x->second;
 
+    /* python hooks don't get a stdin, so pass any input along with everything
+     * else */
+    if (! hook.input().empty())
+        hook_env["HOOK_INPUT"] = hook.input();
+
     bp::object result;
     try
     {
@@ -210,7 +215,7 @@ PyHookFile::run(const Hook & hook, const std::shared_ptr<OutputManager> &) const
         return make_named_values<HookResult>(n::max_exit_status() = 1, n::output() = "");
     }
 
-    if (hook.output_dest == hod_grab)
+    if (hook.output_dest == hod_grab || hook.output_dest == hod_grab_lines)
     {
         if (bp::extract<std::string>(result).check())
         {
@@ -287,6 +292,11 @@ PyHookFile::_add_dependency_class(const Hook & hook, DirectedGraph<std::string,
     for (Hook::ConstIterator x(hook.begin()), x_end(hook.end()) ; x != x_end ; ++x)
         hook_env[x->first] = x->second;
 
+    /* python hooks don't get a stdin, so pass any input along with everything
+     * else */
+    if (! hook.input().empty())
+        hook_env["HOOK_INPUT"] = hook.input();
+
     bp::object result;
     try
     {
@@ -31,6 +31,8 @@
 #include <paludis/util/wrapped_output_iterator.hh>
 #include <paludis/util/singleton-impl.hh>
 #include <paludis/util/return_literal_function.hh>
+#include <paludis/util/file_lock.hh>
+#include <paludis/util/env_var_names.hh>
 #include <paludis/output_manager.hh>
 #include <paludis/name.hh>
 #include <paludis/version_spec.hh>
@@ -501,11 +503,15 @@ AccountsID::perform_action(Action & action) const
             throw InternalError(PALUDIS_HERE, "bad WantPhase");
     }
 
+    /* if installs are running concurrently, only one may merge and clean up
+     * what it replaces at once */
+    std::shared_ptr<FileLock> merge_lock;
     switch (install_action->options.want_phase()("merge"))
     {
         case wp_yes:
             {
                 merge_params.check() = false;
+                merge_lock = lock_file_named_by_environment_variable(env_vars::merge_lock_file);
                 (*install_action->options.destination()).destination_interface()->merge(merge_params);
             }
             break;
@@ -404,6 +404,12 @@ AccountsRepository::perform_hook(
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
+bool
+AccountsRepository::want_hook(const std::string &) const
+{
+    return false;
+}
+
 bool
 AccountsRepository::sync(
         const std::string &,
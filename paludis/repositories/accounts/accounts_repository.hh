@@ -145,6 +145,8 @@ namespace paludis
                         const Hook & hook,
                         const std::shared_ptr<OutputManager> &);
 
+                virtual bool want_hook(const std::string &) const;
+
                 virtual bool sync(
                         const std::string &,
                         const std::string &,
@@ -39,6 +39,8 @@
 #include <paludis/util/join.hh>
 #include <paludis/util/return_literal_function.hh>
 #include <paludis/util/tokeniser.hh>
+#include <paludis/util/file_lock.hh>
+#include <paludis/util/env_var_names.hh>
 
 #include <paludis/action.hh>
 #include <paludis/dep_spec_flattener.hh>
@@ -220,10 +222,17 @@ paludis::erepository::do_install_action(
     auto volatile_files(std::make_shared<FSPathSet>());
     auto destination = install_action.options.destination();
 
+    /* if installs are running concurrently, only one may be anywhere between
+     * pkg_preinst and cleaning up what it replaces at once */
+    std::shared_ptr<FileLock> merge_lock;
+
     EAPIPhases phases(id->eapi()->supported()->ebuild_phases()->ebuild_install());
     for (EAPIPhases::ConstIterator phase(phases.begin_phases()), phase_end(phases.end_phases()) ;
             phase != phase_end ; ++phase)
     {
+        if ((! merge_lock) && (phase->option("prepost") || phase->option("merge")))
+            merge_lock = lock_file_named_by_environment_variable(env_vars::merge_lock_file);
+
         bool skip(false);
         do
         {
@@ -128,6 +128,12 @@ EInstalledRepository::perform_hook(const Hook & hook, const std::shared_ptr<Outp
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
+bool
+EInstalledRepository::want_hook(const std::string & name) const
+{
+    return name == "sync_all_post";
+}
+
 const bool
 EInstalledRepository::is_unimportant() const
 {
@@ -90,6 +90,9 @@ namespace paludis
                         const std::shared_ptr<OutputManager> &)
                     PALUDIS_ATTRIBUTE((warn_unused_result));
 
+                bool want_hook(const std::string &) const
+                    PALUDIS_ATTRIBUTE((warn_unused_result));
+
                 virtual bool sync(
                         const std::string &,
                         const std::string &,
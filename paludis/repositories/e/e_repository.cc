@@ -68,6 +68,7 @@
 #include <paludis/util/deferred_construction_ptr.hh>
 #include <paludis/util/destringify.hh>
 #include <paludis/util/digest_registry.hh>
+#include <paludis/util/env_var_names.hh>
 #include <paludis/util/extract_host_from_url.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/fs_iterator.hh>
@@ -82,7 +83,6 @@
 #include <paludis/util/map.hh>
 #include <paludis/util/options.hh>
 #include <paludis/util/pimp-impl.hh>
-#include <paludis/util/process.hh>
 #include <paludis/util/return_literal_function.hh>
 #include <paludis/util/safe_ifstream.hh>
 #include <paludis/util/safe_ofstream.hh>
@@ -109,6 +109,7 @@
 
 #include <strings.h>
 #include <ctype.h>
+#include <unistd.h>
 
 #include <dlfcn.h>
 #include <stdint.h>
@@ -133,7 +134,78 @@ typedef std::map<FSPath, std::string, FSPathComparator> EAPIForFileMap;
 
 namespace
 {
-    const std::string pbin_tar_extension = ".tar";
+    struct PbinCompression
+    {
+        TarMergerCompression compression;
+        int level;
+        unsigned threads;
+        std::string extension;
+    };
+
+    PbinCompression get_pbin_compression()
+    {
+        PbinCompression result{ tmc_bz2, -1, 0, "" };
+
+        std::string compression_str(getenv_with_default(env_vars::pbin_compression, "bz2"));
+        try
+        {
+            result.compression = destringify<TarMergerCompression>(compression_str);
+        }
+        catch (const DestringifyError &)
+        {
+            Log::get_instance()->message("e.pbin.compression.bad", ll_warning, lc_context)
+                << "Ignoring bad value '" << compression_str << "' for " << env_vars::pbin_compression;
+        }
+
+        std::string level_str(getenv_with_default(env_vars::pbin_compression_level, "-1"));
+        try
+        {
+            result.level = destringify<int>(level_str);
+        }
+        catch (const DestringifyError &)
+        {
+            Log::get_instance()->message("e.pbin.compression_level.bad", ll_warning, lc_context)
+                << "Ignoring bad value '" << level_str << "' for " << env_vars::pbin_compression_level;
+        }
+
+        std::string threads_str(getenv_with_default(env_vars::pbin_compression_threads, "0"));
+        try
+        {
+            result.threads = destringify<unsigned>(threads_str);
+        }
+        catch (const DestringifyError &)
+        {
+            Log::get_instance()->message("e.pbin.compression_threads.bad", ll_warning, lc_context)
+                << "Ignoring bad value '" << threads_str << "' for " << env_vars::pbin_compression_threads;
+        }
+
+        switch (result.compression)
+        {
+            case tmc_none:
+                result.extension = ".tar";
+                break;
+
+            case tmc_bz2:
+                result.extension = ".tar.bz2";
+                break;
+
+            case tmc_xz:
+                result.extension = ".tar.xz";
+                break;
+
+            case tmc_zstd:
+                result.extension = ".tar.zst";
+                break;
+
+            case last_tmc:
+                break;
+        }
+
+        if (result.extension.empty())
+            throw InternalError(PALUDIS_HERE, "unknown compression");
+
+        return result;
+    }
 
     std::shared_ptr<FSPathSequence> get_master_locations(
             const std::shared_ptr<const ERepositorySequence> & r)
@@ -245,6 +317,7 @@ namespace paludis
         std::shared_ptr<const MetadataValueKey<bool> > append_repository_name_to_write_cache_key;
         std::shared_ptr<const MetadataValueKey<bool> > ignore_deprecated_profiles;
         std::shared_ptr<const MetadataValueKey<FSPath> > names_cache_key;
+        std::shared_ptr<const MetadataValueKey<FSPath> > profile_cache_key;
         std::shared_ptr<const MetadataValueKey<FSPath> > distdir_key;
         std::shared_ptr<const MetadataCollectionKey<FSPathSequence> > eclassdirs_key;
         std::shared_ptr<const MetadataValueKey<FSPath> > securitydir_key;
@@ -311,6 +384,8 @@ namespace paludis
                     mkt_internal, params.ignore_deprecated_profiles())),
         names_cache_key(std::make_shared<LiteralMetadataValueKey<FSPath> >(
                     "names_cache", "names_cache", mkt_normal, params.names_cache())),
+        profile_cache_key(std::make_shared<LiteralMetadataValueKey<FSPath> >(
+                    "profile_cache", "profile_cache", mkt_normal, params.profile_cache())),
         distdir_key(std::make_shared<LiteralMetadataValueKey<FSPath> >(
                     "distdir", "distdir", mkt_normal, params.distdir())),
         eclassdirs_key(std::make_shared<LiteralMetadataFSPathSequenceKey>(
@@ -474,7 +549,8 @@ namespace paludis
                 EAPIData::get_instance()->eapi_from_string(params.eapi_when_unknown())->supported()->ebuild_environment_variables()->env_arch(),
                 params.profiles_explicitly_set(),
                 bool(params.master_repositories()),
-                params.ignore_deprecated_profiles());
+                params.ignore_deprecated_profiles(),
+                params.profile_cache() == FSPath("/var/empty") ? params.profile_cache() : params.profile_cache() / stringify(repo->name()));
     }
 }
 
@@ -557,6 +633,7 @@ ERepository::_add_metadata_keys() const
     add_metadata_key(_imp->append_repository_name_to_write_cache_key);
     add_metadata_key(_imp->ignore_deprecated_profiles);
     add_metadata_key(_imp->names_cache_key);
+    add_metadata_key(_imp->profile_cache_key);
     add_metadata_key(_imp->distdir_key);
     add_metadata_key(_imp->eclassdirs_key);
     add_metadata_key(_imp->securitydir_key);
@@ -945,6 +1022,14 @@ ERepository::perform_hook(const Hook & hook, const std::shared_ptr<OutputManager
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
+bool
+ERepository::want_hook(const std::string & name) const
+{
+    return name == "sync_all_post"
+        || name == "install_all_post"
+        || name == "uninstall_all_post";
+}
+
 std::shared_ptr<const CategoryNamePartSet>
 ERepository::unimportant_category_names(const RepositoryContentMayExcludes &) const
 {
@@ -1354,6 +1439,16 @@ ERepository::repository_factory_create(
         }
     }
 
+    std::string profile_cache(f("profile_cache"));
+    if (profile_cache.empty())
+    {
+        profile_cache = EExtraDistributionData::get_instance()->data_from_distribution(
+                *DistributionData::get_instance()->distribution_from_string(
+                    env->distribution()))->default_profile_cache();
+        if (profile_cache.empty())
+            profile_cache = "/var/empty";
+    }
+
     auto sync(std::make_shared<Map<std::string, std::string> >());
     std::vector<std::string> sync_tokens;
     tokenise_whitespace(f("sync"), std::back_inserter(sync_tokens));
@@ -1497,6 +1592,7 @@ ERepository::repository_factory_create(
                 n::master_repositories() = master_repositories,
                 n::names_cache() = FSPath(names_cache).realpath_if_exists(),
                 n::newsdir() = FSPath(newsdir).realpath_if_exists(),
+                n::profile_cache() = FSPath(profile_cache).realpath_if_exists(),
                 n::profile_eapi_when_unspecified() = profile_eapi,
                 n::profile_layout() = profile_layout,
                 n::profiles() = profiles,
@@ -1757,8 +1853,13 @@ ERepository::merge(const MergeParams & m)
             + "--" + stringify(m.package_id()->name().package()) + "-" + stringify(m.package_id()->version())
             + "--" + cookie());
 
+    PbinCompression compression(get_pbin_compression());
+
     PbinMerger merger(
             make_named_values<PbinMergerParams>(
+                n::compression() = compression.compression,
+                n::compression_level() = compression.level,
+                n::compression_threads() = compression.threads,
                 n::environment() = _imp->params.environment(),
                 n::environment_file() = m.environment_file(),
                 n::fix_mtimes_before() = fix_mtimes ?  m.build_start_time() : Timestamp(0, 0),
@@ -1770,7 +1871,7 @@ ERepository::merge(const MergeParams & m)
                 n::package_id() = m.package_id(),
                 n::permit_destination() = m.permit_destination(),
                 n::root() = FSPath("/"),
-                n::tar_file() = _imp->params.binary_distdir() / (bin_dist_base + pbin_tar_extension)
+                n::tar_file() = _imp->params.binary_distdir() / (bin_dist_base + compression.extension)
             ));
 
     if (m.check())
@@ -1782,10 +1883,6 @@ ERepository::merge(const MergeParams & m)
 
     merger.merge();
 
-    Process compress_process(ProcessCommand({"bzip2", stringify(_imp->params.binary_distdir() / (bin_dist_base + pbin_tar_extension)) }));
-    if (0 != compress_process.run().wait())
-        throw ActionFailedError("Compressing tarball failed");
-
     FSPath binary_ebuild_location(layout()->binary_ebuild_directory(m.package_id()->name()) / binary_ebuild_name(
                 m.package_id()->name(), m.package_id()->version(),
                 "pbin-1+" + std::static_pointer_cast<const ERepositoryID>(m.package_id())->eapi()->name()));
@@ -1813,7 +1910,7 @@ ERepository::merge(const MergeParams & m)
                 n::binary_distdir() = _imp->params.binary_distdir(),
                 n::binary_ebuild_location() = binary_ebuild_location,
                 n::binary_keywords() = binary_keywords,
-                n::binary_uri_extension() = pbin_tar_extension + ".bz2",
+                n::binary_uri_extension() = compression.extension,
                 n::builddir() = _imp->params.builddir(),
                 n::destination_repository() = this,
                 n::environment() = _imp->params.environment(),
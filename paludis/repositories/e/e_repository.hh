@@ -141,6 +141,9 @@ namespace paludis
             HookResult perform_hook(const Hook &, const std::shared_ptr<OutputManager> &)
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            bool want_hook(const std::string &) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             virtual std::shared_ptr<const CategoryNamePartSet> unimportant_category_names(const RepositoryContentMayExcludes &) const;
             virtual const bool is_unimportant() const;
 
@@ -34,6 +34,7 @@
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/set.hh>
 #include <paludis/util/fs_stat.hh>
+#include <paludis/util/timestamp.hh>
 #include <paludis/util/safe_ifstream.hh>
 #include <paludis/util/stringify.hh>
 
@@ -561,6 +562,72 @@ TEST_F(ERepositoryQueryUseTest, QueryUse)
     }
 }
 
+TEST_F(ERepositoryQueryUseTest, QueryUseSnapshot)
+{
+    FSPath snapshot(FSPath::cwd() / "e_repository_TEST_dir" / "profile_cache" / "test-repo-9");
+    FSPath target(FSPath::cwd() / "e_repository_TEST_dir" / "repo9" / "profiles" / "targets" / "package.use.force");
+    ASSERT_TRUE(! snapshot.stat().exists());
+    Timestamp written(Timestamp::now());
+    std::pair<dev_t, ino_t> written_id;
+
+    for (int pass = 1 ; pass <= 3 ; ++pass)
+    {
+        /* child/package.use.force is a symlink, so touching what it points to
+         * should make the snapshot stale */
+        if (3 == pass)
+            ASSERT_TRUE(target.utime(Timestamp(Timestamp::now().seconds() + 10, 0)));
+
+        TestEnvironment env;
+        std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+        keys->insert("format", "e");
+        keys->insert("names_cache", "/var/empty");
+        keys->insert("profile_cache", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "profile_cache"));
+        keys->insert("location", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo9"));
+        keys->insert("profiles", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo9/profiles/child"));
+        keys->insert("builddir", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "build"));
+        std::shared_ptr<ERepository> repo(std::static_pointer_cast<ERepository>(ERepository::repository_factory_create(&env,
+                        std::bind(from_keys, keys, std::placeholders::_1))));
+        env.add_repository(1, repo);
+
+        const std::shared_ptr<const PackageID> p1(*env[selection::RequireExactlyOne(generator::Matches(
+                        PackageDepSpec(parse_user_package_dep_spec("=cat-one/pkg-one-1",
+                                &env, { })), nullptr, { }))]->begin());
+        const std::shared_ptr<const PackageID> p2(*env[selection::RequireExactlyOne(generator::Matches(
+                        PackageDepSpec(parse_user_package_dep_spec("=cat-two/pkg-two-1",
+                                &env, { })), nullptr, { }))]->begin());
+
+        test_choice(p1, "flag1",     true,  true,  false);
+        test_choice(p1, "flag2",     false, false, true);
+        test_choice(p1, "flag4",     true,  true,  true);
+        test_choice(p1, "enabled3",  false, false, true);
+        test_choice(p1, "disabled3", true,  true,  true);
+
+        test_choice(p2, "flag3", false, false, true);
+        test_choice(p2, "flag5", true,  true,  true);
+        test_choice(p2, "flag6", true,  true,  false);
+
+        test_choice(p1, "not_in_iuse_masked_package", false, false, true, "masked_package");
+        test_choice(p2, "not_in_iuse_forced_package", true, true, true, "forced_package");
+
+        ASSERT_TRUE(snapshot.stat().is_regular_file()) << "pass " << pass;
+
+        /* the second pass should use the snapshot, not write a new one, and
+         * the third should replace it */
+        if (1 == pass)
+        {
+            written = snapshot.stat().mtim();
+            written_id = snapshot.stat().lowlevel_id();
+        }
+        else if (2 == pass)
+        {
+            EXPECT_EQ(written, snapshot.stat().mtim());
+            EXPECT_TRUE(written_id == snapshot.stat().lowlevel_id());
+        }
+        else
+            EXPECT_TRUE(written_id != snapshot.stat().lowlevel_id());
+    }
+}
+
 TEST_F(ERepositoryQueryUseTest, UseStableMaskForce)
 {
     bool accept_unstable(false);
@@ -22,6 +22,7 @@
 #include <paludis/repositories/e/e_repository_id.hh>
 #include <paludis/repositories/e/eapi.hh>
 #include <paludis/repositories/e/exndbam_repository.hh>
+#include <paludis/repositories/e/spec_tree_pretty_printer.hh>
 
 #include <paludis/repositories/fake/fake_installed_repository.hh>
 #include <paludis/repositories/fake/fake_package_id.hh>
@@ -35,6 +36,9 @@
 #include <paludis/util/set.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/fs_stat.hh>
 
 #include <paludis/standard_output_manager.hh>
 #include <paludis/package_id.hh>
@@ -47,11 +51,14 @@
 #include <paludis/selection.hh>
 #include <paludis/repository_factory.hh>
 #include <paludis/choice.hh>
+#include <paludis/unformatted_pretty_printer.hh>
 
 #include <functional>
 #include <set>
 #include <string>
 
+#include <fcntl.h>
+
 #include "config.h"
 
 #include <gtest/gtest.h>
@@ -691,3 +698,60 @@ TEST(ERepository, ReallyInstallExheres0)
     }
 }
 
+
+TEST(ERepository, Exheres0ProfileSnapshot)
+{
+    FSPath snapshot(FSPath::cwd() / "e_repository_TEST_exheres_0_dir" / "profile_cache" / "snapshot-repo");
+    ASSERT_TRUE(! snapshot.stat().exists());
+    Timestamp written(Timestamp::now());
+
+    for (int pass = 1 ; pass <= 3 ; ++pass)
+    {
+        /* a changed options.conf should make us ignore the snapshot */
+        if (3 == pass)
+        {
+            SafeOFStream f(FSPath::cwd() / "e_repository_TEST_exheres_0_dir" / "snapshotrepo/profiles/child/options.conf",
+                    O_WRONLY | O_APPEND, true);
+            f << "cat/snap baz" << std::endl;
+        }
+
+        TestEnvironment env;
+        std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+        keys->insert("format", "e");
+        keys->insert("names_cache", "/var/empty");
+        keys->insert("location", stringify(FSPath::cwd() / "e_repository_TEST_exheres_0_dir" / "snapshotrepo"));
+        keys->insert("profiles", stringify(FSPath::cwd() / "e_repository_TEST_exheres_0_dir" / "snapshotrepo/profiles/child"));
+        keys->insert("profile_cache", stringify(FSPath::cwd() / "e_repository_TEST_exheres_0_dir" / "profile_cache"));
+        keys->insert("profile_layout", "exheres");
+        keys->insert("layout", "exheres");
+        keys->insert("eapi_when_unknown", "exheres-0");
+        keys->insert("eapi_when_unspecified", "exheres-0");
+        keys->insert("profile_eapi_when_unspecified", "exheres-0");
+        keys->insert("builddir", stringify(FSPath::cwd() / "e_repository_TEST_exheres_0_dir" / "build"));
+        std::shared_ptr<Repository> repo(ERepository::repository_factory_create(&env,
+                    std::bind(from_keys, keys, std::placeholders::_1)));
+        env.add_repository(1, repo);
+
+        const std::shared_ptr<const PackageID> id(*env[selection::RequireExactlyOne(generator::Matches(
+                        PackageDepSpec(parse_user_package_dep_spec("cat/snap", &env, { })), nullptr, { }))]->last());
+        auto choices(id->choices_key()->parse_value());
+        EXPECT_TRUE(choices->find_by_name_with_prefix(ChoiceNameWithPrefix("foo"))->enabled_by_default()) << "pass " << pass;
+        EXPECT_FALSE(choices->find_by_name_with_prefix(ChoiceNameWithPrefix("bar"))->enabled_by_default()) << "pass " << pass;
+        EXPECT_EQ(3 == pass, choices->find_by_name_with_prefix(ChoiceNameWithPrefix("baz"))->enabled_by_default()) << "pass " << pass;
+
+        std::shared_ptr<const SetSpecTree> system(env.set(SetName("system::snapshot-repo")));
+        ASSERT_TRUE(bool(system));
+        UnformattedPrettyPrinter ff;
+        erepository::SpecTreePrettyPrinter pretty(ff, { });
+        system->top()->accept(pretty);
+        EXPECT_EQ("cat/snap", stringify(pretty)) << "pass " << pass;
+
+        ASSERT_TRUE(snapshot.stat().is_regular_file()) << "pass " << pass;
+
+        /* the second pass should use the snapshot, not write a new one */
+        if (1 == pass)
+            written = snapshot.stat().mtim();
+        else if (2 == pass)
+            EXPECT_EQ(written, snapshot.stat().mtim());
+    }
+}
@@ -1284,4 +1284,31 @@ END
 
 cd ..
 
+mkdir -p profile_cache
+mkdir -p snapshotrepo/{profiles/base,profiles/child,metadata,packages/cat/snap} || exit 1
+cd snapshotrepo || exit 1
+echo "snapshot-repo" >> profiles/repo_name || exit 1
+echo "cat" >> metadata/categories.conf || exit 1
+cat <<END > profiles/base/make.defaults
+CHOST="i286-badger-linux-gnu"
+END
+cat <<END > profiles/base/options.conf
+*/* foo bar
+END
+cat <<END > profiles/base/system.conf
+cat/snap
+END
+echo ../base > profiles/child/parents.conf
+cat <<END > profiles/child/options.conf
+cat/snap -bar
+END
+cat <<'END' > packages/cat/snap/snap-1.exheres-0 || exit 1
+SUMMARY="The Short Description"
+SLOT="0"
+MYOPTIONS="foo bar baz"
+LICENCES="GPL-2"
+PLATFORMS="test"
+END
+cd ..
+
 cd ..
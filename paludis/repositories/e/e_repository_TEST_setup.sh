@@ -12,6 +12,8 @@ touch vdb/THISISTHEVDB
 mkdir -p build
 ln -s build symlinked_build
 
+mkdir -p profile_cache
+
 mkdir -p distdir
 echo "already fetched" > distdir/already-fetched.txt || exit 1
 cat <<END > distdir/expatch-success-1.patch || exit 1
@@ -227,10 +229,12 @@ cat-two/pkg-two flag3
 >=cat-one/pkg-one-2 flag3
 cat-one/pkg-one not_in_iuse_masked_package
 END
-cat <<END >profiles/child/package.use.force || exit 1
+mkdir -p profiles/targets || exit 1
+cat <<END >profiles/targets/package.use.force || exit 1
 cat-two/pkg-two flag5
 cat-two/pkg-two not_in_iuse_forced_package
 END
+ln -s ../targets/package.use.force profiles/child/package.use.force || exit 1
 cat <<END >profiles/child/parent || exit 1
 ../profile
 END
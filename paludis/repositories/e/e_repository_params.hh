@@ -62,6 +62,7 @@ namespace paludis
         typedef Name<struct name_master_repositories> master_repositories;
         typedef Name<struct name_names_cache> names_cache;
         typedef Name<struct name_newsdir> newsdir;
+        typedef Name<struct name_profile_cache> profile_cache;
         typedef Name<struct name_profile_eapi_when_unspecified> profile_eapi_when_unspecified;
         typedef Name<struct name_profile_layout> profile_layout;
         typedef Name<struct name_profiles> profiles;
@@ -103,6 +104,7 @@ namespace paludis
             NamedValue<n::master_repositories, std::shared_ptr<const ERepositorySequence> > master_repositories;
             NamedValue<n::names_cache, FSPath> names_cache;
             NamedValue<n::newsdir, FSPath> newsdir;
+            NamedValue<n::profile_cache, FSPath> profile_cache;
             NamedValue<n::profile_eapi_when_unspecified, std::string> profile_eapi_when_unspecified;
             NamedValue<n::profile_layout, std::string> profile_layout;
             NamedValue<n::profiles, std::shared_ptr<const FSPathSequence> > profiles;
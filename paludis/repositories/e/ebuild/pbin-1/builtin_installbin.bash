@@ -21,6 +21,15 @@ builtin_installbin()
     if [[ ${!PALUDIS_ARCHIVES_VAR%.tar.bz2} != ${!PALUDIS_ARCHIVES_VAR} ]] ; then
         echo tar jvxpf "${!PALUDIS_BINARY_DISTDIR_VARIABLE}"/${!PALUDIS_ARCHIVES_VAR} -C "${!PALUDIS_IMAGE_DIR_VAR}"/ --exclude PBIN 1>&2
         tar jvxpf "${!PALUDIS_BINARY_DISTDIR_VARIABLE}"/${!PALUDIS_ARCHIVES_VAR} -C "${!PALUDIS_IMAGE_DIR_VAR}"/ --exclude PBIN || die "Couldn't extract image"
+    elif [[ ${!PALUDIS_ARCHIVES_VAR%.tar.xz} != ${!PALUDIS_ARCHIVES_VAR} ]] ; then
+        echo tar -I "xz -T0" -vxpf "${!PALUDIS_BINARY_DISTDIR_VARIABLE}"/${!PALUDIS_ARCHIVES_VAR} -C "${!PALUDIS_IMAGE_DIR_VAR}"/ --exclude PBIN 1>&2
+        tar -I "xz -T0" -vxpf "${!PALUDIS_BINARY_DISTDIR_VARIABLE}"/${!PALUDIS_ARCHIVES_VAR} -C "${!PALUDIS_IMAGE_DIR_VAR}"/ --exclude PBIN || die "Couldn't extract image"
+    elif [[ ${!PALUDIS_ARCHIVES_VAR%.tar.zst} != ${!PALUDIS_ARCHIVES_VAR} ]] ; then
+        echo tar --zstd -vxpf "${!PALUDIS_BINARY_DISTDIR_VARIABLE}"/${!PALUDIS_ARCHIVES_VAR} -C "${!PALUDIS_IMAGE_DIR_VAR}"/ --exclude PBIN 1>&2
+        tar --zstd -vxpf "${!PALUDIS_BINARY_DISTDIR_VARIABLE}"/${!PALUDIS_ARCHIVES_VAR} -C "${!PALUDIS_IMAGE_DIR_VAR}"/ --exclude PBIN || die "Couldn't extract image"
+    elif [[ ${!PALUDIS_ARCHIVES_VAR%.tar} != ${!PALUDIS_ARCHIVES_VAR} ]] ; then
+        echo tar -vxpf "${!PALUDIS_BINARY_DISTDIR_VARIABLE}"/${!PALUDIS_ARCHIVES_VAR} -C "${!PALUDIS_IMAGE_DIR_VAR}"/ --exclude PBIN 1>&2
+        tar -vxpf "${!PALUDIS_BINARY_DISTDIR_VARIABLE}"/${!PALUDIS_ARCHIVES_VAR} -C "${!PALUDIS_IMAGE_DIR_VAR}"/ --exclude PBIN || die "Couldn't extract image"
     elif [[ ${!PALUDIS_ARCHIVES_VAR%.pax.bz2} != ${!PALUDIS_ARCHIVES_VAR} ]] ; then
         echo unpaxinate img "${!PALUDIS_BINARY_DISTDIR_VARIABLE}"/${!PALUDIS_ARCHIVES_VAR} "${!PALUDIS_IMAGE_DIR_VAR}" 1>&2
         unpaxinate img "${!PALUDIS_BINARY_DISTDIR_VARIABLE}"/${!PALUDIS_ARCHIVES_VAR} "${!PALUDIS_IMAGE_DIR_VAR}" || die "Couldn't extract image"
@@ -22,6 +22,7 @@
 #include <paludis/repositories/e/e_repository.hh>
 #include <paludis/repositories/e/eapi.hh>
 #include <paludis/repositories/e/dep_parser.hh>
+#include <paludis/repositories/e/profile_snapshot.hh>
 
 #include <paludis/util/log.hh>
 #include <paludis/util/tokeniser.hh>
@@ -36,6 +37,8 @@
 #include <paludis/util/system.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/join.hh>
 
 #include <paludis/choice.hh>
 #include <paludis/environment.hh>
@@ -48,23 +51,21 @@
 
 #include <unordered_map>
 #include <list>
+#include <map>
+#include <functional>
 
 using namespace paludis;
 using namespace paludis::erepository;
 
 namespace
 {
-    const std::shared_ptr<const LineConfigFile> make_config_file(
-            const FSPath & f,
-            const LineConfigFileOptions & o)
-    {
-        return std::make_shared<LineConfigFile>(f, o);
-    }
-
     typedef std::unordered_map<std::string, std::string, Hash<std::string> > EnvironmentVariablesMap;
     typedef std::unordered_map<QualifiedPackageName,
             std::list<std::pair<std::shared_ptr<const PackageDepSpec>, std::shared_ptr<const MaskInfo> > >,
             Hash<QualifiedPackageName> > PackageMaskMap;
+
+    /* EAPI and text of each options.conf and system.conf we use */
+    typedef std::map<std::string, std::pair<std::string, std::string> > FileTextsMap;
 }
 
 namespace paludis
@@ -91,6 +92,9 @@ namespace paludis
 
         const std::shared_ptr<SetSpecTree> system_packages;
 
+        FileTextsMap file_texts;
+        std::shared_ptr<ProfileSnapshotWriter> snapshot;
+
         Imp(
                 const Environment * const e,
                 const EAPIForFileFunction & f,
@@ -102,7 +106,8 @@ namespace paludis
             options_conf(make_named_values<PaludisLikeOptionsConfParams>(
                         n::allow_locking() = true,
                         n::environment() = e,
-                        n::make_config_file() = &make_config_file
+                        n::make_config_file() = std::bind(&Imp::make_config_file, this,
+                            std::placeholders::_1, std::placeholders::_2)
                         )),
             use_expand(std::make_shared<Set<std::string>>()),
             use_expand_hidden(std::make_shared<Set<std::string>>()),
@@ -116,6 +121,24 @@ namespace paludis
             environment_variables["CONFIG_PROTECT"] = getenv_with_default("CONFIG_PROTECT", "/etc");
             environment_variables["CONFIG_PROTECT_MASK"] = getenv_with_default("CONFIG_PROTECT_MASK", "");
         }
+
+        const std::shared_ptr<const LineConfigFile> make_config_file(
+                const FSPath & f,
+                const LineConfigFileOptions & o) const
+        {
+            auto t(file_texts.find(stringify(f)));
+            if (file_texts.end() == t)
+                return std::make_shared<LineConfigFile>(f, o);
+            else
+                return std::make_shared<LineConfigFile>(ConfigFile::Source(t->second.second), o);
+        }
+
+        void add_file_text(const FSPath & f, const std::string & eapi)
+        {
+            SafeIFStream file(f);
+            file_texts[stringify(f)] = std::make_pair(eapi, std::string(
+                        (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()));
+        }
     };
 }
 
@@ -128,12 +151,65 @@ ExheresProfile::ExheresProfile(
         const std::string &,
         const bool,
         const bool has_master_repositories,
-        const bool) :
+        const bool,
+        const FSPath & snapshot_location) :
     _imp(env, eapi_for_file, has_master_repositories)
 {
-    for (FSPathSequence::ConstIterator l(location.begin()), l_end(location.end()) ;
-            l != l_end ; ++l)
-        _load_dir(*l);
+    /* options.conf and system.conf are saved as text, and parsed again when
+     * the snapshot is loaded, since their parsed forms aren't something we
+     * can write out without losing information. */
+    std::string key;
+    bool from_snapshot(false);
+    if (snapshot_location != FSPath("/var/empty"))
+    {
+        key = "exheres\n" + join(location.begin(), location.end(), "\n") + "\n" + stringify(has_master_repositories) + "\n" +
+            _imp->environment_variables["CONFIG_PROTECT"] + "\n" + _imp->environment_variables["CONFIG_PROTECT_MASK"];
+        from_snapshot = _load_snapshot(snapshot_location, key);
+        if (! from_snapshot)
+            _imp->snapshot = std::make_shared<ProfileSnapshotWriter>(snapshot_location, key);
+    }
+
+    if (from_snapshot)
+    {
+        for (FSPathSequence::ConstIterator l(_imp->profiles_with_parents->begin()), l_end(_imp->profiles_with_parents->end()) ;
+                l != l_end ; ++l)
+            _load_dir_files(*l);
+    }
+    else
+    {
+        for (FSPathSequence::ConstIterator l(location.begin()), l_end(location.end()) ;
+                l != l_end ; ++l)
+            _load_dir(*l);
+
+        if (_imp->snapshot)
+        {
+            ProfileSnapshotWriter & w(*_imp->snapshot);
+
+            w.write_number(std::distance(_imp->profiles_with_parents->begin(), _imp->profiles_with_parents->end()));
+            for (FSPathSequence::ConstIterator l(_imp->profiles_with_parents->begin()), l_end(_imp->profiles_with_parents->end()) ;
+                    l != l_end ; ++l)
+                w.write_string(stringify(*l));
+
+            w.write_number(_imp->environment_variables.size());
+            for (EnvironmentVariablesMap::const_iterator v(_imp->environment_variables.begin()), v_end(_imp->environment_variables.end()) ;
+                    v != v_end ; ++v)
+            {
+                w.write_string(v->first);
+                w.write_string(v->second);
+            }
+
+            w.write_number(_imp->file_texts.size());
+            for (const auto & t : _imp->file_texts)
+            {
+                w.write_string(t.first);
+                w.write_string(t.second.first);
+                w.write_string(t.second.second);
+            }
+
+            w.save();
+            _imp->snapshot.reset();
+        }
+    }
 
     const std::shared_ptr<const Set<UnprefixedChoiceName> > s(_imp->options_conf.known_choice_value_names(
                 nullptr, ChoicePrefixName("suboptions")));
@@ -160,9 +236,59 @@ ExheresProfile::ExheresProfile(
 
 ExheresProfile::~ExheresProfile() = default;
 
+bool
+ExheresProfile::_load_snapshot(const FSPath & snapshot_location, const std::string & key)
+{
+    ProfileSnapshotReader r(snapshot_location, key);
+    if (! r.usable())
+        return false;
+
+    try
+    {
+        auto profiles_with_parents(std::make_shared<FSPathSequence>());
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+            profiles_with_parents->push_back(FSPath(r.read_string()));
+
+        EnvironmentVariablesMap environment_variables;
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            std::string k(r.read_string());
+            environment_variables[k] = r.read_string();
+        }
+
+        FileTextsMap file_texts;
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            std::string k(r.read_string());
+            std::string eapi(r.read_string());
+            file_texts[k] = std::make_pair(eapi, r.read_string());
+        }
+
+        r.done();
+
+        _imp->profiles_with_parents = profiles_with_parents;
+        std::swap(_imp->environment_variables, environment_variables);
+        std::swap(_imp->file_texts, file_texts);
+        return true;
+    }
+    catch (const ProfileSnapshotError & e)
+    {
+        Log::get_instance()->message("e.exheres_profile.snapshot.unusable", ll_debug, lc_context)
+            << "Not using profile snapshot '" << snapshot_location << "' due to exception '" << e.message() << "' (" << e.what() << ")";
+        return false;
+    }
+}
+
 void
 ExheresProfile::_load_dir(const FSPath & f)
 {
+    if (_imp->snapshot)
+    {
+        _imp->snapshot->add_source(f);
+        for (const auto & s : { "eapi", "parents.conf", "make.defaults", "options.conf", "system.conf" })
+            _imp->snapshot->add_source(f / s);
+    }
+
     if (! f.stat().is_directory_or_symlink_to_directory())
     {
         Log::get_instance()->message("e.exheres_profile.not_a_directory", ll_warning, lc_context) <<
@@ -179,25 +305,12 @@ ExheresProfile::_load_dir(const FSPath & f)
     }
 
     if ((f / "options.conf").stat().exists())
-        _imp->options_conf.add_file(f / "options.conf");
+        _imp->add_file_text(f / "options.conf", "");
 
-    if (! _imp->has_master_repositories)
-    {
-        if ((f / "system.conf").stat().exists())
-        {
-            SafeIFStream file(f / "system.conf");
-            std::string file_text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-            auto eapi(EAPIData::get_instance()->eapi_from_string(_imp->eapi_for_file(f / "system.conf")));
-            auto specs(parse_commented_set(file_text, _imp->env, *EAPIData::get_instance()->eapi_from_string(_imp->eapi_for_file(f / "system.conf"))));
+    if ((! _imp->has_master_repositories) && (f / "system.conf").stat().exists())
+        _imp->add_file_text(f / "system.conf", _imp->eapi_for_file(f / "system.conf"));
 
-            DepSpecFlattener<SetSpecTree, PackageDepSpec> flat_specs(_imp->env, nullptr);
-            specs->top()->accept(flat_specs);
-
-            for (auto s(flat_specs.begin()), s_end(flat_specs.end()) ;
-                    s != s_end ; ++s)
-                _imp->system_packages->top()->append(std::make_shared<PackageDepSpec>(**s));
-        }
-    }
+    _load_dir_files(f);
 
     if ((f / "make.defaults").stat().exists())
     {
@@ -218,6 +331,29 @@ ExheresProfile::_load_dir(const FSPath & f)
     _imp->profiles_with_parents->push_back(f);
 }
 
+void
+ExheresProfile::_load_dir_files(const FSPath & f)
+{
+    if (_imp->file_texts.end() != _imp->file_texts.find(stringify(f / "options.conf")))
+        _imp->options_conf.add_file(f / "options.conf");
+
+    if (! _imp->has_master_repositories)
+    {
+        auto t(_imp->file_texts.find(stringify(f / "system.conf")));
+        if (_imp->file_texts.end() != t)
+        {
+            auto specs(parse_commented_set(t->second.second, _imp->env, *EAPIData::get_instance()->eapi_from_string(t->second.first)));
+
+            DepSpecFlattener<SetSpecTree, PackageDepSpec> flat_specs(_imp->env, nullptr);
+            specs->top()->accept(flat_specs);
+
+            for (auto s(flat_specs.begin()), s_end(flat_specs.end()) ;
+                    s != s_end ; ++s)
+                _imp->system_packages->top()->append(std::make_shared<PackageDepSpec>(**s));
+        }
+    }
+}
+
 std::shared_ptr<const FSPathSequence>
 ExheresProfile::profiles_with_parents() const
 {
@@ -35,6 +35,8 @@ namespace paludis
                 Pimp<ExheresProfile> _imp;
 
                 void _load_dir(const FSPath &);
+                void _load_dir_files(const FSPath &);
+                bool _load_snapshot(const FSPath &, const std::string &);
 
             public:
                 ExheresProfile(
@@ -46,7 +48,8 @@ namespace paludis
                         const std::string & arch_var_if_special,
                         const bool profiles_explicitly_set,
                         const bool has_master_repositories,
-                        const bool ignore_deprecated_profiles);
+                        const bool ignore_deprecated_profiles,
+                        const FSPath & snapshot_location);
 
                 virtual ~ExheresProfile();
 
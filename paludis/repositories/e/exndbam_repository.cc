@@ -38,6 +38,7 @@
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/join.hh>
+#include <paludis/util/destringify.hh>
 #include <paludis/util/return_literal_function.hh>
 
 #include <paludis/output_manager.hh>
@@ -163,6 +164,20 @@ ExndbamRepository::repository_factory_create(
                 *DistributionData::get_instance()->distribution_from_string(
                     env->distribution()))->default_eapi_when_unknown();
 
+    FSMergerDurability merge_durability(fsmd_none);
+    if (! f("merge_durability").empty())
+    {
+        try
+        {
+            merge_durability = destringify<FSMergerDurability>(f("merge_durability"));
+        }
+        catch (const DestringifyError &)
+        {
+            throw ExndbamRepositoryConfigurationError("Value '" + f("merge_durability") + "' for key 'merge_durability' is not one of "
+                    "'none', 'batched' or 'per_file'");
+        }
+    }
+
     return std::make_shared<ExndbamRepository>(
             RepositoryName(name),
             make_named_values<ExndbamRepositoryParams>(
@@ -170,6 +185,7 @@ ExndbamRepository::repository_factory_create(
                 n::eapi_when_unknown() = eapi_when_unknown,
                 n::environment() = env,
                 n::location() = location,
+                n::merge_durability() = merge_durability,
                 n::root() = root
                 )
             );
@@ -469,6 +485,7 @@ ExndbamRepository::merge(const MergeParams & m)
                 n::config_protect() = config_protect,
                 n::config_protect_mask() = config_protect_mask,
                 n::contents_file() = target_ver_dir / "contents",
+                n::durability() = _imp->params.merge_durability(),
                 n::environment() = _imp->params.environment(),
                 n::fix_mtimes_before() = fix_mtimes ?  m.build_start_time() : Timestamp(0, 0),
                 n::fs_merger_options() = eapi->fs_merger_options(),
@@ -25,6 +25,7 @@
 #include <paludis/util/pimp.hh>
 #include <paludis/util/map.hh>
 #include <paludis/repository.hh>
+#include <paludis/fs_merger-fwd.hh>
 #include <memory>
 
 namespace paludis
@@ -35,6 +36,7 @@ namespace paludis
         typedef Name<struct name_eapi_when_unknown> eapi_when_unknown;
         typedef Name<struct name_environment> environment;
         typedef Name<struct name_location> location;
+        typedef Name<struct name_merge_durability> merge_durability;
         typedef Name<struct name_root> root;
     }
 
@@ -48,6 +50,10 @@ namespace paludis
             NamedValue<n::eapi_when_unknown, std::string> eapi_when_unknown;
             NamedValue<n::environment, Environment *> environment;
             NamedValue<n::location, FSPath> location;
+
+            ///\since 3.0
+            NamedValue<n::merge_durability, FSMergerDurability> merge_durability;
+
             NamedValue<n::root, FSPath> root;
         };
     }
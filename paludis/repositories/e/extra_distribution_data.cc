@@ -59,6 +59,7 @@ namespace paludis
                             n::default_layout() = k->get("default_layout"),
                             n::default_manifest_hashes() = make_set(toupper(k->get("default_manifest_hashes"))),
                             n::default_names_cache() = k->get("default_names_cache"),
+                            n::default_profile_cache() = k->get("default_profile_cache"),
                             n::default_profile_eapi() = k->get("default_profile_eapi"),
                             n::default_profile_layout() = k->get("default_profile_layout"),
                             n::default_thin_manifests() = destringify<bool>(k->get("default_thin_manifests")),
@@ -67,7 +67,9 @@ namespace
 
 PbinMerger::PbinMerger(const PbinMergerParams & p) :
     TarMerger(make_named_values<TarMergerParams>(
-                n::compression() = tmc_none,
+                n::compression() = p.compression(),
+                n::compression_level() = p.compression_level(),
+                n::compression_threads() = p.compression_threads(),
                 n::environment() = p.environment(),
                 n::fix_mtimes_before() = p.fix_mtimes_before(),
                 n::get_new_ids_or_minus_one() = std::bind(&get_new_ids_or_minus_one, p.environment(), std::placeholders::_1),
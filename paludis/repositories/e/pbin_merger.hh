@@ -30,6 +30,9 @@ namespace paludis
 {
     namespace n
     {
+        typedef Name<struct name_compression> compression;
+        typedef Name<struct name_compression_level> compression_level;
+        typedef Name<struct name_compression_threads> compression_threads;
         typedef Name<struct name_environment> environment;
         typedef Name<struct name_environment_file> environment_file;
         typedef Name<struct name_fix_mtimes_before> fix_mtimes_before;
@@ -48,6 +51,9 @@ namespace paludis
     {
         struct PbinMergerParams
         {
+            NamedValue<n::compression, TarMergerCompression> compression;
+            NamedValue<n::compression_level, int> compression_level;
+            NamedValue<n::compression_threads, unsigned> compression_threads;
             NamedValue<n::environment, Environment *> environment;
             NamedValue<n::environment_file, FSPath> environment_file;
             NamedValue<n::fix_mtimes_before, Timestamp> fix_mtimes_before;
@@ -46,12 +46,13 @@ ProfileFactory::create(
         const std::string & arch_var_if_special,
         const bool profiles_explicitly_set,
         const bool has_master_repositories,
-        const bool ignore_deprecated_profiles) const
+        const bool ignore_deprecated_profiles,
+        const FSPath & snapshot_location) const
 {
     if (format == "traditional")
-        return std::make_shared<TraditionalProfile>(env, name, eapi_for_file, is_arch_flag, dirs, arch_var_if_special, profiles_explicitly_set, has_master_repositories, ignore_deprecated_profiles);
+        return std::make_shared<TraditionalProfile>(env, name, eapi_for_file, is_arch_flag, dirs, arch_var_if_special, profiles_explicitly_set, has_master_repositories, ignore_deprecated_profiles, snapshot_location);
     if (format == "exheres")
-        return std::make_shared<ExheresProfile>(env, name, eapi_for_file, is_arch_flag, dirs, arch_var_if_special, profiles_explicitly_set, has_master_repositories, ignore_deprecated_profiles);
+        return std::make_shared<ExheresProfile>(env, name, eapi_for_file, is_arch_flag, dirs, arch_var_if_special, profiles_explicitly_set, has_master_repositories, ignore_deprecated_profiles, snapshot_location);
 
     throw ConfigurationError("Unrecognised profile '" + format + "'");
 }
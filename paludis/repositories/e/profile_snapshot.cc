@@ -0,0 +1,349 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/repositories/e/profile_snapshot.hh>
+
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/log.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+
+#include <paludis/about.hh>
+
+#include <iterator>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    const std::string snapshot_magic("paludis-profile-snapshot\n");
+
+    /* bump this whenever the layout written by either profile class changes */
+    const uint64_t snapshot_format(1);
+
+    void append_number(std::string & s, const uint64_t n)
+    {
+        for (int i(0) ; i < 8 ; ++i)
+            s.push_back(static_cast<char>((n >> (8 * i)) & 0xff));
+    }
+
+    void append_string(std::string & s, const std::string & v)
+    {
+        append_number(s, v.length());
+        s.append(v);
+    }
+
+    void append_source(std::string & s, const FSPath & f)
+    {
+        append_string(s, stringify(f));
+
+        /* profile files are often symlinks into another tree, so look at
+         * what they point to, not the link */
+        FSStat f_stat(f.realpath_if_exists());
+        append_number(s, f_stat.exists());
+        if (f_stat.exists())
+        {
+            append_number(s, f_stat.mtim().seconds());
+            append_number(s, f_stat.mtim().nanoseconds());
+            append_number(s, f_stat.is_regular_file() ? f_stat.file_size() : 0);
+        }
+    }
+
+    void remove_if_possible(const FSPath & f)
+    {
+        try
+        {
+            f.unlink();
+        }
+        catch (const FSError &)
+        {
+        }
+    }
+
+    struct Cursor
+    {
+        const std::string & data;
+        std::string::size_type pos;
+        std::string::size_type end;
+
+        Cursor(const std::string & d, const std::string::size_type p, const std::string::size_type e) :
+            data(d),
+            pos(p),
+            end(e)
+        {
+        }
+
+        uint64_t number()
+        {
+            if (end - pos < 8)
+                throw ProfileSnapshotError("Unexpected end of snapshot");
+
+            uint64_t result(0);
+            for (int i(0) ; i < 8 ; ++i)
+                result |= uint64_t(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+            pos += 8;
+            return result;
+        }
+
+        std::string string()
+        {
+            uint64_t length(number());
+            if (end - pos < length)
+                throw ProfileSnapshotError("Unexpected end of snapshot");
+
+            std::string result(data, pos, length);
+            pos += length;
+            return result;
+        }
+    };
+}
+
+ProfileSnapshotError::ProfileSnapshotError(const std::string & s) noexcept :
+    Exception(s)
+{
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<ProfileSnapshotWriter>
+    {
+        const FSPath location;
+        const std::string key;
+
+        uint64_t sources_count;
+        std::string sources;
+        std::string payload;
+
+        Imp(const FSPath & l, const std::string & k) :
+            location(l),
+            key(k),
+            sources_count(0)
+        {
+        }
+    };
+
+    template <>
+    struct Imp<ProfileSnapshotReader>
+    {
+        std::string data;
+        bool usable;
+        std::string::size_type payload_start;
+
+        Imp() :
+            usable(false),
+            payload_start(0)
+        {
+        }
+    };
+}
+
+ProfileSnapshotWriter::ProfileSnapshotWriter(const FSPath & l, const std::string & k) :
+    _imp(l, k)
+{
+}
+
+ProfileSnapshotWriter::~ProfileSnapshotWriter() = default;
+
+void
+ProfileSnapshotWriter::add_source(const FSPath & f)
+{
+    append_source(_imp->sources, f);
+    ++_imp->sources_count;
+}
+
+void
+ProfileSnapshotWriter::write_string(const std::string & s)
+{
+    append_string(_imp->payload, s);
+}
+
+void
+ProfileSnapshotWriter::write_number(const uint64_t n)
+{
+    append_number(_imp->payload, n);
+}
+
+void
+ProfileSnapshotWriter::write_bool(const bool b)
+{
+    append_number(_imp->payload, b);
+}
+
+void
+ProfileSnapshotWriter::save() const
+{
+    Context context("When saving profile snapshot to '" + stringify(_imp->location) + "':");
+
+    if (! _imp->location.dirname().stat().is_directory_or_symlink_to_directory())
+    {
+        Log::get_instance()->message("e.profile.snapshot.no_directory", ll_debug, lc_context)
+            << "Not saving profile snapshot because '" << _imp->location.dirname() << "' is not a directory";
+        return;
+    }
+
+    /* most users can't write to the system-wide cache, and that's fine */
+    if (0 != ::access(stringify(_imp->location.dirname()).c_str(), W_OK))
+    {
+        Log::get_instance()->message("e.profile.snapshot.not_writable", ll_debug, lc_context)
+            << "Not saving profile snapshot because '" << _imp->location.dirname() << "' is not writable";
+        return;
+    }
+
+    std::string header(snapshot_magic);
+    append_number(header, snapshot_format);
+    append_number(header, PALUDIS_VERSION);
+    append_string(header, _imp->key);
+    append_number(header, _imp->sources_count);
+
+    /* write to a temporary file and rename, so that a concurrent reader never
+     * sees a partial snapshot */
+    FSPath tmp(stringify(_imp->location) + ".tmp." + stringify(::getpid()));
+    try
+    {
+        {
+            SafeOFStream f(tmp, O_CREAT | O_TRUNC | O_WRONLY, true);
+            f << header << _imp->sources;
+            std::string length;
+            append_number(length, _imp->payload.length());
+            f << length << _imp->payload;
+        }
+
+        tmp.rename(_imp->location);
+    }
+    catch (const SafeOFStreamError & e)
+    {
+        Log::get_instance()->message("e.profile.snapshot.write_failure", ll_warning, lc_context)
+            << "Cannot write '" << tmp << "': '" << e.message() << "' (" << e.what() << ")";
+        remove_if_possible(tmp);
+    }
+    catch (const FSError & e)
+    {
+        Log::get_instance()->message("e.profile.snapshot.write_failure", ll_warning, lc_context)
+            << "Cannot rename '" << tmp << "': '" << e.message() << "' (" << e.what() << ")";
+        remove_if_possible(tmp);
+    }
+}
+
+ProfileSnapshotReader::ProfileSnapshotReader(const FSPath & location, const std::string & key)
+{
+    Context context("When loading profile snapshot from '" + stringify(location) + "':");
+
+    if (! location.stat().is_regular_file())
+        return;
+
+    try
+    {
+        SafeIFStream f(location);
+        _imp->data.assign((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+        if (0 != _imp->data.compare(0, snapshot_magic.length(), snapshot_magic))
+            return;
+
+        Cursor c(_imp->data, snapshot_magic.length(), _imp->data.length());
+        if (c.number() != snapshot_format || c.number() != PALUDIS_VERSION || c.string() != key)
+            return;
+
+        for (uint64_t n(c.number()) ; n > 0 ; --n)
+        {
+            std::string::size_type start(c.pos);
+            FSPath source(c.string());
+
+            std::string expected;
+            append_source(expected, source);
+            if (0 != _imp->data.compare(start, expected.length(), expected))
+            {
+                Log::get_instance()->message("e.profile.snapshot.stale", ll_debug, lc_context)
+                    << "Not using profile snapshot because '" << source << "' has changed";
+                return;
+            }
+
+            c.pos = start + expected.length();
+        }
+
+        if (c.number() != c.end - c.pos)
+            return;
+
+        _imp->payload_start = c.pos;
+        _imp->usable = true;
+    }
+    catch (const SafeIFStreamError & e)
+    {
+        Log::get_instance()->message("e.profile.snapshot.read_failure", ll_warning, lc_context)
+            << "Cannot read '" << location << "': '" << e.message() << "' (" << e.what() << ")";
+    }
+    catch (const ProfileSnapshotError &)
+    {
+        Log::get_instance()->message("e.profile.snapshot.corrupt", ll_debug, lc_context)
+            << "Not using profile snapshot because it is truncated";
+    }
+}
+
+ProfileSnapshotReader::~ProfileSnapshotReader() = default;
+
+bool
+ProfileSnapshotReader::usable() const
+{
+    return _imp->usable;
+}
+
+std::string
+ProfileSnapshotReader::read_string()
+{
+    Cursor c(_imp->data, _imp->payload_start, _imp->data.length());
+    std::string result(c.string());
+    _imp->payload_start = c.pos;
+    return result;
+}
+
+uint64_t
+ProfileSnapshotReader::read_number()
+{
+    Cursor c(_imp->data, _imp->payload_start, _imp->data.length());
+    uint64_t result(c.number());
+    _imp->payload_start = c.pos;
+    return result;
+}
+
+bool
+ProfileSnapshotReader::read_bool()
+{
+    return 0 != read_number();
+}
+
+void
+ProfileSnapshotReader::done() const
+{
+    if (_imp->payload_start != _imp->data.length())
+        throw ProfileSnapshotError("Trailing data in snapshot");
+}
+
+namespace paludis
+{
+    template class Pimp<ProfileSnapshotWriter>;
+    template class Pimp<ProfileSnapshotReader>;
+}
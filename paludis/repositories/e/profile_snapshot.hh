@@ -0,0 +1,145 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_PROFILE_SNAPSHOT_HH
+#define PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_PROFILE_SNAPSHOT_HH 1
+
+#include <paludis/util/pimp.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/fs_path.hh>
+#include <cstdint>
+#include <string>
+
+/** \file
+ * Declarations for the compiled profile snapshot classes.
+ *
+ * A snapshot holds the fully stacked state of a profile, so that it can be
+ * loaded without parsing any profile files. It is keyed by a caller supplied
+ * string (which should cover everything other than file contents that affects
+ * the result), and by the mtime and size of every file the profile was built
+ * from. If any of those differ, the snapshot is not used.
+ *
+ * \ingroup grperepository
+ */
+
+namespace paludis
+{
+    namespace erepository
+    {
+        /**
+         * Thrown if a profile snapshot is truncated or otherwise unreadable.
+         *
+         * \ingroup grpexceptions
+         * \ingroup grperepository
+         */
+        class PALUDIS_VISIBLE ProfileSnapshotError :
+            public Exception
+        {
+            public:
+                ProfileSnapshotError(const std::string &) noexcept;
+        };
+
+        /**
+         * Builds up and saves a profile snapshot.
+         *
+         * \ingroup grperepository
+         */
+        class PALUDIS_VISIBLE ProfileSnapshotWriter
+        {
+            private:
+                Pimp<ProfileSnapshotWriter> _imp;
+
+            public:
+                ///\name Basic operations
+                ///\{
+
+                ProfileSnapshotWriter(const FSPath & location, const std::string & key);
+                ~ProfileSnapshotWriter();
+
+                ProfileSnapshotWriter(const ProfileSnapshotWriter &) = delete;
+                ProfileSnapshotWriter & operator= (const ProfileSnapshotWriter &) = delete;
+
+                ///\}
+
+                /**
+                 * Record that the profile depends upon a file, which need not
+                 * exist. This should be called before the file is read, so
+                 * that a change made whilst we are loading makes the snapshot
+                 * stale rather than wrong.
+                 */
+                void add_source(const FSPath &);
+
+                void write_string(const std::string &);
+                void write_number(const uint64_t);
+                void write_bool(const bool);
+
+                /**
+                 * Write the snapshot out. Failure is not fatal, and is logged
+                 * rather than thrown.
+                 */
+                void save() const;
+        };
+
+        /**
+         * Reads a profile snapshot, if a current one exists.
+         *
+         * \ingroup grperepository
+         */
+        class PALUDIS_VISIBLE ProfileSnapshotReader
+        {
+            private:
+                Pimp<ProfileSnapshotReader> _imp;
+
+            public:
+                ///\name Basic operations
+                ///\{
+
+                ProfileSnapshotReader(const FSPath & location, const std::string & key);
+                ~ProfileSnapshotReader();
+
+                ProfileSnapshotReader(const ProfileSnapshotReader &) = delete;
+                ProfileSnapshotReader & operator= (const ProfileSnapshotReader &) = delete;
+
+                ///\}
+
+                /**
+                 * Does the snapshot exist, with a matching key, and with none
+                 * of its sources changed?
+                 */
+                bool usable() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                ///\name Read values, in the order they were written
+                ///\{
+
+                std::string read_string();
+                uint64_t read_number();
+                bool read_bool();
+
+                ///\}
+
+                /**
+                 * Check that everything in the snapshot has been read.
+                 */
+                void done() const;
+        };
+    }
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include <paludis/repositories/e/traditional_profile.hh>
 #include <paludis/repositories/e/traditional_profile_file.hh>
 #include <paludis/repositories/e/traditional_mask_file.hh>
+#include <paludis/repositories/e/profile_snapshot.hh>
 #include <paludis/repositories/e/e_repository_exceptions.hh>
 #include <paludis/repositories/e/e_repository.hh>
 #include <paludis/repositories/e/eapi.hh>
@@ -43,6 +44,7 @@
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/fs_error.hh>
 #include <paludis/util/upper_lower.hh>
+#include <paludis/util/make_named_values.hh>
 
 #include <paludis/choice.hh>
 #include <paludis/environment.hh>
@@ -83,6 +85,7 @@ namespace
     struct StackedValues
     {
         std::string origin;
+        std::shared_ptr<const EAPI> eapi;
 
         FlagStatusMap use_mask;
         FlagStatusMap use_stable_mask;
@@ -136,6 +139,8 @@ namespace paludis
 
         PackageMaskMap package_mask;
 
+        std::shared_ptr<ProfileSnapshotWriter> snapshot;
+
         Imp(const Environment * const e,
                 const EAPIForFileFunction & p,
                 const IsArchFlagFunction & a,
@@ -230,6 +235,15 @@ namespace
     {
         Context context("When adding profile directory '" + stringify(dir) + ":");
 
+        if (_imp->snapshot)
+        {
+            _imp->snapshot->add_source(dir);
+            for (const auto & f : { "eapi", "parent", "make.defaults", "use.mask", "use.force", "package.use",
+                    "package.use.mask", "package.use.force", "use.stable.mask", "use.stable.force",
+                    "package.use.stable.mask", "package.use.stable.force", "packages", "package.mask" })
+                _imp->snapshot->add_source(dir / f);
+        }
+
         if (! dir.stat().is_directory_or_symlink_to_directory())
         {
             Log::get_instance()->message("e.profile.not_a_directory", ll_warning, lc_context)
@@ -246,6 +260,7 @@ namespace
         load_profile_make_defaults(_imp, dir);
 
         _imp->stacked_values_list.push_back(StackedValues(stringify(dir)));
+        _imp->stacked_values_list.back().eapi = eapi;
         load_basic_use_file(dir / "use.mask", _imp->stacked_values_list.back().use_mask);
         load_basic_use_file(dir / "use.force", _imp->stacked_values_list.back().use_force);
         load_spec_use_file(*eapi, dir / "package.use", _imp->stacked_values_list.back().package_use);
@@ -312,14 +327,16 @@ namespace
             }
     }
 
-    void make_vars_from_file_vars(
-            Pimp<TraditionalProfile> & _imp)
+    template <typename I_>
+    void add_system_packages(
+            Pimp<TraditionalProfile> & _imp,
+            I_ i,
+            const I_ & i_end)
     {
         try
         {
             if (! _imp->has_master_repositories)
-                for (TraditionalProfileFile<LineConfigFile>::ConstIterator i(_imp->packages_file.begin()),
-                        i_end(_imp->packages_file.end()) ; i != i_end ; ++i)
+                for ( ; i != i_end ; ++i)
                 {
                     if (0 != i->second.compare(0, 1, "*", 0, 1))
                         continue;
@@ -342,9 +359,15 @@ namespace
             Log::get_instance()->message("e.profile.packages.failure", ll_warning, lc_context) << "Loading packages "
                     " failed due to exception: " << e.message() << " (" << e.what() << ")";
         }
+    }
 
-        for (TraditionalProfileFile<TraditionalMaskFile>::ConstIterator line(_imp->package_mask_file.begin()), line_end(_imp->package_mask_file.end()) ;
-                line != line_end ; ++line)
+    template <typename I_>
+    void add_package_masks(
+            Pimp<TraditionalProfile> & _imp,
+            I_ line,
+            const I_ & line_end)
+    {
+        for ( ; line != line_end ; ++line)
         {
             if (line->second.first.empty())
                 continue;
@@ -376,6 +399,13 @@ namespace
         }
     }
 
+    void make_vars_from_file_vars(
+            Pimp<TraditionalProfile> & _imp)
+    {
+        add_system_packages(_imp, _imp->packages_file.begin(), _imp->packages_file.end());
+        add_package_masks(_imp, _imp->package_mask_file.begin(), _imp->package_mask_file.end());
+    }
+
     void load_special_make_defaults_vars(
             Pimp<TraditionalProfile> & _imp,
             std::shared_ptr<const paludis::erepository::EAPI> eapi)
@@ -770,6 +800,306 @@ namespace
     }
 }
 
+namespace
+{
+    void write_strings(ProfileSnapshotWriter & w, const Set<std::string> & s)
+    {
+        w.write_number(s.size());
+        for (Set<std::string>::ConstIterator i(s.begin()), i_end(s.end()) ; i != i_end ; ++i)
+            w.write_string(*i);
+    }
+
+    void read_strings(ProfileSnapshotReader & r, Set<std::string> & s)
+    {
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+            s.insert(r.read_string());
+    }
+
+    void write_flag_status_map(ProfileSnapshotWriter & w, const FlagStatusMap & m)
+    {
+        w.write_number(m.size());
+        for (FlagStatusMap::const_iterator i(m.begin()), i_end(m.end()) ; i != i_end ; ++i)
+        {
+            w.write_string(stringify(i->first));
+            w.write_bool(i->second);
+        }
+    }
+
+    void read_flag_status_map(ProfileSnapshotReader & r, FlagStatusMap & m)
+    {
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            ChoiceNameWithPrefix name(r.read_string());
+            m[name] = r.read_bool();
+        }
+    }
+
+    void write_package_flag_status_map_list(ProfileSnapshotWriter & w, const PackageFlagStatusMapList & m)
+    {
+        w.write_number(m.size());
+        for (PackageFlagStatusMapList::const_iterator i(m.begin()), i_end(m.end()) ; i != i_end ; ++i)
+        {
+            w.write_string(stringify(*i->first));
+            write_flag_status_map(w, i->second);
+        }
+    }
+
+    void read_package_flag_status_map_list(ProfileSnapshotReader & r, const std::shared_ptr<const EAPI> & eapi,
+            PackageFlagStatusMapList & m)
+    {
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            if (! eapi)
+                throw ProfileSnapshotError("Package specific values with no EAPI");
+
+            std::shared_ptr<const PackageDepSpec> spec(std::make_shared<PackageDepSpec>(
+                        parse_elike_package_dep_spec(r.read_string(), eapi->supported()->package_dep_spec_parse_options(),
+                            eapi->supported()->version_spec_options())));
+            read_flag_status_map(r, m.insert(m.end(), std::make_pair(spec, FlagStatusMap()))->second);
+        }
+    }
+
+    /* Everything the constructor computes is written out, except for system
+     * packages and package.mask, where we keep the stacked lines and parse
+     * them again on load so that the specs (and any warnings about them) come
+     * out exactly as they would without a snapshot. */
+    void write_snapshot(
+            Pimp<TraditionalProfile> & _imp)
+    {
+        ProfileSnapshotWriter & w(*_imp->snapshot);
+
+        w.write_number(std::distance(_imp->profiles_with_parents->begin(), _imp->profiles_with_parents->end()));
+        for (FSPathSequence::ConstIterator p(_imp->profiles_with_parents->begin()), p_end(_imp->profiles_with_parents->end()) ;
+                p != p_end ; ++p)
+            w.write_string(stringify(*p));
+
+        w.write_number(_imp->environment_variables.size());
+        for (EnvironmentVariablesMap::const_iterator v(_imp->environment_variables.begin()), v_end(_imp->environment_variables.end()) ;
+                v != v_end ; ++v)
+        {
+            w.write_string(v->first);
+            w.write_string(v->second);
+        }
+
+        w.write_number(_imp->use.size());
+        for (FlagIdStatusMap::const_iterator u(_imp->use.begin()), u_end(_imp->use.end()) ;
+                u != u_end ; ++u)
+        {
+            w.write_string(stringify(u->first.first));
+            w.write_string(stringify(u->first.second));
+            w.write_bool(u->second);
+        }
+
+        write_strings(w, *_imp->use_expand);
+        write_strings(w, *_imp->use_expand_hidden);
+        write_strings(w, *_imp->use_expand_unprefixed);
+        write_strings(w, *_imp->use_expand_implicit);
+        write_strings(w, *_imp->iuse_implicit);
+
+        w.write_number(_imp->use_expand_values.size());
+        for (const auto & v : _imp->use_expand_values)
+        {
+            w.write_string(v.first);
+            write_strings(w, *v.second);
+        }
+
+        w.write_number(_imp->known_choice_value_names.size());
+        for (const auto & k : _imp->known_choice_value_names)
+        {
+            w.write_string(k.first);
+            w.write_number(k.second->size());
+            for (Set<UnprefixedChoiceName>::ConstIterator v(k.second->begin()), v_end(k.second->end()) ;
+                    v != v_end ; ++v)
+                w.write_string(stringify(*v));
+        }
+
+        w.write_number(_imp->stacked_values_list.size());
+        for (const auto & s : _imp->stacked_values_list)
+        {
+            w.write_string(s.origin);
+            w.write_string(s.eapi ? s.eapi->name() : "");
+            write_flag_status_map(w, s.use_mask);
+            write_flag_status_map(w, s.use_stable_mask);
+            write_flag_status_map(w, s.use_force);
+            write_flag_status_map(w, s.use_stable_force);
+            write_package_flag_status_map_list(w, s.package_use);
+            write_package_flag_status_map_list(w, s.package_use_mask);
+            write_package_flag_status_map_list(w, s.package_use_stable_mask);
+            write_package_flag_status_map_list(w, s.package_use_force);
+            write_package_flag_status_map_list(w, s.package_use_stable_force);
+        }
+
+        w.write_number(std::distance(_imp->packages_file.begin(), _imp->packages_file.end()));
+        for (TraditionalProfileFile<LineConfigFile>::ConstIterator i(_imp->packages_file.begin()),
+                i_end(_imp->packages_file.end()) ; i != i_end ; ++i)
+        {
+            w.write_string(i->first->name());
+            w.write_string(i->second);
+        }
+
+        w.write_number(std::distance(_imp->package_mask_file.begin(), _imp->package_mask_file.end()));
+        for (TraditionalProfileFile<TraditionalMaskFile>::ConstIterator line(_imp->package_mask_file.begin()),
+                line_end(_imp->package_mask_file.end()) ; line != line_end ; ++line)
+        {
+            w.write_string(line->first->name());
+            w.write_string(line->second.first);
+            w.write_string(line->second.second->comment());
+            w.write_string(stringify(line->second.second->mask_file()));
+            w.write_string(line->second.second->token());
+        }
+    }
+
+    std::shared_ptr<const EAPI> snapshot_eapi(const std::string & name)
+    {
+        if (name.empty())
+            return nullptr;
+
+        auto eapi(EAPIData::get_instance()->eapi_from_string(name));
+        if (! eapi->supported())
+            throw ProfileSnapshotError("EAPI '" + name + "' is no longer supported");
+        return eapi;
+    }
+
+    void read_snapshot(
+            Pimp<TraditionalProfile> & _imp,
+            ProfileSnapshotReader & r)
+    {
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+            _imp->profiles_with_parents->push_back(FSPath(r.read_string()));
+
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            std::string k(r.read_string());
+            _imp->environment_variables[k] = r.read_string();
+        }
+
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            ChoicePrefixName prefix(r.read_string());
+            UnprefixedChoiceName name(r.read_string());
+            _imp->use.insert(std::make_pair(std::make_pair(prefix, name), r.read_bool()));
+        }
+
+        read_strings(r, *_imp->use_expand);
+        read_strings(r, *_imp->use_expand_hidden);
+        read_strings(r, *_imp->use_expand_unprefixed);
+        read_strings(r, *_imp->use_expand_implicit);
+        read_strings(r, *_imp->iuse_implicit);
+
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            std::string k(r.read_string());
+            std::shared_ptr<Set<std::string> > v(std::make_shared<Set<std::string>>());
+            read_strings(r, *v);
+            _imp->use_expand_values.insert(std::make_pair(k, v));
+        }
+
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            std::string k(r.read_string());
+            std::shared_ptr<Set<UnprefixedChoiceName> > v(std::make_shared<Set<UnprefixedChoiceName>>());
+            for (uint64_t m(r.read_number()) ; m > 0 ; --m)
+                v->insert(UnprefixedChoiceName(r.read_string()));
+            _imp->known_choice_value_names.insert(std::make_pair(k, v));
+        }
+
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            _imp->stacked_values_list.push_back(StackedValues(r.read_string()));
+            StackedValues & s(_imp->stacked_values_list.back());
+            s.eapi = snapshot_eapi(r.read_string());
+
+            /* the EAPI a directory uses can change without any of its files
+             * changing, if the repository's configuration changes */
+            if (s.eapi && s.eapi->name() != EAPIData::get_instance()->eapi_from_string(
+                        _imp->eapi_for_file(FSPath(s.origin) / "use.mask"))->name())
+                throw ProfileSnapshotError("EAPI for '" + s.origin + "' has changed");
+
+            read_flag_status_map(r, s.use_mask);
+            read_flag_status_map(r, s.use_stable_mask);
+            read_flag_status_map(r, s.use_force);
+            read_flag_status_map(r, s.use_stable_force);
+            read_package_flag_status_map_list(r, s.eapi, s.package_use);
+            read_package_flag_status_map_list(r, s.eapi, s.package_use_mask);
+            read_package_flag_status_map_list(r, s.eapi, s.package_use_stable_mask);
+            read_package_flag_status_map_list(r, s.eapi, s.package_use_force);
+            read_package_flag_status_map_list(r, s.eapi, s.package_use_stable_force);
+        }
+
+        std::list<std::pair<std::shared_ptr<const EAPI>, std::string> > packages_lines;
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            auto eapi(snapshot_eapi(r.read_string()));
+            packages_lines.push_back(std::make_pair(eapi, r.read_string()));
+        }
+
+        std::list<std::pair<std::shared_ptr<const EAPI>, std::pair<std::string, std::shared_ptr<const MaskInfo> > > > package_mask_lines;
+        for (uint64_t n(r.read_number()) ; n > 0 ; --n)
+        {
+            auto eapi(snapshot_eapi(r.read_string()));
+            std::string spec(r.read_string());
+            std::string comment(r.read_string());
+            FSPath mask_file(r.read_string());
+            std::string token(r.read_string());
+            package_mask_lines.push_back(std::make_pair(eapi, std::make_pair(spec, std::make_shared<MaskInfo>(make_named_values<MaskInfo>(
+                                n::comment() = comment,
+                                n::mask_file() = mask_file,
+                                n::token() = token
+                                )))));
+        }
+
+        r.done();
+
+        add_system_packages(_imp, packages_lines.begin(), packages_lines.end());
+        add_package_masks(_imp, package_mask_lines.begin(), package_mask_lines.end());
+    }
+
+    void clear_snapshot_state(
+            Pimp<TraditionalProfile> & _imp)
+    {
+        _imp->profiles_with_parents = std::make_shared<FSPathSequence>();
+        _imp->environment_variables.clear();
+        _imp->system_packages = std::make_shared<SetSpecTree>(std::make_shared<AllDepSpec>());
+        _imp->use.clear();
+        _imp->use_expand = std::make_shared<Set<std::string>>();
+        _imp->use_expand_hidden = std::make_shared<Set<std::string>>();
+        _imp->use_expand_unprefixed = std::make_shared<Set<std::string>>();
+        _imp->use_expand_implicit = std::make_shared<Set<std::string>>();
+        _imp->iuse_implicit = std::make_shared<Set<std::string>>();
+        _imp->use_expand_values.clear();
+        _imp->known_choice_value_names.clear();
+        _imp->stacked_values_list.clear();
+        _imp->package_mask.clear();
+    }
+
+    bool load_snapshot(
+            Pimp<TraditionalProfile> & _imp,
+            const FSPath & location,
+            const std::string & key)
+    {
+        ProfileSnapshotReader r(location, key);
+        if (! r.usable())
+            return false;
+
+        try
+        {
+            read_snapshot(_imp, r);
+            return true;
+        }
+        catch (const InternalError &)
+        {
+            throw;
+        }
+        catch (const Exception & e)
+        {
+            Log::get_instance()->message("e.profile.snapshot.unusable", ll_debug, lc_context)
+                << "Not using profile snapshot '" << location << "' due to exception '" << e.message() << "' (" << e.what() << ")";
+            clear_snapshot_state(_imp);
+            return false;
+        }
+    }
+}
+
 TraditionalProfile::TraditionalProfile(
         const Environment * const env,
         const RepositoryName & name,
@@ -779,7 +1109,8 @@ TraditionalProfile::TraditionalProfile(
         const std::string & arch_var_if_special,
         const bool profiles_explicitly_set,
         const bool has_master_repositories,
-        const bool ignore_deprecated_profiles) :
+        const bool ignore_deprecated_profiles,
+        const FSPath & snapshot_location) :
     _imp(env, eapi_for_file, is_arch_flag, has_master_repositories)
 {
     Context context("When loading profiles '" + join(dirs.begin(), dirs.end(), "' '") + "' for repository '" + stringify(name) + "':");
@@ -787,8 +1118,6 @@ TraditionalProfile::TraditionalProfile(
     if (dirs.empty())
         throw ERepositoryConfigurationError("No profiles directories specified");
 
-    load_environment(_imp);
-
     for (FSPathSequence::ConstIterator d(dirs.begin()), d_end(dirs.end()) ;
             d != d_end ; ++d)
     {
@@ -798,7 +1127,26 @@ TraditionalProfile::TraditionalProfile(
             if ((*d / "deprecated").stat().is_regular_file_or_symlink_to_regular_file())
                 Log::get_instance()->message("e.profile.deprecated", ll_warning, lc_context) << "Profile directory '" << *d
                     << "' is deprecated. See the file '" << (*d / "deprecated") << "' for details";
+    }
+
+    if (snapshot_location != FSPath("/var/empty"))
+    {
+        std::string key("traditional\n" + join(dirs.begin(), dirs.end(), "\n") + "\n" + arch_var_if_special + "\n" +
+                stringify(has_master_repositories) + "\n" + getenv_with_default("CONFIG_PROTECT", "/etc") + "\n" +
+                getenv_with_default("CONFIG_PROTECT_MASK", ""));
+
+        if (load_snapshot(_imp, snapshot_location, key))
+            return;
+
+        _imp->snapshot = std::make_shared<ProfileSnapshotWriter>(snapshot_location, key);
+    }
 
+    load_environment(_imp);
+
+    for (FSPathSequence::ConstIterator d(dirs.begin()), d_end(dirs.end()) ;
+            d != d_end ; ++d)
+    {
+        Context subcontext("When using directory '" + stringify(*d) + "':");
         load_profile_directory_recursively(_imp, *d);
     }
 
@@ -816,6 +1164,13 @@ TraditionalProfile::TraditionalProfile(
     fish_out_use_expand_names(_imp);
     if (! arch_var_if_special.empty())
         handle_profile_arch_var(_imp, arch_var_if_special);
+
+    if (_imp->snapshot)
+    {
+        write_snapshot(_imp);
+        _imp->snapshot->save();
+        _imp->snapshot.reset();
+    }
 }
 
 TraditionalProfile::~TraditionalProfile() = default;
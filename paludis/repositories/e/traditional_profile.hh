@@ -44,7 +44,8 @@ namespace paludis
                         const std::string & arch_var_if_special,
                         const bool profiles_explicitly_set,
                         const bool has_master_repositories,
-                        const bool ignore_deprecated_profiles
+                        const bool ignore_deprecated_profiles,
+                        const FSPath & snapshot_location
                         );
 
                 virtual ~TraditionalProfile();
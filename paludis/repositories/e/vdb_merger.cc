@@ -60,12 +60,16 @@ namespace paludis
         FSPath realroot;
         std::shared_ptr<SafeOFStream> contents_file;
 
+        /* where we write the contents file until it can be trusted */
+        FSPath partial_contents_file;
+
         std::list<std::string> config_protect;
         std::list<std::string> config_protect_mask;
 
         Imp(const VDBMergerParams & p) :
             params(p),
-            realroot(params.root().realpath())
+            realroot(params.root().realpath()),
+            partial_contents_file(params.contents_file().dirname() / ("-merging-" + params.contents_file().basename()))
         {
             tokenise_whitespace(params.config_protect(), std::back_inserter(config_protect));
             tokenise_whitespace(params.config_protect_mask(), std::back_inserter(config_protect_mask));
@@ -88,6 +92,7 @@ namespace
 
 VDBMerger::VDBMerger(const VDBMergerParams & p) :
     FSMerger(make_named_values<FSMergerParams>(
+                n::durability() = p.durability(),
                 n::environment() = p.environment(),
                 n::fix_mtimes_before() = p.fix_mtimes_before(),
                 n::fs_merger_options() = p.fs_merger_options(),
@@ -154,16 +159,12 @@ VDBMerger::record_install_file(const FSPath & src, const FSPath & dst_dir, const
                       tidy_real(stringify(file.strip_leading(_imp->realroot)));
     const Timestamp timestamp(renamed_file.stat().mtim());
 
-    SafeIFStream infile(renamed_file);
-    if (! infile)
-        throw FSMergerError("Cannot read '" + stringify(renamed_file) + "'");
-
-    MD5 md5(infile);
+    const std::string md5(file_md5(renamed_file));
 
     display_merge(et_file, renamed_file, flags,
                   src.basename() == dst_name ? "" : dst_name);
 
-    *_imp->contents_file << "obj " << tidy_real << " " << md5.hexsum() << " " << timestamp.seconds() << std::endl;
+    *_imp->contents_file << "obj " << tidy_real << " " << md5 << " " << timestamp.seconds() << std::endl;
 }
 
 void
@@ -249,10 +250,7 @@ VDBMerger::make_config_protect_name(const FSPath & src, const FSPath & dst)
     std::string result_name(src.basename());
     int n(0);
 
-    SafeIFStream our_md5_file(src);
-    if (! our_md5_file)
-        throw FSMergerError("Could not get md5 for '" + stringify((dst / src.basename()).strip_leading(_imp->realroot)) + "'");
-    MD5 our_md5(our_md5_file);
+    const std::string our_md5(file_md5(src));
 
     while (true)
     {
@@ -267,7 +265,7 @@ VDBMerger::make_config_protect_name(const FSPath & src, const FSPath & dst)
             {
                 SafeIFStream other_md5_file(dst / result_name);
                 MD5 other_md5(other_md5_file);
-                if (our_md5.hexsum() == other_md5.hexsum())
+                if (our_md5 == other_md5.hexsum())
                     break;
             }
             catch (const SafeIFStreamError &)
@@ -283,12 +281,45 @@ VDBMerger::make_config_protect_name(const FSPath & src, const FSPath & dst)
     return result_name;
 }
 
+bool
+VDBMerger::want_file_md5s() const
+{
+    return true;
+}
+
 void
 VDBMerger::merge()
 {
     display_override(">>> Merging to " + stringify(_imp->params.root()));
-    _imp->contents_file = std::make_shared<SafeOFStream>(_imp->params.contents_file(), -1, false);
-    FSMerger::merge();
+
+    /* the contents file only gets its real name once everything it lists has
+     * been synced, or if the merge fails part way through, so that whatever
+     * did get merged can still be uninstalled */
+    _imp->contents_file = std::make_shared<SafeOFStream>(_imp->partial_contents_file, -1, false);
+    try
+    {
+        FSMerger::merge();
+    }
+    catch (...)
+    {
+        if (_imp->contents_file)
+        {
+            _imp->contents_file.reset();
+            _imp->partial_contents_file.rename(_imp->params.contents_file());
+        }
+        throw;
+    }
+}
+
+void
+VDBMerger::on_done_merge()
+{
+    FSMerger::on_done_merge();
+
+    _imp->contents_file.reset();
+    make_durable(_imp->partial_contents_file);
+    _imp->partial_contents_file.rename(_imp->params.contents_file());
+    make_durable(_imp->params.contents_file().dirname());
 }
 
 bool
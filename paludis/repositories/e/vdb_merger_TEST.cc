@@ -34,9 +34,12 @@
 #include <paludis/standard_output_manager.hh>
 
 #include <functional>
+#include <map>
 
 #include <gtest/gtest.h>
 
+#include "config.h"
+
 using namespace paludis;
 
 namespace
@@ -65,6 +68,25 @@ namespace
             }
     };
 
+    class VDBMergerRecordingFlags :
+        public VDBMergerNoDisplay
+    {
+        public:
+            std::map<std::string, FSMergerStatusFlags> file_flags;
+
+            VDBMergerRecordingFlags(const VDBMergerParams & p) :
+                VDBMergerNoDisplay(p)
+            {
+            }
+
+            void record_install_file(const FSPath & src, const FSPath & dst_dir, const std::string & dst_name,
+                    const FSMergerStatusFlags & flags) override
+            {
+                file_flags[dst_name] = flags;
+                VDBMerger::record_install_file(src, dst_dir, dst_name, flags);
+            }
+    };
+
     static std::string file_contents(const FSPath & f)
     {
         if (! f.stat().is_regular_file())
@@ -105,6 +127,7 @@ namespace
                         n::config_protect() = "/protected_file /protected_dir",
                         n::config_protect_mask() = "/protected_dir/unprotected_file /protected_dir/unprotected_dir",
                         n::contents_file() = FSPath::cwd() / "vdb_merger_TEST_dir/CONTENTS" / (target + "_dir"),
+                        n::durability() = fsmd_none,
                         n::environment() = &env,
                         n::fix_mtimes_before() = Timestamp(0, 0),
                         n::fs_merger_options() = FSMergerOptions(),
@@ -213,3 +236,45 @@ INSTANTIATE_TEST_CASE_P(Errors, VDBMergerErrorTest, testing::Values(
             std::string("sym_arrow2")
             ));
 
+TEST(VDBMerger, KernelCopyWithDigest)
+{
+    TestEnvironment env;
+    FSPath root_dir(FSPath::cwd() / "vdb_merger_TEST_dir/kernel_copy_dir/root");
+    FSPath contents(FSPath::cwd() / "vdb_merger_TEST_dir/CONTENTS/kernel_copy_dir");
+
+    std::shared_ptr<VDBMergerRecordingFlags> merger(std::make_shared<VDBMergerRecordingFlags>(make_named_values<VDBMergerParams>(
+                    n::config_protect() = "",
+                    n::config_protect_mask() = "",
+                    n::contents_file() = contents,
+                    n::durability() = fsmd_none,
+                    n::environment() = &env,
+                    n::fix_mtimes_before() = Timestamp(0, 0),
+                    n::fs_merger_options() = FSMergerOptions(),
+                    n::image() = FSPath::cwd() / "vdb_merger_TEST_dir/kernel_copy_dir/image",
+                    n::merged_entries() = std::make_shared<FSPathSet>(),
+                    n::options() = MergerOptions() + mo_nondestructive + mo_allow_empty_dirs,
+                    n::output_manager() = std::make_shared<StandardOutputManager>(),
+                    n::package_id() = std::shared_ptr<PackageID>(),
+                    n::permit_destination() = std::bind(return_literal_function(true)),
+                    n::root() = root_dir
+                    )));
+
+    ASSERT_TRUE(merger->check());
+    merger->merge();
+
+    EXPECT_EQ("foo", file_contents(root_dir / "file"));
+    ASSERT_EQ(1u, merger->file_flags.size());
+
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+    /* wanting the digest for CONTENTS mustn't stop the kernel doing the copy */
+    const FSMergerStatusFlags & flags(merger->file_flags["file"]);
+    EXPECT_TRUE(flags[msi_copy_file_range] || flags[msi_sendfile] || flags[msi_reflinked]);
+#endif
+
+    merger.reset();
+
+    SafeIFStream stream(contents);
+    std::string line;
+    ASSERT_TRUE(bool(std::getline(stream, line)));
+    EXPECT_EQ(0u, line.find("obj /file d3b07384d113edec49eaa6238ad5ff00 "));
+}
@@ -61,6 +61,10 @@ echo bar >protected_dir_not_really/unprotected_file
 cd ../..
 
 
+mkdir -p kernel_copy_dir/{image,root} || exit 4
+echo foo >kernel_copy_dir/image/file
+
+
 mkdir -p file_newline_dir/{image,root} || exit 4
 touch file_newline_dir/image/"file
 newline" || exit 5
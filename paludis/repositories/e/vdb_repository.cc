@@ -320,11 +320,26 @@ VDBRepository::repository_factory_create(
                 *DistributionData::get_instance()->distribution_from_string(
                     env->distribution()))->default_eapi_when_unknown();
 
+    FSMergerDurability merge_durability(fsmd_none);
+    if (! f("merge_durability").empty())
+    {
+        try
+        {
+            merge_durability = destringify<FSMergerDurability>(f("merge_durability"));
+        }
+        catch (const DestringifyError &)
+        {
+            throw VDBRepositoryConfigurationError("Value '" + f("merge_durability") + "' for key 'merge_durability' is not one of "
+                    "'none', 'batched' or 'per_file'");
+        }
+    }
+
     return std::make_shared<VDBRepository>(make_named_values<VDBRepositoryParams>(
                 n::builddir() = builddir,
                 n::eapi_when_unknown() = eapi_when_unknown,
                 n::environment() = env,
                 n::location() = location,
+                n::merge_durability() = merge_durability,
                 n::name() = RepositoryName(name),
                 n::names_cache() = names_cache,
                 n::root() = root
@@ -688,6 +703,7 @@ VDBRepository::merge(const MergeParams & m)
                 n::config_protect() = config_protect,
                 n::config_protect_mask() = config_protect_mask,
                 n::contents_file() = vdb_dir / "CONTENTS",
+                n::durability() = _imp->params.merge_durability(),
                 n::environment() = _imp->params.environment(),
                 n::fix_mtimes_before() = fix_mtimes ?  m.build_start_time() : Timestamp(0, 0),
                 n::fs_merger_options() = eapi->fs_merger_options(),
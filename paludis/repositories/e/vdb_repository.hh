@@ -27,6 +27,7 @@
 #include <paludis/util/pimp.hh>
 #include <paludis/util/map.hh>
 #include <paludis/repositories/e/e_repository_id.hh>
+#include <paludis/fs_merger-fwd.hh>
 #include <memory>
 
 /** \file
@@ -43,6 +44,7 @@ namespace paludis
         typedef Name<struct name_eapi_when_unknown> eapi_when_unknown;
         typedef Name<struct name_environment> environment;
         typedef Name<struct name_location> location;
+        typedef Name<struct name_merge_durability> merge_durability;
         typedef Name<struct name_name> name;
         typedef Name<struct name_names_cache> names_cache;
         typedef Name<struct name_root> root;
@@ -56,6 +58,10 @@ namespace paludis
             NamedValue<n::eapi_when_unknown, std::string> eapi_when_unknown;
             NamedValue<n::environment, Environment *> environment;
             NamedValue<n::location, FSPath> location;
+
+            ///\since 3.0
+            NamedValue<n::merge_durability, FSMergerDurability> merge_durability;
+
             NamedValue<n::name, RepositoryName> name;
             NamedValue<n::names_cache, FSPath> names_cache;
             NamedValue<n::root, FSPath> root;
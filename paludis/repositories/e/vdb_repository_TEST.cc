@@ -43,6 +43,7 @@
 #include <paludis/choice.hh>
 #include <paludis/unformatted_pretty_printer.hh>
 #include <paludis/contents.hh>
+#include <paludis/hook.hh>
 
 #include <paludis/util/indirect_iterator-impl.hh>
 
@@ -118,6 +119,37 @@ namespace
         }
     };
 
+    /* notes what an installed package's VDB entry looks like at the start
+     * and end of its merge, by which time any syncing has been done */
+    class EntryVisibilityTestEnvironment :
+        public TestEnvironment
+    {
+        public:
+            FSPath entry;
+            mutable std::string visibility_before_merge, visibility_after_merge;
+
+            EntryVisibilityTestEnvironment(const FSPath & e) :
+                entry(e)
+            {
+            }
+
+            std::string visibility() const
+            {
+                return std::string(entry.stat().is_directory() ? "entry" : "no entry")
+                    + ((entry / "CONTENTS").stat().exists() ? ", contents" : "")
+                    + ((entry / "-merging-CONTENTS").stat().exists() ? ", partial contents" : "");
+            }
+
+            HookResult perform_hook(const Hook & hook, const std::shared_ptr<OutputManager> & optional_output_manager) const override
+            {
+                if (hook.name() == "merger_install_pre")
+                    visibility_before_merge = visibility();
+                else if (hook.name() == "merger_install_post")
+                    visibility_after_merge = visibility();
+                return TestEnvironment::perform_hook(hook, optional_output_manager);
+            }
+    };
+
     void install(const Environment & env,
             const std::shared_ptr<Repository> & vdb_repo,
             const std::string & chosen_one,
@@ -337,6 +369,55 @@ TEST(VDBRepository, Reinstall)
     }
 }
 
+TEST(VDBRepository, MergeDurability)
+{
+    EntryVisibilityTestEnvironment env(FSPath::cwd() / "vdb_repository_TEST_dir" / "durabilitytest" / "cat" / "durable-1");
+    std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+    keys->insert("format", "e");
+    keys->insert("names_cache", "/var/empty");
+    keys->insert("location", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "reinstalltest_src1"));
+    keys->insert("profiles", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "reinstalltest_src1/profiles/profile"));
+    keys->insert("layout", "traditional");
+    keys->insert("eapi_when_unknown", "0");
+    keys->insert("eapi_when_unspecified", "0");
+    keys->insert("profile_eapi", "0");
+    keys->insert("distdir", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "distdir"));
+    keys->insert("builddir", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "build"));
+    keys->insert("root", stringify(FSPath("vdb_repository_TEST_dir/root").realpath()));
+    std::shared_ptr<Repository> repo1(ERepository::repository_factory_create(&env,
+                std::bind(from_keys, keys, std::placeholders::_1)));
+    env.add_repository(1, repo1);
+
+    keys = std::make_shared<Map<std::string, std::string>>();
+    keys->insert("format", "vdb");
+    keys->insert("names_cache", "/var/empty");
+    keys->insert("location", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "durabilitytest"));
+    keys->insert("builddir", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "build"));
+    keys->insert("root", stringify(FSPath("vdb_repository_TEST_dir/root").realpath()));
+    keys->insert("merge_durability", "batched");
+    std::shared_ptr<Repository> vdb_repo(VDBRepository::VDBRepository::repository_factory_create(&env,
+                std::bind(from_keys, keys, std::placeholders::_1)));
+    env.add_repository(0, vdb_repo);
+
+    install(env, vdb_repo, "=cat/durable-1::reinstalltest_src1", "");
+    vdb_repo->invalidate();
+
+    /* the entry is in place throughout, but its contents only get their
+     * real name once everything they list has been synced */
+    EXPECT_EQ("entry, partial contents", env.visibility_before_merge);
+    EXPECT_EQ("entry, contents", env.visibility_after_merge);
+    EXPECT_TRUE((env.entry / "CONTENTS").stat().is_regular_file());
+    EXPECT_FALSE((env.entry.dirname() / "-checking-durable-1").stat().exists());
+
+    SafeIFStream merged(FSPath("vdb_repository_TEST_dir/root/durable"));
+    std::string line;
+    EXPECT_TRUE(bool(std::getline(merged, line)));
+    EXPECT_EQ("foo", line);
+
+    std::shared_ptr<const PackageIDSequence> ids(vdb_repo->package_ids(QualifiedPackageName("cat/durable"), { }));
+    EXPECT_EQ("cat/durable-1::installed", join(indirect_iterator(ids->begin()), indirect_iterator(ids->end()), " "));
+}
+
 TEST(VDBRepository, PhaseOrdering)
 {
     TestEnvironment env(FSPath(stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "root")).realpath());
@@ -101,6 +101,16 @@ SLOT="0"
 END
 cp reinstalltest_src1/cat/pkg/pkg-1.ebuild reinstalltest_src2/cat/pkg/pkg-1-r0.ebuild
 
+mkdir -p durabilitytest reinstalltest_src1/cat/durable || exit 1
+cat <<"END" >reinstalltest_src1/cat/durable/durable-1.ebuild
+KEYWORDS="test"
+SLOT="0"
+
+src_install() {
+    echo foo > "${D}"/durable
+}
+END
+
 mkdir -p postinsttest postinsttest_src1/{eclass,profiles/profile,cat/pkg} || exit 1
 
 cat <<END > postinsttest_src1/profiles/profile/make.defaults
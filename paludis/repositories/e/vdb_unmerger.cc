@@ -22,7 +22,6 @@
 #include <paludis/repositories/e/vdb_contents_tokeniser.hh>
 
 #include <paludis/util/destringify.hh>
-#include <paludis/util/md5.hh>
 #include <paludis/util/safe_ifstream.hh>
 #include <paludis/util/join.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
@@ -209,8 +208,7 @@ VDBUnmerger::check_file(const std::shared_ptr<const ContentsEntry> & e) const
     {
         try
         {
-            SafeIFStream md5_file(_imp->options.root() / f);
-            if (MD5(md5_file).hexsum() != require_key<MetadataValueKey<std::string> >(*e, "md5").parse_value())
+            if (file_md5(root_f) != require_key<MetadataValueKey<std::string> >(*e, "md5").parse_value())
                 display("--- [!md5 ] " + stringify(f));
             else if (config_protected(_imp->options.root() / f))
                 display("--- [cfgpr] " + stringify(f));
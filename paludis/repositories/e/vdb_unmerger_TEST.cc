@@ -40,6 +40,7 @@
 #include <paludis/metadata_key.hh>
 
 #include <algorithm>
+#include <cstdlib>
 
 #include <gtest/gtest.h>
 
@@ -195,6 +196,29 @@ INSTANTIATE_TEST_CASE_P(Succeeds, VDBUnmergerTestSucceeds, testing::Values(
             std::string("file_replaces_dir")
             ));
 
+struct VDBUnmergerTestJobs : VDBUnmergerTest
+{
+};
+
+TEST_P(VDBUnmergerTestJobs, Jobs)
+{
+    ASSERT_TRUE((root_dir / target).stat().exists());
+    ::setenv("PALUDIS_MERGE_JOBS", "4", 1);
+    unmerger->unmerge();
+    ::unsetenv("PALUDIS_MERGE_JOBS");
+
+    EXPECT_TRUE(! (root_dir / target / "dir_1").stat().exists());
+    EXPECT_TRUE(! (root_dir / target / "dir_3").stat().exists());
+    EXPECT_TRUE(! (root_dir / target / "dir_2" / "file_6").stat().exists());
+    EXPECT_TRUE((root_dir / target / "dir_2" / "file_7").stat().is_regular_file());
+    EXPECT_TRUE(! (root_dir / target / "dir_2" / "file_8").stat().exists());
+    EXPECT_TRUE((root_dir / target).stat().is_directory());
+}
+
+INSTANTIATE_TEST_CASE_P(Jobs, VDBUnmergerTestJobs, testing::Values(
+            std::string("jobs")
+            ));
+
 struct VDBUnmergerTestConfigProtect : VDBUnmergerTest
 {
 };
@@ -136,3 +136,18 @@ find . -name '*protected*' -type f -print | while read file; do
     echo obj "${file#.}" "$(md5sum "${file}" | cut -f1 -d' ')" "$(${PALUDIS_EBUILD_DIR}/utils/wrapped_getmtime "${file}")"
 done >../repo/cat/config_protect-1234/CONTENTS
 
+make_vdb jobs
+mkdir jobs
+echo "dir /jobs" > ../repo/cat/jobs-1234/CONTENTS
+for d in 1 2 3 ; do
+    mkdir jobs/dir_${d}
+    echo "dir /jobs/dir_${d}" >> ../repo/cat/jobs-1234/CONTENTS
+    for f in $(seq 1 20) ; do
+        echo "file ${d} ${f}" > jobs/dir_${d}/file_${f}
+        echo "obj /jobs/dir_${d}/file_${f} $(md5sum jobs/dir_${d}/file_${f} | cut -f1 -d' ') $(${PALUDIS_EBUILD_DIR}/utils/wrapped_getmtime jobs/dir_${d}/file_${f})" \
+            >> ../repo/cat/jobs-1234/CONTENTS
+    done
+done
+touch -r jobs/dir_2/file_7 ../jobs_reference
+echo "changed" > jobs/dir_2/file_7
+touch -r ../jobs_reference jobs/dir_2/file_7
@@ -25,6 +25,7 @@
 #include <paludis/elike_conditional_dep_spec.hh>
 #include <paludis/elike_package_dep_spec.hh>
 #include <paludis/dep_spec.hh>
+#include <paludis/dep_spec_annotations.hh>
 #include <paludis/environment.hh>
 #include <paludis/repository.hh>
 #include <paludis/package_id.hh>
@@ -64,14 +65,26 @@ namespace
     {
         if ((! s.empty()) && ('!' == s.at(0)))
         {
-            (*h.begin())->append(std::make_shared<BlockDepSpec>(s,
-                            parse_elike_package_dep_spec(s.substr(1),
+            /* like the e parser, so that the resolver knows what to do */
+            bool strong(s.length() > 1 && '!' == s.at(1));
+            auto annotations(std::make_shared<DepSpecAnnotations>());
+            annotations->add(make_named_values<DepSpecAnnotation>(
+                        n::key() = "<resolution>",
+                        n::kind() = dsak_synthetic,
+                        n::role() = strong ? dsar_blocker_strong : dsar_blocker_weak,
+                        n::value() = strong ? "<explicit-strong>" : "<implicit-weak>"
+                        ));
+
+            auto block(std::make_shared<BlockDepSpec>(s,
+                            parse_elike_package_dep_spec(s.substr(strong ? 2 : 1),
                                 ELikePackageDepSpecOptions() + epdso_allow_slot_deps
                                 + epdso_allow_slot_star_deps + epdso_allow_slot_equal_deps + epdso_allow_repository_deps
                                 + epdso_allow_use_deps + epdso_allow_ranged_deps + epdso_allow_tilde_greater_deps
                                 + epdso_allow_slot_equal_deps_portage + epdso_allow_subslot_deps
                                 + epdso_strict_parsing,
                                 user_version_spec_options())));
+            block->set_annotations(annotations);
+            (*h.begin())->append(block);
         }
         else
             package_dep_spec_string_handler<T_>(h, s);
@@ -195,6 +195,12 @@ FakeRepositoryBase::perform_hook(const Hook &, const std::shared_ptr<OutputManag
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
+bool
+FakeRepositoryBase::want_hook(const std::string &) const
+{
+    return false;
+}
+
 bool
 FakeRepositoryBase::sync(
         const std::string &,
@@ -261,6 +261,12 @@ GemcutterRepository::perform_hook(const Hook &, const std::shared_ptr<OutputMana
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
+bool
+GemcutterRepository::want_hook(const std::string &) const
+{
+    return false;
+}
+
 const std::shared_ptr<const MetadataCollectionKey<Map<std::string, std::string> > >
 GemcutterRepository::sync_host_key() const
 {
@@ -280,6 +280,12 @@ RepositoryRepository::perform_hook(const Hook &, const std::shared_ptr<OutputMan
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
+bool
+RepositoryRepository::want_hook(const std::string &) const
+{
+    return false;
+}
+
 const std::shared_ptr<const MetadataCollectionKey<Map<std::string, std::string> > >
 RepositoryRepository::sync_host_key() const
 {
@@ -409,6 +409,12 @@ UnavailableRepository::perform_hook(const Hook &, const std::shared_ptr<OutputMa
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
+bool
+UnavailableRepository::want_hook(const std::string &) const
+{
+    return false;
+}
+
 const std::shared_ptr<const MetadataCollectionKey<Map<std::string, std::string> > >
 UnavailableRepository::sync_host_key() const
 {
@@ -121,6 +121,7 @@ namespace paludis
                 ///\}
 
                 virtual HookResult perform_hook(const Hook & hook, const std::shared_ptr<OutputManager> &);
+                virtual bool want_hook(const std::string &) const;
             };
     }
 
@@ -332,6 +332,7 @@ InstalledUnpackagedRepository::merge(const MergeParams & m)
                 n::config_protect() = getenv_with_default("CONFIG_PROTECT", ""),
                 n::config_protect_mask() = getenv_with_default("CONFIG_PROTECT_MASK", ""),
                 n::contents_file() = target_ver_dir / "contents",
+                n::durability() = fsmd_none,
                 n::environment() = _imp->params.environment(),
                 n::fix_mtimes_before() = m.build_start_time(),
                 n::fs_merger_options() = FSMergerOptions(),
@@ -473,6 +474,12 @@ InstalledUnpackagedRepository::perform_hook(const Hook &, const std::shared_ptr<
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
+bool
+InstalledUnpackagedRepository::want_hook(const std::string &) const
+{
+    return false;
+}
+
 bool
 InstalledUnpackagedRepository::sync(
         const std::string &,
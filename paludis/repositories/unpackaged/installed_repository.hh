@@ -139,6 +139,9 @@ namespace paludis
             virtual HookResult perform_hook(const Hook & hook, const std::shared_ptr<OutputManager> &)
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            virtual bool want_hook(const std::string &) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             virtual bool sync(const std::string &, const std::string &, const std::shared_ptr<OutputManager> &) const;
     };
 }
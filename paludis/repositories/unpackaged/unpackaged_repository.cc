@@ -294,6 +294,12 @@ UnpackagedRepository::perform_hook(const Hook &, const std::shared_ptr<OutputMan
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
+bool
+UnpackagedRepository::want_hook(const std::string &) const
+{
+    return false;
+}
+
 bool
 UnpackagedRepository::sync(
         const std::string &,
@@ -146,6 +146,9 @@ namespace paludis
 
             virtual HookResult perform_hook(const Hook & hook, const std::shared_ptr<OutputManager> &)
                 PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            virtual bool want_hook(const std::string &) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 }
 
@@ -163,6 +163,12 @@ Repository::purge_invalid_cache() const
 {
 }
 
+bool
+Repository::want_hook(const std::string &) const
+{
+    return true;
+}
+
 RepositoryEnvironmentVariableInterface::~RepositoryEnvironmentVariableInterface() = default;
 
 RepositoryDestinationInterface::~RepositoryDestinationInterface() = default;
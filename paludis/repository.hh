@@ -442,6 +442,16 @@ namespace paludis
                     const std::shared_ptr<OutputManager> & optional_output_manager)
                 PALUDIS_ATTRIBUTE((warn_unused_result)) = 0;
 
+            /**
+             * Might perform_hook do anything for hooks with this name? If
+             * not, callers may skip the hook entirely. The default
+             * implementation returns true.
+             *
+             * \since 3.0
+             */
+            virtual bool want_hook(const std::string & name) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             /**
              * Sync, if necessary.
              *
@@ -42,6 +42,8 @@
 #include <paludis/resolver/has_behaviour-fwd.hh>
 #include <paludis/resolver/get_sameness.hh>
 #include <paludis/resolver/destination_utils.hh>
+#include <paludis/resolver/resolver_profile.hh>
+#include <paludis/resolver/query_cache.hh>
 #include <paludis/util/exception.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/make_named_values.hh>
@@ -53,6 +55,8 @@
 #include <paludis/util/tribool.hh>
 #include <paludis/util/log.hh>
 #include <paludis/util/visitor_cast.hh>
+#include <paludis/util/hashes.hh>
+#include <paludis/util/ordered_work_queue.hh>
 #include <paludis/environment.hh>
 #include <paludis/notifier_callback.hh>
 #include <paludis/repository.hh>
@@ -80,6 +84,12 @@
 #include <algorithm>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <functional>
 
 using namespace paludis;
 using namespace paludis::resolver;
@@ -94,11 +104,22 @@ namespace paludis
 
         const std::shared_ptr<ResolutionsByResolvent> resolutions_by_resolvent;
 
+        std::shared_ptr<QueryCache> query_cache;
+        bool query_cache_is_shared;
+
+        unsigned candidate_evaluation_jobs;
+        mutable std::unique_ptr<OrderedWorkQueue> candidate_evaluation_queue;
+
+        std::shared_ptr<ResolverProfile> profile;
+
         Imp(const Environment * const e, const ResolverFunctions & f,
                 const std::shared_ptr<ResolutionsByResolvent> & l) :
             env(e),
             fns(f),
-            resolutions_by_resolvent(l)
+            resolutions_by_resolvent(l),
+            query_cache(std::make_shared<QueryCache>(e)),
+            query_cache_is_shared(false),
+            candidate_evaluation_jobs(1)
         {
         }
     };
@@ -360,8 +381,8 @@ Decider::_collect_staying(const std::shared_ptr<const ChangeByResolventSequence>
 {
     Context context("When collecting staying packages:");
 
-    const std::shared_ptr<const PackageIDSequence> existing((*_imp->env)[selection::AllVersionsUnsorted(
-                generator::All() | filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value()))]);
+    const std::shared_ptr<const PackageIDSequence> existing(_select(selection::AllVersionsUnsorted(
+                generator::All() | filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value())), nullptr));
 
     const std::shared_ptr<PackageIDSequence> result(std::make_shared<PackageIDSequence>());
     for (const auto & package : *existing)
@@ -415,10 +436,10 @@ Decider::_make_change_type_for(
 
     if (decision.destination()->replacing()->empty())
     {
-        const std::shared_ptr<const PackageIDSequence> others((*_imp->env)[selection::AllVersionsUnsorted(
+        const std::shared_ptr<const PackageIDSequence> others(_select(selection::AllVersionsUnsorted(
                     generator::Package(decision.origin_id()->name()) &
                     generator::InRepository(decision.destination()->repository())
-                    )]);
+                    ), nullptr));
         if (others->empty())
             return ct_new;
         else
@@ -1211,10 +1232,10 @@ Decider::find_any_score(
     {
         Context sub_context("When working out whether it's acs_vacuous_blocker:");
 
-        const std::shared_ptr<const PackageIDSequence> ids((*_imp->env)[selection::BestVersionOnly(
+        const std::shared_ptr<const PackageIDSequence> ids(_select(selection::BestVersionOnly(
                     generator::Matches(spec, our_id, { mpo_ignore_additional_requirements })
                         | filter::SupportsAction<InstallAction>() | filter::NotMasked()
-                    )]);
+                    ), our_id));
         if (ids->empty())
             return std::make_pair(acs_vacuous_blocker, operator_bias);
     }
@@ -1246,10 +1267,10 @@ Decider::find_any_score(
 
         for (const auto & decision : could_install_decisions)
         {
-            const auto installed_resolvent((*_imp->env)[selection::SomeArbitraryVersion(
+            const auto installed_resolvent(_select(selection::SomeArbitraryVersion(
                         generator::Package(decision->resolvent().package()) |
                         make_slot_filter(decision->resolvent()) |
-                        filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value()))]);
+                        filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value())), nullptr));
             if (! installed_resolvent->empty())
                 return std::make_pair(acs_could_install_and_installedish, operator_bias);
         }
@@ -1260,9 +1281,9 @@ Decider::find_any_score(
     {
         Context sub_context("When working out whether it's acs_already_installed:");
 
-        const std::shared_ptr<const PackageIDSequence> installed_id((*_imp->env)[selection::BestVersionOnly(
+        const std::shared_ptr<const PackageIDSequence> installed_id(_select(selection::BestVersionOnly(
                     generator::Matches(spec, our_id, { }) |
-                    filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value()))]);
+                    filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value())), our_id));
 
         if (! installed_id->empty() ^ is_block)
             return std::make_pair(acs_already_installed, operator_bias);
@@ -1282,9 +1303,9 @@ Decider::find_any_score(
     {
         Context sub_context("When working out whether it's acs_blocks_installed:");
 
-        const std::shared_ptr<const PackageIDSequence> installed_ids((*_imp->env)[selection::BestVersionOnly(
+        const std::shared_ptr<const PackageIDSequence> installed_ids(_select(selection::BestVersionOnly(
                     generator::Matches(spec, our_id, { }) |
-                    filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value()))]);
+                    filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value())), our_id));
         if (! installed_ids->empty())
             return std::make_pair(acs_blocks_installed, operator_bias);
     }
@@ -1352,9 +1373,9 @@ Decider::_get_resolvents_for_blocker(const BlockDepSpec & spec,
     }
     else
     {
-        const std::shared_ptr<const PackageIDSequence> ids((*_imp->env)[selection::BestVersionInEachSlot(
+        const std::shared_ptr<const PackageIDSequence> ids(_select(selection::BestVersionInEachSlot(
                     generator::Package(*spec.blocking().package_ptr())
-                    )]);
+                    ), nullptr));
         for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ;
                 i != i_end ; ++i)
             for (EnumIterator<DestinationType> t, t_end(last_dt) ; t != t_end ; ++t)
@@ -1681,8 +1702,8 @@ Decider::_installed_ids(const std::shared_ptr<const Resolution> & resolution) co
 {
     Context context("When finding installed IDs for '" + stringify(resolution->resolvent()) + "':");
 
-    return (*_imp->env)[selection::AllVersionsSorted(_imp->fns.make_destination_filtered_generator_fn()(generator::Package(resolution->resolvent().package()), resolution) |
-                                                     make_slot_filter(resolution->resolvent()))];
+    return _select(selection::AllVersionsSorted(_imp->fns.make_destination_filtered_generator_fn()(generator::Package(resolution->resolvent().package()), resolution) |
+                                                make_slot_filter(resolution->resolvent())), nullptr);
 }
 
 const std::shared_ptr<const PackageIDSequence>
@@ -1696,13 +1717,13 @@ Decider::_find_installable_id_candidates_for(
     Context context("When finding installable ID candidates for '" + stringify(package) + "':");
 
     return _imp->fns.remove_hidden_fn()(
-            (*_imp->env)[_imp->fns.promote_binaries_fn()(
+            _select(_imp->fns.promote_binaries_fn()(
                 _imp->fns.make_origin_filtered_generator_fn()(generator::Package(package)) |
                 slot_filter |
                 destination_type_filter |
                 filter::SupportsAction<InstallAction>() |
                 (include_errors ? filter::All() : include_unmaskable ? _imp->fns.make_unmaskable_filter_fn()(package) : filter::NotMasked())
-                )]);
+                ), nullptr));
 }
 
 const Decider::FoundID
@@ -1729,6 +1750,8 @@ Decider::_find_id_for_from(
     if (trying_changing_choices)
         opts += mpo_ignore_additional_requirements;
 
+    _prefetch_candidates(resolution, ids, opts);
+
     std::shared_ptr<const PackageID> best_version;
     for (PackageIDSequence::ReverseConstIterator i(ids->rbegin()), i_end(ids->rend()) ;
             i != i_end ; ++i)
@@ -1740,9 +1763,9 @@ Decider::_find_id_for_from(
         for (const auto & constraint : *resolution->constraints())
         {
             if (constraint->spec().if_package())
-                ok = ok && match_package(*_imp->env, *constraint->spec().if_package(), *i, constraint->from_id(), opts);
+                ok = ok && _match(*constraint->spec().if_package(), *i, constraint->from_id(), opts);
             else
-                ok = ok && ! match_package(*_imp->env, constraint->spec().if_block()->blocking(), *i, constraint->from_id(), opts);
+                ok = ok && ! _match(constraint->spec().if_block()->blocking(), *i, constraint->from_id(), opts);
 
             if (! ok)
                 break;
@@ -1866,6 +1889,7 @@ void
 Decider::add_target_with_reason(const PackageOrBlockDepSpec & spec, const std::shared_ptr<const Reason> & reason)
 {
     Context context("When adding target '" + stringify(spec) + "':");
+    ScopedResolverProfileTimer timer(_imp->profile, "adding targets");
 
     _imp->env->trigger_notifier_callback(NotifierCallbackResolverStepEvent());
 
@@ -1898,6 +1922,7 @@ void
 Decider::purge()
 {
     Context context("When purging everything:");
+    ScopedResolverProfileTimer timer(_imp->profile, "purging");
 
     _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Collecting Unused"));
 
@@ -1942,30 +1967,292 @@ Decider::purge()
     }
 }
 
+namespace
+{
+    enum ConstraintSourceKind
+    {
+        csk_target,     /* never affected by a restart */
+        csk_preset,     /* comes back from get_initial_constraints_for_fn */
+        csk_dependency, /* from the decision made for another resolvent */
+        csk_copied,     /* from another resolvent, and copied again when we next decide */
+        csk_global      /* from every decision together, and redone by the later passes */
+    };
+
+    typedef std::pair<ConstraintSourceKind, std::shared_ptr<const Resolvent> > ConstraintSource;
+
+    ConstraintSource get_constraint_source(const std::shared_ptr<const Reason> & reason)
+    {
+        return reason->make_accept_returning(
+                [&] (const TargetReason &)                     { return ConstraintSource(csk_target, nullptr); },
+                [&] (const PresetReason &)                     { return ConstraintSource(csk_preset, nullptr); },
+                [&] (const DependencyReason & r)               { return ConstraintSource(csk_dependency, std::make_shared<Resolvent>(r.from_resolvent())); },
+                [&] (const LikeOtherDestinationTypeReason & r) { return ConstraintSource(csk_copied, std::make_shared<Resolvent>(r.other_resolvent())); },
+                [&] (const ViaBinaryReason & r)                { return ConstraintSource(csk_copied, std::make_shared<Resolvent>(r.other_resolvent())); },
+                [&] (const DependentReason &)                  { return ConstraintSource(csk_global, nullptr); },
+                [&] (const WasUsedByReason &)                  { return ConstraintSource(csk_global, nullptr); },
+                [&] (const SetReason & r)                      { return get_constraint_source(r.reason_for_set()); }
+                );
+    }
+}
+
+const RestartStatistics
+Decider::restart(const SuggestRestart & e)
+{
+    Context context("When restarting because of '" + stringify(e.resolvent()) + "':");
+    ScopedResolverProfileTimer timer(_imp->profile, "restarting");
+
+    typedef std::unordered_set<Resolvent, Hash<Resolvent> > ResolventsSet;
+
+    /* if x has a constraint that came from y, then x needs redeciding if y
+     * does */
+    std::unordered_map<Resolvent, std::list<Resolvent>, Hash<Resolvent> > constrained_by;
+    std::list<Resolvent> pending;
+    pending.push_back(e.resolvent());
+
+    /* we may have been part way through adding the dependencies for whatever
+     * caused the restart, so it needs doing again too */
+    auto problem_source(get_constraint_source(e.problematic_constraint()->reason()));
+    if (problem_source.second)
+        pending.push_back(*problem_source.second);
+
+    for (const auto & resolution : *_imp->resolutions_by_resolvent)
+        for (const auto & constraint : *resolution->constraints())
+        {
+            auto source(get_constraint_source(constraint->reason()));
+            if (source.second)
+                constrained_by[*source.second].push_back(resolution->resolvent());
+            else if (csk_global == source.first)
+                pending.push_back(resolution->resolvent());
+        }
+
+    ResolventsSet redecide;
+    while (! pending.empty())
+    {
+        Resolvent r(pending.front());
+        pending.pop_front();
+
+        if (! redecide.insert(r).second)
+            continue;
+
+        auto c(constrained_by.find(r));
+        if (c != constrained_by.end())
+            std::copy(c->second.begin(), c->second.end(), std::back_inserter(pending));
+    }
+
+    RestartStatistics result(make_named_values<RestartStatistics>(
+                n::discarded_resolutions() = 0,
+                n::kept_resolutions() = 0,
+                n::redecided_resolutions() = 0
+                ));
+
+    std::list<Resolvent> discard;
+    for (const auto & resolution : *_imp->resolutions_by_resolvent)
+    {
+        if (redecide.end() == redecide.find(resolution->resolvent()))
+        {
+            ++result.kept_resolutions();
+            continue;
+        }
+
+        /* start again from what a new resolution would get, which includes
+         * the preset for this restart, and keep anything that came from
+         * somewhere unaffected. if the initial constraints are shared with
+         * the resolution, which happens with presets, we can't take things
+         * out, but then neither would a full restart. */
+        auto constraints(_imp->fns.get_initial_constraints_for_fn()(resolution->resolvent()));
+        bool still_wanted(false);
+        for (const auto & constraint : *resolution->constraints())
+        {
+            auto source(get_constraint_source(constraint->reason()));
+            switch (source.first)
+            {
+                case csk_target:
+                    break;
+
+                case csk_dependency:
+                    if (redecide.end() != redecide.find(*source.second))
+                        continue;
+                    break;
+
+                case csk_preset:
+                case csk_copied:
+                case csk_global:
+                    continue;
+            }
+
+            still_wanted = true;
+            if (constraints != resolution->constraints())
+                constraints->add(constraint);
+        }
+
+        if (still_wanted)
+        {
+            resolution->constraints() = constraints;
+            resolution->decision() = nullptr;
+            ++result.redecided_resolutions();
+        }
+        else
+            discard.push_back(resolution->resolvent());
+    }
+
+    for (const auto & r : discard)
+        _imp->resolutions_by_resolvent->erase(r);
+    result.discarded_resolutions() = discard.size();
+
+    if (_imp->profile)
+    {
+        _imp->profile->increment("restarts");
+        _imp->profile->increment("resolutions kept by restarts", result.kept_resolutions());
+        _imp->profile->increment("resolutions redecided by restarts", result.redecided_resolutions());
+        _imp->profile->increment("resolutions discarded by restarts", result.discarded_resolutions());
+    }
+
+    return result;
+}
+
+const std::shared_ptr<const PackageIDSequence>
+Decider::_select(const Selection & selection, const std::shared_ptr<const PackageID> & from_id) const
+{
+    return _imp->query_cache->select(selection, from_id, _imp->profile);
+}
+
+bool
+Decider::_match(const PackageDepSpec & spec, const std::shared_ptr<const PackageID> & id,
+        const std::shared_ptr<const PackageID> & from_id, const MatchPackageOptions & opts) const
+{
+    return _imp->query_cache->match(spec, id, from_id, opts, _imp->profile);
+}
+
+void
+Decider::_prefetch_candidates(
+        const std::shared_ptr<const Resolution> & resolution,
+        const std::shared_ptr<const PackageIDSequence> & ids,
+        const MatchPackageOptions & opts) const
+{
+    if (_imp->candidate_evaluation_jobs < 2)
+        return;
+
+    std::vector<std::shared_ptr<const PackageID> > candidates(ids->rbegin(), ids->rend());
+    if (candidates.size() < 2)
+        return;
+
+    /* work out, in parallel, what _find_id_for_from's first pass over the
+     * constraints would. The answers go into the match cache, so the
+     * sequential pass that follows picks exactly the same ID, and any
+     * exception is thrown from there rather than from a worker. */
+    typedef std::list<std::tuple<PackageDepSpec, std::shared_ptr<const PackageID>, bool> > Verdicts;
+    std::vector<Verdicts> verdicts(candidates.size());
+
+    auto evaluate([&] (const unsigned n) {
+            try
+            {
+                Context context("When evaluating candidate '" + stringify(*candidates[n]) + "' for '"
+                        + stringify(resolution->resolvent()) + "':");
+
+                for (const auto & constraint : *resolution->constraints())
+                {
+                    const PackageDepSpec & spec(constraint->spec().if_package() ? *constraint->spec().if_package() :
+                            constraint->spec().if_block()->blocking());
+
+                    /* nothing writes to the cache until we're all done */
+                    bool matched;
+                    if (! _imp->query_cache->known_match(spec, candidates[n], constraint->from_id(), opts, matched))
+                    {
+                        matched = match_package(*_imp->env, spec, candidates[n], constraint->from_id(), opts);
+                        verdicts[n].push_back(std::make_tuple(spec, constraint->from_id(), matched));
+                    }
+
+                    if (matched != bool(constraint->spec().if_package()))
+                        break;
+                }
+            }
+            catch (...)
+            {
+                /* leave it for the sequential pass to rediscover */
+            }
+        });
+
+    {
+        ScopedResolverProfileTimer timer(_imp->profile, "parallel candidate evaluation");
+
+        /* we get called for every decision, so keep the same workers around
+         * rather than starting new threads each time */
+        if (! _imp->candidate_evaluation_queue)
+            _imp->candidate_evaluation_queue.reset(new OrderedWorkQueue(_imp->candidate_evaluation_jobs));
+
+        for (unsigned n(0), n_end(candidates.size()) ; n != n_end ; ++n)
+            _imp->candidate_evaluation_queue->add(std::bind(evaluate, n), [] () { });
+        _imp->candidate_evaluation_queue->finish(0);
+    }
+
+    for (unsigned n(0), n_end(candidates.size()) ; n != n_end ; ++n)
+        for (const auto & v : verdicts[n])
+            _imp->query_cache->add_match(std::get<0>(v), candidates[n], std::get<1>(v), opts, std::get<2>(v));
+}
+
+void
+Decider::set_candidate_evaluation_jobs(const unsigned n)
+{
+    _imp->candidate_evaluation_jobs = n;
+    _imp->candidate_evaluation_queue.reset();
+}
+
+void
+Decider::set_profile(const std::shared_ptr<ResolverProfile> & p)
+{
+    _imp->profile = p;
+}
+
+void
+Decider::set_query_cache(const std::shared_ptr<QueryCache> & c)
+{
+    _imp->query_cache_is_shared = bool(c);
+    _imp->query_cache = c ? c : std::make_shared<QueryCache>(_imp->env);
+}
+
 void
 Decider::resolve()
 {
+    /* masks and choices can have been changed by whoever is driving us
+     * since we last ran, for example by adding presets for a restart. if
+     * our cache is shared, keeping it valid is our driver's job. */
+    if (! _imp->query_cache_is_shared)
+        _imp->query_cache->clear();
+
     while (true)
     {
         _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Deciding"));
-        _resolve_decide_with_dependencies();
+        {
+            ScopedResolverProfileTimer timer(_imp->profile, "deciding");
+            _resolve_decide_with_dependencies();
+        }
 
         _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Vialating"));
-        if (_resolve_vias())
-            continue;
+        {
+            ScopedResolverProfileTimer timer(_imp->profile, "vialating");
+            if (_resolve_vias())
+                continue;
+        }
 
         _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Finding Dependents"));
-        if (_resolve_dependents())
-            continue;
+        {
+            ScopedResolverProfileTimer timer(_imp->profile, "finding dependents");
+            if (_resolve_dependents())
+                continue;
+        }
 
         _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Finding Purgeables"));
-        if (_resolve_purges())
-            continue;
+        {
+            ScopedResolverProfileTimer timer(_imp->profile, "finding purgeables");
+            if (_resolve_purges())
+                continue;
+        }
 
         break;
     }
 
     _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Confirming"));
+    ScopedResolverProfileTimer timer(_imp->profile, "confirming");
     _resolve_confirmations();
 }
 
@@ -1974,9 +2261,9 @@ Decider::_package_dep_spec_already_met(const PackageDepSpec & spec, const std::s
 {
     Context context("When determining already met for '" + stringify(spec) + "':");
 
-    const std::shared_ptr<const PackageIDSequence> installed_ids((*_imp->env)[selection::AllVersionsUnsorted(
+    const std::shared_ptr<const PackageIDSequence> installed_ids(_select(selection::AllVersionsUnsorted(
                 generator::Matches(spec, from_id, { }) |
-                filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value()))]);
+                filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value())), from_id));
     if (installed_ids->empty())
         return false;
     else
@@ -1995,10 +2282,10 @@ Decider::_block_dep_spec_has_nothing_installed(const BlockDepSpec & spec, const
 {
     Context context("When determining already met for '" + stringify(spec) + "':");
 
-    const std::shared_ptr<const PackageIDSequence> installed_ids((*_imp->env)[selection::SomeArbitraryVersion(
+    const std::shared_ptr<const PackageIDSequence> installed_ids(_select(selection::SomeArbitraryVersion(
                 generator::Matches(spec.blocking(), from_id, { }) |
                 make_slot_filter(resolvent) |
-                filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value()))]);
+                filter::InstalledAtRoot(_imp->env->system_root_key()->parse_value())), from_id));
     return installed_ids->empty();
 }
 
@@ -38,6 +38,9 @@
 #include <paludis/resolver/resolutions_by_resolvent-fwd.hh>
 #include <paludis/resolver/change_by_resolvent-fwd.hh>
 #include <paludis/resolver/why_changed_choices-fwd.hh>
+#include <paludis/resolver/suggest_restart-fwd.hh>
+#include <paludis/resolver/resolver_profile-fwd.hh>
+#include <paludis/resolver/query_cache-fwd.hh>
 #include <paludis/util/attributes.hh>
 #include <paludis/util/pimp.hh>
 #include <paludis/util/tribool-fwd.hh>
@@ -46,6 +49,8 @@
 #include <paludis/repository-fwd.hh>
 #include <paludis/filtered_generator-fwd.hh>
 #include <paludis/generator-fwd.hh>
+#include <paludis/selection-fwd.hh>
+#include <paludis/match_package-fwd.hh>
 #include <paludis/changed_choices-fwd.hh>
 #include <paludis/name-fwd.hh>
 #include <tuple>
@@ -231,6 +236,21 @@ namespace paludis
 
                 void _confirm(const std::shared_ptr<const Resolution> & resolution);
 
+                const std::shared_ptr<const PackageIDSequence> _select(
+                        const Selection &,
+                        const std::shared_ptr<const PackageID> & from_id) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                bool _match(
+                        const PackageDepSpec &,
+                        const std::shared_ptr<const PackageID> &,
+                        const std::shared_ptr<const PackageID> & from_id,
+                        const MatchPackageOptions &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                void _prefetch_candidates(
+                        const std::shared_ptr<const Resolution> &,
+                        const std::shared_ptr<const PackageIDSequence> &,
+                        const MatchPackageOptions &) const;
+
             public:
                 Decider(const Environment * const,
                         const ResolverFunctions &,
@@ -243,6 +263,34 @@ namespace paludis
 
                 void purge();
 
+                /**
+                 * Forget every decision that could have been affected by the
+                 * restart, so that resolve() can be called again without
+                 * starting from scratch.
+                 */
+                const RestartStatistics restart(const SuggestRestart &);
+
+                /**
+                 * If n is greater than one, evaluate up to n candidate IDs
+                 * at once when looking for an ID, so that metadata for the
+                 * candidates is loaded in parallel. The same ID is chosen
+                 * either way.
+                 */
+                void set_candidate_evaluation_jobs(const unsigned n);
+
+                /**
+                 * Record timings and counters into the supplied profile,
+                 * which may be null.
+                 */
+                void set_profile(const std::shared_ptr<ResolverProfile> &);
+
+                /**
+                 * Use the supplied QueryCache, which may be shared with other
+                 * Decider instances, rather than our own. Passing null goes
+                 * back to using a fresh one of our own.
+                 */
+                void set_query_cache(const std::shared_ptr<QueryCache> &);
+
                 std::pair<AnyChildScore, OperatorScore> find_any_score(
                         const std::shared_ptr<const Resolution> &,
                         const std::shared_ptr<const PackageID> &,
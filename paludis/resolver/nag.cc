@@ -36,8 +36,9 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <algorithm>
-#include <list>
 #include <set>
+#include <tuple>
+#include <vector>
 
 using namespace paludis;
 using namespace paludis::resolver;
@@ -100,12 +101,6 @@ NAGIndex::deserialise(Deserialisation & d)
 
 namespace paludis
 {
-    namespace n
-    {
-        typedef Name<struct name_index> index;
-        typedef Name<struct name_lowlink> lowlink;
-    }
-
     template <>
     struct Imp<NAG>
     {
@@ -169,61 +164,121 @@ NAG::verify_edges() const
 
 namespace
 {
-    struct TarjanData
+    /* a compact copy of a NAG, with nodes numbered densely and edges held in
+     * CSR form, for the benefit of tarjan. rows holds the from nodes in the
+     * order the original edges map iterates over them, and each row's targets
+     * are in the order the original inner map iterates over them. */
+    struct CompactNAG
     {
-        NamedValue<n::index, int> index;
-        NamedValue<n::lowlink, int> lowlink;
-    };
+        std::vector<const NAGIndex *> nodes;
+        std::unordered_map<NAGIndex, int, Hash<NAGIndex> > ids;
+        std::vector<int> offsets;
+        std::vector<int> targets;
+        std::vector<int> rows;
 
-    typedef std::unordered_map<NAGIndex, TarjanData, Hash<NAGIndex> > TarjanDataMap;
-    typedef std::list<NAGIndex> TarjanStack;
-    typedef std::unordered_map<NAGIndex, StronglyConnectedComponent, Hash<NAGIndex> > StronglyConnectedComponentsByRepresentative;
-    typedef std::unordered_map<NAGIndex, NAGIndex, Hash<NAGIndex> > RepresentativeNodes;
+        CompactNAG(const Nodes & n, const Edges & edges)
+        {
+            nodes.reserve(n.size());
+            ids.reserve(n.size());
+            for (const auto & node : n)
+            {
+                ids.insert(std::make_pair(node, nodes.size()));
+                nodes.push_back(&node);
+            }
 
-    TarjanDataMap::iterator tarjan(const NAGIndex & node, const Edges & edges, TarjanDataMap & data, TarjanStack & stack, int & index,
-            StronglyConnectedComponentsByRepresentative & result)
-    {
-        TarjanDataMap::iterator node_data(data.insert(std::make_pair(node, make_named_values<TarjanData>(
-                            n::index() = index,
-                            n::lowlink() = index
-                            ))).first);
-        ++index;
+            offsets.assign(nodes.size() + 1, 0);
+            rows.reserve(edges.size());
+            for (const auto & e : edges)
+            {
+                int from(id(e.first));
+                rows.push_back(from);
+                offsets[from + 1] = e.second.size();
+            }
 
-        TarjanStack::iterator top_of_stack_before_node(stack.begin());
-        stack.push_front(node);
+            for (std::size_t i(1) ; i < offsets.size() ; ++i)
+                offsets[i] += offsets[i - 1];
 
-        Edges::const_iterator e(edges.find(node));
-        if (e != edges.end())
-        {
-            for (const auto & n : e->second)
+            targets.resize(offsets.back());
+            for (const auto & e : edges)
             {
-                TarjanDataMap::iterator n_data(data.find(n.first));
-                if (data.end() == n_data)
-                {
-                    n_data = tarjan(n.first, edges, data, stack, index, result);
-                    node_data->second.lowlink() = std::min(node_data->second.lowlink(), n_data->second.lowlink());
-                }
-                else if (stack.end() != std::find(stack.begin(), stack.end(), n.first))
-                    node_data->second.lowlink() = std::min(node_data->second.lowlink(), n_data->second.index());
+                int pos(offsets[id(e.first)]);
+                for (const auto & t : e.second)
+                    targets[pos++] = id(t.first);
             }
         }
 
-        if (node_data->second.index() == node_data->second.lowlink())
+        int id(const NAGIndex & x) const
         {
-            StronglyConnectedComponent scc(make_named_values<StronglyConnectedComponent>(
-                        n::nodes() = std::make_shared<Set<NAGIndex>>(),
-                        n::requirements() = std::make_shared<Set<NAGIndex>>()
-                        ));
+            auto i(ids.find(x));
+            if (i == ids.end())
+                throw InternalError(PALUDIS_HERE, "Missing node '" + stringify(x) + "'");
+            return i->second;
+        }
+    };
 
-            std::copy(stack.begin(), top_of_stack_before_node, scc.nodes()->inserter());
-            stack.erase(stack.begin(), top_of_stack_before_node);
+    /* iterative, so that a long dependency chain can't run us out of stack.
+     * returns the number of components, and fills in component for every
+     * node. */
+    int tarjan(const CompactNAG & graph, std::vector<int> & component)
+    {
+        const int n(graph.nodes.size());
+        std::vector<int> index(n, -1), lowlink(n, 0);
+        std::vector<char> on_stack(n, 0);
+        std::vector<int> stack;
+        std::vector<std::pair<int, int> > calls;
+        int next_index(0), n_components(0);
+
+        component.assign(n, -1);
 
-            if (scc.nodes()->empty())
-                throw InternalError(PALUDIS_HERE, "empty scc");
-            result.insert(std::make_pair(*scc.nodes()->begin(), scc));
+        for (int root(0) ; root < n ; ++root)
+        {
+            if (-1 != index[root])
+                continue;
+
+            index[root] = lowlink[root] = next_index++;
+            stack.push_back(root);
+            on_stack[root] = 1;
+            calls.push_back(std::make_pair(root, graph.offsets[root]));
+
+            while (! calls.empty())
+            {
+                const int v(calls.back().first);
+                if (calls.back().second < graph.offsets[v + 1])
+                {
+                    const int w(graph.targets[calls.back().second++]);
+                    if (-1 == index[w])
+                    {
+                        index[w] = lowlink[w] = next_index++;
+                        stack.push_back(w);
+                        on_stack[w] = 1;
+                        calls.push_back(std::make_pair(w, graph.offsets[w]));
+                    }
+                    else if (on_stack[w])
+                        lowlink[v] = std::min(lowlink[v], index[w]);
+
+                    continue;
+                }
+
+                if (lowlink[v] == index[v])
+                {
+                    int w;
+                    do
+                    {
+                        w = stack.back();
+                        stack.pop_back();
+                        on_stack[w] = 0;
+                        component[w] = n_components;
+                    } while (w != v);
+                    ++n_components;
+                }
+
+                calls.pop_back();
+                if (! calls.empty())
+                    lowlink[calls.back().first] = std::min(lowlink[calls.back().first], lowlink[v]);
+            }
         }
 
-        return node_data;
+        return n_components;
     }
 
     int order_score_one(const NAGIndex & n, const std::function<Tribool (const NAGIndex &)> & order_early_fn)
@@ -251,7 +306,9 @@ namespace
         throw InternalError(PALUDIS_HERE, "bad nir");
     }
 
-    std::pair<int, NAGIndex> order_score(const NAGIndex & r, const StronglyConnectedComponent & scc,
+    typedef std::tuple<int, NAGIndex, int> OrderScore;
+
+    OrderScore order_score(const int c, const StronglyConnectedComponent & scc,
             const std::function<Tribool (const NAGIndex &)> & order_early_fn)
     {
         int best_score(-1);
@@ -264,7 +321,9 @@ namespace
                 best_score = score;
         }
 
-        return std::make_pair(best_score, r);
+        /* the representative node is unique to the scc, so c never affects
+         * the ordering */
+        return OrderScore(best_score, *scc.nodes()->begin(), c);
     }
 }
 
@@ -273,108 +332,105 @@ NAG::sorted_strongly_connected_components(
         const std::function<Tribool (const NAGIndex &)> & order_early_fn
         ) const
 {
-    StronglyConnectedComponentsByRepresentative sccs;
-    TarjanDataMap data;
-    TarjanStack stack;
-
     /* find our strongly connected components */
-    int index(0);
-    for (Nodes::const_iterator n(_imp->nodes.begin()), n_end(_imp->nodes.end()) ;
-            n != n_end ; ++n)
-        if (data.end() == data.find(*n))
-            tarjan(*n, _imp->edges, data, stack, index, sccs);
-
-    /* find the 'representative' scc node for every node */
-    RepresentativeNodes representative_nodes;
-    for (StronglyConnectedComponentsByRepresentative::const_iterator s(sccs.begin()), s_end(sccs.end()) ;
-            s != s_end ; ++s)
-        for (Set<NAGIndex>::ConstIterator r(s->second.nodes()->begin()), r_end(s->second.nodes()->end()) ;
-                r != r_end ; ++r)
-            if (! representative_nodes.insert(std::make_pair(*r, s->first)).second)
-                throw InternalError(PALUDIS_HERE, "node in multiple sccs");
-
-    /* sanity check, to avoid us much weirdness if there's a bug */
-    if (representative_nodes.size() != _imp->nodes.size())
-        throw InternalError(PALUDIS_HERE, "mismatch");
-
-    /* build edges between SCCs */
-    PlainEdges all_scc_edges, scc_edges, scc_edges_backwards;
-    for (const auto & edge : _imp->edges)
-    {
-        RepresentativeNodes::const_iterator from(representative_nodes.find(edge.first));
-        for (const auto & n : edge.second)
+    const CompactNAG graph(_imp->nodes, _imp->edges);
+    std::vector<int> component;
+    const int n_sccs(tarjan(graph, component));
+
+    std::vector<StronglyConnectedComponent> sccs;
+    sccs.reserve(n_sccs);
+    for (int c(0) ; c < n_sccs ; ++c)
+        sccs.push_back(make_named_values<StronglyConnectedComponent>(
+                    n::nodes() = std::make_shared<Set<NAGIndex>>(),
+                    n::requirements() = std::make_shared<Set<NAGIndex>>()
+                    ));
+
+    for (std::size_t i(0) ; i < graph.nodes.size() ; ++i)
+        sccs[component[i]].nodes()->insert(*graph.nodes[i]);
+
+    /* build edges between SCCs. the order in which pending fetches get
+     * emitted below depends upon the iteration order of all_scc_edges, so it
+     * must be populated in the same order as the edges are stored. */
+    PlainEdges all_scc_edges;
+    std::vector<std::pair<int, int> > scc_edges;
+    for (int from : graph.rows)
+        for (int pos(graph.offsets[from]), pos_end(graph.offsets[from + 1]) ; pos != pos_end ; ++pos)
         {
-            RepresentativeNodes::const_iterator to(representative_nodes.find(n.first));
-            if (! (to->second == from->second))
+            const int from_c(component[from]), to_c(component[graph.targets[pos]]);
+            if (from_c != to_c)
             {
-                all_scc_edges.insert(std::make_pair(from->second, Nodes())).first->second.insert(to->second);
-                scc_edges.insert(std::make_pair(from->second, Nodes())).first->second.insert(to->second);
-                scc_edges_backwards.insert(std::make_pair(to->second, Nodes())).first->second.insert(from->second);
+                all_scc_edges.insert(std::make_pair(*sccs[from_c].nodes()->begin(), Nodes())).first->second.insert(
+                        *sccs[to_c].nodes()->begin());
+                scc_edges.push_back(std::make_pair(from_c, to_c));
             }
         }
+
+    std::sort(scc_edges.begin(), scc_edges.end());
+    scc_edges.erase(std::unique(scc_edges.begin(), scc_edges.end()), scc_edges.end());
+
+    std::vector<int> unordered_dependencies(n_sccs, 0);
+    std::vector<std::vector<int> > dependents(n_sccs);
+    for (const auto & e : scc_edges)
+    {
+        ++unordered_dependencies[e.first];
+        dependents[e.second].push_back(e.first);
     }
 
     /* topological sort with consistent ordering (mostly to make test cases
      * easier). we know there're no cycles. */
     std::shared_ptr<SortedStronglyConnectedComponents> result(std::make_shared<SortedStronglyConnectedComponents>());
 
-    typedef std::set<std::pair<int, NAGIndex> > OrderableNow;
+    typedef std::set<OrderScore> OrderableNow;
     OrderableNow orderable_now;
-    Nodes done, pending_fetches;
+    std::vector<char> pending_fetches(n_sccs, 0);
+    int done(0), n_pending_fetches(0);
 
-    for (StronglyConnectedComponentsByRepresentative::const_iterator c(sccs.begin()), c_end(sccs.end()) ;
-            c != c_end ; ++c)
-        if (scc_edges.end() == scc_edges.find(c->first))
-            orderable_now.insert(order_score(c->first, c->second, order_early_fn));
+    for (int c(0) ; c < n_sccs ; ++c)
+        if (0 == unordered_dependencies[c])
+            orderable_now.insert(order_score(c, sccs[c], order_early_fn));
 
     while (! orderable_now.empty())
     {
         OrderableNow::iterator ordering_now(orderable_now.begin());
-        StronglyConnectedComponentsByRepresentative::const_iterator ordering_now_scc(sccs.find(ordering_now->second));
+        const int c(std::get<2>(*ordering_now));
 
-        if (ordering_now_scc->second.nodes()->size() == 1 && ordering_now_scc->second.nodes()->begin()->role() == nir_fetched)
-            pending_fetches.insert(ordering_now->second);
+        if (sccs[c].nodes()->size() == 1 && sccs[c].nodes()->begin()->role() == nir_fetched)
+        {
+            pending_fetches[c] = 1;
+            ++n_pending_fetches;
+        }
         else
         {
-            auto this_scc_edges(all_scc_edges.find(ordering_now->second));
+            auto this_scc_edges(all_scc_edges.find(std::get<1>(*ordering_now)));
             if (this_scc_edges != all_scc_edges.end())
             {
                 for (const auto & e : this_scc_edges->second)
                 {
-                    auto p(pending_fetches.find(e));
-                    if (p != pending_fetches.end())
+                    const int p(component[graph.id(e)]);
+                    if (pending_fetches[p])
                     {
-                        result->push_back(sccs.find(e)->second);
-                        pending_fetches.erase(p);
+                        result->push_back(sccs[p]);
+                        pending_fetches[p] = 0;
+                        --n_pending_fetches;
                     }
                 }
             }
 
-            result->push_back(ordering_now_scc->second);
+            result->push_back(sccs[c]);
         }
-        done.insert(ordering_now->second);
+        ++done;
 
-        PlainEdges::iterator ordering_now_edges(scc_edges_backwards.find(ordering_now->second));
-        if (ordering_now_edges != scc_edges_backwards.end())
-            for (Nodes::iterator e(ordering_now_edges->second.begin()), e_end(ordering_now_edges->second.end()) ;
-                    e != e_end ; )
-            {
-                PlainEdges::iterator reverse_edges(scc_edges.find(*e));
-                if (reverse_edges == scc_edges.end())
-                    throw InternalError(PALUDIS_HERE, "huh?");
-                reverse_edges->second.erase(ordering_now->second);
-                if (reverse_edges->second.empty())
-                    orderable_now.insert(order_score(*e, sccs.find(*e)->second, order_early_fn));
-                ordering_now_edges->second.erase(e++);
-            }
+        for (int d : dependents[c])
+            if (0 == --unordered_dependencies[d])
+                orderable_now.insert(order_score(d, sccs[d], order_early_fn));
 
         orderable_now.erase(ordering_now);
     }
 
-    if (! pending_fetches.empty())
+    if (0 != n_pending_fetches)
         throw InternalError(PALUDIS_HERE, "still have pending fetches");
 
-    if (done.size() != sccs.size())
+    if (done != n_sccs)
         throw InternalError(PALUDIS_HERE, "mismatch");
 
     return result;
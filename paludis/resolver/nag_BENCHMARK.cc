@@ -0,0 +1,189 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Times NAG::sorted_strongly_connected_components on synthetic graphs shaped
+ * roughly like real resolutions: every resolvent has a fetched and a done
+ * node, most dependencies point at earlier resolvents, and a few point
+ * backwards to make cycles.
+ *
+ * Usage:
+ *
+ *     nag_BENCHMARK [--print] [resolvents ...]
+ *
+ * With --print, the sorted components are written out too, which is handy
+ * for checking that a change to the implementation hasn't changed the
+ * ordering. The graphs are always generated from the same seed.
+ */
+
+#include <paludis/resolver/nag.hh>
+#include <paludis/resolver/resolvent.hh>
+#include <paludis/resolver/destination_types.hh>
+#include <paludis/resolver/strongly_connected_component.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/tribool.hh>
+#include <paludis/util/join.hh>
+#include <paludis/name.hh>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace paludis;
+using namespace paludis::resolver;
+
+namespace
+{
+    template <typename F_>
+    double time_ms(const F_ & f)
+    {
+        auto start(std::chrono::steady_clock::now());
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    NAGIndex make_index(const int i, const NAGIndexRole role)
+    {
+        return make_named_values<NAGIndex>(
+                n::resolvent() = Resolvent(QualifiedPackageName("cat-" + std::to_string(i % 97) + "/pkg" + std::to_string(i)),
+                    SlotName("0"), dt_install_to_slash),
+                n::role() = role
+                );
+    }
+
+    NAGEdgeProperties make_properties(const bool build, const bool run)
+    {
+        return make_named_values<NAGEdgeProperties>(
+                n::always() = false,
+                n::build() = build,
+                n::build_all_met() = ! build,
+                n::run() = run,
+                n::run_all_met() = ! run
+                );
+    }
+
+    void make_synthetic_nag(NAG & nag, const int size)
+    {
+        std::mt19937 random(size);
+        std::vector<NAGIndex> fetched, done;
+        fetched.reserve(size);
+        done.reserve(size);
+
+        for (int i(0) ; i < size ; ++i)
+        {
+            fetched.push_back(make_index(i, nir_fetched));
+            done.push_back(make_index(i, nir_done));
+            nag.add_node(fetched.back());
+            nag.add_node(done.back());
+            nag.add_edge(done.back(), fetched.back(), make_properties(true, false));
+        }
+
+        for (int i(1) ; i < size ; ++i)
+        {
+            int n_deps(random() % 8);
+            for (int d(0) ; d < n_deps ; ++d)
+            {
+                /* mostly near neighbours, like a real dependency tree */
+                int j(i - 1 - int(random() % std::min(i, 200)));
+                switch (random() % 10)
+                {
+                    case 0:
+                        nag.add_edge(fetched[i], done[j], make_properties(true, false));
+                        break;
+
+                    case 1:
+                    case 2:
+                        nag.add_edge(done[i], done[j], make_properties(false, true));
+                        break;
+
+                    default:
+                        nag.add_edge(done[i], done[j], make_properties(true, true));
+                        break;
+                }
+            }
+
+            /* and the occasional cycle */
+            if (0 == random() % 10)
+            {
+                int j(i - 1 - int(random() % std::min(i, 5)));
+                nag.add_edge(done[j], done[i], make_properties(false, true));
+            }
+        }
+
+        nag.verify_edges();
+    }
+
+    Tribool order_early(const NAGIndex & x)
+    {
+        switch (x.resolvent().package().package().value().length() % 3)
+        {
+            case 0:
+                return true;
+            case 1:
+                return false;
+            default:
+                return indeterminate;
+        }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    bool print(false);
+    std::vector<int> sizes;
+
+    for (int i(1) ; i < argc ; ++i)
+    {
+        if (std::string(argv[i]) == "--print")
+            print = true;
+        else
+            sizes.push_back(std::atoi(argv[i]));
+    }
+
+    if (sizes.empty())
+        sizes = { 1000, 10000, 50000 };
+
+    for (int size : sizes)
+    {
+        NAG nag;
+        double build_ms(time_ms([&] () { make_synthetic_nag(nag, size); }));
+
+        std::shared_ptr<const SortedStronglyConnectedComponents> ssccs;
+        double sort_ms(time_ms([&] () { ssccs = nag.sorted_strongly_connected_components(order_early); }));
+
+        int n_sccs(0), n_cyclic(0);
+        for (const auto & scc : *ssccs)
+        {
+            ++n_sccs;
+            if (scc.nodes()->size() > 1)
+                ++n_cyclic;
+            if (print)
+                std::cout << join(scc.nodes()->begin(), scc.nodes()->end(), ", ") << std::endl;
+        }
+
+        std::cout << "resolvents:      " << size << " (" << n_sccs << " components, " << n_cyclic << " cyclic)" << std::endl;
+        std::cout << "build:           " << build_ms << " ms" << std::endl;
+        std::cout << "sorted sccs:     " << sort_ms << " ms" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
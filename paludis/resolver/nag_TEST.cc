@@ -0,0 +1,154 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/resolver/nag.hh>
+#include <paludis/resolver/resolvent.hh>
+#include <paludis/resolver/destination_types.hh>
+#include <paludis/resolver/strongly_connected_component.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/tribool.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/name.hh>
+
+#include <iterator>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+using namespace paludis::resolver;
+
+namespace
+{
+    NAGIndex make_index(const std::string & p, const NAGIndexRole role = nir_done)
+    {
+        return make_named_values<NAGIndex>(
+                n::resolvent() = Resolvent(QualifiedPackageName("cat/" + p), SlotName("0"), dt_install_to_slash),
+                n::role() = role
+                );
+    }
+
+    void add_edge(NAG & nag, const NAGIndex & from, const NAGIndex & to)
+    {
+        nag.add_edge(from, to, make_named_values<NAGEdgeProperties>(
+                    n::always() = false,
+                    n::build() = true,
+                    n::build_all_met() = false,
+                    n::run() = true,
+                    n::run_all_met() = false
+                    ));
+    }
+
+    void add_edge(NAG & nag, const std::string & from, const std::string & to)
+    {
+        add_edge(nag, make_index(from), make_index(to));
+    }
+
+    Tribool no_preference(const NAGIndex &)
+    {
+        return indeterminate;
+    }
+
+    std::string describe(const NAG & nag)
+    {
+        std::string result;
+        auto sccs(nag.sorted_strongly_connected_components(&no_preference));
+        for (const auto & scc : *sccs)
+        {
+            if (! result.empty())
+                result.append("; ");
+
+            std::string nodes;
+            for (const auto & node : *scc.nodes())
+            {
+                if (! nodes.empty())
+                    nodes.append(" ");
+                nodes.append(stringify(node.resolvent().package().package()));
+                if (node.role() == nir_fetched)
+                    nodes.append(" (fetch)");
+            }
+            result.append(nodes);
+        }
+
+        return result;
+    }
+}
+
+TEST(NAG, Components)
+{
+    NAG nag;
+    for (const auto & p : { "a", "b", "c", "d", "e", "f", "g", "h", "i" })
+        nag.add_node(make_index(p));
+
+    /* a self loop */
+    add_edge(nag, "a", "a");
+
+    /* b <-> c, nested inside c -> d -> e -> c */
+    add_edge(nag, "b", "c");
+    add_edge(nag, "c", "b");
+    add_edge(nag, "c", "d");
+    add_edge(nag, "d", "e");
+    add_edge(nag, "e", "c");
+
+    /* a separate cycle, which depends upon the first */
+    add_edge(nag, "f", "g");
+    add_edge(nag, "g", "f");
+    add_edge(nag, "g", "d");
+
+    add_edge(nag, "h", "a");
+    add_edge(nag, "i", "f");
+    add_edge(nag, "i", "h");
+
+    nag.verify_edges();
+    EXPECT_EQ("a; b c d e; f g; h; i", describe(nag));
+}
+
+TEST(NAG, PendingFetches)
+{
+    NAG nag;
+    nag.add_node(make_index("x", nir_fetched));
+    nag.add_node(make_index("x"));
+    nag.add_node(make_index("y"));
+
+    add_edge(nag, make_index("x"), make_index("x", nir_fetched));
+    add_edge(nag, "y", "x");
+
+    nag.verify_edges();
+    EXPECT_EQ("x (fetch); x; y", describe(nag));
+}
+
+TEST(NAG, DeepCycle)
+{
+    /* one long cycle, far deeper than any real dependency chain */
+    const int size(50000);
+
+    NAG nag;
+    for (int n(0) ; n < size ; ++n)
+        nag.add_node(make_index("p" + stringify(n)));
+    for (int n(0) ; n < size ; ++n)
+        add_edge(nag, "p" + stringify(n), "p" + stringify((n + 1) % size));
+    nag.add_node(make_index("q"));
+    add_edge(nag, "q", "p0");
+
+    nag.verify_edges();
+    auto sccs(nag.sorted_strongly_connected_components(&no_preference));
+    ASSERT_EQ(2, std::distance(sccs->begin(), sccs->end()));
+    EXPECT_EQ(std::size_t(size), sccs->begin()->nodes()->size());
+    EXPECT_EQ(make_index("q"), *std::next(sccs->begin())->nodes()->begin());
+}
@@ -782,8 +782,8 @@ Orderer::_order_sub_ssccs(
             for (Set<NAGIndex>::ConstIterator r(sub_scc->nodes()->begin()), r_end(sub_scc->nodes()->end()) ;
                     r != r_end ; ++r)
             {
-                if (r->role() == nir_fetched && sub_scc->nodes()->end() != std::find(sub_scc->nodes()->begin(),
-                            sub_scc->nodes()->end(), make_named_values<NAGIndex>(
+                if (r->role() == nir_fetched && sub_scc->nodes()->end() != sub_scc->nodes()->find(
+                            make_named_values<NAGIndex>(
                                 n::resolvent() = r->resolvent(),
                                 n::role() = nir_done
                                 )))
@@ -1,7 +1,7 @@
 /* vim: set sw=4 sts=4 et foldmethod=syntax : */
 
 /*
- * Copyright (c) 2010 Ciaran McCreesh
+ * Copyright (c) 2026 the Paludis developers
  *
  * This file is part of the Paludis package manager. Paludis is free software;
  * you can redistribute it and/or modify it under the terms of the GNU General
@@ -17,16 +17,16 @@
  * Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#ifndef PALUDIS_GUARD_PALUDIS_STRIPPER_EXTRAS_HH
-#define PALUDIS_GUARD_PALUDIS_STRIPPER_EXTRAS_HH 1
 
-#include <paludis/util/attributes.hh>
-#include <string>
+#ifndef PALUDIS_GUARD_PALUDIS_RESOLVER_QUERY_CACHE_FWD_HH
+#define PALUDIS_GUARD_PALUDIS_RESOLVER_QUERY_CACHE_FWD_HH 1
 
-struct PaludisStripperExtras;
-
-extern "C" PaludisStripperExtras * paludis_stripper_extras_init() PALUDIS_VISIBLE PALUDIS_ATTRIBUTE((warn_unused_result));
-extern "C" const std::string paludis_stripper_extras_lookup(PaludisStripperExtras * const, const std::string &) PALUDIS_VISIBLE;
-extern "C" void paludis_stripper_extras_cleanup(PaludisStripperExtras * const) PALUDIS_VISIBLE;
+namespace paludis
+{
+    namespace resolver
+    {
+        class QueryCache;
+    }
+}
 
 #endif
@@ -0,0 +1,169 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/resolver/query_cache.hh>
+#include <paludis/resolver/resolver_profile.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/enum_iterator.hh>
+#include <paludis/util/hashes.hh>
+#include <paludis/util/options.hh>
+#include <paludis/environment.hh>
+#include <paludis/selection.hh>
+#include <paludis/match_package.hh>
+#include <paludis/dep_spec.hh>
+#include <paludis/package_id.hh>
+#include <unordered_map>
+#include <tuple>
+
+using namespace paludis;
+using namespace paludis::resolver;
+
+namespace
+{
+    /* from_id is part of every key, because a selection's string form
+     * doesn't include it, and because it matters for [foo?] style
+     * requirements. */
+    typedef std::pair<std::string, std::shared_ptr<const PackageID> > SelectionCacheKey;
+
+    struct SelectionCacheKeyHash
+    {
+        std::size_t operator() (const SelectionCacheKey & k) const
+        {
+            return Hash<std::string>()(k.first) ^ std::hash<const PackageID *>()(k.second.get());
+        }
+    };
+
+    typedef std::unordered_map<SelectionCacheKey, std::shared_ptr<const PackageIDSequence>, SelectionCacheKeyHash> SelectionCache;
+
+    /* specs are keyed by their shared data, which is kept alive by the key,
+     * so copies of the same spec share cache entries */
+    typedef std::tuple<std::shared_ptr<const PackageDepSpecData>, std::shared_ptr<const PackageID>,
+            std::shared_ptr<const PackageID>, unsigned> MatchCacheKey;
+
+    struct MatchCacheKeyHash
+    {
+        std::size_t operator() (const MatchCacheKey & k) const
+        {
+            return std::hash<const PackageDepSpecData *>()(std::get<0>(k).get())
+                ^ (std::hash<const PackageID *>()(std::get<1>(k).get()) << 1)
+                ^ (std::hash<const PackageID *>()(std::get<2>(k).get()) << 2)
+                ^ std::get<3>(k);
+        }
+    };
+
+    typedef std::unordered_map<MatchCacheKey, bool, MatchCacheKeyHash> MatchCache;
+
+    MatchCacheKey make_match_cache_key(const PackageDepSpec & spec, const std::shared_ptr<const PackageID> & id,
+            const std::shared_ptr<const PackageID> & from_id, const MatchPackageOptions & o)
+    {
+        unsigned options_bits(0);
+        for (EnumIterator<MatchPackageOption> t, t_end(last_mpo) ; t != t_end ; ++t)
+            if (o[*t])
+                options_bits |= (1u << static_cast<unsigned>(*t));
+
+        return MatchCacheKey(spec.data(), id, from_id, options_bits);
+    }
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<QueryCache>
+    {
+        const Environment * const env;
+
+        mutable SelectionCache selection_cache;
+        mutable MatchCache match_cache;
+
+        Imp(const Environment * const e) :
+            env(e)
+        {
+        }
+    };
+}
+
+QueryCache::QueryCache(const Environment * const e) :
+    _imp(e)
+{
+}
+
+QueryCache::~QueryCache() = default;
+
+const std::shared_ptr<const PackageIDSequence>
+QueryCache::select(const Selection & selection, const std::shared_ptr<const PackageID> & from_id,
+        const std::shared_ptr<ResolverProfile> & profile) const
+{
+    SelectionCacheKey key(selection.as_string(), from_id);
+    auto i(_imp->selection_cache.find(key));
+    if (i == _imp->selection_cache.end())
+    {
+        /* this is where metadata gets loaded and masks get checked */
+        ScopedResolverProfileTimer timer(profile, "selections");
+        i = _imp->selection_cache.insert(std::make_pair(key, (*_imp->env)[selection])).first;
+    }
+    else if (profile)
+        profile->increment("selection cache hits");
+
+    return i->second;
+}
+
+bool
+QueryCache::match(const PackageDepSpec & spec, const std::shared_ptr<const PackageID> & id,
+        const std::shared_ptr<const PackageID> & from_id, const MatchPackageOptions & opts,
+        const std::shared_ptr<ResolverProfile> & profile) const
+{
+    MatchCacheKey key(make_match_cache_key(spec, id, from_id, opts));
+    auto i(_imp->match_cache.find(key));
+    if (i == _imp->match_cache.end())
+    {
+        ScopedResolverProfileTimer timer(profile, "matches");
+        i = _imp->match_cache.insert(std::make_pair(key, match_package(*_imp->env, spec, id, from_id, opts))).first;
+    }
+    else if (profile)
+        profile->increment("match cache hits");
+
+    return i->second;
+}
+
+bool
+QueryCache::known_match(const PackageDepSpec & spec, const std::shared_ptr<const PackageID> & id,
+        const std::shared_ptr<const PackageID> & from_id, const MatchPackageOptions & opts, bool & result) const
+{
+    auto i(_imp->match_cache.find(make_match_cache_key(spec, id, from_id, opts)));
+    if (i == _imp->match_cache.end())
+        return false;
+
+    result = i->second;
+    return true;
+}
+
+void
+QueryCache::add_match(const PackageDepSpec & spec, const std::shared_ptr<const PackageID> & id,
+        const std::shared_ptr<const PackageID> & from_id, const MatchPackageOptions & opts, const bool result)
+{
+    _imp->match_cache.insert(std::make_pair(make_match_cache_key(spec, id, from_id, opts), result));
+}
+
+void
+QueryCache::clear()
+{
+    _imp->selection_cache.clear();
+    _imp->match_cache.clear();
+}
@@ -0,0 +1,110 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_RESOLVER_QUERY_CACHE_HH
+#define PALUDIS_GUARD_PALUDIS_RESOLVER_QUERY_CACHE_HH 1
+
+#include <paludis/resolver/query_cache-fwd.hh>
+#include <paludis/resolver/resolver_profile-fwd.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/environment-fwd.hh>
+#include <paludis/selection-fwd.hh>
+#include <paludis/package_id-fwd.hh>
+#include <paludis/dep_spec-fwd.hh>
+#include <paludis/match_package-fwd.hh>
+#include <memory>
+
+namespace paludis
+{
+    namespace resolver
+    {
+        /**
+         * Remembers the answers to the selections and package matches that
+         * the Decider makes, since it asks for the same ones over and over
+         * again.
+         *
+         * A Decider normally has its own QueryCache, which it clears each time
+         * resolve() starts. One may instead be shared between several
+         * Resolver instances using Resolver::set_query_cache, in which case
+         * it is never cleared for us. Only do this if nothing changes the
+         * environment in between, and if every Resolver sharing it is using
+         * equivalent ResolverFunctions.
+         */
+        class PALUDIS_VISIBLE QueryCache
+        {
+            private:
+                Pimp<QueryCache> _imp;
+
+            public:
+                explicit QueryCache(const Environment * const);
+                ~QueryCache();
+
+                QueryCache(const QueryCache &) = delete;
+                QueryCache & operator= (const QueryCache &) = delete;
+
+                /**
+                 * Equivalent to (*env)[selection]. The from_id must be the
+                 * one used by any generator::Matches in the selection.
+                 */
+                const std::shared_ptr<const PackageIDSequence> select(
+                        const Selection &,
+                        const std::shared_ptr<const PackageID> & from_id,
+                        const std::shared_ptr<ResolverProfile> &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * Equivalent to match_package.
+                 */
+                bool match(
+                        const PackageDepSpec &,
+                        const std::shared_ptr<const PackageID> &,
+                        const std::shared_ptr<const PackageID> & from_id,
+                        const MatchPackageOptions &,
+                        const std::shared_ptr<ResolverProfile> &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * If we already know the answer to a match, set result to
+                 * it and return true. Nothing is computed or remembered, so
+                 * this may be called from several threads at once, as long
+                 * as nothing else is called at the same time.
+                 */
+                bool known_match(
+                        const PackageDepSpec &,
+                        const std::shared_ptr<const PackageID> &,
+                        const std::shared_ptr<const PackageID> & from_id,
+                        const MatchPackageOptions &,
+                        bool & result) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * Remember the answer to a match worked out elsewhere.
+                 */
+                void add_match(
+                        const PackageDepSpec &,
+                        const std::shared_ptr<const PackageID> &,
+                        const std::shared_ptr<const PackageID> & from_id,
+                        const MatchPackageOptions &,
+                        const bool result);
+
+                void clear();
+        };
+    }
+}
+
+#endif
@@ -94,6 +94,17 @@ ResolutionsByResolvent::insert_new(const std::shared_ptr<Resolution> & r)
     return ConstIterator(i);
 }
 
+void
+ResolutionsByResolvent::erase(const Resolvent & r)
+{
+    ResolutionListIndex::iterator x(_imp->resolution_list_index.find(r));
+    if (x == _imp->resolution_list_index.end())
+        throw InternalError(PALUDIS_HERE, "no such resolution");
+
+    _imp->resolution_list.erase(x->second);
+    _imp->resolution_list_index.erase(x);
+}
+
 void
 ResolutionsByResolvent::serialise(Serialiser & s) const
 {
@@ -49,6 +49,12 @@ namespace paludis
 
                 ConstIterator insert_new(const std::shared_ptr<Resolution> &);
 
+                /**
+                 * Remove a resolution. Iterators to other resolutions remain
+                 * valid.
+                 */
+                void erase(const Resolvent &);
+
                 void serialise(Serialiser &) const;
 
                 static const std::shared_ptr<ResolutionsByResolvent> deserialise(
@@ -28,6 +28,8 @@
 #include <paludis/resolver/job_list.hh>
 #include <paludis/resolver/job_lists.hh>
 #include <paludis/resolver/nag.hh>
+#include <paludis/resolver/suggest_restart.hh>
+#include <paludis/resolver/resolver_profile.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/sequence.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
@@ -59,6 +61,8 @@ namespace paludis
         const std::shared_ptr<Decider> decider;
         const std::shared_ptr<Orderer> orderer;
 
+        std::shared_ptr<ResolverProfile> profile;
+
         Imp(const Environment * const e, const ResolverFunctions & f) :
             env(e),
             fns(f),
@@ -168,11 +172,41 @@ Resolver::purge()
 void
 Resolver::resolve()
 {
+    ScopedResolverProfileTimer timer(_imp->profile, "resolving");
     _imp->decider->resolve();
-    _imp->orderer->resolve();
+
+    {
+        ScopedResolverProfileTimer ordering_timer(_imp->profile, "ordering");
+        _imp->orderer->resolve();
+    }
     _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Done"));
 }
 
+const RestartStatistics
+Resolver::restart(const SuggestRestart & e)
+{
+    return _imp->decider->restart(e);
+}
+
+void
+Resolver::set_candidate_evaluation_jobs(const unsigned n)
+{
+    _imp->decider->set_candidate_evaluation_jobs(n);
+}
+
+void
+Resolver::set_profile(const std::shared_ptr<ResolverProfile> & p)
+{
+    _imp->profile = p;
+    _imp->decider->set_profile(p);
+}
+
+void
+Resolver::set_query_cache(const std::shared_ptr<QueryCache> & c)
+{
+    _imp->decider->set_query_cache(c);
+}
+
 const std::shared_ptr<const Resolved>
 Resolver::resolved() const
 {
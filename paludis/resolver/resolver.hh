@@ -27,6 +27,9 @@
 #include <paludis/resolver/resolved-fwd.hh>
 #include <paludis/resolver/sanitised_dependencies-fwd.hh>
 #include <paludis/resolver/package_or_block_dep_spec-fwd.hh>
+#include <paludis/resolver/suggest_restart-fwd.hh>
+#include <paludis/resolver/resolver_profile-fwd.hh>
+#include <paludis/resolver/query_cache-fwd.hh>
 #include <paludis/util/pimp.hh>
 #include <paludis/package_id-fwd.hh>
 #include <paludis/dep_spec-fwd.hh>
@@ -59,6 +62,41 @@ namespace paludis
 
                 void resolve();
 
+                /**
+                 * Called after resolve() throws SuggestRestart, to throw away
+                 * only the decisions affected by the restart. Afterwards,
+                 * call resolve() again; targets do not need to be re-added.
+                 *
+                 * The get_initial_constraints_for_fn must already know about
+                 * the restart. This cannot be used if the restart happened
+                 * whilst targets were being added, or when purging.
+                 */
+                const RestartStatistics restart(const SuggestRestart &);
+
+                /**
+                 * Evaluate up to n candidate IDs at once when deciding. Must
+                 * be called before resolve().
+                 *
+                 * \see Decider::set_candidate_evaluation_jobs
+                 */
+                void set_candidate_evaluation_jobs(const unsigned n);
+
+                /**
+                 * Record timings and counters for each phase of resolution
+                 * into the supplied profile, which may be null. Profiling is
+                 * off by default.
+                 */
+                void set_profile(const std::shared_ptr<ResolverProfile> &);
+
+                /**
+                 * Share the supplied QueryCache with other Resolver
+                 * instances, so that their selections and matches are only
+                 * worked out once. Must be called before resolve().
+                 *
+                 * \see QueryCache
+                 */
+                void set_query_cache(const std::shared_ptr<QueryCache> &);
+
                 const std::shared_ptr<const Resolved> resolved() const PALUDIS_ATTRIBUTE((warn_unused_result));
         };
     }
@@ -0,0 +1,302 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Times a complete resolution against a large synthetic repository, so that
+ * performance regressions in the resolver show up before a release rather
+ * than on a user's machine. The repository is generated on the fake
+ * repository classes with a fixed seed, and tries to look something like a
+ * real tree: most packages have a few versions, some are slotted, some have
+ * subslots, dependencies use slot operators, versions and USE requirements,
+ * a few packages have blockers, some post dependencies make cycles, and a
+ * third of the packages are already installed. Some dependencies want older
+ * versions than the newest, which makes the resolver restart.
+ *
+ * Usage:
+ *
+ *     resolver_BENCHMARK [ids ...]
+ *
+ * Each size is an approximate number of package IDs. The time spent in each
+ * part of the resolver is reported too, using ResolverProfile. Finding
+ * purgeables and ordering currently grow much faster than linearly, so the
+ * default sizes are modest; pass larger ones to check behaviour on trees
+ * of 100000 IDs.
+ *
+ * As with the tests, PALUDIS_DISTRIBUTIONS_DIR and PALUDIS_DISTRIBUTION must
+ * be set if Paludis is not installed.
+ */
+
+#include <paludis/resolver/resolver.hh>
+#include <paludis/resolver/resolver_functions.hh>
+#include <paludis/resolver/resolver_profile.hh>
+#include <paludis/resolver/resolved.hh>
+#include <paludis/resolver/decision.hh>
+#include <paludis/resolver/decisions.hh>
+#include <paludis/resolver/suggest_restart.hh>
+#include <paludis/resolver/resolution.hh>
+#include <paludis/resolver/package_or_block_dep_spec.hh>
+
+#include <paludis/resolver/resolver_test_helpers.hh>
+
+#include <paludis/repositories/fake/fake_repository.hh>
+#include <paludis/repositories/fake/fake_installed_repository.hh>
+#include <paludis/repositories/fake/fake_package_id.hh>
+
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/stringify.hh>
+
+#include <paludis/user_dep_spec.hh>
+#include <paludis/dep_spec.hh>
+#include <paludis/filter.hh>
+#include <paludis/filtered_generator.hh>
+#include <paludis/generator.hh>
+#include <paludis/selection.hh>
+#include <paludis/name.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace paludis;
+using namespace paludis::resolver;
+
+namespace
+{
+    template <typename F_>
+    double time_ms(const F_ & f)
+    {
+        auto start(std::chrono::steady_clock::now());
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    struct SyntheticPackage
+    {
+        std::string category;
+        std::string package;
+        std::vector<std::string> slots;
+        int versions;
+        std::vector<std::shared_ptr<FakePackageID> > ids;
+    };
+
+    struct SyntheticResolverData :
+        resolver_test::ResolverTestHelpers
+    {
+        std::shared_ptr<FakeRepository> repo;
+        std::shared_ptr<FakeInstalledRepository> inst_repo;
+        std::vector<SyntheticPackage> packages;
+        int n_ids;
+
+        SyntheticResolverData() :
+            repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                            n::environment() = &env,
+                            n::name() = RepositoryName("repo")
+                            ))),
+            inst_repo(std::make_shared<FakeInstalledRepository>(make_named_values<FakeInstalledRepositoryParams>(
+                            n::environment() = &env,
+                            n::name() = RepositoryName("installed"),
+                            n::suitable_destination() = true,
+                            n::supports_uninstall() = true
+                            ))),
+            n_ids(0)
+        {
+            env.add_repository(1, repo);
+            env.add_repository(2, inst_repo);
+        }
+
+        std::string name(const int i) const
+        {
+            return packages[i].category + "/" + packages[i].package;
+        }
+
+        /* a dependency upon an earlier package, in one of the forms that
+         * turn up in real trees */
+        std::string dependency(std::mt19937 & random, const int j) const
+        {
+            const SyntheticPackage & p(packages[j]);
+            std::string slot(p.slots.size() > 1 ? ":" + p.slots[random() % p.slots.size()] : "");
+
+            switch (random() % 8)
+            {
+                case 0:
+                    return ">=" + name(j) + "-1" + slot;
+                case 1:
+                    return name(j) + (slot.empty() ? ":=" : slot + "=");
+                case 2:
+                    return name(j) + slot + "[enabled]";
+                case 3:
+                    return name(j) + slot + "[-disabled]";
+                default:
+                    return name(j) + slot;
+            }
+        }
+
+        void generate(const int size)
+        {
+            std::mt19937 random(size);
+
+            for (int i(0) ; n_ids < size ; ++i)
+            {
+                SyntheticPackage p;
+                p.category = "cat-" + stringify(i % 50);
+                p.package = "pkg" + stringify(i);
+                p.slots.push_back(0 == i % 10 ? "1" : "0");
+                if (0 == i % 10)
+                    p.slots.push_back("2");
+                p.versions = 1 + random() % 3;
+                packages.push_back(p);
+
+                std::string build_deps, run_deps;
+                int n_deps(i == 0 ? 0 : random() % 6);
+                for (int d(0) ; d < n_deps ; ++d)
+                {
+                    int j(i - 1 - int(random() % std::min(i, 300)));
+                    (0 == random() % 2 ? build_deps : run_deps) += " " + dependency(random, j);
+                }
+
+                /* blockers that are checked against everything, but that
+                 * never match, since there is no version below 1 */
+                if (i > 0 && 0 == random() % 20)
+                    run_deps += " !<" + name(i - 1 - int(random() % std::min(i, 300))) + "-1";
+
+                /* asking for something other than the best version of a
+                 * package that has probably already been decided forces a
+                 * restart */
+                if (i > 0 && 0 == random() % 40)
+                {
+                    int j(i - 1 - int(random() % std::min(i, 300)));
+                    if (packages[j].versions > 1 && packages[j].slots.size() == 1)
+                        run_deps += " <" + name(j) + "-" + stringify(packages[j].versions);
+                }
+
+                for (const auto & slot : p.slots)
+                    for (int v(1) ; v <= p.versions ; ++v)
+                    {
+                        std::shared_ptr<FakePackageID> id(repo->add_version(p.category, p.package,
+                                    slot == "2" ? "2." + stringify(v) : stringify(v)));
+                        if (0 == i % 4)
+                            id->set_slot(SlotName(slot), SlotName(slot + "." + stringify(v)));
+                        else
+                            id->set_slot(SlotName(slot));
+                        id->choices_key()->add("", "enabled");
+                        id->choices_key()->add("", "disabled");
+                        id->build_dependencies_key()->set_from_string(build_deps);
+                        id->run_dependencies_key()->set_from_string(run_deps);
+                        packages.back().ids.push_back(id);
+                        ++n_ids;
+                    }
+
+                if (0 == i % 3)
+                {
+                    std::shared_ptr<FakePackageID> id(inst_repo->add_version(p.category, p.package, "1"));
+                    id->set_slot(SlotName(p.slots[0]));
+                    id->choices_key()->add("", "enabled");
+                    id->choices_key()->add("", "disabled");
+                }
+            }
+
+            /* cycles, via post dependencies upon a later package */
+            for (int i(0), i_end(packages.size()) ; i < i_end - 50 ; ++i)
+                if (0 == random() % 15)
+                {
+                    int j(i + 1 + random() % 50);
+                    for (const auto & id : packages[i].ids)
+                        id->post_dependencies_key()->set_from_string(name(j));
+                }
+        }
+    };
+
+    void run(const int size)
+    {
+        SyntheticResolverData data;
+        double generate_ms(time_ms([&] () { data.generate(size); }));
+
+        std::shared_ptr<ResolverProfile> profile(std::make_shared<ResolverProfile>());
+        Resolver resolver(&data.env, data.get_resolver_functions());
+        resolver.set_profile(profile);
+
+        /* the newest two percent of the packages, which between them
+         * drag in most of the rest */
+        int n_targets(0);
+        for (int i(data.packages.size() - data.packages.size() / 50), i_end(data.packages.size()) ; i < i_end ; ++i, ++n_targets)
+            resolver.add_target(PackageOrBlockDepSpec(parse_user_package_dep_spec(data.name(i), &data.env, { })), "");
+
+        int restarts(0);
+        double restart_ms(0);
+        double resolve_ms(time_ms([&] () {
+                    while (true)
+                    {
+                        try
+                        {
+                            resolver.resolve();
+                            break;
+                        }
+                        catch (const SuggestRestart & e)
+                        {
+                            ++restarts;
+                            restart_ms += time_ms([&] () {
+                                    data.get_initial_constraints_for_helper.add_suggested_restart(e);
+                                    resolver.restart(e);
+                                    });
+                        }
+                    }
+                    }));
+
+        const std::shared_ptr<const Resolved> resolved(resolver.resolved());
+        int changes(std::distance(resolved->taken_change_or_remove_decisions()->begin(),
+                    resolved->taken_change_or_remove_decisions()->end()));
+        int errors(std::distance(resolved->taken_unable_to_make_decisions()->begin(),
+                    resolved->taken_unable_to_make_decisions()->end()));
+
+        std::cout << "ids:             " << data.n_ids << " (" << data.packages.size() << " packages, "
+            << n_targets << " targets)" << std::endl;
+        std::cout << "generate:        " << generate_ms << " ms" << std::endl;
+        std::cout << "resolve:         " << resolve_ms << " ms (" << changes << " changes, " << errors << " errors, "
+            << restarts << " restarts)" << std::endl;
+        std::cout << "restart:         " << restart_ms << " ms" << std::endl;
+
+        auto timers(profile->timers());
+        for (const auto & t : *timers)
+            std::cout << "    " << std::left << std::setw(40) << t.name() << std::right << std::setw(10)
+                << (t.nanoseconds() / 1000000) << " ms" << std::setw(10) << t.calls() << " calls" << std::endl;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    std::vector<int> sizes;
+    for (int i(1) ; i < argc ; ++i)
+        sizes.push_back(std::atoi(argv[i]));
+
+    if (sizes.empty())
+        sizes = { 2000, 5000, 10000 };
+
+    for (int size : sizes)
+        run(size);
+
+    return EXIT_SUCCESS;
+}
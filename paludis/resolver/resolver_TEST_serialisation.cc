@@ -46,6 +46,7 @@
 #include <functional>
 #include <algorithm>
 #include <map>
+#include <sstream>
 
 using namespace paludis;
 using namespace paludis::resolver;
@@ -66,6 +67,28 @@ namespace
         {
             data.reset();
         }
+
+        void check_serialisation_resolved(const std::shared_ptr<const Resolved> & resolved)
+        {
+            check_resolved(resolved,
+                    n::taken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                        .change(QualifiedPackageName("serialisation/dep"))
+                        .change(QualifiedPackageName("serialisation/target"))
+                        .finished()),
+                    n::taken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                        .unable(QualifiedPackageName("serialisation/error"))
+                        .finished()),
+                    n::taken_unconfirmed_decisions() = make_shared_copy(DecisionChecks()
+                        .finished()),
+                    n::taken_unorderable_decisions() = make_shared_copy(DecisionChecks()
+                        .finished()),
+                    n::untaken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                        .change(QualifiedPackageName("serialisation/suggestion"))
+                        .finished()),
+                    n::untaken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                        .finished())
+                    );
+        }
     };
 }
 
@@ -80,27 +103,36 @@ TEST_F(ResolverSerialisationTestCase, Serialisation)
         str.nothing_more_to_write();
 
         Deserialiser deser(&data->env, str);
+        EXPECT_EQ(sf_text, deser.format());
+        Deserialisation desern("ResolverLists", deser);
+        resolved = std::make_shared<Resolved>(Resolved::deserialise(desern));
+    }
+
+    check_serialisation_resolved(resolved);
+}
+
+TEST_F(ResolverSerialisationTestCase, BinarySerialisation)
+{
+    std::shared_ptr<const Resolved> resolved;
+    {
+        std::shared_ptr<const Resolved> orig_resolved(data->get_resolved("serialisation/target"));
+
+        std::stringstream text_str;
+        Serialiser text_ser(text_str);
+        orig_resolved->serialise(text_ser);
+
+        std::stringstream binary_str;
+        Serialiser binary_ser(binary_str, sf_binary);
+        orig_resolved->serialise(binary_ser);
+
+        EXPECT_LT(binary_str.str().length(), text_str.str().length());
+
+        Deserialiser deser(&data->env, binary_str);
+        EXPECT_EQ(sf_binary, deser.format());
         Deserialisation desern("ResolverLists", deser);
         resolved = std::make_shared<Resolved>(Resolved::deserialise(desern));
     }
 
-    this->check_resolved(resolved,
-            n::taken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
-                .change(QualifiedPackageName("serialisation/dep"))
-                .change(QualifiedPackageName("serialisation/target"))
-                .finished()),
-            n::taken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
-                .unable(QualifiedPackageName("serialisation/error"))
-                .finished()),
-            n::taken_unconfirmed_decisions() = make_shared_copy(DecisionChecks()
-                .finished()),
-            n::taken_unorderable_decisions() = make_shared_copy(DecisionChecks()
-                .finished()),
-            n::untaken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
-                .change(QualifiedPackageName("serialisation/suggestion"))
-                .finished()),
-            n::untaken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
-                .finished())
-            );
+    check_serialisation_resolved(resolved);
 }
 
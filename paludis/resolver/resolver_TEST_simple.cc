@@ -24,6 +24,8 @@
 #include <paludis/resolver/constraint.hh>
 #include <paludis/resolver/resolvent.hh>
 #include <paludis/resolver/suggest_restart.hh>
+#include <paludis/resolver/resolver_profile.hh>
+#include <paludis/resolver/query_cache.hh>
 
 #include <paludis/environments/test/test_environment.hh>
 
@@ -159,3 +161,119 @@ TEST_F(ResolverSimpleTestCase, PostDeps)
             );
 }
 
+namespace
+{
+    struct ResolverSimpleRestartTestCase :
+        ResolverSimpleTestCase,
+        testing::WithParamInterface<unsigned>
+    {
+    };
+}
+
+TEST_P(ResolverSimpleRestartTestCase, Restart)
+{
+    data->candidate_evaluation_jobs = GetParam();
+    std::shared_ptr<const Resolved> resolved(data->get_resolved("restart/target"));
+
+    this->check_resolved(resolved,
+            n::taken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                .change(QualifiedPackageName("restart/c-dep"))
+                .change(QualifiedPackageName("restart/a-dep"))
+                .change(QualifiedPackageName("restart/d-dep"))
+                .change(QualifiedPackageName("restart/b-dep"))
+                .change(QualifiedPackageName("restart/unrelated"))
+                .change(QualifiedPackageName("restart/target"))
+                .finished()),
+            n::taken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::taken_unconfirmed_decisions() = make_shared_copy(DecisionChecks()
+                .change(QualifiedPackageName("restart/c-dep"))
+                .finished()),
+            n::taken_unorderable_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::untaken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::untaken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                .finished())
+            );
+
+    ASSERT_EQ(1u, data->restarts.size());
+    EXPECT_EQ(4, data->restarts.front().kept_resolutions());
+    EXPECT_EQ(2, data->restarts.front().redecided_resolutions());
+    EXPECT_EQ(0, data->restarts.front().discarded_resolutions());
+}
+
+INSTANTIATE_TEST_CASE_P(CandidateEvaluationJobs, ResolverSimpleRestartTestCase, testing::Values(1u, 4u));
+
+TEST_F(ResolverSimpleTestCase, Profile)
+{
+    data->profile = std::make_shared<ResolverProfile>();
+    std::shared_ptr<const Resolved> resolved(data->get_resolved("restart/target"));
+
+    auto profile_timers(data->profile->timers());
+    auto profile_counters(data->profile->counters());
+
+    std::map<std::string, unsigned long> timers, counters;
+    for (const auto & t : *profile_timers)
+        timers.insert(std::make_pair(t.name(), t.calls()));
+    for (const auto & c : *profile_counters)
+        counters.insert(std::make_pair(c.name(), c.value()));
+
+    EXPECT_EQ(1u, counters["restarts"]);
+    EXPECT_EQ(4u, counters["resolutions kept by restarts"]);
+    EXPECT_EQ(2u, counters["resolutions redecided by restarts"]);
+    EXPECT_EQ(0u, counters["resolutions discarded by restarts"]);
+    EXPECT_EQ(1u, timers["restarting"]);
+    EXPECT_EQ(2u, timers["resolving"]);
+    EXPECT_EQ(1u, timers["ordering"]);
+    EXPECT_LE(2u, timers["deciding"]);
+    EXPECT_LT(0u, timers["selections"]);
+    EXPECT_LT(0u, timers["matches"]);
+}
+
+TEST_F(ResolverSimpleTestCase, SharedQueryCache)
+{
+    data->query_cache = std::make_shared<QueryCache>(&data->env);
+    std::shared_ptr<const Resolved> first(data->get_resolved("restart/target"));
+
+    /* a second resolver sharing the cache shouldn't need to make any
+     * selections. it does still match against the restart's preset
+     * constraints, which are new specs each time. */
+    data->profile = std::make_shared<ResolverProfile>();
+    std::shared_ptr<const Resolved> resolved(data->get_resolved("restart/target"));
+
+    auto profile_timers(data->profile->timers());
+    auto profile_counters(data->profile->counters());
+
+    std::map<std::string, unsigned long> timers, counters;
+    for (const auto & t : *profile_timers)
+        timers.insert(std::make_pair(t.name(), t.calls()));
+    for (const auto & c : *profile_counters)
+        counters.insert(std::make_pair(c.name(), c.value()));
+
+    EXPECT_EQ(0u, timers["selections"]);
+    EXPECT_LT(0u, counters["selection cache hits"]);
+    EXPECT_LT(0u, counters["match cache hits"]);
+
+    this->check_resolved(resolved,
+            n::taken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                .change(QualifiedPackageName("restart/c-dep"))
+                .change(QualifiedPackageName("restart/a-dep"))
+                .change(QualifiedPackageName("restart/d-dep"))
+                .change(QualifiedPackageName("restart/b-dep"))
+                .change(QualifiedPackageName("restart/unrelated"))
+                .change(QualifiedPackageName("restart/target"))
+                .finished()),
+            n::taken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::taken_unconfirmed_decisions() = make_shared_copy(DecisionChecks()
+                .change(QualifiedPackageName("restart/c-dep"))
+                .finished()),
+            n::taken_unorderable_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::untaken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::untaken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                .finished())
+            );
+}
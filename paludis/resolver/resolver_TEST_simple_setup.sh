@@ -130,5 +130,62 @@ SLOT="0"
 DEPENDENCIES=""
 END
 
+# restart
+echo 'restart' >> metadata/categories.conf
+
+mkdir -p 'packages/restart/target'
+cat <<END > packages/restart/target/target-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="restart/a-dep restart/b-dep restart/unrelated"
+END
+
+mkdir -p 'packages/restart/a-dep'
+cat <<END > packages/restart/a-dep/a-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="restart/c-dep"
+END
+
+mkdir -p 'packages/restart/b-dep'
+cat <<END > packages/restart/b-dep/b-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="restart/d-dep"
+END
+
+mkdir -p 'packages/restart/d-dep'
+cat <<END > packages/restart/d-dep/d-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="restart/c-dep[<2]"
+END
+
+mkdir -p 'packages/restart/c-dep'
+cat <<END > packages/restart/c-dep/c-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+cat <<END > packages/restart/c-dep/c-dep-2.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+mkdir -p 'packages/restart/unrelated'
+cat <<END > packages/restart/unrelated/unrelated-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
 cd ..
 
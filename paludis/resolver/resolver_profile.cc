@@ -0,0 +1,128 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/resolver/resolver_profile.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/sequence-impl.hh>
+#include <paludis/util/wrapped_forward_iterator-impl.hh>
+#include <paludis/util/make_named_values.hh>
+#include <list>
+#include <map>
+#include <mutex>
+
+using namespace paludis;
+using namespace paludis::resolver;
+
+namespace paludis
+{
+    template <>
+    struct Imp<ResolverProfile>
+    {
+        mutable std::mutex mutex;
+
+        std::list<ResolverProfileTimer> timers;
+        std::map<std::string, std::list<ResolverProfileTimer>::iterator> timers_by_name;
+
+        std::list<ResolverProfileCounter> counters;
+        std::map<std::string, std::list<ResolverProfileCounter>::iterator> counters_by_name;
+    };
+}
+
+ResolverProfile::ResolverProfile() :
+    _imp()
+{
+}
+
+ResolverProfile::~ResolverProfile() = default;
+
+void
+ResolverProfile::add_time(const std::string & name, const std::chrono::steady_clock::duration d)
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    auto t(_imp->timers_by_name.find(name));
+    if (t == _imp->timers_by_name.end())
+        t = _imp->timers_by_name.insert(std::make_pair(name, _imp->timers.insert(_imp->timers.end(),
+                        make_named_values<ResolverProfileTimer>(
+                            n::calls() = 0,
+                            n::name() = name,
+                            n::nanoseconds() = 0)))).first;
+
+    ++t->second->calls();
+    t->second->nanoseconds() += std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+void
+ResolverProfile::increment(const std::string & name, const unsigned long n)
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    auto c(_imp->counters_by_name.find(name));
+    if (c == _imp->counters_by_name.end())
+        c = _imp->counters_by_name.insert(std::make_pair(name, _imp->counters.insert(_imp->counters.end(),
+                        make_named_values<ResolverProfileCounter>(
+                            n::name() = name,
+                            n::value() = 0)))).first;
+
+    c->second->value() += n;
+}
+
+const std::shared_ptr<const Sequence<ResolverProfileTimer> >
+ResolverProfile::timers() const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    auto result(std::make_shared<Sequence<ResolverProfileTimer> >());
+    for (const auto & t : _imp->timers)
+        result->push_back(t);
+    return result;
+}
+
+const std::shared_ptr<const Sequence<ResolverProfileCounter> >
+ResolverProfile::counters() const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    auto result(std::make_shared<Sequence<ResolverProfileCounter> >());
+    for (const auto & c : _imp->counters)
+        result->push_back(c);
+    return result;
+}
+
+ScopedResolverProfileTimer::ScopedResolverProfileTimer(const std::shared_ptr<ResolverProfile> & p, const char * const n) :
+    _profile(p.get()),
+    _name(n),
+    _start(p ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+{
+}
+
+ScopedResolverProfileTimer::~ScopedResolverProfileTimer()
+{
+    if (_profile)
+        _profile->add_time(_name, std::chrono::steady_clock::now() - _start);
+}
+
+namespace paludis
+{
+    template class Pimp<ResolverProfile>;
+    template class Sequence<ResolverProfileTimer>;
+    template class WrappedForwardIterator<Sequence<ResolverProfileTimer>::ConstIteratorTag, const ResolverProfileTimer>;
+    template class Sequence<ResolverProfileCounter>;
+    template class WrappedForwardIterator<Sequence<ResolverProfileCounter>::ConstIteratorTag, const ResolverProfileCounter>;
+}
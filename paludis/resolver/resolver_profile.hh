@@ -0,0 +1,120 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_RESOLVER_RESOLVER_PROFILE_HH
+#define PALUDIS_GUARD_PALUDIS_RESOLVER_RESOLVER_PROFILE_HH 1
+
+#include <paludis/resolver/resolver_profile-fwd.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/util/named_value.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace paludis
+{
+    namespace n
+    {
+        typedef Name<struct name_calls> calls;
+        typedef Name<struct name_name> name;
+        typedef Name<struct name_nanoseconds> nanoseconds;
+        typedef Name<struct name_value> value;
+    }
+
+    namespace resolver
+    {
+        /**
+         * How long was spent in one part of the resolver.
+         *
+         * Timers can nest, so times are inclusive and do not add up to the
+         * total.
+         */
+        struct ResolverProfileTimer
+        {
+            NamedValue<n::calls, unsigned long> calls;
+            NamedValue<n::name, std::string> name;
+            NamedValue<n::nanoseconds, unsigned long long> nanoseconds;
+        };
+
+        struct ResolverProfileCounter
+        {
+            NamedValue<n::name, std::string> name;
+            NamedValue<n::value, unsigned long> value;
+        };
+
+        /**
+         * Collects timings and counters from a Resolver, if one is given to
+         * Resolver::set_profile. May be shared between several Resolver
+         * instances, for example across restarts.
+         */
+        class PALUDIS_VISIBLE ResolverProfile
+        {
+            private:
+                Pimp<ResolverProfile> _imp;
+
+            public:
+                ResolverProfile();
+                ~ResolverProfile();
+
+                ResolverProfile(const ResolverProfile &) = delete;
+                ResolverProfile & operator= (const ResolverProfile &) = delete;
+
+                void add_time(const std::string &, const std::chrono::steady_clock::duration);
+                void increment(const std::string &, const unsigned long n = 1);
+
+                ///\name Results, in the order they were first seen
+                ///\{
+
+                const std::shared_ptr<const Sequence<ResolverProfileTimer> > timers() const PALUDIS_ATTRIBUTE((warn_unused_result));
+                const std::shared_ptr<const Sequence<ResolverProfileCounter> > counters() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                ///\}
+        };
+
+        /**
+         * Adds the time between construction and destruction to a
+         * ResolverProfile. Does nothing if the profile is null, so it can be
+         * left in place when profiling is not wanted.
+         */
+        class PALUDIS_VISIBLE ScopedResolverProfileTimer
+        {
+            private:
+                ResolverProfile * const _profile;
+                const char * const _name;
+                const std::chrono::steady_clock::time_point _start;
+
+            public:
+                ScopedResolverProfileTimer(const std::shared_ptr<ResolverProfile> &, const char * const);
+                ~ScopedResolverProfileTimer();
+
+                ScopedResolverProfileTimer(const ScopedResolverProfileTimer &) = delete;
+                ScopedResolverProfileTimer & operator= (const ScopedResolverProfileTimer &) = delete;
+        };
+    }
+
+    extern template class PALUDIS_VISIBLE Sequence<resolver::ResolverProfileTimer>;
+    extern template class PALUDIS_VISIBLE WrappedForwardIterator<Sequence<resolver::ResolverProfileTimer>::ConstIteratorTag, const resolver::ResolverProfileTimer>;
+    extern template class PALUDIS_VISIBLE Sequence<resolver::ResolverProfileCounter>;
+    extern template class PALUDIS_VISIBLE WrappedForwardIterator<Sequence<resolver::ResolverProfileCounter>::ConstIteratorTag, const resolver::ResolverProfileCounter>;
+}
+
+#endif
@@ -75,31 +75,7 @@ paludis::resolver::resolver_test::from_keys(const std::shared_ptr<const Map<std:
 }
 
 ResolverTestData::ResolverTestData(const std::string & t, const std::string & e, const std::string & l) :
-    allow_choice_changes_helper(&env),
-    allowed_to_remove_helper(&env),
-    allowed_to_restart_helper(&env),
-    always_via_binary_helper(&env),
-    can_use_helper(&env),
-    confirm_helper(&env),
-    find_replacing_helper(&env),
-    find_repository_for_helper(&env),
-    get_constraints_for_dependent_helper(&env),
-    get_constraints_for_purge_helper(&env),
-    get_constraints_for_via_binary_helper(&env),
-    get_destination_types_for_blocker_helper(&env),
-    get_destination_types_for_error_helper(&env),
-    get_initial_constraints_for_helper(&env),
-    get_use_existing_nothing_helper(&env),
-    interest_in_spec_helper(&env),
-    make_destination_filtered_generator_helper(&env),
-    make_origin_filtered_generator_helper(&env),
-    make_unmaskable_filter_helper(&env),
-    order_early_helper(&env),
-    prefer_or_avoid_helper(&env),
-    promote_binaries_helper(&env),
-    remove_hidden_helper(&env),
-    remove_if_dependent_helper(&env),
-    get_resolvents_for_helper(&env, std::cref(remove_hidden_helper))
+    candidate_evaluation_jobs(1)
 {
     std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
     keys->insert("format", "e");
@@ -133,11 +109,6 @@ ResolverTestData::ResolverTestData(const std::string & t, const std::string & e,
                     n::supports_uninstall() = true
                     ));
     env.add_repository(1, fake_inst_repo);
-
-    interest_in_spec_helper.set_follow_installed_dependencies(true);
-    interest_in_spec_helper.set_follow_installed_build_dependencies(true);
-
-    make_unmaskable_filter_helper.set_override_masks(false);
 }
 
 ResolverWithBinaryTestData::ResolverWithBinaryTestData(const std::string & t, const std::string & e, const std::string & l, bool u) :
@@ -162,53 +133,26 @@ ResolverWithBinaryTestData::ResolverWithBinaryTestData(const std::string & t, co
     env.add_repository(u ? 0 : 2, bin_repo);
 }
 
-ResolverFunctions
-ResolverTestData::get_resolver_functions()
-{
-    return make_named_values<ResolverFunctions>(
-            n::allow_choice_changes_fn() = std::cref(allow_choice_changes_helper),
-            n::allowed_to_remove_fn() = std::cref(allowed_to_remove_helper),
-            n::allowed_to_restart_fn() = std::cref(allowed_to_restart_helper),
-            n::always_via_binary_fn() = std::cref(always_via_binary_helper),
-            n::can_use_fn() = std::cref(can_use_helper),
-            n::confirm_fn() = std::cref(confirm_helper),
-            n::find_replacing_fn() = std::cref(find_replacing_helper),
-            n::find_repository_for_fn() = std::cref(find_repository_for_helper),
-            n::get_constraints_for_dependent_fn() = std::cref(get_constraints_for_dependent_helper),
-            n::get_constraints_for_purge_fn() = std::cref(get_constraints_for_purge_helper),
-            n::get_constraints_for_via_binary_fn() = std::cref(get_constraints_for_via_binary_helper),
-            n::get_destination_types_for_blocker_fn() = std::cref(get_destination_types_for_blocker_helper),
-            n::get_destination_types_for_error_fn() = std::cref(get_destination_types_for_error_helper),
-            n::get_initial_constraints_for_fn() = std::cref(get_initial_constraints_for_helper),
-            n::get_resolvents_for_fn() = std::cref(get_resolvents_for_helper),
-            n::get_use_existing_nothing_fn() = std::cref(get_use_existing_nothing_helper),
-            n::interest_in_spec_fn() = std::cref(interest_in_spec_helper),
-            n::make_destination_filtered_generator_fn() = std::cref(make_destination_filtered_generator_helper),
-            n::make_origin_filtered_generator_fn() = std::cref(make_origin_filtered_generator_helper),
-            n::make_unmaskable_filter_fn() = std::cref(make_unmaskable_filter_helper),
-            n::order_early_fn() = std::cref(order_early_helper),
-            n::prefer_or_avoid_fn() = std::cref(prefer_or_avoid_helper),
-            n::promote_binaries_fn() = std::cref(promote_binaries_helper),
-            n::remove_hidden_fn() = std::cref(remove_hidden_helper),
-            n::remove_if_dependent_fn() = std::cref(remove_if_dependent_helper)
-            );
-}
-
 const std::shared_ptr<const Resolved>
 ResolverTestData::get_resolved(const PackageOrBlockDepSpec & target)
 {
+    Resolver resolver(&env, get_resolver_functions());
+    resolver.set_candidate_evaluation_jobs(candidate_evaluation_jobs);
+    resolver.set_profile(profile);
+    resolver.set_query_cache(query_cache);
+    resolver.add_target(target, "");
+
     while (true)
     {
         try
         {
-            Resolver resolver(&env, get_resolver_functions());
-            resolver.add_target(target, "");
             resolver.resolve();
             return resolver.resolved();
         }
         catch (const SuggestRestart & e)
         {
             get_initial_constraints_for_helper.add_suggested_restart(e);
+            restarts.push_back(resolver.restart(e));
         }
     }
 }
@@ -35,37 +35,14 @@
 #include <paludis/resolver/resolved-fwd.hh>
 #include <paludis/resolver/change_by_resolvent-fwd.hh>
 
-#include <paludis/resolver/allow_choice_changes_helper.hh>
-#include <paludis/resolver/allowed_to_remove_helper.hh>
-#include <paludis/resolver/allowed_to_restart_helper.hh>
-#include <paludis/resolver/always_via_binary_helper.hh>
-#include <paludis/resolver/can_use_helper.hh>
-#include <paludis/resolver/confirm_helper.hh>
-#include <paludis/resolver/find_replacing_helper.hh>
-#include <paludis/resolver/find_repository_for_helper.hh>
-#include <paludis/resolver/get_constraints_for_dependent_helper.hh>
-#include <paludis/resolver/get_constraints_for_purge_helper.hh>
-#include <paludis/resolver/get_constraints_for_via_binary_helper.hh>
-#include <paludis/resolver/get_destination_types_for_blocker_helper.hh>
-#include <paludis/resolver/get_destination_types_for_error_helper.hh>
-#include <paludis/resolver/get_initial_constraints_for_helper.hh>
-#include <paludis/resolver/get_resolvents_for_helper.hh>
-#include <paludis/resolver/get_use_existing_nothing_helper.hh>
-#include <paludis/resolver/interest_in_spec_helper.hh>
-#include <paludis/resolver/make_destination_filtered_generator_helper.hh>
-#include <paludis/resolver/make_origin_filtered_generator_helper.hh>
-#include <paludis/resolver/make_unmaskable_filter_helper.hh>
-#include <paludis/resolver/order_early_helper.hh>
-#include <paludis/resolver/remove_hidden_helper.hh>
-#include <paludis/resolver/remove_if_dependent_helper.hh>
-#include <paludis/resolver/prefer_or_avoid_helper.hh>
-#include <paludis/resolver/promote_binaries_helper.hh>
+#include <paludis/resolver/resolver_test_helpers.hh>
+#include <paludis/resolver/resolver_profile-fwd.hh>
+#include <paludis/resolver/query_cache-fwd.hh>
+#include <paludis/resolver/suggest_restart.hh>
 
 #include <paludis/repositories/fake/fake_installed_repository.hh>
 #include <paludis/repositories/fake/fake_package_id.hh>
 
-#include <paludis/environments/test/test_environment.hh>
-
 #include <paludis/util/map-fwd.hh>
 
 #include <paludis/dep_spec-fwd.hh>
@@ -88,42 +65,19 @@ namespace paludis
             std::string from_keys(const std::shared_ptr<const Map<std::string, std::string> > & m,
                     const std::string & k);
 
-            struct ResolverTestData
+            struct ResolverTestData :
+                ResolverTestHelpers
             {
-                TestEnvironment env;
                 std::shared_ptr<Repository> repo, inst_repo;
                 std::shared_ptr<FakeInstalledRepository> fake_inst_repo;
 
-                AllowChoiceChangesHelper allow_choice_changes_helper;
-                AllowedToRemoveHelper allowed_to_remove_helper;
-                AllowedToRestartHelper allowed_to_restart_helper;
-                AlwaysViaBinaryHelper always_via_binary_helper;
-                CanUseHelper can_use_helper;
-                ConfirmHelper confirm_helper;
-                FindReplacingHelper find_replacing_helper;
-                FindRepositoryForHelper find_repository_for_helper;
-                GetConstraintsForDependentHelper get_constraints_for_dependent_helper;
-                GetConstraintsForPurgeHelper get_constraints_for_purge_helper;
-                GetConstraintsForViaBinaryHelper get_constraints_for_via_binary_helper;
-                GetDestinationTypesForBlockerHelper get_destination_types_for_blocker_helper;
-                GetDestinationTypesForErrorHelper get_destination_types_for_error_helper;
-                GetInitialConstraintsForHelper get_initial_constraints_for_helper;
-                GetUseExistingNothingHelper get_use_existing_nothing_helper;
-                InterestInSpecHelper interest_in_spec_helper;
-                MakeDestinationFilteredGeneratorHelper make_destination_filtered_generator_helper;
-                MakeOriginFilteredGeneratorHelper make_origin_filtered_generator_helper;
-                MakeUnmaskableFilterHelper make_unmaskable_filter_helper;
-                OrderEarlyHelper order_early_helper;
-                PreferOrAvoidHelper prefer_or_avoid_helper;
-                PromoteBinariesHelper promote_binaries_helper;
-                RemoveHiddenHelper remove_hidden_helper;
-                RemoveIfDependentHelper remove_if_dependent_helper;
-                GetResolventsForHelper get_resolvents_for_helper;
+                unsigned candidate_evaluation_jobs;
+                std::shared_ptr<ResolverProfile> profile;
+                std::shared_ptr<QueryCache> query_cache;
+                std::list<RestartStatistics> restarts;
 
                 ResolverTestData(const std::string & group, const std::string & eapi, const std::string & layout);
 
-                ResolverFunctions get_resolver_functions();
-
                 const std::shared_ptr<const Resolved> get_resolved(const PackageOrBlockDepSpec & target);
 
                 const std::shared_ptr<const Resolved> get_resolved(const std::string & target);
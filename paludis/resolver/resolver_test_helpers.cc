@@ -0,0 +1,106 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/resolver/resolver_test_helpers.hh>
+#include <paludis/resolver/resolver_functions.hh>
+#include <paludis/resolver/resolvent.hh>
+#include <paludis/resolver/resolution.hh>
+#include <paludis/resolver/constraint.hh>
+#include <paludis/resolver/decision.hh>
+#include <paludis/resolver/reason.hh>
+#include <paludis/resolver/change_by_resolvent.hh>
+
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/sequence.hh>
+
+#include <paludis/filter.hh>
+#include <paludis/filtered_generator.hh>
+#include <paludis/generator.hh>
+#include <paludis/selection.hh>
+
+#include <functional>
+
+using namespace paludis;
+using namespace paludis::resolver;
+using namespace paludis::resolver::resolver_test;
+
+ResolverTestHelpers::ResolverTestHelpers() :
+    allow_choice_changes_helper(&env),
+    allowed_to_remove_helper(&env),
+    allowed_to_restart_helper(&env),
+    always_via_binary_helper(&env),
+    can_use_helper(&env),
+    confirm_helper(&env),
+    find_replacing_helper(&env),
+    find_repository_for_helper(&env),
+    get_constraints_for_dependent_helper(&env),
+    get_constraints_for_purge_helper(&env),
+    get_constraints_for_via_binary_helper(&env),
+    get_destination_types_for_blocker_helper(&env),
+    get_destination_types_for_error_helper(&env),
+    get_initial_constraints_for_helper(&env),
+    get_use_existing_nothing_helper(&env),
+    interest_in_spec_helper(&env),
+    make_destination_filtered_generator_helper(&env),
+    make_origin_filtered_generator_helper(&env),
+    make_unmaskable_filter_helper(&env),
+    order_early_helper(&env),
+    prefer_or_avoid_helper(&env),
+    promote_binaries_helper(&env),
+    remove_hidden_helper(&env),
+    remove_if_dependent_helper(&env),
+    get_resolvents_for_helper(&env, std::cref(remove_hidden_helper))
+{
+    interest_in_spec_helper.set_follow_installed_dependencies(true);
+    interest_in_spec_helper.set_follow_installed_build_dependencies(true);
+
+    make_unmaskable_filter_helper.set_override_masks(false);
+}
+
+ResolverFunctions
+ResolverTestHelpers::get_resolver_functions()
+{
+    return make_named_values<ResolverFunctions>(
+            n::allow_choice_changes_fn() = std::cref(allow_choice_changes_helper),
+            n::allowed_to_remove_fn() = std::cref(allowed_to_remove_helper),
+            n::allowed_to_restart_fn() = std::cref(allowed_to_restart_helper),
+            n::always_via_binary_fn() = std::cref(always_via_binary_helper),
+            n::can_use_fn() = std::cref(can_use_helper),
+            n::confirm_fn() = std::cref(confirm_helper),
+            n::find_replacing_fn() = std::cref(find_replacing_helper),
+            n::find_repository_for_fn() = std::cref(find_repository_for_helper),
+            n::get_constraints_for_dependent_fn() = std::cref(get_constraints_for_dependent_helper),
+            n::get_constraints_for_purge_fn() = std::cref(get_constraints_for_purge_helper),
+            n::get_constraints_for_via_binary_fn() = std::cref(get_constraints_for_via_binary_helper),
+            n::get_destination_types_for_blocker_fn() = std::cref(get_destination_types_for_blocker_helper),
+            n::get_destination_types_for_error_fn() = std::cref(get_destination_types_for_error_helper),
+            n::get_initial_constraints_for_fn() = std::cref(get_initial_constraints_for_helper),
+            n::get_resolvents_for_fn() = std::cref(get_resolvents_for_helper),
+            n::get_use_existing_nothing_fn() = std::cref(get_use_existing_nothing_helper),
+            n::interest_in_spec_fn() = std::cref(interest_in_spec_helper),
+            n::make_destination_filtered_generator_fn() = std::cref(make_destination_filtered_generator_helper),
+            n::make_origin_filtered_generator_fn() = std::cref(make_origin_filtered_generator_helper),
+            n::make_unmaskable_filter_fn() = std::cref(make_unmaskable_filter_helper),
+            n::order_early_fn() = std::cref(order_early_helper),
+            n::prefer_or_avoid_fn() = std::cref(prefer_or_avoid_helper),
+            n::promote_binaries_fn() = std::cref(promote_binaries_helper),
+            n::remove_hidden_fn() = std::cref(remove_hidden_helper),
+            n::remove_if_dependent_fn() = std::cref(remove_if_dependent_helper)
+            );
+}
@@ -0,0 +1,101 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_RESOLVER_RESOLVER_TEST_HELPERS_HH
+#define PALUDIS_GUARD_PALUDIS_RESOLVER_RESOLVER_TEST_HELPERS_HH 1
+
+#include <paludis/resolver/resolver_functions-fwd.hh>
+
+#include <paludis/resolver/allow_choice_changes_helper.hh>
+#include <paludis/resolver/allowed_to_remove_helper.hh>
+#include <paludis/resolver/allowed_to_restart_helper.hh>
+#include <paludis/resolver/always_via_binary_helper.hh>
+#include <paludis/resolver/can_use_helper.hh>
+#include <paludis/resolver/confirm_helper.hh>
+#include <paludis/resolver/find_replacing_helper.hh>
+#include <paludis/resolver/find_repository_for_helper.hh>
+#include <paludis/resolver/get_constraints_for_dependent_helper.hh>
+#include <paludis/resolver/get_constraints_for_purge_helper.hh>
+#include <paludis/resolver/get_constraints_for_via_binary_helper.hh>
+#include <paludis/resolver/get_destination_types_for_blocker_helper.hh>
+#include <paludis/resolver/get_destination_types_for_error_helper.hh>
+#include <paludis/resolver/get_initial_constraints_for_helper.hh>
+#include <paludis/resolver/get_resolvents_for_helper.hh>
+#include <paludis/resolver/get_use_existing_nothing_helper.hh>
+#include <paludis/resolver/interest_in_spec_helper.hh>
+#include <paludis/resolver/make_destination_filtered_generator_helper.hh>
+#include <paludis/resolver/make_origin_filtered_generator_helper.hh>
+#include <paludis/resolver/make_unmaskable_filter_helper.hh>
+#include <paludis/resolver/order_early_helper.hh>
+#include <paludis/resolver/remove_hidden_helper.hh>
+#include <paludis/resolver/remove_if_dependent_helper.hh>
+#include <paludis/resolver/prefer_or_avoid_helper.hh>
+#include <paludis/resolver/promote_binaries_helper.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+namespace paludis
+{
+    namespace resolver
+    {
+        namespace resolver_test
+        {
+            /**
+             * A TestEnvironment, with one of each resolver helper set up
+             * against it, for the resolver tests and benchmark.
+             */
+            struct ResolverTestHelpers
+            {
+                TestEnvironment env;
+
+                AllowChoiceChangesHelper allow_choice_changes_helper;
+                AllowedToRemoveHelper allowed_to_remove_helper;
+                AllowedToRestartHelper allowed_to_restart_helper;
+                AlwaysViaBinaryHelper always_via_binary_helper;
+                CanUseHelper can_use_helper;
+                ConfirmHelper confirm_helper;
+                FindReplacingHelper find_replacing_helper;
+                FindRepositoryForHelper find_repository_for_helper;
+                GetConstraintsForDependentHelper get_constraints_for_dependent_helper;
+                GetConstraintsForPurgeHelper get_constraints_for_purge_helper;
+                GetConstraintsForViaBinaryHelper get_constraints_for_via_binary_helper;
+                GetDestinationTypesForBlockerHelper get_destination_types_for_blocker_helper;
+                GetDestinationTypesForErrorHelper get_destination_types_for_error_helper;
+                GetInitialConstraintsForHelper get_initial_constraints_for_helper;
+                GetUseExistingNothingHelper get_use_existing_nothing_helper;
+                InterestInSpecHelper interest_in_spec_helper;
+                MakeDestinationFilteredGeneratorHelper make_destination_filtered_generator_helper;
+                MakeOriginFilteredGeneratorHelper make_origin_filtered_generator_helper;
+                MakeUnmaskableFilterHelper make_unmaskable_filter_helper;
+                OrderEarlyHelper order_early_helper;
+                PreferOrAvoidHelper prefer_or_avoid_helper;
+                PromoteBinariesHelper promote_binaries_helper;
+                RemoveHiddenHelper remove_hidden_helper;
+                RemoveIfDependentHelper remove_if_dependent_helper;
+                GetResolventsForHelper get_resolvents_for_helper;
+
+                ResolverTestHelpers();
+
+                ResolverFunctions get_resolver_functions();
+            };
+        }
+    }
+}
+
+#endif
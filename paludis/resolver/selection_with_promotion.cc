@@ -74,7 +74,7 @@ namespace
 
             std::string as_string() const override
             {
-                return "all versions sorted from " + stringify(_fg);
+                return "all versions sorted with promotion from " + stringify(_fg);
             }
     };
 }
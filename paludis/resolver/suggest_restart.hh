@@ -27,9 +27,17 @@
 #include <paludis/util/pimp.hh>
 #include <paludis/util/exception.hh>
 #include <paludis/util/attributes.hh>
+#include <paludis/util/named_value.hh>
 
 namespace paludis
 {
+    namespace n
+    {
+        typedef Name<struct name_discarded_resolutions> discarded_resolutions;
+        typedef Name<struct name_kept_resolutions> kept_resolutions;
+        typedef Name<struct name_redecided_resolutions> redecided_resolutions;
+    }
+
     namespace resolver
     {
         class PALUDIS_VISIBLE SuggestRestart :
@@ -54,6 +62,23 @@ namespace paludis
                 const std::shared_ptr<const Decision> new_decision() const PALUDIS_ATTRIBUTE((warn_unused_result));
                 const std::shared_ptr<const Constraint> suggested_preset() const PALUDIS_ATTRIBUTE((warn_unused_result));
         };
+
+        /**
+         * How much of the previous attempt was reused when restarting.
+         *
+         * \see Resolver::restart
+         */
+        struct RestartStatistics
+        {
+            /// Resolutions that were thrown away, because nothing unaffected needs them
+            NamedValue<n::discarded_resolutions, int> discarded_resolutions;
+
+            /// Resolutions whose decisions were kept
+            NamedValue<n::kept_resolutions, int> kept_resolutions;
+
+            /// Resolutions that were kept, but that need deciding again
+            NamedValue<n::redecided_resolutions, int> redecided_resolutions;
+        };
     }
 
     extern template class Pimp<resolver::SuggestRestart>;
@@ -24,6 +24,24 @@ namespace paludis
 {
     class Serialiser;
 
+    /**
+     * The format used by a Serialiser.
+     *
+     * The text format is human readable, and is what should be used for
+     * anything a user might look at. The binary format writes each string and
+     * each PackageID only once, and afterwards refers to it by index, which
+     * makes it much smaller and cheaper to read for large resolutions. A
+     * Deserialiser recognises either format automatically.
+     *
+     * \see Serialiser
+     */
+    enum SerialiserFormat
+    {
+        sf_text,
+        sf_binary,
+        last_sf
+    };
+
     class Deserialiser;
     class Deserialisation;
 }
@@ -33,9 +33,109 @@
 #include <paludis/elike_package_dep_spec.hh>
 #include <list>
 #include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 using namespace paludis;
 
+namespace
+{
+    /* a binary stream starts with a nul, which can never start a text stream */
+    const std::string binary_magic(std::string(1, '\0') + "paludis-binary-serialisation-1\n");
+
+    enum BinaryTag
+    {
+        bt_object = 'o',
+        bt_member = 'k',
+        bt_end_object = 'e',
+        bt_string = 's',
+        bt_null = 'n',
+        bt_package_id = 'i'
+    };
+
+    void write_number(std::ostream & s, std::size_t n)
+    {
+        do
+        {
+            unsigned char c(n & 0x7f);
+            n >>= 7;
+            if (n)
+                c |= 0x80;
+            s.put(static_cast<char>(c));
+        } while (n);
+    }
+
+    void binary_error(const std::string & s) PALUDIS_ATTRIBUTE((noreturn));
+
+    void binary_error(const std::string & s)
+    {
+        throw InternalError(PALUDIS_HERE, "can't parse binary serialisation: " + s);
+    }
+
+    std::size_t read_number(std::istream & s)
+    {
+        std::size_t result(0);
+        for (unsigned shift(0) ; ; shift += 7)
+        {
+            char c;
+            if (! s.get(c))
+                binary_error("unexpected end of stream");
+            if (shift >= sizeof(std::size_t) * 8)
+                binary_error("number too large");
+
+            result |= std::size_t(static_cast<unsigned char>(c) & 0x7f) << shift;
+            if (! (static_cast<unsigned char>(c) & 0x80))
+                return result;
+        }
+    }
+
+    char read_tag(std::istream & s)
+    {
+        char c;
+        if (! s.get(c))
+            binary_error("unexpected end of stream");
+        return c;
+    }
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<Serialiser>
+    {
+        std::ostream & stream;
+        const SerialiserFormat format;
+
+        /* for the binary format. a string or ID is written out in full the
+         * first time we see it, and as 1 + its index thereafter. IDs are
+         * keyed by address, which is fine since everything we serialise holds
+         * on to the IDs it refers to for at least as long as we do. */
+        std::unordered_map<std::string, std::size_t> strings;
+        std::unordered_map<const PackageID *, std::size_t> ids;
+
+        Imp(std::ostream & s, const SerialiserFormat f) :
+            stream(s),
+            format(f)
+        {
+        }
+
+        void write_string_ref(const std::string & t)
+        {
+            auto i(strings.find(t));
+            if (i != strings.end())
+                write_number(stream, i->second + 1);
+            else
+            {
+                write_number(stream, 0);
+                write_number(stream, t.length());
+                stream.write(t.data(), t.length());
+                strings.emplace(t, strings.size());
+            }
+        }
+    };
+}
+
 SerialiserObjectWriter::SerialiserObjectWriter(Serialiser & s) :
     _serialiser(s)
 {
@@ -43,58 +143,178 @@ SerialiserObjectWriter::SerialiserObjectWriter(Serialiser & s) :
 
 SerialiserObjectWriter::~SerialiserObjectWriter()
 {
-    _serialiser.raw_stream() << ");";
+    _serialiser.end_object();
 }
 
-Serialiser::Serialiser(std::ostream & s) :
-    _stream(s)
+Serialiser::Serialiser(std::ostream & s, const SerialiserFormat f) :
+    _imp(s, f)
 {
+    if (sf_binary == _imp->format)
+        _imp->stream << binary_magic;
 }
 
 Serialiser::~Serialiser() = default;
 
+SerialiserFormat
+Serialiser::format() const
+{
+    return _imp->format;
+}
+
 std::ostream &
 Serialiser::raw_stream()
 {
-    return _stream;
+    return _imp->stream;
 }
 
 SerialiserObjectWriter
 Serialiser::object(const std::string & c)
 {
-    raw_stream() << c << "(";
+    switch (_imp->format)
+    {
+        case sf_text:
+            raw_stream() << c << "(";
+            break;
+
+        case sf_binary:
+            raw_stream().put(bt_object);
+            _imp->write_string_ref(c);
+            break;
+
+        case last_sf:
+            break;
+    }
+
     return SerialiserObjectWriter(*this);
 }
 
+void
+Serialiser::begin_member(const std::string & item_name)
+{
+    switch (_imp->format)
+    {
+        case sf_text:
+            raw_stream() << item_name << "=";
+            break;
+
+        case sf_binary:
+            raw_stream().put(bt_member);
+            _imp->write_string_ref(item_name);
+            break;
+
+        case last_sf:
+            break;
+    }
+}
+
+void
+Serialiser::end_object()
+{
+    switch (_imp->format)
+    {
+        case sf_text:
+            raw_stream() << ");";
+            break;
+
+        case sf_binary:
+            raw_stream().put(bt_end_object);
+            break;
+
+        case last_sf:
+            break;
+    }
+}
+
+void
+Serialiser::write_string(const std::string & t)
+{
+    switch (_imp->format)
+    {
+        case sf_text:
+            raw_stream() << "\"";
+            escape_write(t);
+            raw_stream() << "\";";
+            break;
+
+        case sf_binary:
+            raw_stream().put(bt_string);
+            _imp->write_string_ref(t);
+            break;
+
+        case last_sf:
+            break;
+    }
+}
+
+void
+Serialiser::write_null()
+{
+    switch (_imp->format)
+    {
+        case sf_text:
+            raw_stream() << "null;";
+            break;
+
+        case sf_binary:
+            raw_stream().put(bt_null);
+            break;
+
+        case last_sf:
+            break;
+    }
+}
+
+void
+Serialiser::write_package_id(const PackageID & t)
+{
+    switch (_imp->format)
+    {
+        case sf_text:
+            write_string(stringify(t.uniquely_identifying_spec()));
+            break;
+
+        case sf_binary:
+            {
+                raw_stream().put(bt_package_id);
+                auto i(_imp->ids.find(&t));
+                if (i != _imp->ids.end())
+                    write_number(raw_stream(), i->second + 1);
+                else
+                {
+                    write_number(raw_stream(), 0);
+                    _imp->write_string_ref(stringify(t.uniquely_identifying_spec()));
+                    _imp->ids.emplace(&t, _imp->ids.size());
+                }
+            }
+            break;
+
+        case last_sf:
+            break;
+    }
+}
+
 void
 SerialiserObjectWriterHandler<false, false, bool>::write(Serialiser & s, const bool t)
 {
-    if (t)
-        s.raw_stream() << "\"true\";";
-    else
-        s.raw_stream() << "\"false\";";
+    s.write_string(t ? "true" : "false");
 }
 
 void
 SerialiserObjectWriterHandler<false, false, int>::write(Serialiser & s, const int i)
 {
-    s.raw_stream() << "\"" << i << "\";";
+    s.write_string(stringify(i));
 }
 
 void
 SerialiserObjectWriterHandler<false, false, std::string>::write(Serialiser & s, const std::string & t)
 {
-    s.raw_stream() << "\"";
-    s.escape_write(t);
-    s.raw_stream() << "\";";
+    s.write_string(t);
 }
 
 void
 SerialiserObjectWriterHandler<false, false, const PackageID>::write(Serialiser & s, const PackageID & t)
 {
-    s.raw_stream() << "\"";
-    s.escape_write(stringify(t.uniquely_identifying_spec()));
-    s.raw_stream() << "\";";
+    s.write_package_id(t);
 }
 
 void
@@ -122,12 +342,49 @@ namespace paludis
     {
         const Environment * const env;
         std::istream & stream;
+        SerialiserFormat format;
+
+        std::vector<std::string> strings;
+        std::vector<std::string> id_specs;
+        mutable std::unordered_map<std::string, std::shared_ptr<const PackageID> > ids;
 
         Imp(const Environment * const e, std::istream & s) :
             env(e),
-            stream(s)
+            stream(s),
+            format(sf_text)
         {
         }
+
+        const std::string & read_string_ref()
+        {
+            std::size_t n(read_number(stream));
+            if (0 != n)
+            {
+                if (n > strings.size())
+                    binary_error("bad string index " + stringify(n));
+                return strings[n - 1];
+            }
+
+            std::string t(read_number(stream), '\0');
+            if (! stream.read(&t[0], t.length()))
+                binary_error("unexpected end of stream");
+            strings.push_back(std::move(t));
+            return strings.back();
+        }
+
+        const std::string & read_id_ref()
+        {
+            std::size_t n(read_number(stream));
+            if (0 != n)
+            {
+                if (n > id_specs.size())
+                    binary_error("bad ID index " + stringify(n));
+                return id_specs[n - 1];
+            }
+
+            id_specs.push_back(read_string_ref());
+            return id_specs.back();
+        }
     };
 
     template <>
@@ -171,6 +428,13 @@ namespace paludis
 Deserialiser::Deserialiser(const Environment * const e, std::istream & s) :
     _imp(e, s)
 {
+    if (std::char_traits<char>::to_int_type('\0') == s.peek())
+    {
+        std::string magic(binary_magic.length(), '\0');
+        if ((! s.read(&magic[0], magic.length())) || magic != binary_magic)
+            binary_error("bad header");
+        _imp->format = sf_binary;
+    }
 }
 
 Deserialiser::~Deserialiser() = default;
@@ -187,9 +451,76 @@ Deserialiser::environment() const
     return _imp->env;
 }
 
+SerialiserFormat
+Deserialiser::format() const
+{
+    return _imp->format;
+}
+
+const std::shared_ptr<const PackageID>
+Deserialiser::package_id(const std::string & spec) const
+{
+    auto i(_imp->ids.find(spec));
+    if (i != _imp->ids.end())
+        return i->second;
+
+    std::shared_ptr<const PackageID> result(*(*_imp->env)[
+        selection::RequireExactlyOne(generator::Matches(
+                    parse_elike_package_dep_spec(spec,
+                        { epdso_allow_tilde_greater_deps,
+                        epdso_allow_ranged_deps, epdso_allow_use_deps, epdso_allow_use_deps_portage,
+                        epdso_allow_use_dep_defaults, epdso_allow_repository_deps, epdso_allow_slot_star_deps,
+                        epdso_allow_slot_equal_deps, epdso_allow_slot_equal_deps_portage,
+                        epdso_allow_slot_deps, epdso_allow_key_requirements,
+                        epdso_allow_use_dep_question_defaults, epdso_allow_subslot_deps },
+                        { vso_flexible_dashes, vso_flexible_dots, vso_ignore_case,
+                        vso_letters_anywhere, vso_dotted_suffixes }), nullptr, { }))]->begin());
+
+    _imp->ids.emplace(spec, result);
+    return result;
+}
+
 Deserialisation::Deserialisation(const std::string & i, Deserialiser & d) :
     _imp(d, i)
 {
+    if (sf_binary == d.format())
+    {
+        switch (read_tag(d.stream()))
+        {
+            case bt_string:
+                _imp->string_value = d._imp->read_string_ref();
+                break;
+
+            case bt_package_id:
+                _imp->string_value = d._imp->read_id_ref();
+                break;
+
+            case bt_null:
+                _imp->null = true;
+                break;
+
+            case bt_object:
+                _imp->class_name = d._imp->read_string_ref();
+                while (true)
+                {
+                    char tag(read_tag(d.stream()));
+                    if (bt_end_object == tag)
+                        break;
+                    else if (bt_member != tag)
+                        binary_error("expected a member of '" + _imp->class_name + "'");
+
+                    std::string k(d._imp->read_string_ref());
+                    _imp->children.push_back(std::make_shared<Deserialisation>(k, d));
+                }
+                break;
+
+            default:
+                binary_error("bad tag");
+        }
+
+        return;
+    }
+
     char c;
     if (! d.stream().get(c))
         throw InternalError(PALUDIS_HERE, "can't parse string");
@@ -361,21 +692,12 @@ DeserialisatorHandler<std::shared_ptr<const PackageID> >::handle(Deserialisation
     if (v.null())
         return nullptr;
 
-    return *(*v.deserialiser().environment())[
-        selection::RequireExactlyOne(generator::Matches(
-                    parse_elike_package_dep_spec(v.string_value(),
-                        { epdso_allow_tilde_greater_deps,
-                        epdso_allow_ranged_deps, epdso_allow_use_deps, epdso_allow_use_deps_portage,
-                        epdso_allow_use_dep_defaults, epdso_allow_repository_deps, epdso_allow_slot_star_deps,
-                        epdso_allow_slot_equal_deps, epdso_allow_slot_equal_deps_portage,
-                        epdso_allow_slot_deps, epdso_allow_key_requirements,
-                        epdso_allow_use_dep_question_defaults, epdso_allow_subslot_deps },
-                        { vso_flexible_dashes, vso_flexible_dots, vso_ignore_case,
-                        vso_letters_anywhere, vso_dotted_suffixes }), nullptr, { }))]->begin();
+    return v.deserialiser().package_id(v.string_value());
 }
 
 namespace paludis
 {
+    template class Pimp<Serialiser>;
     template class Pimp<Deserialiser>;
     template class Pimp<Deserialisation>;
     template class Pimp<Deserialisator>;
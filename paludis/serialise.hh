@@ -25,6 +25,7 @@
 #include <paludis/util/wrapped_forward_iterator-fwd.hh>
 #include <paludis/serialise-fwd.hh>
 #include <paludis/environment-fwd.hh>
+#include <paludis/package_id-fwd.hh>
 #include <memory>
 #include <string>
 #include <ostream>
@@ -70,22 +71,37 @@ namespace paludis
     class PALUDIS_VISIBLE Serialiser
     {
         private:
-            std::ostream & _stream;
+            Pimp<Serialiser> _imp;
 
         public:
-            Serialiser(std::ostream &);
+            explicit Serialiser(std::ostream &, const SerialiserFormat = sf_text);
             ~Serialiser();
 
+            SerialiserFormat format() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
             SerialiserObjectWriter object(const std::string & class_name)
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
             std::ostream & raw_stream() PALUDIS_ATTRIBUTE((warn_unused_result));
 
             void escape_write(const std::string &);
+
+            ///\name Low level writers, for use by SerialiserObjectWriterHandler
+            ///\{
+
+            void begin_member(const std::string & item_name);
+            void end_object();
+            void write_string(const std::string &);
+            void write_null();
+            void write_package_id(const PackageID &);
+
+            ///\}
     };
 
     class PALUDIS_VISIBLE Deserialiser
     {
+        friend class Deserialisation;
+
         private:
             Pimp<Deserialiser> _imp;
 
@@ -96,6 +112,21 @@ namespace paludis
             const Environment * environment() const PALUDIS_ATTRIBUTE((warn_unused_result));
 
             std::istream & stream() PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Which format are we reading? This is determined from the start
+             * of the stream.
+             */
+            SerialiserFormat format() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Find the PackageID with the given uniquely identifying spec.
+             *
+             * Each distinct spec is only looked up in the environment once,
+             * and only when something asks for it.
+             */
+            const std::shared_ptr<const PackageID> package_id(const std::string &) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
     class PALUDIS_VISIBLE Deserialisation
@@ -153,6 +184,7 @@ namespace paludis
             const std::string &,
             const std::string &) PALUDIS_VISIBLE PALUDIS_ATTRIBUTE((warn_unused_result));
 
+    extern template class Pimp<Serialiser>;
     extern template class Pimp<Deserialiser>;
     extern template class Pimp<Deserialisation>;
     extern template class Pimp<Deserialisator>;
@@ -20,8 +20,13 @@
 #ifndef PALUDIS_GUARD_PALUDIS_STRIPPER_FWD_HH
 #define PALUDIS_GUARD_PALUDIS_STRIPPER_FWD_HH 1
 
+#include <iosfwd>
+#include <paludis/util/attributes.hh>
+
 namespace paludis
 {
+#include <paludis/stripper-se.hh>
+
     class Stripper;
     struct StripperOptions;
 }
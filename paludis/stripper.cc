@@ -18,35 +18,35 @@
  */
 
 #include <paludis/stripper.hh>
-#include <paludis/stripper_extras.hh>
-#include <paludis/about.hh>
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/strip.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/destringify.hh>
 #include <paludis/util/log.hh>
 #include <paludis/util/process.hh>
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/options.hh>
-#include <paludis/util/singleton-impl.hh>
+#include <paludis/util/system.hh>
+#include <paludis/util/env_var_names.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/ordered_work_queue.hh>
+#include <paludis/util/elf.hh>
+#include <paludis/util/elf_types.hh>
 #include <functional>
-#include <sstream>
+#include <istream>
 #include <list>
+#include <memory>
 #include <set>
 #include <algorithm>
 #include <sys/stat.h>
 
-#include <dlfcn.h>
-#include <stdint.h>
-
-#include "config.h"
-
-#define STUPID_CAST(type, val) reinterpret_cast<type>(reinterpret_cast<uintptr_t>(val))
-
 using namespace paludis;
 
 typedef std::set<std::pair<dev_t, ino_t> > StrippedSet;
 
+#include <paludis/stripper-se.cc>
+
 StripperError::StripperError(const std::string & s) noexcept :
     Exception(s)
 {
@@ -54,66 +54,25 @@ StripperError::StripperError(const std::string & s) noexcept :
 
 namespace
 {
-    struct StripperHandle :
-        Singleton<StripperHandle>
+    template <typename ElfType_>
+    bool is_elf_object(std::istream & stream)
     {
-        typedef PaludisStripperExtras * (* InitPtr) ();
-        typedef const std::string (* LookupPtr) (PaludisStripperExtras * const, const std::string &);
-        typedef void (* CleanupPtr) (PaludisStripperExtras * const);
-
-        void * handle;
-        InitPtr init;
-        LookupPtr lookup;
-        CleanupPtr cleanup;
-
-        StripperHandle() :
-            handle(nullptr),
-            init(nullptr),
-            lookup(nullptr),
-            cleanup(nullptr)
-        {
-#ifndef ENABLE_STRIPPER
-            Log::get_instance()->message("strip.unsupported", ll_warning, lc_context)
-                << "Paludis was built without support for stripping. No stripping will be done.";
-#else
-            do
-            {
-                handle = ::dlopen(("libpaludisstripperextras_" + stringify(PALUDIS_PC_SLOT) + ".so").c_str(), RTLD_NOW | RTLD_GLOBAL);
-                if (! handle)
-                    break;
-
-                init = STUPID_CAST(InitPtr, ::dlsym(handle, "paludis_stripper_extras_init"));
-                if (! init)
-                    break;
-
-                lookup = STUPID_CAST(LookupPtr, ::dlsym(handle, "paludis_stripper_extras_lookup"));
-                if (! lookup)
-                    break;
-
-                cleanup = STUPID_CAST(CleanupPtr, ::dlsym(handle, "paludis_stripper_extras_cleanup"));
-                if (! cleanup)
-                    break;
-            }
-            while (false);
+        if (! ElfObject<ElfType_>::is_valid_elf(stream))
+            return false;
 
-            if (! (handle && init && lookup && cleanup))
-            {
-                Log::get_instance()->message("strip.broken", ll_warning, lc_context)
-                    << "Stripping cannot be used due to error '" << stringify(::dlerror()) << "' when using libpaludisstripperextras";
+        unsigned int type(ElfObject<ElfType_>::read_type(stream));
+        return ET_EXEC == type || ET_DYN == type;
+    }
 
-                if (handle)
-                    ::dlclose(handle);
-                handle = nullptr;
-            }
-#endif
-        }
+    bool is_ar_archive(std::istream & stream)
+    {
+        static const std::string ar_magic("!<arch>\n");
 
-        ~StripperHandle()
-        {
-            if (handle)
-                ::dlclose(handle);
-        }
-    };
+        std::string magic(ar_magic.length(), '\0');
+        stream.clear();
+        stream.seekg(0, std::ios::beg);
+        return stream.read(&magic[0], magic.length()) && magic == ar_magic;
+    }
 }
 
 namespace paludis
@@ -123,29 +82,11 @@ namespace paludis
     {
         StripperOptions options;
         StrippedSet stripped_ids;
-        PaludisStripperExtras * stripper_extras;
+        std::unique_ptr<OrderedWorkQueue> queue;
 
         Imp(const StripperOptions & o) :
-            options(o),
-            stripper_extras(nullptr)
-        {
-            try
-            {
-                if (StripperHandle::get_instance()->handle)
-                    stripper_extras = StripperHandle::get_instance()->init();
-            }
-            catch (const StripperError & e)
-            {
-                Log::get_instance()->message("strip.broken", ll_warning, lc_context)
-                    << "Got error '" << e.message() << "' (" << e.what() << ") when attempting to strip";
-                stripper_extras = nullptr;
-            }
-        }
-
-        ~Imp()
+            options(o)
         {
-            if (stripper_extras)
-                StripperHandle::get_instance()->cleanup(stripper_extras);
         }
     };
 }
@@ -165,7 +106,50 @@ Stripper::strip()
     if (! _imp->options.strip())
         return;
 
+    unsigned jobs(1);
+    std::string jobs_str(getenv_with_default(env_vars::strip_jobs, "1"));
+    try
+    {
+        jobs = destringify<unsigned>(jobs_str);
+    }
+    catch (const DestringifyError &)
+    {
+        Log::get_instance()->message("strip.jobs.bad", ll_warning, lc_context)
+            << "Ignoring bad value '" << jobs_str << "' for " << env_vars::strip_jobs;
+    }
+
+    struct StopQueue
+    {
+        std::unique_ptr<OrderedWorkQueue> & q;
+
+        StopQueue(std::unique_ptr<OrderedWorkQueue> & qq) :
+            q(qq)
+        {
+        }
+
+        ~StopQueue()
+        {
+            q.reset();
+        }
+    } stop_queue(_imp->queue);
+
+    if (jobs > 1)
+        _imp->queue.reset(new OrderedWorkQueue(jobs));
+    _imp->stripped_ids.clear();
+
     do_dir_recursive(_imp->options.image_dir());
+
+    if (_imp->queue)
+        _imp->queue->finish(0);
+}
+
+void
+Stripper::in_order(const std::function<void ()> & f)
+{
+    if (_imp->queue)
+        _imp->queue->add(nullptr, f);
+    else
+        f();
 }
 
 void
@@ -176,7 +160,7 @@ Stripper::do_dir_recursive(const FSPath & f)
     if (f == _imp->options.debug_dir())
         return;
 
-    on_enter_dir(f);
+    in_order([this, f] { on_enter_dir(f); });
 
     for (FSIterator d(f, { fsio_include_dotfiles, fsio_inode_sort }), d_end ; d != d_end ; ++d)
     {
@@ -196,78 +180,140 @@ Stripper::do_dir_recursive(const FSPath & f)
                     (std::string::npos != d->basename().find(".so.")) ||
                     (d->basename() != strip_trailing_string(d->basename(), ".so")))
             {
-                std::string t(file_type(*d));
-                if (std::string::npos != t.find("SB executable") || std::string::npos != t.find("SB shared object") ||
-                    std::string::npos != t.find("SB pie executable")
-                    )
-                {
-                    if (_imp->options.dwarf_compression())
-                        do_dwarf_compress(*d);
-                    if (_imp->options.split())
-                    {
-                        FSPath target(_imp->options.debug_dir() / d->strip_leading(_imp->options.image_dir()));
-                        target = target.dirname() / (target.basename() + ".debug");
-                        do_split(*d, target);
-                    }
-                    do_strip(*d, "");
-                }
-                else if (std::string::npos != t.find("current ar archive"))
-                {
-                    do_strip(*d, "-g");
-                }
-                else
-                    on_unknown(*d);
+                /* mark it now rather than once it's done, so that we don't
+                 * start on a hardlink to something that is still queued */
+                _imp->stripped_ids.insert(d_stat.lowlevel_id());
+                strip_file(*d);
             }
         }
     }
 
-    on_leave_dir(f);
+    in_order([this, f] { on_leave_dir(f); });
 }
 
-std::string
+void
+Stripper::strip_file(const FSPath & f)
+{
+    StripperFileType t(file_type(f));
+    FSPath target(_imp->options.debug_dir() / f.strip_leading(_imp->options.image_dir()));
+    target = target.dirname() / (target.basename() + ".debug");
+
+    /* debug directories are made here, so that workers never race to make
+     * them */
+    if (stft_object == t && _imp->options.split())
+    {
+        std::list<FSPath> to_make;
+        for (FSPath d(target.dirname()) ; (! d.stat().exists()) && (d != _imp->options.image_dir()) ; d = d.dirname())
+            to_make.push_front(d);
+
+        using namespace std::placeholders;
+        std::for_each(to_make.begin(), to_make.end(), std::bind(std::mem_fn(&FSPath::mkdir), _1, 0755, FSPathMkdirOptions() + fspmkdo_ok_if_exists));
+    }
+
+    auto report([this, f, t, target] {
+            switch (t)
+            {
+                case stft_object:
+                    if (_imp->options.dwarf_compression())
+                        on_dwarf_compress(f);
+                    if (_imp->options.split())
+                        on_split(f, target);
+                    on_strip(f);
+                    return;
+
+                case stft_archive:
+                    on_strip(f);
+                    return;
+
+                case stft_other:
+                case last_stft:
+                    break;
+            }
+
+            on_unknown(f);
+            });
+
+    auto work([this, f, t, target] {
+            switch (t)
+            {
+                case stft_object:
+                    if (_imp->options.dwarf_compression())
+                        do_dwarf_compress(f);
+                    if (_imp->options.split())
+                        do_split(f, target);
+                    do_strip(f, "");
+                    return;
+
+                case stft_archive:
+                    do_strip(f, "-g");
+                    return;
+
+                case stft_other:
+                case last_stft:
+                    break;
+            }
+            });
+
+    if (stft_other == t)
+        in_order(report);
+    else if (_imp->queue)
+        _imp->queue->add(work, report);
+    else
+    {
+        report();
+        work();
+    }
+}
+
+StripperFileType
 Stripper::file_type(const FSPath & f)
 {
     Context context("When finding the file type of '" + stringify(f) + "':");
 
-    if (_imp->stripper_extras)
+    try
     {
-        std::string result(StripperHandle::get_instance()->lookup(_imp->stripper_extras, stringify(f)));
+        SafeIFStream stream(f);
+
+        StripperFileType result(stft_other);
+        if (is_elf_object<Elf32Type>(stream) || is_elf_object<Elf64Type>(stream))
+            result = stft_object;
+        else if (is_ar_archive(stream))
+            result = stft_archive;
+
         Log::get_instance()->message("strip.type", ll_debug, lc_context)
-            << "Magic says '" << f << "' is '" << result << "'";
+            << "'" << f << "' is '" << result << "'";
         return result;
     }
-    else
-        return "";
+    catch (const SafeIFStreamError & e)
+    {
+        Log::get_instance()->message("strip.type", ll_warning, lc_context)
+            << "Couldn't read '" << f << "': '" << e.message() << "' (" << e.what() << ")";
+    }
+    catch (const InvalidElfFileError & e)
+    {
+        Log::get_instance()->message("strip.type", ll_warning, lc_context)
+            << "Couldn't read '" << f << "' as ELF: '" << e.message() << "' (" << e.what() << ")";
+    }
+
+    return stft_other;
 }
 
 void
 Stripper::do_strip(const FSPath & f, const std::string & options)
 {
     Context context("When stripping '" + stringify(f) + "':");
-    on_strip(f);
 
     Process strip_process(options.empty() ?
             ProcessCommand({ "strip", stringify(f) }) :
             ProcessCommand({ "strip", options, stringify(f) }));
     if (0 != strip_process.run().wait())
         Log::get_instance()->message("strip.failure", ll_warning, lc_context) << "Couldn't strip '" << f << "'";
-    _imp->stripped_ids.insert(f.stat().lowlevel_id());
 }
 
 void
 Stripper::do_split(const FSPath & f, const FSPath & g)
 {
     Context context("When splitting '" + stringify(f) + "' to '" + stringify(g) + "':");
-    on_split(f, g);
-
-    {
-        std::list<FSPath> to_make;
-        for (FSPath d(g.dirname()) ; (! d.stat().exists()) && (d != _imp->options.image_dir()) ; d = d.dirname())
-            to_make.push_front(d);
-
-        using namespace std::placeholders;
-        std::for_each(to_make.begin(), to_make.end(), std::bind(std::mem_fn(&FSPath::mkdir), _1, 0755, FSPathMkdirOptions() + fspmkdo_ok_if_exists));
-    }
 
     ProcessCommand objcopy_copy_process_args({ "objcopy", "--only-keep-debug", stringify(f), stringify(g) });
     if (_imp->options.compress_splits())
@@ -289,8 +335,6 @@ Stripper::do_dwarf_compress(const FSPath & f)
 {
     Context context("When compressing DWARF information for '" + stringify(f) + "'");
 
-    on_dwarf_compress(f);
-
     Process dwz_process(ProcessCommand({ "dwz", /* quiet => */ "-q", stringify(f) }));
     if (dwz_process.run().wait() != 0)
         Log::get_instance()->message("strip.failure", ll_warning, lc_context)
@@ -27,6 +27,7 @@
 #include <paludis/util/fs_path.hh>
 #include <paludis/util/named_value.hh>
 #include <paludis/util/exception.hh>
+#include <functional>
 
 namespace paludis
 {
@@ -62,6 +63,9 @@ namespace paludis
         private:
             Pimp<Stripper> _imp;
 
+            void in_order(const std::function<void ()> &);
+            void strip_file(const FSPath &);
+
         protected:
             virtual void on_enter_dir(const FSPath &) = 0;
             virtual void on_leave_dir(const FSPath &) = 0;
@@ -73,12 +77,25 @@ namespace paludis
 
             virtual void do_dir_recursive(const FSPath &);
 
-            virtual std::string file_type(const FSPath &);
+            /**
+             * Work out what kind of file we have, by looking at its header
+             * rather than by running anything.
+             */
+            virtual StripperFileType file_type(const FSPath &);
+
+            /**
+             * These may be called on worker threads, several at once, so
+             * they must not use the on_ functions, which are always called
+             * from the thread which called strip, in image order.
+             */
+            ///\{
 
             virtual void do_split(const FSPath &, const FSPath &);
             virtual void do_strip(const FSPath &, const std::string &);
             virtual void do_dwarf_compress(const FSPath &);
 
+            ///\}
+
             virtual std::string strip_action_desc() const;
             virtual std::string split_action_desc() const;
             virtual std::string unknown_action_desc() const;
@@ -95,6 +112,9 @@ namespace paludis
 
             /**
              * Perform the strip.
+             *
+             * If PALUDIS_STRIP_JOBS is set to a number greater than one, that
+             * many files are stripped at once.
              */
             virtual void strip();
     };
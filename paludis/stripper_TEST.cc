@@ -23,6 +23,11 @@
 
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/make_named_values.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/join.hh>
+
+#include <list>
+#include <stdlib.h>
 
 #include <gtest/gtest.h>
 
@@ -33,50 +38,97 @@ namespace
     struct TestStripper :
         Stripper
     {
-        void on_enter_dir(const FSPath &) override
+        const FSPath image_dir;
+        std::list<std::string> recorded;
+
+        void on_enter_dir(const FSPath & f) override
         {
+            recorded.push_back("enter " + stringify(f.strip_leading(image_dir)));
         }
 
-        void on_leave_dir(const FSPath &) override
+        void on_leave_dir(const FSPath & f) override
         {
+            recorded.push_back("leave " + stringify(f.strip_leading(image_dir)));
         }
 
 
-        void on_strip(const FSPath &) override
+        void on_strip(const FSPath & f) override
         {
+            recorded.push_back("strip " + stringify(f.strip_leading(image_dir)));
         }
 
-        void on_split(const FSPath &, const FSPath &) override
+        void on_split(const FSPath & f, const FSPath & g) override
         {
+            recorded.push_back("split " + stringify(f.strip_leading(image_dir)) + " " + stringify(g.strip_leading(image_dir)));
         }
 
-        void on_dwarf_compress(const FSPath &) override
+        void on_dwarf_compress(const FSPath & f) override
         {
+            recorded.push_back("dwz " + stringify(f.strip_leading(image_dir)));
         }
 
-        void on_unknown(const FSPath &) override
+        void on_unknown(const FSPath & f) override
         {
+            recorded.push_back("unknown " + stringify(f.strip_leading(image_dir)));
         }
 
         TestStripper(const StripperOptions & o) :
-            Stripper(o)
+            Stripper(o),
+            image_dir(o.image_dir())
         {
         }
+
+        using Stripper::file_type;
     };
+
+    StripperOptions make_options(const std::string & image)
+    {
+        return make_named_values<StripperOptions>(
+                    n::compress_splits() = false,
+                    n::debug_dir() = FSPath("stripper_TEST_dir/" + image).realpath() / "usr" / "lib" / "debug",
+                    n::dwarf_compression() = false,
+                    n::image_dir() = FSPath("stripper_TEST_dir/" + image).realpath(),
+                    n::split() = true,
+                    n::strip() = true
+                    );
+    }
 }
 
 TEST(Stripper, Works)
 {
-    TestStripper s(make_named_values<StripperOptions>(
-                n::compress_splits() = false,
-                n::debug_dir() = FSPath("stripper_TEST_dir/image").realpath() / "usr" / "lib" / "debug",
-                n::dwarf_compression() = false,
-                n::image_dir() = FSPath("stripper_TEST_dir/image").realpath(),
-                n::split() = true,
-                n::strip() = true
-            ));
+    TestStripper s(make_options("image"));
     s.strip();
 
     ASSERT_TRUE(FSPath("stripper_TEST_dir/image/usr/lib/debug/usr/bin/stripper_TEST_binary.debug").stat().is_regular_file());
 }
 
+TEST(Stripper, FileType)
+{
+    TestStripper s(make_options("types"));
+
+    EXPECT_EQ(stft_object, s.file_type(FSPath("stripper_TEST_dir/types/binary")));
+    EXPECT_EQ(stft_other, s.file_type(FSPath("stripper_TEST_dir/types/script")));
+    EXPECT_EQ(stft_other, s.file_type(FSPath("stripper_TEST_dir/types/empty")));
+}
+
+TEST(Stripper, Jobs)
+{
+    TestStripper serial(make_options("serial"));
+    serial.strip();
+
+    TestStripper parallel(make_options("parallel"));
+    ::setenv("PALUDIS_STRIP_JOBS", "4", 1);
+    parallel.strip();
+    ::unsetenv("PALUDIS_STRIP_JOBS");
+
+    EXPECT_EQ(join(serial.recorded.begin(), serial.recorded.end(), " | "),
+            join(parallel.recorded.begin(), parallel.recorded.end(), " | "));
+
+    for (int n(1) ; n <= 8 ; ++n)
+    {
+        const std::string name("usr/lib/debug/usr/bin/binary_" + stringify(n) + ".debug");
+        ASSERT_TRUE((FSPath("stripper_TEST_dir/parallel") / name).stat().is_regular_file());
+        EXPECT_EQ((FSPath("stripper_TEST_dir/serial") / name).stat().file_size(),
+                (FSPath("stripper_TEST_dir/parallel") / name).stat().file_size());
+    }
+}
@@ -7,3 +7,19 @@ cd stripper_TEST_dir || exit 3
 mkdir -p image/usr/bin || exit 5
 cp ../stripper_TEST_binary image/usr/bin || exit 6
 
+mkdir -p types || exit 7
+cp ../stripper_TEST_binary types/binary || exit 8
+echo '#!/bin/sh' > types/script || exit 9
+chmod +x types/script || exit 10
+touch types/empty || exit 11
+
+for image in serial parallel ; do
+    mkdir -p ${image}/usr/bin ${image}/usr/share || exit 12
+    for n in 1 2 3 4 5 6 7 8 ; do
+        cp ../stripper_TEST_binary ${image}/usr/bin/binary_${n} || exit 13
+    done
+    echo '#!/bin/sh' > ${image}/usr/bin/script || exit 14
+    chmod +x ${image}/usr/bin/script || exit 15
+    ln ${image}/usr/bin/binary_1 ${image}/usr/share/hardlink || exit 16
+    ln -s ../bin/binary_2 ${image}/usr/share/symlink || exit 17
+done
@@ -19,9 +19,16 @@
 
 #include <paludis/tar_extras.hh>
 #include <paludis/merger.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/fd_holder.hh>
+#include <paludis/util/log.hh>
+#include <vector>
+#include <cstring>
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <archive.h>
 #include <archive_entry.h>
 
@@ -33,11 +40,12 @@ struct PaludisTarExtras
 {
     struct archive * archive;
     struct archive_entry_linkresolver * linkresolver;
+    std::vector<char> buffer;
 };
 
 extern "C"
 PaludisTarExtras *
-paludis_tar_extras_init(const std::string & f, const std::string & compress)
+paludis_tar_extras_init(const std::string & f, const std::string & compress, const int level, const unsigned threads)
 {
     auto extras(new PaludisTarExtras);
     extras->archive = archive_write_new();
@@ -45,10 +53,45 @@ paludis_tar_extras_init(const std::string & f, const std::string & compress)
     if (! extras->archive)
         throw MergerError("archive_write_new returned null");
 
+    int status;
     if (compress == "bz2")
-        archive_write_add_filter_bzip2(extras->archive);
+        status = archive_write_add_filter_bzip2(extras->archive);
+    else if (compress == "xz")
+        status = archive_write_add_filter_xz(extras->archive);
+    else if (compress == "zstd")
+    {
+#if ARCHIVE_VERSION_NUMBER >= 3003003
+        status = archive_write_add_filter_zstd(extras->archive);
+#else
+        throw MergerError("This version of libarchive does not support zstd compression");
+#endif
+    }
     else
-        archive_write_add_filter_none(extras->archive);
+        status = archive_write_add_filter_none(extras->archive);
+
+    /* ARCHIVE_WARN means libarchive will use an external program instead */
+    if (status < ARCHIVE_WARN)
+        throw MergerError("Unable to use compression '" + compress + "': " + stringify(archive_error_string(extras->archive)));
+
+    if (level >= 0)
+        if (archive_write_set_filter_option(extras->archive, nullptr, "compression-level", stringify(level).c_str()) < ARCHIVE_WARN)
+            throw MergerError("Unable to use compression level '" + stringify(level) + "' for compression '" + compress + "': "
+                    + stringify(archive_error_string(extras->archive)));
+
+    /* the xz and zstd compressors run on their own threads, so that we can
+     * carry on reading files whilst earlier blocks are being compressed. older
+     * libarchives just warn about the option, and compress on one thread. */
+    if (threads > 1 && (compress == "xz" || compress == "zstd"))
+    {
+        int threads_status(archive_write_set_filter_option(extras->archive, nullptr, "threads", stringify(threads).c_str()));
+        if (threads_status < ARCHIVE_WARN)
+            throw MergerError("Unable to use '" + stringify(threads) + "' threads for compression '" + compress + "': "
+                    + stringify(archive_error_string(extras->archive)));
+        else if (threads_status == ARCHIVE_WARN)
+            Log::get_instance()->message("tar_extras.threads.unsupported", ll_warning, lc_context)
+                << "Compressing '" << f << "' using '" << compress << "' on a single thread, because libarchive "
+                << "does not support threads for this compressor";
+    }
 
     archive_write_set_format_gnutar(extras->archive);
 
@@ -62,6 +105,8 @@ paludis_tar_extras_init(const std::string & f, const std::string & compress)
 
     archive_entry_linkresolver_set_strategy(extras->linkresolver, archive_format(extras->archive));
 
+    extras->buffer.resize(64 * 1024);
+
     return extras;
 }
 
@@ -78,7 +123,13 @@ paludis_tar_extras_add_file(PaludisTarExtras * const extras, const std::string &
     struct archive_entry * entry(archive_entry_new());
     struct archive_entry * sparse(archive_entry_new());
 
-    int fd(open(from.c_str(), O_RDONLY));
+    FDHolder fd(open(from.c_str(), O_RDONLY), false);
+    if (-1 == fd)
+        throw MergerError("open of '" + from + "' failed: " + ::strerror(errno));
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 
     archive_entry_copy_pathname(entry, path.c_str());
     if (ARCHIVE_OK != archive_read_disk_entry_from_file(disk_archive, entry, fd, nullptr))
@@ -91,22 +142,17 @@ paludis_tar_extras_add_file(PaludisTarExtras * const extras, const std::string &
 
     if (archive_entry_size(entry) > 0)
     {
-        int bytes_read;
-        char buf[4096];
-        while ((bytes_read = read(fd, buf, sizeof(buf))) > 0)
-            if (bytes_read != archive_write_data(extras->archive, buf, bytes_read))
+        ssize_t bytes_read;
+        while ((bytes_read = read(fd, extras->buffer.data(), extras->buffer.size())) > 0)
+            if (bytes_read != archive_write_data(extras->archive, extras->buffer.data(), bytes_read))
                 throw MergerError("archive_write_data failed");
 
-        close(fd);
-
         if (ARCHIVE_OK != archive_write_finish_entry(extras->archive))
             throw MergerError("archive_write_finish_entry failed");
 
         if (ARCHIVE_OK != archive_read_free(disk_archive))
             throw MergerError("archive_read_finish failed");
     }
-    else
-        close(fd);
 
     archive_entry_free(entry);
 }
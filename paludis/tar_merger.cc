@@ -27,7 +27,9 @@
 #include <paludis/util/stringify.hh>
 #include <paludis/about.hh>
 
+#include <algorithm>
 #include <ostream>
+#include <thread>
 
 #include <dlfcn.h>
 #include <stdint.h>
@@ -45,7 +47,7 @@ namespace
     struct TarMergerHandle :
         Singleton<TarMergerHandle>
     {
-        typedef PaludisTarExtras * (* InitPtr) (const std::string &, const std::string &);
+        typedef PaludisTarExtras * (* InitPtr) (const std::string &, const std::string &, const int, const unsigned);
         typedef void (* AddFilePtr) (PaludisTarExtras * const, const std::string &, const std::string &);
         typedef void (* AddSymPtr) (PaludisTarExtras * const, const std::string &, const std::string &, const std::string &);
         typedef void (* CleanupPtr) (PaludisTarExtras * const);
@@ -181,6 +183,14 @@ TarMerger::merge()
             compress = "bz2";
             break;
 
+        case tmc_xz:
+            compress = "xz";
+            break;
+
+        case tmc_zstd:
+            compress = "zstd";
+            break;
+
         case last_tmc:
             break;
     };
@@ -188,7 +198,12 @@ TarMerger::merge()
     if (compress.empty())
         throw InternalError(PALUDIS_HERE, "unknown compress");
 
-    _imp->tar = (*TarMergerHandle::get_instance()->init)(stringify(_imp->params.tar_file()), compress);
+    unsigned threads(_imp->params.compression_threads());
+    if (0 == threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    _imp->tar = (*TarMergerHandle::get_instance()->init)(stringify(_imp->params.tar_file()), compress,
+            _imp->params.compression_level(), threads);
 
     try
     {
@@ -29,6 +29,8 @@ namespace paludis
     namespace n
     {
         typedef Name<struct name_compression> compression;
+        typedef Name<struct name_compression_level> compression_level;
+        typedef Name<struct name_compression_threads> compression_threads;
         typedef Name<struct name_environment> environment;
         typedef Name<struct name_fix_mtimes_before> fix_mtimes_before;
         typedef Name<struct name_get_new_ids_or_minus_one> get_new_ids_or_minus_one;
@@ -54,6 +56,22 @@ namespace paludis
     struct TarMergerParams
     {
         NamedValue<n::compression, TarMergerCompression> compression;
+
+        /**
+         * Compression level, or -1 to use the compressor's default.
+         *
+         * \since 3.0
+         */
+        NamedValue<n::compression_level, int> compression_level;
+
+        /**
+         * How many threads to compress with, or zero to use one per CPU.
+         * Only xz and zstd can use more than one thread.
+         *
+         * \since 3.0
+         */
+        NamedValue<n::compression_threads, unsigned> compression_threads;
+
         NamedValue<n::environment, Environment *> environment;
         NamedValue<n::fix_mtimes_before, Timestamp> fix_mtimes_before;
         NamedValue<n::get_new_ids_or_minus_one, std::function<std::pair<uid_t, gid_t> (const FSPath &)> > get_new_ids_or_minus_one;
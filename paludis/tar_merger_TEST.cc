@@ -91,6 +91,8 @@ TEST(TarMerger, Works)
     TestEnvironment env;
     TestTarMerger merger(make_named_values<TarMergerParams>(
                 n::compression() = tmc_none,
+                n::compression_level() = -1,
+                n::compression_threads() = 0,
                 n::environment() = &env,
                 n::fix_mtimes_before() = Timestamp(0, 0),
                 n::get_new_ids_or_minus_one() = &get_new_ids_or_minus_one,
@@ -137,6 +139,92 @@ TEST(TarMerger, Works)
     EXPECT_EQ("/bin/cat", (FSPath("tar_merger_TEST_dir") / "simple_extract" / "rewritesym").readlink());
 }
 
+TEST(TarMerger, Xz)
+{
+    auto output(FSPath("tar_merger_TEST_dir") / "xz.tar.xz");
+
+    TestEnvironment env;
+    TestTarMerger merger(make_named_values<TarMergerParams>(
+                n::compression() = tmc_xz,
+                n::compression_level() = 1,
+                n::compression_threads() = 2,
+                n::environment() = &env,
+                n::fix_mtimes_before() = Timestamp(0, 0),
+                n::get_new_ids_or_minus_one() = &get_new_ids_or_minus_one,
+                n::image() = FSPath("tar_merger_TEST_dir") / "simple",
+                n::install_under() = FSPath("/"),
+                n::maybe_output_manager() = nullptr,
+                n::merged_entries() = std::make_shared<FSPathSet>(),
+                n::no_chown() = true,
+                n::options() = MergerOptions() + mo_rewrite_symlinks,
+                n::permit_destination() = std::bind(return_literal_function(true)),
+                n::root() = FSPath("/"),
+                n::tar_file() = output
+                ));
+
+    ASSERT_TRUE(merger.check());
+    merger.merge();
+    ASSERT_TRUE(output.stat().is_regular_file());
+
+    Process untar_process(ProcessCommand({"sh", "-c", "tar Jxf ../xz.tar.xz 2>&1"}));
+    untar_process.chdir(FSPath("tar_merger_TEST_dir/xz_extract"));
+    ASSERT_EQ(0, untar_process.run().wait());
+
+    EXPECT_EQ((FSPath("tar_merger_TEST_dir") / "xz_extract" / "file").stat().file_size(),
+            (FSPath("tar_merger_TEST_dir") / "simple" / "file").stat().file_size());
+    EXPECT_TRUE((FSPath("tar_merger_TEST_dir") / "xz_extract" / "subdir" / "subsubdir" / "script").stat().is_regular_file());
+    EXPECT_EQ("file", (FSPath("tar_merger_TEST_dir") / "xz_extract" / "goodsym").readlink());
+}
+
+TEST(TarMerger, Zstd)
+{
+    auto output(FSPath("tar_merger_TEST_dir") / "zstd.tar.zst");
+
+    TestEnvironment env;
+    TestTarMerger merger(make_named_values<TarMergerParams>(
+                n::compression() = tmc_zstd,
+                n::compression_level() = 0,
+                n::compression_threads() = 2,
+                n::environment() = &env,
+                n::fix_mtimes_before() = Timestamp(0, 0),
+                n::get_new_ids_or_minus_one() = &get_new_ids_or_minus_one,
+                n::image() = FSPath("tar_merger_TEST_dir") / "simple",
+                n::install_under() = FSPath("/"),
+                n::maybe_output_manager() = nullptr,
+                n::merged_entries() = std::make_shared<FSPathSet>(),
+                n::no_chown() = true,
+                n::options() = MergerOptions() + mo_rewrite_symlinks,
+                n::permit_destination() = std::bind(return_literal_function(true)),
+                n::root() = FSPath("/"),
+                n::tar_file() = output
+                ));
+
+    ASSERT_TRUE(merger.check());
+
+    try
+    {
+        merger.merge();
+    }
+    catch (const MergerError & e)
+    {
+        /* libarchive older than 3.3.3 can't write zstd at all */
+        if (std::string::npos != e.message().find("does not support zstd"))
+            return;
+        throw;
+    }
+
+    ASSERT_TRUE(output.stat().is_regular_file());
+
+    Process untar_process(ProcessCommand({"sh", "-c", "zstd -dc ../zstd.tar.zst | tar xf - 2>&1"}));
+    untar_process.chdir(FSPath("tar_merger_TEST_dir/zstd_extract"));
+    ASSERT_EQ(0, untar_process.run().wait());
+
+    EXPECT_EQ((FSPath("tar_merger_TEST_dir") / "zstd_extract" / "file").stat().file_size(),
+            (FSPath("tar_merger_TEST_dir") / "simple" / "file").stat().file_size());
+    EXPECT_TRUE((FSPath("tar_merger_TEST_dir") / "zstd_extract" / "subdir" / "subsubdir" / "script").stat().is_regular_file());
+    EXPECT_EQ("file", (FSPath("tar_merger_TEST_dir") / "zstd_extract" / "goodsym").readlink());
+}
+
 #else
 
 TEST(TarMerger, NotAvailable)
@@ -146,6 +234,8 @@ TEST(TarMerger, NotAvailable)
     TestEnvironment env;
     TestTarMerger merger(make_named_values<TarMergerParams>(
                 n::compression() = tmc_none,
+                n::compression_level() = -1,
+                n::compression_threads() = 0,
                 n::environment() = &env,
                 n::fix_mtimes_before() = Timestamp(0, 0),
                 n::get_new_ids_or_minus_one() = &get_new_ids_or_minus_one,
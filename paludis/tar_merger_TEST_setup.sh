@@ -4,7 +4,7 @@
 mkdir tar_merger_TEST_dir || exit 2
 cd tar_merger_TEST_dir || exit 3
 
-mkdir -p simple/subdir/subsubdir simple_extract
+mkdir -p simple/subdir/subsubdir simple_extract xz_extract zstd_extract
 cat <<END > simple/file
 This is the file.
 END
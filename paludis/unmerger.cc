@@ -23,32 +23,172 @@
 #include <paludis/hook.hh>
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/fs_stat.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/tokeniser.hh>
+#include <paludis/util/ordered_work_queue.hh>
+#include <paludis/util/fd_holder.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/md5.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/system.hh>
+#include <paludis/util/destringify.hh>
+#include <paludis/util/env_var_names.hh>
+#include <paludis/util/log.hh>
+#include <paludis/util/visitor_cast.hh>
+#include <paludis/util/timestamp.hh>
 #include <paludis/contents.hh>
 #include <paludis/metadata_key.hh>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
+
+#include "config.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 
 using namespace paludis;
 
 namespace paludis
 {
-    typedef std::multimap<std::string, std::pair<EntryType, std::shared_ptr<const ContentsEntry> > > UnmergeEntries;
-    typedef UnmergeEntries::reverse_iterator UnmergeEntriesIterator;
+    /* orders directories so that the deepest come first, so that by the time
+     * we get to a directory's parent, everything in it has already gone */
+    struct DeepestFirst
+    {
+        static long depth(const std::string & d)
+        {
+            return "/" == d ? 0 : std::count(d.begin(), d.end(), '/');
+        }
+
+        bool operator() (const std::string & a, const std::string & b) const
+        {
+            long a_depth(depth(a)), b_depth(depth(b));
+            if (a_depth != b_depth)
+                return a_depth > b_depth;
+            return a > b;
+        }
+    };
+
+    typedef std::multimap<std::string, std::pair<EntryType, std::shared_ptr<const ContentsEntry> >,
+            std::greater<std::string> > UnmergeDirectoryEntries;
+    typedef std::map<std::string, UnmergeDirectoryEntries, DeepestFirst> UnmergeEntries;
 
     template<>
     struct Imp<Unmerger>
     {
         UnmergerOptions options;
 
+        /* grouped by the directory they're in */
         UnmergeEntries unmerge_entries;
 
+        mutable std::map<std::string, bool> wanted_hooks;
+
+        /* what unmerger_unlink_override_batch said about each entry */
+        mutable std::map<std::string, std::string> batch_verdicts;
+
+        /* md5s worked out by worker threads, waiting to be checked */
+        mutable std::mutex md5s_mutex;
+        mutable std::map<std::string, std::string> md5s;
+
+        /* the directory we're removing things from */
+        mutable std::string dir_fd_path;
+        mutable std::unique_ptr<FDHolder> dir_fd;
+
         Imp(const UnmergerOptions & o) :
             options(o)
         {
         }
+
+        void prepare_md5(const std::shared_ptr<const ContentsEntry> & e, const FSPath & f) const
+        {
+            FSStat f_stat(f);
+            if (! f_stat.is_regular_file())
+                return;
+
+            /* if the mtime is wrong, check_file won't ask for the md5 */
+            auto m(e->find_metadata("mtime"));
+            if (e->end_metadata() != m)
+            {
+                auto t(visitor_cast<const MetadataTimeKey>(**m));
+                if (t && t->parse_value().seconds() != f_stat.mtim().seconds())
+                    return;
+            }
+
+            try
+            {
+                SafeIFStream s(f);
+                std::string md5(MD5(s).hexsum());
+
+                std::unique_lock<std::mutex> lock(md5s_mutex);
+                md5s.insert(std::make_pair(stringify(f), md5));
+            }
+            catch (const SafeIFStreamError &)
+            {
+                /* we'll try again when the file is checked, and complain
+                 * properly then */
+            }
+        }
+
+        /* check_file doesn't always want the md5 (config protection, for
+         * example), so don't keep it around once the file is dealt with */
+        void discard_md5(const FSPath & f) const
+        {
+            std::unique_lock<std::mutex> lock(md5s_mutex);
+            md5s.erase(stringify(f));
+        }
+
+        /* everything in a directory goes in one go, so we open each
+         * directory once, and remove things relative to it rather than
+         * having the whole path looked up each time */
+        void enter_dir(const FSPath & d) const
+        {
+            dir_fd.reset(new FDHolder(::open(stringify(d).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC), false));
+            dir_fd_path = stringify(d);
+        }
+
+        void unlink_at(const FSPath & f, const int flags) const
+        {
+#ifdef HAVE_LCHFLAGS
+            if (0 != ::lchflags(stringify(f).c_str(), 0) && ENOENT != errno)
+                throw FSError("lchflags for unlink '" + stringify(f) + "' failed: " + ::strerror(errno));
+#endif
+
+            int result(((! dir_fd) || -1 == *dir_fd || stringify(f.dirname()) != dir_fd_path) ?
+                    ::unlinkat(AT_FDCWD, stringify(f).c_str(), flags) :
+                    ::unlinkat(*dir_fd, f.basename().c_str(), flags));
+
+            if (0 != result && ENOENT != errno)
+                throw FSError(std::string((flags & AT_REMOVEDIR) ? "rmdir" : "unlink") + " '" + stringify(f)
+                        + "' failed: " + ::strerror(errno));
+        }
+
+        void add_batch_verdicts(const std::string & output) const
+        {
+            std::list<std::string> lines;
+            tokenise<delim_kind::AnyOfTag, delim_mode::DelimiterTag>(output, "\n", "", std::back_inserter(lines));
+            for (const auto & line : lines)
+            {
+                std::string::size_type p(line.find(' '));
+                batch_verdicts.insert(std::make_pair(line.substr(p + 1), line.substr(0, p)));
+            }
+        }
+
+        std::string batch_verdict(const FSPath & f) const
+        {
+            auto i(batch_verdicts.find(stringify(f)));
+            if (batch_verdicts.end() == i)
+                return "";
+
+            std::string verdict(i->second);
+            batch_verdicts.erase(i);
+            return verdict;
+        }
     };
 }
 
@@ -67,7 +207,8 @@ Unmerger::~Unmerger() = default;
 void
 Unmerger::add_unmerge_entry(const EntryType et, const std::shared_ptr<const ContentsEntry> & e)
 {
-    _imp->unmerge_entries.insert(std::make_pair(stringify(e->location_key()->parse_value()), std::make_pair(et, e)));
+    FSPath f(e->location_key()->parse_value());
+    _imp->unmerge_entries[stringify(f.dirname())].insert(std::make_pair(stringify(f), std::make_pair(et, e)));
 }
 
 void
@@ -81,35 +222,102 @@ Unmerger::unmerge()
                 _imp->options.maybe_output_manager()).max_exit_status())
         throw UnmergerError("Unmerge from '" + stringify(_imp->options.root()) + "' aborted by hook");
 
-    for (UnmergeEntriesIterator  i(_imp->unmerge_entries.rbegin()), i_end(_imp->unmerge_entries.rend()) ; i != i_end ; ++i)
+    /* ask batched override hooks about everything at once, which is much
+     * cheaper than starting a hook for each entry */
+    if (want_hook("unmerger_unlink_override_batch"))
     {
-        FSPath f(i->first);
-        switch (i->second.first)
-        {
-            case et_dir:
-                unmerge_dir(i->second.second);
-                continue;
+        std::string input;
+        for (const auto & d : _imp->unmerge_entries)
+            for (const auto & i : d.second)
+            {
+                std::string f_real(stringify(_imp->options.root() / i.second.second->location_key()->parse_value()));
+                if (std::string::npos == f_real.find('\n'))
+                    input.append(stringify(i.second.first) + " " + f_real + "\n");
+            }
+
+        HookResult hr(_imp->options.environment()->perform_hook(extend_hook(
+                        Hook("unmerger_unlink_override_batch")
+                        .input(input)
+                        .grab_output_lines(Hook::AllowedOutputValues()("skip")("force"))),
+                    _imp->options.maybe_output_manager()));
+
+        if (hr.max_exit_status() != 0)
+            throw UnmergerError("Unmerge from '" + stringify(_imp->options.root()) + "' aborted by hook");
+        _imp->add_batch_verdicts(hr.output());
+    }
 
-            case et_file:
-                unmerge_file(i->second.second);
-                continue;
+    unsigned jobs(1);
+    std::string jobs_str(getenv_with_default(env_vars::merge_jobs, "1"));
+    try
+    {
+        jobs = destringify<unsigned>(jobs_str);
+    }
+    catch (const DestringifyError &)
+    {
+        Log::get_instance()->message("unmerger.jobs.bad", ll_warning, lc_context)
+            << "Ignoring bad value '" << jobs_str << "' for " << env_vars::merge_jobs;
+    }
 
-            case et_sym:
-                unmerge_sym(i->second.second);
-                continue;
+    /* working out md5s is the slow part, so if we can, do that on worker
+     * threads ahead of everything else, which still happens here and in order */
+    std::unique_ptr<OrderedWorkQueue> queue;
+    if (jobs > 1)
+        queue.reset(new OrderedWorkQueue(jobs));
 
-            case et_misc:
-                unmerge_misc(i->second.second);
-                continue;
+    for (const auto & d : _imp->unmerge_entries)
+    {
+        FSPath d_real(_imp->options.root() / d.first);
+        if (queue)
+            queue->add(nullptr, [this, d_real] () { _imp->enter_dir(d_real); });
+        else
+            _imp->enter_dir(d_real);
 
-            case et_nothing:
-            case last_et:
-                ;
+        for (const auto & i : d.second)
+        {
+            std::shared_ptr<const ContentsEntry> e(i.second.second);
+            std::function<void ()> work, finish;
+
+            switch (i.second.first)
+            {
+                case et_dir:
+                    finish = [this, e] () { unmerge_dir(e); };
+                    break;
+
+                case et_file:
+                    {
+                        FSPath f_real(_imp->options.root() / e->location_key()->parse_value());
+                        work = [this, e, f_real] () { _imp->prepare_md5(e, f_real); };
+                        finish = [this, e, f_real] () { unmerge_file(e); _imp->discard_md5(f_real); };
+                    }
+                    break;
+
+                case et_sym:
+                    finish = [this, e] () { unmerge_sym(e); };
+                    break;
+
+                case et_misc:
+                    finish = [this, e] () { unmerge_misc(e); };
+                    break;
+
+                case et_nothing:
+                case last_et:
+                    break;
+            }
+
+            if (! finish)
+                throw InternalError(PALUDIS_HERE, "Unexpected entry_type '" + stringify(i.second.first) + "'");
+
+            if (queue)
+                queue->add(work, finish);
+            else
+                finish();
         }
-
-        throw InternalError(PALUDIS_HERE, "Unexpected entry_type '" + stringify((*i).second.first) + "'");
     }
 
+    if (queue)
+        queue->finish(0);
+    _imp->dir_fd.reset();
+
     if (0 != _imp->options.environment()->perform_hook(extend_hook(
                               Hook("unmerger_unlink_post")
                               ("UNLINK_TARGET", stringify(_imp->options.root()))),
@@ -122,11 +330,16 @@ Unmerger::unmerge_file(const std::shared_ptr<const ContentsEntry> & e) const
 {
     FSPath f_real(_imp->options.root() / e->location_key()->parse_value());
 
-    HookResult hr(_imp->options.environment()->perform_hook(extend_hook(
+    HookResult hr(make_named_values<HookResult>(
+                n::max_exit_status() = 0,
+                n::output() = _imp->batch_verdict(f_real)
+                ));
+    if (hr.output().empty() && want_hook("unmerger_unlink_file_override"))
+        hr = _imp->options.environment()->perform_hook(extend_hook(
                     Hook("unmerger_unlink_file_override")
                     ("UNLINK_TARGET", stringify(f_real))
                     .grab_output(Hook::AllowedOutputValues()("skip")("force"))),
-                _imp->options.maybe_output_manager()));
+                _imp->options.maybe_output_manager());
 
     if (hr.max_exit_status() != 0)
         throw UnmergerError("Unmerge of '" + stringify(e->location_key()->parse_value()) + "' aborted by hook");
@@ -151,11 +364,16 @@ Unmerger::unmerge_sym(const std::shared_ptr<const ContentsEntry> & e) const
 {
     FSPath f_real(_imp->options.root() / e->location_key()->parse_value());
 
-    HookResult hr(_imp->options.environment()->perform_hook(extend_hook(
+    HookResult hr(make_named_values<HookResult>(
+                n::max_exit_status() = 0,
+                n::output() = _imp->batch_verdict(f_real)
+                ));
+    if (hr.output().empty() && want_hook("unmerger_unlink_sym_override"))
+        hr = _imp->options.environment()->perform_hook(extend_hook(
                     Hook("unmerger_unlink_sym_override")
                     ("UNLINK_TARGET", stringify(f_real))
                     .grab_output(Hook::AllowedOutputValues()("skip")("force"))),
-                _imp->options.maybe_output_manager()));
+                _imp->options.maybe_output_manager());
 
     if (hr.max_exit_status() != 0)
         throw UnmergerError("Unmerge of '" + stringify(e->location_key()->parse_value()) + "' aborted by hook");
@@ -180,11 +398,16 @@ Unmerger::unmerge_dir(const std::shared_ptr<const ContentsEntry> & e) const
 {
     FSPath f_real(_imp->options.root() / e->location_key()->parse_value());
 
-    HookResult hr(_imp->options.environment()->perform_hook(extend_hook(
+    HookResult hr(make_named_values<HookResult>(
+                n::max_exit_status() = 0,
+                n::output() = _imp->batch_verdict(f_real)
+                ));
+    if (hr.output().empty() && want_hook("unmerger_unlink_dir_override"))
+        hr = _imp->options.environment()->perform_hook(extend_hook(
                     Hook("unmerger_unlink_dir_override")
                     ("UNLINK_TARGET", stringify(f_real))
                     .grab_output(Hook::AllowedOutputValues()("skip"))),
-                _imp->options.maybe_output_manager()));
+                _imp->options.maybe_output_manager());
 
     if (hr.max_exit_status() != 0)
         throw UnmergerError("Unmerge of '" + stringify(e->location_key()->parse_value()) + "' aborted by hook");
@@ -204,11 +427,16 @@ Unmerger::unmerge_misc(const std::shared_ptr<const ContentsEntry> & e) const
 {
     FSPath f_real(_imp->options.root() / e->location_key()->parse_value());
 
-    HookResult hr(_imp->options.environment()->perform_hook(extend_hook(
+    HookResult hr(make_named_values<HookResult>(
+                n::max_exit_status() = 0,
+                n::output() = _imp->batch_verdict(f_real)
+                ));
+    if (hr.output().empty() && want_hook("unmerger_unlink_misc_override"))
+        hr = _imp->options.environment()->perform_hook(extend_hook(
                     Hook("unmerger_unlink_misc_override")
                     ("UNLINK_TARGET", stringify(f_real))
                     .grab_output(Hook::AllowedOutputValues()("skip")("force"))),
-                _imp->options.maybe_output_manager()));
+                _imp->options.maybe_output_manager());
 
     if (hr.max_exit_status() != 0)
         throw UnmergerError("Unmerge of '" + stringify(e->location_key()->parse_value()) + "' aborted by hook");
@@ -231,7 +459,7 @@ Unmerger::unmerge_misc(const std::shared_ptr<const ContentsEntry> & e) const
 void
 Unmerger::unlink_file(FSPath f, const std::shared_ptr<const ContentsEntry> & e) const
 {
-    if (0 != _imp->options.environment()->perform_hook(extend_hook(
+    if (want_hook("unmerger_unlink_file_pre") && 0 != _imp->options.environment()->perform_hook(extend_hook(
                          Hook("unmerger_unlink_file_pre")
                          ("UNLINK_TARGET", stringify(e->location_key()->parse_value()))),
                 _imp->options.maybe_output_manager()).max_exit_status())
@@ -248,9 +476,9 @@ Unmerger::unlink_file(FSPath f, const std::shared_ptr<const ContentsEntry> & e)
         }
     }
 
-    f.unlink();
+    _imp->unlink_at(f, 0);
 
-    if (0 != _imp->options.environment()->perform_hook(extend_hook(
+    if (want_hook("unmerger_unlink_file_post") && 0 != _imp->options.environment()->perform_hook(extend_hook(
                          Hook("unmerger_unlink_file_post")
                          ("UNLINK_TARGET", stringify(e->location_key()->parse_value()))),
                 _imp->options.maybe_output_manager()).max_exit_status())
@@ -260,15 +488,15 @@ Unmerger::unlink_file(FSPath f, const std::shared_ptr<const ContentsEntry> & e)
 void
 Unmerger::unlink_sym(FSPath f, const std::shared_ptr<const ContentsEntry> & e) const
 {
-    if (0 != _imp->options.environment()->perform_hook(extend_hook(
+    if (want_hook("unmerger_unlink_sym_pre") && 0 != _imp->options.environment()->perform_hook(extend_hook(
                          Hook("unmerger_unlink_sym_pre")
                          ("UNLINK_TARGET", stringify(e->location_key()->parse_value()))),
                 _imp->options.maybe_output_manager()).max_exit_status())
         throw UnmergerError("Unmerge of '" + stringify(e->location_key()->parse_value()) + "' aborted by hook");
 
-    f.unlink();
+    _imp->unlink_at(f, 0);
 
-    if (0 != _imp->options.environment()->perform_hook(extend_hook(
+    if (want_hook("unmerger_unlink_sym_post") && 0 != _imp->options.environment()->perform_hook(extend_hook(
                          Hook("unmerger_unlink_sym_post")
                          ("UNLINK_TARGET", stringify(e->location_key()->parse_value()))),
                 _imp->options.maybe_output_manager()).max_exit_status())
@@ -278,15 +506,15 @@ Unmerger::unlink_sym(FSPath f, const std::shared_ptr<const ContentsEntry> & e) c
 void
 Unmerger::unlink_dir(FSPath f, const std::shared_ptr<const ContentsEntry> & e) const
 {
-    if (0 != _imp->options.environment()->perform_hook(extend_hook(
+    if (want_hook("unmerger_unlink_dir_pre") && 0 != _imp->options.environment()->perform_hook(extend_hook(
                          Hook("unmerger_unlink_dir_pre")
                          ("UNLINK_TARGET", stringify(e->location_key()->parse_value()))),
                 _imp->options.maybe_output_manager()).max_exit_status())
         throw UnmergerError("Unmerge of '" + stringify(e->location_key()->parse_value()) + "' aborted by hook");
 
-    f.rmdir();
+    _imp->unlink_at(f, AT_REMOVEDIR);
 
-    if (0 != _imp->options.environment()->perform_hook(extend_hook(
+    if (want_hook("unmerger_unlink_dir_post") && 0 != _imp->options.environment()->perform_hook(extend_hook(
                          Hook("unmerger_unlink_dir_post")
                          ("UNLINK_TARGET", stringify(e->location_key()->parse_value()))),
                 _imp->options.maybe_output_manager()).max_exit_status())
@@ -296,21 +524,39 @@ Unmerger::unlink_dir(FSPath f, const std::shared_ptr<const ContentsEntry> & e) c
 void
 Unmerger::unlink_misc(FSPath f, const std::shared_ptr<const ContentsEntry> & e) const
 {
-    if (0 != _imp->options.environment()->perform_hook(extend_hook(
+    if (want_hook("unmerger_unlink_misc_pre") && 0 != _imp->options.environment()->perform_hook(extend_hook(
                          Hook("unmerger_unlink_misc_pre")
                          ("UNLINK_TARGET", stringify(e->location_key()->parse_value()))),
                 _imp->options.maybe_output_manager()).max_exit_status())
         throw UnmergerError("Unmerge of '" + stringify(e->location_key()->parse_value()) + "' aborted by hook");
 
-    f.unlink();
+    _imp->unlink_at(f, 0);
 
-    if (0 != _imp->options.environment()->perform_hook(extend_hook(
+    if (want_hook("unmerger_unlink_misc_post") && 0 != _imp->options.environment()->perform_hook(extend_hook(
                          Hook("unmerger_unlink_misc_post")
                          ("UNLINK_TARGET", stringify(e->location_key()->parse_value()))),
                 _imp->options.maybe_output_manager()).max_exit_status())
         throw UnmergerError("Unmerge of '" + stringify(e->location_key()->parse_value()) + "' aborted by hook");
 }
 
+std::string
+Unmerger::file_md5(const FSPath & f) const
+{
+    {
+        std::unique_lock<std::mutex> lock(_imp->md5s_mutex);
+        auto i(_imp->md5s.find(stringify(f)));
+        if (_imp->md5s.end() != i)
+        {
+            std::string md5(i->second);
+            _imp->md5s.erase(i);
+            return md5;
+        }
+    }
+
+    SafeIFStream s(f);
+    return MD5(s).hexsum();
+}
+
 Hook
 Unmerger::extend_hook(const Hook & h) const
 {
@@ -318,6 +564,15 @@ Unmerger::extend_hook(const Hook & h) const
         ("ROOT", stringify(_imp->options.root()));
 }
 
+bool
+Unmerger::want_hook(const std::string & name) const
+{
+    auto i(_imp->wanted_hooks.find(name));
+    if (_imp->wanted_hooks.end() == i)
+        i = _imp->wanted_hooks.insert(std::make_pair(name, _imp->options.environment()->want_hook(name))).first;
+    return i->second;
+}
+
 bool
 Unmerger::check_file(const std::shared_ptr<const ContentsEntry> &) const
 {
@@ -122,6 +122,23 @@ namespace paludis
              */
             virtual Hook extend_hook(const Hook &) const;
 
+            /**
+             * Is anything interested in the named per-entry hook? If not,
+             * there is no need to build and run it.
+             *
+             * \since 3.0
+             */
+            bool want_hook(const std::string &) const;
+
+            /**
+             * Work out the md5 of a file being unmerged, which may already
+             * have been done on a worker thread.
+             *
+             * \throw SafeIFStreamError if the file cannot be read.
+             * \since 3.0
+             */
+            std::string file_md5(const FSPath &) const;
+
             ///\name Unmerge operations
             ///\{
 
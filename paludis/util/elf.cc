@@ -258,6 +258,28 @@ ElfObject<ElfType_>::is_valid_elf(std::istream & stream)
     }
 }
 
+template <typename ElfType_>
+unsigned int
+ElfObject<ElfType_>::read_type(std::istream & stream)
+{
+    try
+    {
+        StreamExceptions exns(stream, std::ios::eofbit | std::ios::failbit | std::ios::badbit);
+
+        typename ElfType_::Header hdr;
+        stream.seekg(0, std::ios::beg);
+        stream.read(reinterpret_cast<char *>(&hdr), sizeof(typename ElfType_::Header));
+        if (hdr.e_ident[EI_DATA] != native_byte_order)
+            ByteSwapElfHeader<ElfType_>::swap_in_place(hdr);
+
+        return hdr.e_type;
+    }
+    catch (const std::ios_base::failure &)
+    {
+        throw InvalidElfFileError("file is truncated, or an offset points past the end of the file");
+    }
+}
+
 template <typename ElfType_>
 ElfObject<ElfType_>::ElfObject(std::istream & stream) :
     _imp()
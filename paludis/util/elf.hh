@@ -53,6 +53,13 @@ namespace paludis
 
         public:
             static bool is_valid_elf(std::istream & stream);
+
+            /**
+             * Returns e_type from the ELF header, without reading any of the
+             * sections. Only use this if is_valid_elf(...) is true.
+             */
+            static unsigned int read_type(std::istream & stream);
+
             ElfObject(std::istream & stream);
             ~ElfObject();
 
@@ -38,17 +38,23 @@ namespace paludis
         const std::string home("PALUDIS_HOME");
         const std::string hooker_dir("PALUDIS_HOOKER_DIR");
         const std::string ignore_hooks_named("PALUDIS_IGNORE_HOOKS_NAMED");
+        const std::string merge_jobs("PALUDIS_MERGE_JOBS");
+        const std::string merge_lock_file("PALUDIS_MERGE_LOCK_FILE");
         const std::string no_chown("PALUDIS_NO_CHOWN");
         const std::string no_global_fetchers("PALUDIS_NO_GLOBAL_FETCHERS");
         const std::string no_global_hooks("PALUDIS_NO_GLOBAL_HOOKS");
         const std::string no_global_sets("PALUDIS_NO_GLOBAL_SETS");
         const std::string no_global_syncers("PALUDIS_NO_GLOBAL_SYNCERS");
         const std::string no_xml("PALUDIS_NO_XML");
+        const std::string pbin_compression("PALUDIS_PBIN_COMPRESSION");
+        const std::string pbin_compression_level("PALUDIS_PBIN_COMPRESSION_LEVEL");
+        const std::string pbin_compression_threads("PALUDIS_PBIN_COMPRESSION_THREADS");
         const std::string portage_bashrc("PALUDIS_PORTAGE_BASHRC");
         const std::string python_dir("PALUDIS_PYTHON_DIR");
         const std::string reduced_gid("PALUDIS_REDUCED_GID");
         const std::string reduced_uid("PALUDIS_REDUCED_UID");
         const std::string reduced_username("PALUDIS_REDUCED_USERNAME");
+        const std::string strip_jobs("PALUDIS_STRIP_JOBS");
         const std::string suffixes_file("PALUDIS_SUFFIXES_FILE");
     }
 }
@@ -21,6 +21,7 @@
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/exception.hh>
 #include <paludis/util/stringify.hh>
+#include <algorithm>
 #include <condition_variable>
 #include <functional>
 #include <iostream>
@@ -48,6 +49,7 @@ namespace paludis
         int done;
 
         Queues queues;
+        std::map<std::string, int> queue_limits;
         ReadyForPost ready_for_post;
         std::mutex mutex;
         std::condition_variable condition;
@@ -114,10 +116,18 @@ Executor::add(const std::shared_ptr<Executive> & x)
     _imp->queues.insert(std::make_pair(x->queue_name(), ExecutiveList())).first->second.push_back(x);
 }
 
+void
+Executor::set_queue_limit(const std::string & queue_name, const int n)
+{
+    if (n < 1)
+        throw InternalError(PALUDIS_HERE, "bad queue limit " + stringify(n));
+    _imp->queue_limits[queue_name] = n;
+}
+
 void
 Executor::execute()
 {
-    typedef std::map<std::string, std::pair<std::thread, std::shared_ptr<Executive> > > Running;
+    typedef std::multimap<std::string, std::pair<std::thread, std::shared_ptr<Executive> > > Running;
     Running running;
 
     std::unique_lock<std::mutex> lock(_imp->mutex);
@@ -127,22 +137,34 @@ Executor::execute()
         for (Queues::iterator q(_imp->queues.begin()), q_end(_imp->queues.end()) ;
                 q != q_end ; )
         {
-            if ((running.end() != running.find(q->first)) || ! (*q->second.begin())->can_run())
+            auto l(_imp->queue_limits.find(q->first));
+            int limit(l == _imp->queue_limits.end() ? 1 : l->second);
+
+            /* a queue that may only run one thing at once is strictly
+             * ordered. otherwise, anything in it that can run may start. */
+            for (ExecutiveList::iterator x(q->second.begin()), x_end(q->second.end()) ;
+                    x != x_end && static_cast<int>(running.count(q->first)) < limit ; )
             {
-                ++q;
-                continue;
+                if (! (*x)->can_run())
+                {
+                    if (1 == limit)
+                        break;
+                    ++x;
+                    continue;
+                }
+
+                ++_imp->active;
+                --_imp->pending;
+                (*x)->pre_execute_exclusive();
+                running.insert(std::make_pair(q->first, std::make_pair(std::thread(std::bind(&Executor::_one, this, *x)), *x)));
+                x = q->second.erase(x);
+                any = true;
             }
 
-            ++_imp->active;
-            --_imp->pending;
-            (*q->second.begin())->pre_execute_exclusive();
-            running.insert(std::make_pair(q->first, std::make_pair(std::thread(std::bind(&Executor::_one, this, *q->second.begin())), *q->second.begin())));
-            q->second.erase(q->second.begin());
             if (q->second.empty())
                 _imp->queues.erase(q++);
             else
                 ++q;
-            any = true;
         }
 
         if ((! any) && running.empty())
@@ -162,7 +184,11 @@ Executor::execute()
         {
             --_imp->active;
             ++_imp->done;
-            auto r = running.find((*p)->queue_name());
+
+            auto range(running.equal_range((*p)->queue_name()));
+            auto r(std::find_if(range.first, range.second, [&] (const Running::value_type & v) { return v.second.second == *p; }));
+            if (r == range.second)
+                throw InternalError(PALUDIS_HERE, "finished executive isn't running");
             r->second.first.join();
             running.erase(r);
             (*p)->post_execute_exclusive();
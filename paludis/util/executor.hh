@@ -61,6 +61,16 @@ namespace paludis
 
             void add(const std::shared_ptr<Executive> & x);
 
+            /**
+             * Allow up to n executives from the named queue to run at once.
+             *
+             * By default, a queue runs one thing at a time, in the order
+             * things were added. If n is greater than 1, any executive in the
+             * queue whose can_run() returns true may be started, so can_run()
+             * must take care of any ordering that matters.
+             */
+            void set_queue_limit(const std::string & queue_name, const int n);
+
             void execute();
 
             std::mutex & exclusivity_mutex() PALUDIS_ATTRIBUTE((warn_unused_result));
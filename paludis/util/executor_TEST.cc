@@ -0,0 +1,176 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/executor.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/exception.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    struct Counts
+    {
+        std::atomic<int> running;
+        std::atomic<int> most_running;
+        int started;
+        std::list<std::string> finished;
+
+        Counts() :
+            running(0),
+            most_running(0),
+            started(0)
+        {
+        }
+    };
+
+    struct TestExecutive :
+        Executive
+    {
+        const std::string id;
+        Counts & counts;
+        const std::function<bool ()> can_run_fn;
+
+        TestExecutive(const std::string & i, Counts & c, const std::function<bool ()> & f) :
+            id(i),
+            counts(c),
+            can_run_fn(f)
+        {
+        }
+
+        std::string queue_name() const override
+        {
+            return "q";
+        }
+
+        std::string unique_id() const override
+        {
+            return id;
+        }
+
+        bool can_run() const override
+        {
+            return can_run_fn();
+        }
+
+        void pre_execute_exclusive() override
+        {
+            ++counts.started;
+        }
+
+        void execute_threaded() override
+        {
+            int now(++counts.running);
+            for (int most(counts.most_running) ; now > most && ! counts.most_running.compare_exchange_weak(most, now) ; )
+            {
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            --counts.running;
+        }
+
+        void flush_threaded() override
+        {
+        }
+
+        void post_execute_exclusive() override
+        {
+            --counts.started;
+            counts.finished.push_back(id);
+        }
+    };
+
+    bool always()
+    {
+        return true;
+    }
+}
+
+TEST(Executor, DefaultIsSequential)
+{
+    Counts counts;
+    Executor executor(10);
+    for (int n(1) ; n <= 4 ; ++n)
+        executor.add(std::make_shared<TestExecutive>(stringify(n), counts, &always));
+    executor.execute();
+
+    EXPECT_EQ(1, counts.most_running);
+    EXPECT_EQ("1 2 3 4", join(counts.finished.begin(), counts.finished.end(), " "));
+    EXPECT_EQ(4, executor.done());
+}
+
+TEST(Executor, QueueLimit)
+{
+    Counts counts;
+    Executor executor(10);
+    executor.set_queue_limit("q", 3);
+    for (int n(1) ; n <= 8 ; ++n)
+        executor.add(std::make_shared<TestExecutive>(stringify(n), counts, &always));
+    executor.execute();
+
+    EXPECT_LE(counts.most_running, 3);
+    EXPECT_GT(counts.most_running, 1);
+    EXPECT_EQ(8u, counts.finished.size());
+}
+
+TEST(Executor, CanRunHoldsBackConcurrentStarts)
+{
+    /* this is how cave's --install-load-limit works: something may always
+     * start if nothing else is running, but not alongside anything else */
+    Counts counts;
+    Executor executor(10);
+    executor.set_queue_limit("q", 4);
+    for (int n(1) ; n <= 4 ; ++n)
+        executor.add(std::make_shared<TestExecutive>(stringify(n), counts, [&] () { return 0 == counts.started; }));
+    executor.execute();
+
+    EXPECT_EQ(1, counts.most_running);
+    EXPECT_EQ(4u, counts.finished.size());
+}
+
+TEST(Executor, CanRunOutOfOrder)
+{
+    Counts counts;
+    Executor executor(10);
+    executor.set_queue_limit("q", 2);
+    executor.add(std::make_shared<TestExecutive>("first", counts, [&] () {
+                    return counts.finished.end() != std::find(counts.finished.begin(), counts.finished.end(), "second"); }));
+    executor.add(std::make_shared<TestExecutive>("second", counts, &always));
+    executor.execute();
+
+    EXPECT_EQ("second first", join(counts.finished.begin(), counts.finished.end(), " "));
+}
+
+TEST(Executor, BadQueueLimit)
+{
+    Executor executor;
+    EXPECT_THROW(executor.set_queue_limit("q", 0), InternalError);
+}
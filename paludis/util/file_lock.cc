@@ -0,0 +1,68 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/file_lock.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/system.hh>
+#include <paludis/util/log.hh>
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace paludis;
+
+FileLock::FileLock(const FSPath & f) :
+    _fd(::open(stringify(f).c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0644))
+{
+    if (-1 == _fd)
+        throw FSError("Cannot open lock file '" + stringify(f) + "': " + std::strerror(errno));
+
+    while (-1 == ::flock(_fd, LOCK_EX))
+    {
+        if (EINTR == errno)
+            continue;
+
+        int e(errno);
+        ::close(_fd);
+        throw FSError("Cannot lock '" + stringify(f) + "': " + std::strerror(e));
+    }
+}
+
+FileLock::~FileLock()
+{
+    ::flock(_fd, LOCK_UN);
+    ::close(_fd);
+}
+
+std::shared_ptr<FileLock>
+paludis::lock_file_named_by_environment_variable(const std::string & var)
+{
+    std::string f(getenv_with_default(var, ""));
+    if (f.empty())
+        return nullptr;
+
+    Log::get_instance()->message("util.file_lock.waiting", ll_debug, lc_context) << "Waiting for lock on '" << f << "'";
+    return std::make_shared<FileLock>(FSPath(f));
+}
@@ -0,0 +1,76 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_UTIL_FILE_LOCK_HH
+#define PALUDIS_GUARD_PALUDIS_UTIL_FILE_LOCK_HH 1
+
+#include <paludis/util/attributes.hh>
+#include <paludis/util/fs_path-fwd.hh>
+#include <memory>
+#include <string>
+
+namespace paludis
+{
+    /**
+     * RAII holder for an exclusive lock on a file, which is created if
+     * necessary.
+     *
+     * The lock is an flock() lock, so it excludes other processes as well as
+     * other FileLock instances in this process.
+     *
+     * Lock files usually live in shared directories such as $TMPDIR, so a
+     * symlink in the lock file's place is not followed.
+     *
+     * \ingroup g_fs
+     */
+    class PALUDIS_VISIBLE FileLock
+    {
+        private:
+            int _fd;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            /**
+             * Block until we hold the lock.
+             *
+             * \throw FSError if the file cannot be opened or locked, or is a
+             *   symlink.
+             */
+            explicit FileLock(const FSPath &);
+            ~FileLock();
+
+            FileLock(const FileLock &) = delete;
+            FileLock & operator= (const FileLock &) = delete;
+
+            ///\}
+    };
+
+    /**
+     * If the named environment variable is set, lock the file it names,
+     * otherwise return a null pointer.
+     *
+     * \ingroup g_fs
+     */
+    std::shared_ptr<FileLock> lock_file_named_by_environment_variable(const std::string &)
+        PALUDIS_VISIBLE PALUDIS_ATTRIBUTE((warn_unused_result));
+}
+
+#endif
@@ -0,0 +1,88 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/file_lock.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/fs_error.hh>
+
+#include <cstdlib>
+
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    bool can_lock(const FSPath & f)
+    {
+        int fd(::open(stringify(f).c_str(), O_RDWR));
+        EXPECT_NE(-1, fd);
+        bool result(0 == ::flock(fd, LOCK_EX | LOCK_NB));
+        ::close(fd);
+        return result;
+    }
+}
+
+TEST(FileLock, Works)
+{
+    FSPath f("file_lock_TEST_file");
+
+    {
+        FileLock lock(f);
+        ASSERT_TRUE(f.stat().is_regular_file());
+        EXPECT_FALSE(can_lock(f));
+    }
+
+    EXPECT_TRUE(can_lock(f));
+    f.unlink();
+}
+
+TEST(FileLock, Environment)
+{
+    ::unsetenv("PALUDIS_FILE_LOCK_TEST");
+    EXPECT_FALSE(lock_file_named_by_environment_variable("PALUDIS_FILE_LOCK_TEST"));
+
+    FSPath f("file_lock_TEST_env_file");
+    ::setenv("PALUDIS_FILE_LOCK_TEST", stringify(f).c_str(), 1);
+    {
+        auto lock(lock_file_named_by_environment_variable("PALUDIS_FILE_LOCK_TEST"));
+        EXPECT_TRUE(bool(lock));
+        EXPECT_FALSE(can_lock(f));
+    }
+
+    EXPECT_TRUE(can_lock(f));
+    f.unlink();
+}
+
+TEST(FileLock, Symlink)
+{
+    FSPath f("file_lock_TEST_symlink");
+    FSPath target("file_lock_TEST_symlink_target");
+    ASSERT_TRUE(f.symlink(stringify(target)));
+
+    EXPECT_THROW(FileLock lock(f), FSError);
+    EXPECT_FALSE(target.stat().exists());
+    f.unlink();
+}
@@ -35,6 +35,7 @@ add(`exception',                         `hh', `cc')
 add(`executor',                          `hh', `cc', `fwd')
 add(`extract_host_from_url',             `hh', `cc', `fwd', `gtest')
 add(`fd_holder',                         `hh')
+add(`file_lock',                         `hh', `cc', `gtest')
 add(`fs_iterator',                       `hh', `cc', `fwd', `se', `gtest', `testscript')
 add(`fs_error',                          `hh', `cc')
 add(`fs_path',                           `hh', `cc', `fwd', `se', `gtest', `testscript')
@@ -22,6 +22,8 @@
 #include <sstream>
 #include <istream>
 #include <iomanip>
+#include <algorithm>
+#include <cstring>
 
 using namespace paludis;
 
@@ -141,45 +143,74 @@ MD5::_update(const uint8_t * const block)
     _r[3] += d;
 }
 
-MD5::MD5(std::istream & stream) :
+MD5::MD5() :
     _size(0),
-    _done_one_pad(false)
+    _buffered(0)
 {
     _r[0] = 0x67452301;
     _r[1] = 0xefcdab89;
     _r[2] = 0x98badcfe;
     _r[3] = 0x10325476;
+}
 
-    uint8_t buffer[64];
-    int c, s(0);
-    while (-1 != ((c = _get(stream))))
+MD5::MD5(std::istream & stream) :
+    MD5()
+{
+    char buffer[1 << 16];
+    while (stream)
     {
-        buffer[s++] = c;
-        if (64 == s)
-        {
-            _update(&buffer[0]);
-            s = 0;
-        }
+        stream.read(buffer, sizeof(buffer));
+        update(buffer, stream.gcount());
     }
-    while (56 != s)
+
+    finish();
+}
+
+void
+MD5::update(const void * const data, const std::size_t length)
+{
+    const uint8_t * p(static_cast<const uint8_t *>(data));
+    std::size_t left(length);
+    _size += static_cast<uint64_t>(length) * 8;
+
+    if (0 != _buffered)
     {
-        buffer[s++] = 0;
-        if (64 == s)
-        {
-            _update(&buffer[0]);
-            s = 0;
-        }
+        std::size_t take(std::min(left, sizeof(_buffer) - _buffered));
+        std::memcpy(&_buffer[_buffered], p, take);
+        _buffered += take;
+        p += take;
+        left -= take;
+
+        if (sizeof(_buffer) != _buffered)
+            return;
+
+        _update(&_buffer[0]);
+        _buffered = 0;
     }
 
-    buffer[56] = static_cast<uint8_t>(_size >> (0 * 8));
-    buffer[57] = static_cast<uint8_t>(_size >> (1 * 8));
-    buffer[58] = static_cast<uint8_t>(_size >> (2 * 8));
-    buffer[59] = static_cast<uint8_t>(_size >> (3 * 8));
-    buffer[60] = static_cast<uint8_t>(_size >> (4 * 8));
-    buffer[61] = static_cast<uint8_t>(_size >> (5 * 8));
-    buffer[62] = static_cast<uint8_t>(_size >> (6 * 8));
-    buffer[63] = static_cast<uint8_t>(_size >> (7 * 8));
-    _update(&buffer[0]);
+    for ( ; left >= sizeof(_buffer) ; p += sizeof(_buffer), left -= sizeof(_buffer))
+        _update(p);
+
+    std::memcpy(&_buffer[0], p, left);
+    _buffered = left;
+}
+
+void
+MD5::finish()
+{
+    _buffer[_buffered++] = 0x80;
+    if (_buffered > 56)
+    {
+        std::fill(&_buffer[_buffered], &_buffer[64], 0);
+        _update(&_buffer[0]);
+        _buffered = 0;
+    }
+    std::fill(&_buffer[_buffered], &_buffer[56], 0);
+
+    for (int i(0) ; i < 8 ; ++i)
+        _buffer[56 + i] = static_cast<uint8_t>(_size >> (i * 8));
+    _update(&_buffer[0]);
+    _buffered = 0;
 }
 
 std::string
@@ -194,24 +225,6 @@ MD5::hexsum() const
     return result.str();
 }
 
-int
-MD5::_get(std::istream & stream)
-{
-    char c;
-    if (stream.get(c))
-    {
-        _size += 8;
-        return static_cast<unsigned char>(c);
-    }
-    else if (! _done_one_pad)
-    {
-        _done_one_pad = true;
-        return 0x80;
-    }
-    else
-        return -1;
-}
-
 const uint8_t MD5::_s[64] = {
     7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,
     5,  9, 14, 20,  5,  9, 14, 20,  5,  9, 14, 20,  5,  9, 14, 20,
@@ -22,6 +22,7 @@
 
 #include <iosfwd>
 #include <string>
+#include <cstddef>
 #include <inttypes.h>
 #include <paludis/util/attributes.hh>
 
@@ -49,18 +50,39 @@ namespace paludis
             static const PALUDIS_HIDDEN uint8_t _s[64];
             uint32_t _r[4];
             uint64_t _size;
-            bool _done_one_pad;
+            uint8_t _buffer[64];
+            std::size_t _buffered;
 
             void PALUDIS_HIDDEN _update(const uint8_t * const block);
 
-            inline int PALUDIS_HIDDEN _get(std::istream & stream);
-
         public:
             /**
              * Constructor.
              */
             MD5(std::istream & stream);
 
+            /**
+             * Constructor, for data that is supplied using update(). Call
+             * finish() once all of it has been supplied.
+             *
+             * \since 3.0
+             */
+            MD5();
+
+            /**
+             * Add some more data.
+             *
+             * \since 3.0
+             */
+            void update(const void * const data, const std::size_t length);
+
+            /**
+             * No more data is coming, so make hexsum() usable.
+             *
+             * \since 3.0
+             */
+            void finish();
+
             /**
              * Our checksum, as a string of hex characters.
              */
@@ -19,6 +19,9 @@
 
 #include <paludis/util/md5.hh>
 
+#include <algorithm>
+#include <sstream>
+
 #include <gtest/gtest.h>
 
 using namespace paludis;
@@ -73,3 +76,18 @@ TEST(MD5, t8)
     EXPECT_EQ("7707d6ae4e027c70eea2a935c2296f21", md5(std::string(1000000, 'a')));
 }
 
+TEST(MD5, Incremental)
+{
+    std::string data;
+    for (int i(0) ; i < 1000 ; ++i)
+        data.append(1, static_cast<char>('a' + i % 26));
+
+    for (std::size_t chunk : { 1, 7, 63, 64, 65, 500 })
+    {
+        MD5 m;
+        for (std::size_t p(0) ; p < data.length() ; p += chunk)
+            m.update(data.data() + p, std::min(chunk, data.length() - p));
+        m.finish();
+        EXPECT_EQ(md5(data), m.hexsum());
+    }
+}
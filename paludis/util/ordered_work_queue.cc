@@ -0,0 +1,173 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/ordered_work_queue.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/thread_pool.hh>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+using namespace paludis;
+
+namespace
+{
+    struct QueuedWork
+    {
+        std::function<void ()> work;
+        std::function<void ()> finish;
+        bool done;
+        std::exception_ptr exception;
+    };
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<OrderedWorkQueue>
+    {
+        const std::size_t max_outstanding;
+
+        std::mutex mutex;
+        std::condition_variable work_condition;
+        std::condition_variable done_condition;
+        std::deque<std::shared_ptr<QueuedWork> > unstarted;
+        bool stopping;
+
+        std::deque<std::shared_ptr<QueuedWork> > in_order;
+        bool finishing;
+
+        /* last, so that the workers are joined before anything they use
+         * goes away */
+        ThreadPool pool;
+
+        Imp(const unsigned jobs) :
+            max_outstanding(jobs * 4),
+            stopping(false),
+            finishing(false)
+        {
+        }
+
+        void worker() noexcept
+        {
+            while (true)
+            {
+                std::shared_ptr<QueuedWork> q;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    work_condition.wait(lock, [&] { return stopping || ! unstarted.empty(); });
+                    if (stopping)
+                        return;
+                    q = unstarted.front();
+                    unstarted.pop_front();
+                }
+
+                try
+                {
+                    q->work();
+                }
+                catch (...)
+                {
+                    q->exception = std::current_exception();
+                }
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    q->done = true;
+                }
+                done_condition.notify_all();
+            }
+        }
+    };
+}
+
+OrderedWorkQueue::OrderedWorkQueue(const unsigned jobs) :
+    _imp(jobs)
+{
+    for (unsigned n(0) ; n < jobs ; ++n)
+        _imp->pool.create_thread([this] () noexcept { _imp->worker(); });
+}
+
+OrderedWorkQueue::~OrderedWorkQueue()
+{
+    {
+        std::unique_lock<std::mutex> lock(_imp->mutex);
+        _imp->stopping = true;
+    }
+    _imp->work_condition.notify_all();
+}
+
+void
+OrderedWorkQueue::add(const std::function<void ()> & work, const std::function<void ()> & finish)
+{
+    if ((! work) && (_imp->finishing || _imp->in_order.empty()))
+        return finish();
+
+    std::shared_ptr<QueuedWork> q(std::make_shared<QueuedWork>(QueuedWork{ work, finish, ! work, nullptr }));
+    _imp->in_order.push_back(q);
+
+    if (work)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_imp->mutex);
+            _imp->unstarted.push_back(q);
+        }
+        _imp->work_condition.notify_one();
+    }
+
+    this->finish(_imp->max_outstanding);
+}
+
+void
+OrderedWorkQueue::finish(const std::size_t leave)
+{
+    while (! _imp->in_order.empty())
+    {
+        std::shared_ptr<QueuedWork> q(_imp->in_order.front());
+        {
+            std::unique_lock<std::mutex> lock(_imp->mutex);
+            if ((! q->done) && _imp->in_order.size() <= leave)
+                return;
+            _imp->done_condition.wait(lock, [&] { return q->done; });
+        }
+
+        _imp->in_order.pop_front();
+        if (q->exception)
+            std::rethrow_exception(q->exception);
+
+        _imp->finishing = true;
+        try
+        {
+            q->finish();
+        }
+        catch (...)
+        {
+            _imp->finishing = false;
+            throw;
+        }
+        _imp->finishing = false;
+    }
+}
+
+namespace paludis
+{
+    template class Pimp<OrderedWorkQueue>;
+}
@@ -0,0 +1,94 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_UTIL_ORDERED_WORK_QUEUE_HH
+#define PALUDIS_GUARD_PALUDIS_UTIL_ORDERED_WORK_QUEUE_HH 1
+
+#include <paludis/util/attributes.hh>
+#include <paludis/util/pimp.hh>
+#include <functional>
+#include <cstddef>
+
+/** \file
+ * Declarations for the OrderedWorkQueue class.
+ *
+ * \ingroup g_threads
+ *
+ * \section Examples
+ *
+ * - None at this time.
+ */
+
+namespace paludis
+{
+    /**
+     * Runs the slow part of a series of tasks on a fixed number of worker
+     * threads, and then everything else, including anything that records or
+     * displays what was done, back on the calling thread in the order in which
+     * the tasks were added.
+     *
+     * Only the thread which created the queue may call add or finish. If a
+     * task's work throws, the exception is rethrown from add or finish when
+     * that task's turn comes. Any work which has not started when the queue
+     * is destroyed is discarded.
+     *
+     * \ingroup g_threads
+     * \nosubgrouping
+     * \since 3.0
+     */
+    class PALUDIS_VISIBLE OrderedWorkQueue
+    {
+        private:
+            Pimp<OrderedWorkQueue> _imp;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            /**
+             * Start jobs worker threads. No more than four tasks per worker
+             * are allowed to be outstanding at once.
+             */
+            explicit OrderedWorkQueue(const unsigned jobs);
+            ~OrderedWorkQueue();
+
+            OrderedWorkQueue(const OrderedWorkQueue &) = delete;
+            OrderedWorkQueue & operator= (const OrderedWorkQueue &) = delete;
+
+            ///\}
+
+            /**
+             * Queue a task. The work is run on a worker thread, and may be
+             * empty, in which case the finish just waits its turn. Anything
+             * added from inside a finish is already in the right place, so
+             * it isn't made to wait.
+             */
+            void add(const std::function<void ()> & work, const std::function<void ()> & finish);
+
+            /**
+             * Finish everything that is ready, and then wait for and finish
+             * tasks until no more than leave are outstanding.
+             */
+            void finish(const std::size_t leave);
+    };
+
+    extern template class Pimp<OrderedWorkQueue>;
+}
+
+#endif
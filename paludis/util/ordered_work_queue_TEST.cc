@@ -0,0 +1,84 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/ordered_work_queue.hh>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+TEST(OrderedWorkQueue, FinishesInOrder)
+{
+    std::atomic<int> worked(0);
+    std::vector<int> finished;
+
+    {
+        OrderedWorkQueue q(4);
+        for (int x(0) ; x < 100 ; ++x)
+            q.add(
+                    [&, x] {
+                        /* make later tasks likely to complete first */
+                        std::this_thread::sleep_for(std::chrono::microseconds((100 - x) % 7 * 100));
+                        ++worked;
+                    },
+                    [&, x] { finished.push_back(x); });
+        q.finish(0);
+    }
+
+    ASSERT_EQ(100, worked.load());
+    ASSERT_EQ(100u, finished.size());
+    for (int x(0) ; x < 100 ; ++x)
+        EXPECT_EQ(x, finished[x]);
+}
+
+TEST(OrderedWorkQueue, NoWork)
+{
+    std::vector<int> finished;
+
+    OrderedWorkQueue q(2);
+    q.add(nullptr, [&] { finished.push_back(0); });
+    ASSERT_EQ(1u, finished.size());
+
+    q.add([] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); }, [&] { finished.push_back(1); });
+    q.add(nullptr, [&] { finished.push_back(2); });
+    q.finish(0);
+
+    ASSERT_EQ(3u, finished.size());
+    EXPECT_EQ(1, finished[1]);
+    EXPECT_EQ(2, finished[2]);
+}
+
+TEST(OrderedWorkQueue, Exceptions)
+{
+    std::vector<int> finished;
+
+    OrderedWorkQueue q(2);
+    q.add([] { }, [&] { finished.push_back(0); });
+    q.add([] { throw std::runtime_error("oops"); }, [&] { finished.push_back(1); });
+    EXPECT_THROW(q.finish(0), std::runtime_error);
+
+    ASSERT_EQ(1u, finished.size());
+    EXPECT_EQ(0, finished[0]);
+}
@@ -542,6 +542,14 @@ RunningProcessThread::thread_func()
     bool prefix_stdout_buffer_has_newline(false), prefix_stderr_buffer_has_newline(false), want_to_finish(true);
     bool done_extra_newlines_stdout(false), done_extra_newlines_stderr(false);
     std::string input_stream_pending;
+    bool input_refused(false);
+
+    /* if the child stops reading its input early, we want write() to give us
+     * EPIPE, rather than for SIGPIPE to kill the whole process */
+    sigset_t sigpipe_set;
+    sigemptyset(&sigpipe_set);
+    sigaddset(&sigpipe_set, SIGPIPE);
+    ::pthread_sigmask(SIG_BLOCK, &sigpipe_set, nullptr);
 
     if (as_main_process && send_input_to_fd)
         want_to_finish = false;
@@ -662,13 +670,23 @@ RunningProcessThread::thread_func()
 
                 if (0 == w || (-1 == w && (errno == EAGAIN || errno == EWOULDBLOCK)))
                     break;
+                else if (-1 == w && errno == EPIPE)
+                {
+                    /* it doesn't want the rest, so treat that as the end of
+                     * the input, and throw away the pending SIGPIPE */
+                    struct timespec no_wait = { 0, 0 };
+                    while (SIGPIPE == ::sigtimedwait(&sigpipe_set, nullptr, &no_wait))
+                        ;
+                    input_refused = true;
+                    break;
+                }
                 else if (-1 == w)
                     throw ProcessError("write() send_input_to_fd_pipe write_fd failed");
                 else
                     input_stream_pending.erase(0, w);
             }
 
-            if (input_stream_pending.empty() && ! send_input_to_fd->good())
+            if (input_refused || (input_stream_pending.empty() && ! send_input_to_fd->good()))
             {
                 if (0 != ::close(send_input_to_fd_pipe->write_fd()))
                     throw ProcessError("close() send_input_to_fd_pipe write_fd failed");
@@ -1208,6 +1226,14 @@ Process::run()
             throw ProcessError(error);
         }
 
+        /* likewise for the read end of its input, so that if it stops
+         * reading, we find out rather than filling up the pipe */
+        if (thread && thread->send_input_to_fd_pipe)
+        {
+            close(thread->send_input_to_fd_pipe->read_fd());
+            thread->send_input_to_fd_pipe->clear_read_fd();
+        }
+
         if (thread)
             thread->start();
         return RunningProcessHandle(_imp->as_main_process ? 0 : child, std::move(thread));
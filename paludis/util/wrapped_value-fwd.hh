@@ -31,6 +31,12 @@ namespace paludis
     template <typename Tag_>
     struct WrappedValueTraits;
 
+    template <typename Tag_>
+    struct WrappedValueInterned;
+
+    template <typename Type_>
+    struct WrappedValueInternedEntry;
+
     template <typename Type_>
     struct WrappedValueDevoid;
 
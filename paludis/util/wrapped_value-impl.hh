@@ -21,7 +21,10 @@
 #define PALUDIS_GUARD_PALUDIS_UTIL_WRAPPED_VALUE_IMPL_HH 1
 
 #include <paludis/util/wrapped_value.hh>
+#include <paludis/util/hashes.hh>
 #include <ostream>
+#include <mutex>
+#include <unordered_map>
 
 namespace paludis
 {
@@ -42,15 +45,108 @@ namespace paludis
         }
     };
 
+    namespace wrapped_value_internals
+    {
+        template <typename Tag_, bool interned_>
+        struct Storage;
+
+        template <typename Tag_>
+        struct Storage<Tag_, false>
+        {
+            typedef typename WrappedValueTraits<Tag_>::UnderlyingType UnderlyingType;
+            typedef typename WrappedValueDevoid<typename WrappedValueTraits<Tag_>::ValidationParamsType>::Type ParamsType;
+            typedef std::shared_ptr<const UnderlyingType> Type;
+
+            static Type make(const UnderlyingType & v, const ParamsType & p)
+            {
+                if (WrappedValueValidate<Tag_, typename WrappedValueTraits<Tag_>::ValidationParamsType>::Type::validate(v, p))
+                    return std::make_shared<UnderlyingType>(v);
+                else
+                    throw typename WrappedValueTraits<Tag_>::ExceptionType(v);
+            }
+
+            static const UnderlyingType & value(const Type & t)
+            {
+                return *t;
+            }
+
+            static std::size_t hash(const Type & t)
+            {
+                return Hash<UnderlyingType>()(*t);
+            }
+
+            static bool equal(const Type & a, const Type & b)
+            {
+                return a == b || *a == *b;
+            }
+
+            static bool less(const Type & a, const Type & b)
+            {
+                return a != b && *a < *b;
+            }
+        };
+
+        template <typename Tag_>
+        struct Storage<Tag_, true>
+        {
+            typedef typename WrappedValueTraits<Tag_>::UnderlyingType UnderlyingType;
+            typedef typename WrappedValueDevoid<typename WrappedValueTraits<Tag_>::ValidationParamsType>::Type ParamsType;
+            typedef WrappedValueInternedEntry<UnderlyingType> Entry;
+            typedef const Entry * Type;
+            typedef std::unordered_map<UnderlyingType, std::unique_ptr<const Entry>, Hash<UnderlyingType> > Table;
+
+            static Type make(const UnderlyingType & v, const ParamsType & p)
+            {
+                /* deliberately never freed, so that interned values outlive
+                 * any static WrappedValue that refers to them */
+                static std::mutex * const mutex(new std::mutex);
+                static Table * const table(new Table);
+
+                {
+                    std::unique_lock<std::mutex> lock(*mutex);
+                    typename Table::const_iterator i(table->find(v));
+                    if (i != table->end())
+                        return i->second.get();
+                }
+
+                if (! WrappedValueValidate<Tag_, typename WrappedValueTraits<Tag_>::ValidationParamsType>::Type::validate(v, p))
+                    throw typename WrappedValueTraits<Tag_>::ExceptionType(v);
+
+                std::unique_lock<std::mutex> lock(*mutex);
+                std::unique_ptr<const Entry> & e((*table)[v]);
+                if (! e)
+                    e.reset(new Entry{ v, Hash<UnderlyingType>()(v) });
+                return e.get();
+            }
+
+            static const UnderlyingType & value(const Type & t)
+            {
+                return t->value;
+            }
+
+            static std::size_t hash(const Type & t)
+            {
+                return t->hash;
+            }
+
+            static bool equal(const Type & a, const Type & b)
+            {
+                return a == b;
+            }
+
+            static bool less(const Type & a, const Type & b)
+            {
+                return a != b && a->value < b->value;
+            }
+        };
+    }
+
     template <typename Tag_>
     WrappedValue<Tag_>::WrappedValue(
             const typename WrappedValueTraits<Tag_>::UnderlyingType & v,
-            const typename WrappedValueDevoid<typename WrappedValueTraits<Tag_>::ValidationParamsType>::Type & p)
+            const typename WrappedValueDevoid<typename WrappedValueTraits<Tag_>::ValidationParamsType>::Type & p) :
+        _value(wrapped_value_internals::Storage<Tag_, WrappedValueInterned<Tag_>::value>::make(v, p))
     {
-        if (WrappedValueValidate<Tag_, typename WrappedValueTraits<Tag_>::ValidationParamsType>::Type::validate(v, p))
-            _value = std::make_shared<typename WrappedValueTraits<Tag_>::UnderlyingType>(v);
-        else
-            throw typename WrappedValueTraits<Tag_>::ExceptionType(v);
     }
 
     template <typename Tag_>
@@ -65,14 +161,14 @@ namespace paludis
     bool
     WrappedValue<Tag_>::WrappedValue::operator< (const WrappedValue & other) const
     {
-        return value() < other.value();
+        return wrapped_value_internals::Storage<Tag_, WrappedValueInterned<Tag_>::value>::less(_value, other._value);
     }
 
     template <typename Tag_>
     bool
     WrappedValue<Tag_>::WrappedValue::operator== (const WrappedValue & other) const
     {
-        return value() == other.value();
+        return wrapped_value_internals::Storage<Tag_, WrappedValueInterned<Tag_>::value>::equal(_value, other._value);
     }
 
     template <typename Tag_>
@@ -88,7 +184,14 @@ namespace paludis
     const typename WrappedValueTraits<Tag_>::UnderlyingType &
     WrappedValue<Tag_>::value() const
     {
-        return *_value;
+        return wrapped_value_internals::Storage<Tag_, WrappedValueInterned<Tag_>::value>::value(_value);
+    }
+
+    template <typename Tag_>
+    std::size_t
+    WrappedValue<Tag_>::hash() const
+    {
+        return wrapped_value_internals::Storage<Tag_, WrappedValueInterned<Tag_>::value>::hash(_value);
     }
 
     template <typename Tag_>
@@ -24,6 +24,8 @@
 #include <paludis/util/no_type.hh>
 #include <paludis/util/operators.hh>
 #include <memory>
+#include <type_traits>
+#include <cstddef>
 
 namespace paludis
 {
@@ -39,12 +41,49 @@ namespace paludis
         typedef NoType<0u> * Type;
     };
 
+    /**
+     * Specialise to std::true_type to make every distinct value of a
+     * WrappedValue<Tag_> share a single, never freed, interned copy.
+     *
+     * Interned values are validated only once, copies are a single pointer,
+     * and equality and hashing do not need to look at the underlying value.
+     * Only sensible for tags whose ValidationParamsType is void, and whose
+     * set of distinct values is small, such as names.
+     *
+     * \since 3.0
+     */
+    template <typename Tag_>
+    struct WrappedValueInterned :
+        std::false_type
+    {
+    };
+
+    /**
+     * The shared copy of an interned WrappedValue.
+     *
+     * \since 3.0
+     */
+    template <typename Type_>
+    struct WrappedValueInternedEntry
+    {
+        const Type_ value;
+        const std::size_t hash;
+    };
+
+    template <typename Tag_>
+    struct WrappedValueStorage
+    {
+        typedef typename std::conditional<WrappedValueInterned<Tag_>::value,
+                const WrappedValueInternedEntry<typename WrappedValueTraits<Tag_>::UnderlyingType> *,
+                std::shared_ptr<const typename WrappedValueTraits<Tag_>::UnderlyingType> >::type Type;
+    };
+
     template <typename Tag_>
     class PALUDIS_VISIBLE WrappedValue :
         public relational_operators::HasRelationalOperators
     {
         private:
-            std::shared_ptr<const typename WrappedValueTraits<Tag_>::UnderlyingType> _value;
+            typename WrappedValueStorage<Tag_>::Type _value;
 
         public:
             explicit WrappedValue(
@@ -58,6 +97,8 @@ namespace paludis
 
             const typename WrappedValueTraits<Tag_>::UnderlyingType & value() const PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            std::size_t hash() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
             bool operator< (const WrappedValue &) const PALUDIS_ATTRIBUTE((warn_unused_result));
             bool operator== (const WrappedValue &) const PALUDIS_ATTRIBUTE((warn_unused_result));
     };
@@ -44,6 +44,17 @@ namespace
         {
         }
     };
+
+    typedef WrappedValue<struct VoleTag> Vole;
+
+    struct PALUDIS_VISIBLE NotAVoleError
+    {
+        NotAVoleError(const std::string &)
+        {
+        }
+    };
+
+    int vole_validations(0);
 }
 
 namespace paludis
@@ -73,6 +84,26 @@ namespace paludis
             return s == "stilton" || (s == "camembert" && ! tasty);
         }
     };
+
+    template <>
+    struct WrappedValueTraits<VoleTag>
+    {
+        typedef std::string UnderlyingType;
+        typedef void ValidationParamsType;
+        typedef NotAVoleError ExceptionType;
+
+        static bool validate(const std::string & s)
+        {
+            ++vole_validations;
+            return s == "arvicola amphibius" || s == "microtus agrestis";
+        }
+    };
+
+    template <>
+    struct WrappedValueInterned<VoleTag> :
+        std::true_type
+    {
+    };
 }
 
 TEST(Dormouse, Works)
@@ -99,3 +130,26 @@ TEST(Cheese, Works)
     ASSERT_EQ("camembert", cheese.value());
 }
 
+TEST(Vole, Interned)
+{
+    Vole water_vole("arvicola amphibius");
+    ASSERT_EQ("arvicola amphibius", water_vole.value());
+    ASSERT_EQ(1, vole_validations);
+
+    Vole another_water_vole(std::string("arvicola ") + "amphibius");
+    ASSERT_EQ(1, vole_validations);
+    ASSERT_EQ(&water_vole.value(), &another_water_vole.value());
+    ASSERT_TRUE(water_vole == another_water_vole);
+    ASSERT_EQ(Hash<std::string>()("arvicola amphibius"), Hash<Vole>()(another_water_vole));
+
+    Vole field_vole("microtus agrestis");
+    ASSERT_EQ(2, vole_validations);
+    ASSERT_TRUE(water_vole != field_vole);
+    ASSERT_TRUE(water_vole < field_vole);
+    ASSERT_FALSE(field_vole < water_vole);
+    ASSERT_FALSE(water_vole < another_water_vole);
+
+    ASSERT_THROW(Vole("rattus norvegicus"), NotAVoleError);
+    ASSERT_THROW(Vole("rattus norvegicus"), NotAVoleError);
+    ASSERT_EQ(4, vole_validations);
+}
@@ -33,6 +33,7 @@
 #include <paludis/version_spec.hh>
 #include <vector>
 #include <limits>
+#include <cstdint>
 
 using namespace paludis;
 
@@ -50,6 +51,68 @@ BadVersionSpecError::BadVersionSpecError(const std::string & name, const std::st
 
 typedef std::vector<VersionSpecComponent> Parts;
 
+namespace
+{
+    /**
+     * A pre-tokenised VersionSpecComponent, used to make comparisons cheap.
+     *
+     * Numbers with no more than max_key_digits significant digits, letters
+     * and the magic MAX value are reduced to an integer key which orders the
+     * same way the number_value does. Anything else has has_key unset, and
+     * we fall back to comparing the number_value strings.
+     */
+    struct PackedComponent
+    {
+        VersionSpecComponentType type;
+        bool has_key;
+        uint64_t key;
+    };
+
+    typedef std::vector<PackedComponent> PackedParts;
+
+    const uint64_t max_key(std::numeric_limits<uint64_t>::max());
+    const std::string::size_type max_key_digits(std::numeric_limits<uint64_t>::digits10);
+
+    uint64_t digits_to_key(const std::string & s)
+    {
+        uint64_t result(0);
+        for (char c : s)
+            result = result * 10 + (c - '0');
+        return result;
+    }
+
+    PackedComponent pack(const VersionSpecComponent & c)
+    {
+        PackedComponent result{ c.type(), true, 0 };
+        const std::string & v(c.number_value());
+
+        if (v == "MAX")
+            result.key = max_key;
+        else if (c.type() == vsct_letter)
+            result.key = static_cast<unsigned char>(v.at(0));
+        else if (c.type() == vsct_floatlike)
+        {
+            /* compared stringwise without trailing zeroes, so treat it as a
+             * fixed point fraction padded out to max_key_digits */
+            std::string f(strip_trailing(v, "0"));
+            if (f.length() > max_key_digits)
+                result.has_key = false;
+            else
+            {
+                result.key = digits_to_key(f);
+                for (std::string::size_type n(f.length()) ; n < max_key_digits ; ++n)
+                    result.key *= 10;
+            }
+        }
+        else if (v.length() > max_key_digits)
+            result.has_key = false;
+        else
+            result.key = digits_to_key(v);
+
+        return result;
+    }
+}
+
 namespace paludis
 {
     template<>
@@ -57,6 +120,7 @@ namespace paludis
     {
         std::string text;
         Parts parts;
+        PackedParts packed_parts;
 
         const VersionSpecOptions options;
 
@@ -64,6 +128,13 @@ namespace paludis
             options(o)
         {
         }
+
+        void pack_parts()
+        {
+            packed_parts.clear();
+            packed_parts.reserve(parts.size());
+            std::transform(parts.begin(), parts.end(), std::back_inserter(packed_parts), pack);
+        }
     };
 
     template <>
@@ -329,6 +400,8 @@ VersionSpec::VersionSpec(const std::string & text, const VersionSpecOptions & op
     /* trailing stuff? */
     if (! parser.eof())
         throw BadVersionSpecError(text, "unexpected trailing text '" + text.substr(parser.offset()) + "'");
+
+    _imp->pack_parts();
 }
 
 VersionSpec::VersionSpec(const VersionSpec & other) :
@@ -336,6 +409,7 @@ VersionSpec::VersionSpec(const VersionSpec & other) :
 {
     _imp->text = other._imp->text;
     _imp->parts = other._imp->parts;
+    _imp->packed_parts = other._imp->packed_parts;
 }
 
 const VersionSpec &
@@ -345,6 +419,7 @@ VersionSpec::operator= (const VersionSpec & other)
     {
         _imp->text = other._imp->text;
         _imp->parts = other._imp->parts;
+        _imp->packed_parts = other._imp->packed_parts;
     }
     return *this;
 }
@@ -353,34 +428,74 @@ VersionSpec::~VersionSpec() = default;
 
 namespace
 {
+    int compare_number_values(const VersionSpecComponent & p1, const VersionSpecComponent & p2)
+    {
+        std::string p1s(p1.number_value()), p2s(p2.number_value());
+        if (p1.type() == vsct_floatlike)
+        {
+            p1s = strip_trailing(p1s, "0");
+            p2s = strip_trailing(p2s, "0");
+        }
+
+        /* _suffix-scm? */
+        if (p1s == "MAX" && p2s == "MAX")
+            return 0;
+        else if (p1s == "MAX")
+            return 1;
+        else if (p2s == "MAX")
+            return -1;
+
+        /* common part */
+        if (p1.type() != vsct_floatlike)
+        {
+            /* length compare (integers) */
+            int c = p1s.size() - p2s.size();
+            if (c < 0)
+                return -1;
+            else if (c > 0)
+                return 1;
+        }
+
+        /* stringwise compare (also for integers with the same size) */
+        int c(p1s.compare(p2s));
+        return c < 0 ? -1 : c > 0 ? 1 : 0;
+    }
+
     template <typename R_>
     R_
-    componentwise_compare(const Parts & a, const Parts & b,
+    componentwise_compare(const Parts & a, const PackedParts & a_packed, const Parts & b, const PackedParts & b_packed,
             std::pair<R_, bool> (*comparator)(const VersionSpecComponent &, Parts::const_iterator, Parts::const_iterator,
                     const VersionSpecComponent &, Parts::const_iterator, Parts::const_iterator, int))
     {
         std::vector<VersionSpecComponent>::const_iterator
             v1(a.begin()), v1_end(a.end()), v2(b.begin()), v2_end(b.end());
+        PackedParts::const_iterator k1(a_packed.begin()), k2(b_packed.begin());
 
-        VersionSpecComponent end_part(make_named_values<VersionSpecComponent>(
+        static const VersionSpecComponent end_part(make_named_values<VersionSpecComponent>(
                     n::number_value() = "",
                     n::text() = "",
                     n::type() = vsct_empty
                     ));
+        static const PackedComponent end_packed{ vsct_empty, true, 0 };
+
         while (true)
         {
             const VersionSpecComponent * const p1(v1 == v1_end ? &end_part : &*v1);
             const VersionSpecComponent * const p2(v2 == v2_end ? &end_part : &*v2);
+            const PackedComponent & q1(v1 == v1_end ? end_packed : *k1);
+            const PackedComponent & q2(v2 == v2_end ? end_packed : *k2);
 
-            if (p1->type() == vsct_ignore)
+            if (q1.type == vsct_ignore)
             {
                 ++v1;
+                ++k1;
                 continue;
             }
 
-            if (p2->type() == vsct_ignore)
+            if (q2.type == vsct_ignore)
             {
                 ++v2;
+                ++k2;
                 continue;
             }
 
@@ -393,66 +508,39 @@ namespace
                     throw InternalError(PALUDIS_HERE, "comparator reached the end of the versions without deciding on a result");
             }
 
-            int compared(-2);
+            int compared;
 
-            if (p1 == &end_part && (*p2).type() == vsct_revision && (*p2).number_value() == "0")
+            if (p1 == &end_part && q2.type == vsct_revision && q2.has_key && 0 == q2.key)
                 compared = 0;
 
-            else if (p2 == &end_part && (*p1).type() == vsct_revision && (*p1).number_value() == "0")
+            else if (p2 == &end_part && q1.type == vsct_revision && q1.has_key && 0 == q1.key)
                 compared = 0;
 
-            else if ((*p1).type() < (*p2).type())
+            else if (q1.type < q2.type)
                 compared = -1;
-            else if ((*p1).type() > (*p2).type())
+            else if (q1.type > q2.type)
                 compared = 1;
 
-            else
-            {
-                std::string p1s((*p1).number_value()), p2s((*p2).number_value());
-                if ((*p1).type() == vsct_floatlike)
-                {
-                    p1s = strip_trailing(p1s, "0");
-                    p2s = strip_trailing(p2s, "0");
-                }
-
-                /* _suffix-scm? */
-                if (p1s == "MAX" && p2s == "MAX")
-                    compared = 0;
-                else if (p1s == "MAX")
-                    compared = 1;
-                else if (p2s == "MAX")
-                    compared = -1;
+            else if (q1.has_key && q2.has_key)
+                compared = q1.key < q2.key ? -1 : q1.key > q2.key ? 1 : 0;
 
-                if (compared == -2)
-                {
-                    /* common part */
-                    if ((*p1).type() != vsct_floatlike)
-                    {
-                        /* length compare (integers) */
-                        int c = p1s.size() - p2s.size();
-                        if (c < 0)
-                            compared = -1;
-                        else if (c > 0)
-                            compared = 1;
-                    }
-                }
-
-                if (compared == -2)
-                {
-                    /* stringwise compare (also for integers with the same size) */
-                    int c(p1s.compare(p2s));
-                    compared = c < 0 ? -1 : c > 0 ? 1 : 0;
-                }
-            }
+            else
+                compared = compare_number_values(*p1, *p2);
 
             std::pair<R_, bool> result(comparator(*p1, v1, v1_end, *p2, v2, v2_end, compared));
             if (result.second)
                 return result.first;
 
             if (v1_end != v1)
+            {
                 ++v1;
+                ++k1;
+            }
             if (v2_end != v2)
+            {
                 ++v2;
+                ++k2;
+            }
         }
     }
 
@@ -494,19 +582,19 @@ namespace
 int
 VersionSpec::compare(const VersionSpec & other) const
 {
-    return componentwise_compare(_imp->parts, other._imp->parts, compare_comparator);
+    return componentwise_compare(_imp->parts, _imp->packed_parts, other._imp->parts, other._imp->packed_parts, compare_comparator);
 }
 
 bool
 VersionSpec::tilde_compare(const VersionSpec & other) const
 {
-    return componentwise_compare(_imp->parts, other._imp->parts, tilde_compare_comparator);
+    return componentwise_compare(_imp->parts, _imp->packed_parts, other._imp->parts, other._imp->packed_parts, tilde_compare_comparator);
 }
 
 bool
 VersionSpec::equal_star_compare(const VersionSpec & other) const
 {
-    return componentwise_compare(_imp->parts, other._imp->parts, equal_star_compare_comparator);
+    return componentwise_compare(_imp->parts, _imp->packed_parts, other._imp->parts, other._imp->packed_parts, equal_star_compare_comparator);
 }
 
 std::size_t
@@ -590,6 +678,7 @@ VersionSpec::remove_revision() const
                 result._imp->parts.begin(),
                 result._imp->parts.end(),
                 IsVersionSpecComponentType<vsct_revision>()), result._imp->parts.end());
+    result._imp->pack_parts();
 
     std::string::size_type p;
     if (std::string::npos != ((p = result._imp->text.rfind("-r"))))
@@ -0,0 +1,157 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Times parsing, sorting and comparing VersionSpec objects.
+ *
+ * To benchmark against every version in a real tree, feed it the output of
+ * something like:
+ *
+ *     cave print-ids --format '%v\n' | version_spec_BENCHMARK -
+ *
+ * With no arguments, a synthetic set of versions is used instead.
+ */
+
+#include <paludis/version_spec.hh>
+#include <paludis/util/options.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace paludis;
+
+namespace
+{
+    const VersionSpecOptions options{ };
+
+    template <typename F_>
+    double time_ms(const F_ & f)
+    {
+        auto start(std::chrono::steady_clock::now());
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void read_versions(std::istream & s, std::vector<std::string> & result)
+    {
+        std::string line;
+        while (std::getline(s, line))
+            if (! line.empty())
+                result.push_back(line);
+    }
+
+    void make_synthetic_versions(std::vector<std::string> & result)
+    {
+        const std::vector<std::string> suffixes{ "", "_alpha", "_beta2", "_pre20260101", "_rc1", "_p3", "-r1", "-r12", "-scm" };
+
+        for (int a(0) ; a < 20 ; ++a)
+            for (int b(0) ; b < 25 ; ++b)
+                for (const auto & s : suffixes)
+                {
+                    result.push_back(std::to_string(a) + "." + std::to_string(b) + s);
+                    result.push_back(std::to_string(a) + ".0" + std::to_string(b) + "." + std::to_string(a * b) + "b" + s);
+                }
+
+        result.push_back("1.2.3.4.5.6.7.8.9.10.11.12");
+        result.push_back("20260101123456789012345678");
+        result.push_back("9999");
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    std::vector<std::string> strings;
+
+    for (int i(1) ; i < argc ; ++i)
+    {
+        if (std::string(argv[i]) == "-")
+            read_versions(std::cin, strings);
+        else
+        {
+            std::ifstream f(argv[i]);
+            if (! f)
+            {
+                std::cerr << argv[0] << ": cannot read '" << argv[i] << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+            read_versions(f, strings);
+        }
+    }
+
+    if (strings.empty())
+        make_synthetic_versions(strings);
+
+    std::vector<VersionSpec> versions;
+    versions.reserve(strings.size());
+    unsigned bad(0);
+
+    double parse_ms(time_ms([&] () {
+                for (const auto & s : strings)
+                {
+                    try
+                    {
+                        versions.push_back(VersionSpec(s, options));
+                    }
+                    catch (const BadVersionSpecError &)
+                    {
+                        ++bad;
+                    }
+                }
+            }));
+
+    std::vector<VersionSpec> sorted(versions);
+    double sort_ms(time_ms([&] () {
+                std::sort(sorted.begin(), sorted.end());
+            }));
+
+    /* pairwise compare against a sliding window, which is roughly what
+     * BestVersionOnly and range matching do */
+    const std::size_t window(std::min<std::size_t>(64, versions.size()));
+    long compares(0), less(0);
+    double compare_ms(time_ms([&] () {
+                for (std::size_t i(0) ; i < versions.size() ; ++i)
+                    for (std::size_t j(0) ; j < window ; ++j)
+                    {
+                        less += versions[i] < versions[(i + j) % versions.size()];
+                        ++compares;
+                    }
+            }));
+
+    long tilde(0);
+    double tilde_ms(time_ms([&] () {
+                for (std::size_t i(0) ; i < versions.size() ; ++i)
+                    for (std::size_t j(0) ; j < window ; ++j)
+                        tilde += versions[i].tilde_compare(versions[(i + j) % versions.size()]);
+            }));
+
+    std::cout << "versions:        " << versions.size() << " (" << bad << " unparseable)" << std::endl;
+    std::cout << "parse:           " << parse_ms << " ms" << std::endl;
+    std::cout << "sort:            " << sort_ms << " ms" << std::endl;
+    std::cout << "compare:         " << compare_ms << " ms for " << compares << " compares ("
+        << (compares ? compare_ms * 1000000.0 / compares : 0) << " ns each, " << less << " less)" << std::endl;
+    std::cout << "tilde_compare:   " << tilde_ms << " ms (" << tilde << " matched)" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
@@ -431,6 +431,23 @@ TEST(VersionSpec, Ordering)
     }
 }
 
+TEST(VersionSpec, BigNumbers)
+{
+    ASSERT_TRUE(VersionSpec("9999999999999999999", { }) < VersionSpec("10000000000000000000", { }));
+    ASSERT_TRUE(VersionSpec("10000000000000000000", { }) < VersionSpec("10000000000000000001", { }));
+    ASSERT_TRUE(VersionSpec("18446744073709551615", { }) < VersionSpec("18446744073709551616", { }));
+    ASSERT_TRUE(VersionSpec("000018446744073709551616", { }) == VersionSpec("18446744073709551616", { }));
+    ASSERT_TRUE(VersionSpec("1_pre99999999999999999999", { }) < VersionSpec("1_pre-scm", { }));
+    ASSERT_TRUE(VersionSpec("1_pre9999999999999999999", { }) < VersionSpec("1_pre99999999999999999999", { }));
+    ASSERT_TRUE(VersionSpec("1-r99999999999999999999", { }) > VersionSpec("1-r9", { }));
+
+    ASSERT_TRUE(VersionSpec("1.0000000000000000000001", { }) < VersionSpec("1.000000000000000000001", { }));
+    ASSERT_TRUE(VersionSpec("1.0000000000000000000001", { }) < VersionSpec("1.01", { }));
+    ASSERT_TRUE(VersionSpec("1.0000000000000000000001000", { }) == VersionSpec("1.0000000000000000000001", { }));
+    ASSERT_TRUE(VersionSpec("1.099999999999999999999", { }) < VersionSpec("1.1", { }));
+    ASSERT_TRUE(VersionSpec("1.0999999999999999999999", { }) > VersionSpec("1.099", { }));
+}
+
 TEST(VersionSpec, Components)
 {
     VersionSpec v1("1.2x_pre3_rc-scm", { });
@@ -46,6 +46,8 @@
 #include <paludis/util/executor.hh>
 #include <paludis/util/timestamp.hh>
 #include <paludis/util/process.hh>
+#include <paludis/util/env_var_names.hh>
+#include <paludis/util/fs_error.hh>
 #include <paludis/resolver/resolutions_by_resolvent.hh>
 #include <paludis/resolver/reason.hh>
 #include <paludis/resolver/sanitised_dependencies.hh>
@@ -87,6 +89,11 @@
 #include <algorithm>
 #include <unordered_map>
 #include <mutex>
+#include <vector>
+#include <cstring>
+
+#include <unistd.h>
+#include <errno.h>
 
 using namespace paludis;
 using namespace cave;
@@ -1153,6 +1160,8 @@ namespace
         const ExecuteResolutionCommandLine & cmdline;
         Executor & executor;
         const int n_fetch_jobs;
+        const int n_install_jobs;
+        const JobNumber job_number;
         const std::shared_ptr<ExecuteJob> job;
         const std::shared_ptr<JobLists> lists;
         JobRequirementIf require_if;
@@ -1161,29 +1170,36 @@ namespace
         int local_retcode;
         ExecuteCounts & counts;
         std::string & old_heading;
+        int & installs_running;
+        const double install_load_limit;
 
         Timestamp last_flushed, last_output;
 
         std::recursive_mutex job_mutex;
 
-        bool want, already_done;
+        bool want, already_done, counted_as_running;
 
         ExecuteJobExecutive(
                 const std::shared_ptr<Environment> & e,
                 const ExecuteResolutionCommandLine & c,
                 Executor & x,
                 const int n,
+                const int i,
+                const JobNumber jn,
                 const std::shared_ptr<ExecuteJob> & j,
                 const std::shared_ptr<JobLists> & l,
                 JobRequirementIf r,
                 std::mutex & m,
                 int & rc,
                 ExecuteCounts & k,
-                std::string & h) :
+                std::string & h,
+                int & ir) :
             env(e),
             cmdline(c),
             executor(x),
             n_fetch_jobs(n),
+            n_install_jobs(i),
+            job_number(jn),
             job(j),
             lists(l),
             require_if(r),
@@ -1192,10 +1208,14 @@ namespace
             local_retcode(0),
             counts(k),
             old_heading(h),
+            installs_running(ir),
+            install_load_limit(c.execution_options.a_install_load_limit.specified() ?
+                    destringify<double>(c.execution_options.a_install_load_limit.argument()) : 0.0),
             last_flushed(Timestamp::now()),
             last_output(last_flushed),
             want(true),
-            already_done(false)
+            already_done(false),
+            counted_as_running(false)
         {
         }
 
@@ -1226,8 +1246,50 @@ namespace
                 );
         }
 
+        static bool finished(const std::shared_ptr<const JobState> & state)
+        {
+            return state->make_accept_returning(
+                    [&] (const JobSkippedState &)   { return true; },
+                    [&] (const JobPendingState &)   { return false; },
+                    [&] (const JobActiveState &)    { return false; },
+                    [&] (const JobSucceededState &) { return true; },
+                    [&] (const JobFailedState &)    { return true; }
+                    );
+        }
+
+        bool can_run_concurrently() const
+        {
+            /* anything we depend upon must be done. requirements on later jobs
+             * come from cycles that we broke, and are ignored when running
+             * sequentially too. */
+            for (const auto & requirement : *job->requirements())
+                if (requirement.job_number() < job_number &&
+                        ! finished((*lists->execute_job_list()->fetch(requirement.job_number()))->state()))
+                    return false;
+
+            /* we don't try to work out what an uninstall might break, so
+             * uninstalls act as barriers */
+            const bool is_uninstall(visitor_cast<const UninstallJob>(*job));
+            for (auto j(lists->execute_job_list()->begin()) ; j != lists->execute_job_list()->fetch(job_number) ; ++j)
+                if ((is_uninstall ? ! visitor_cast<const FetchJob>(**j) : bool(visitor_cast<const UninstallJob>(**j)))
+                        && ! finished((*j)->state()))
+                    return false;
+
+            if (0 != installs_running && cmdline.execution_options.a_install_load_limit.specified())
+            {
+                double load;
+                if (1 == ::getloadavg(&load, 1) && load >= install_load_limit)
+                    return false;
+            }
+
+            return true;
+        }
+
         bool can_run() const override
         {
+            if (1 != n_install_jobs && ! visitor_cast<const FetchJob>(*job))
+                return can_run_concurrently();
+
             for (const auto & requirement : *job->requirements())
             {
                 if (! requirement.required_if()[jri_fetching])
@@ -1305,6 +1367,9 @@ namespace
                                 },
 
                                 [&] (const JobActiveState &) -> bool {
+                                    /* when running concurrently, this can happen for the same reason as above */
+                                    if (1 != n_install_jobs)
+                                        return true;
                                     throw InternalError(PALUDIS_HERE, "still active? how did that happen?");
                                 },
 
@@ -1328,6 +1393,12 @@ namespace
 
             if (want)
             {
+                if (! visitor_cast<const FetchJob>(*job))
+                {
+                    ++installs_running;
+                    counted_as_running = true;
+                }
+
                 ExecuteOneVisitor execute(env, cmdline, n_fetch_jobs, counts, job_mutex, executor.exclusivity_mutex(), x1_pre, local_retcode);
                 int job_retcode(job->accept_returning<int>(execute));
                 local_retcode |= job_retcode;
@@ -1418,6 +1489,9 @@ namespace
 
         void post_execute_exclusive() override
         {
+            if (counted_as_running)
+                --installs_running;
+
             if (want)
             {
                 ExecuteOneVisitor execute(env, cmdline, n_fetch_jobs, counts, job_mutex, executor.exclusivity_mutex(), x1_post, local_retcode);
@@ -1447,11 +1521,52 @@ namespace
         }
     };
 
+    /* names a file that our install processes lock whilst merging, so that
+     * concurrent installs don't merge over each other. it's created using
+     * mkstemp, so that nobody else can make it first and hold the lock. */
+    FSPath make_merge_lock_file()
+    {
+        std::string name(getenv_with_default("TMPDIR", "/tmp") + "/cave-merge-lock.XXXXXX");
+        std::vector<char> buf(name.begin(), name.end());
+        buf.push_back('\0');
+
+        int fd(::mkstemp(buf.data()));
+        if (-1 == fd)
+            throw FSError("Couldn't create merge lock file from template '" + name + "': " + ::strerror(errno));
+        ::close(fd);
+
+        return FSPath(buf.data());
+    }
+
+    struct MergeLockFile
+    {
+        const FSPath path;
+
+        MergeLockFile() :
+            path(make_merge_lock_file())
+        {
+            ::setenv(env_vars::merge_lock_file.c_str(), stringify(path).c_str(), 1);
+        }
+
+        ~MergeLockFile()
+        {
+            ::unsetenv(env_vars::merge_lock_file.c_str());
+            try
+            {
+                path.unlink();
+            }
+            catch (const FSError &)
+            {
+            }
+        }
+    };
+
     int execute_executions(
             const std::shared_ptr<Environment> & env,
             const std::shared_ptr<JobLists> & lists,
             const ExecuteResolutionCommandLine & cmdline,
-            const int n_fetch_jobs)
+            const int n_fetch_jobs,
+            const int n_install_jobs)
     {
         int retcode(0);
         std::mutex retcode_mutex;
@@ -1481,10 +1596,19 @@ namespace
 
         Executor executor(100);
 
+        std::shared_ptr<MergeLockFile> merge_lock_file;
+        if (1 != n_install_jobs)
+        {
+            executor.set_queue_limit("execute", n_install_jobs);
+            merge_lock_file = std::make_shared<MergeLockFile>();
+        }
+
         std::string old_heading;
+        int installs_running(0);
+        JobNumber job_number(0);
         for (const auto & job : *lists->execute_job_list())
-            executor.add(std::make_shared<ExecuteJobExecutive>(env, cmdline, executor, n_fetch_jobs, job, lists, require_if, retcode_mutex,
-                            retcode, counts, old_heading));
+            executor.add(std::make_shared<ExecuteJobExecutive>(env, cmdline, executor, n_fetch_jobs, n_install_jobs, job_number++,
+                            job, lists, require_if, retcode_mutex, retcode, counts, old_heading, installs_running));
 
         executor.execute();
 
@@ -1500,7 +1624,8 @@ namespace
             const std::shared_ptr<Environment> & env,
             const std::shared_ptr<JobLists> & lists,
             const ExecuteResolutionCommandLine & cmdline,
-            const int n_fetch_jobs)
+            const int n_fetch_jobs,
+            const int n_install_jobs)
     {
         for (const auto & job : *lists->execute_job_list())
             if (! job->state())
@@ -1512,7 +1637,7 @@ namespace
         if (0 != retcode || cmdline.a_pretend.specified())
             return retcode;
 
-        retcode |= execute_executions(env, lists, cmdline, n_fetch_jobs);
+        retcode |= execute_executions(env, lists, cmdline, n_fetch_jobs, n_install_jobs);
 
         if (0 != retcode)
             return retcode;
@@ -1655,7 +1780,8 @@ namespace
             const std::shared_ptr<Environment> & env,
             const std::shared_ptr<JobLists> & lists,
             const ExecuteResolutionCommandLine & cmdline,
-            const int n_fetch_jobs)
+            const int n_fetch_jobs,
+            const int n_install_jobs)
     {
         Context context("When executing chosen resolution:");
 
@@ -1667,7 +1793,7 @@ namespace
 
         try
         {
-            retcode = execute_resolution_main(env, lists, cmdline, n_fetch_jobs);
+            retcode = execute_resolution_main(env, lists, cmdline, n_fetch_jobs, n_install_jobs);
         }
         catch (...)
         {
@@ -1743,7 +1869,51 @@ ExecuteResolutionCommand::run(
     else
         n_fetch_jobs = 1;
 
-    return execute_resolution(env, lists, cmdline, n_fetch_jobs);
+    int n_install_jobs(1);
+    if (cmdline.execution_options.a_install_jobs.specified() && ! cmdline.execution_options.a_fetch.specified())
+    {
+        n_install_jobs = cmdline.execution_options.a_install_jobs.argument();
+        if (n_install_jobs < 1)
+            throw args::DoHelp("Argument to '--" + cmdline.execution_options.a_install_jobs.long_name() + "' must be at least 1");
+
+        /* fetches can't be interleaved with installs that aren't in order */
+        if (1 != n_install_jobs && 0 == n_fetch_jobs)
+            n_fetch_jobs = 1;
+    }
+
+    if (cmdline.execution_options.a_install_load_limit.specified())
+    {
+        double limit(0.0);
+        try
+        {
+            limit = destringify<double>(cmdline.execution_options.a_install_load_limit.argument());
+        }
+        catch (const DestringifyError &)
+        {
+        }
+
+        if (! (limit > 0.0))
+            throw args::DoHelp("Argument to '--" + cmdline.execution_options.a_install_load_limit.long_name()
+                    + "' must be a positive number");
+    }
+
+    /* installs and merges happen in child processes, so they get told via the
+     * environment */
+    if (cmdline.execution_options.a_merge_jobs.specified())
+    {
+        if (cmdline.execution_options.a_merge_jobs.argument() < 1)
+            throw args::DoHelp("Argument to '--" + cmdline.execution_options.a_merge_jobs.long_name() + "' must be at least 1");
+        ::setenv(env_vars::merge_jobs.c_str(), stringify(cmdline.execution_options.a_merge_jobs.argument()).c_str(), 1);
+    }
+
+    if (cmdline.execution_options.a_strip_jobs.specified())
+    {
+        if (cmdline.execution_options.a_strip_jobs.argument() < 1)
+            throw args::DoHelp("Argument to '--" + cmdline.execution_options.a_strip_jobs.long_name() + "' must be at least 1");
+        ::setenv(env_vars::strip_jobs.c_str(), stringify(cmdline.execution_options.a_strip_jobs.argument()).c_str(), 1);
+    }
+
+    return execute_resolution(env, lists, cmdline, n_fetch_jobs, n_install_jobs);
 }
 
 int
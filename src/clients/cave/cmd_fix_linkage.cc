@@ -240,7 +240,7 @@ FixLinkageCommand::run(const std::shared_ptr<Environment> & env,
     }
 
     return resolve_common(env, resolve_cmdline.resolution_options, resolve_cmdline.execution_options, resolve_cmdline.display_options, resolve_cmdline.graph_jobs_options,
-                          resolve_cmdline.program_options, nullptr, targets, nullptr, false);
+                          resolve_cmdline.program_options, nullptr, targets, nullptr, false, nullptr);
 }
 
 std::shared_ptr<args::ArgsHandler>
@@ -314,7 +314,7 @@ ImportCommand::run(
             resolve_cmdline.display_options,
             resolve_cmdline.graph_jobs_options,
             resolve_cmdline.program_options,
-            keys, targets, world_specs, false);
+            keys, targets, world_specs, false, nullptr);
 }
 
 std::shared_ptr<args::ArgsHandler>
@@ -107,7 +107,7 @@ PurgeCommand::run(
     cmdline.resolution_options->a_purge.add_argument("*/*");
 
     return resolve_common(env, *cmdline.resolution_options, *cmdline.execution_options, *cmdline.display_options,
-            *cmdline.graph_jobs_options, *cmdline.program_options, nullptr, nullptr, nullptr, true);
+            *cmdline.graph_jobs_options, *cmdline.program_options, nullptr, nullptr, nullptr, true, nullptr);
 }
 
 std::shared_ptr<args::ArgsHandler>
@@ -21,13 +21,26 @@
 #include "resolve_cmdline.hh"
 #include "resolve_common.hh"
 
+#include <paludis/args/do_help.hh>
+#include <paludis/resolver/query_cache.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/tokeniser.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/join.hh>
+
 #include <iostream>
 #include <cstdlib>
+#include <memory>
+#include <list>
 
 using namespace paludis;
+using namespace paludis::resolver;
 using namespace cave;
 
 using std::cout;
+using std::cerr;
 using std::endl;
 
 namespace
@@ -41,16 +54,25 @@ namespace
         ResolveCommandLineGraphJobsOptions graph_jobs_options;
         ResolveCommandLineProgramOptions program_options;
 
+        args::ArgsGroup g_batch_options;
+        args::StringArg a_batch;
+
         ResolveCommandLine() :
             resolution_options(this),
             execution_options(this),
             display_options(this),
             graph_jobs_options(this),
-            program_options(this)
+            program_options(this),
+            g_batch_options(main_options_section(), "Batch Options", "Options for resolving many target lists at once."),
+            a_batch(&g_batch_options, "batch", '\0', "Read target lists, one per line, from the specified file (or "
+                    "standard input, if '-'), and resolve each one in turn, sharing the environment and loaded "
+                    "metadata between them. Blank lines and lines starting with '#' are ignored. Cannot be used "
+                    "with --execute, --execute-resolution-program or with targets on the command line.")
         {
             add_usage_line("[ -x|--execute ] [ -z|--lazy or -c|--complete or -e|--everything ] spec ...");
             add_usage_line("[ -x|--execute ] [ -z|--lazy or -c|--complete or -e|--everything ] set");
             add_usage_line("[ -x|--execute ] !spec ...");
+            add_usage_line("--batch file");
         }
 
         std::string app_name() const override
@@ -71,6 +93,55 @@ namespace
                 "resolution.";
         }
     };
+
+    int resolve_batch(
+            const std::shared_ptr<Environment> & env,
+            const ResolveCommandLine & cmdline,
+            std::istream & input)
+    {
+        /* nothing is executed in batch mode, so the environment stays put
+         * and every request uses the same options. that lets the requests
+         * share the resolver's selection and match caches. */
+        const std::shared_ptr<QueryCache> query_cache(std::make_shared<QueryCache>(env.get()));
+
+        int retcode(0), request(0);
+        std::string line;
+        while (std::getline(input, line))
+        {
+            std::shared_ptr<Sequence<std::pair<std::string, std::string> > > targets(std::make_shared<Sequence<std::pair<std::string, std::string> >>());
+            std::list<std::string> tokens;
+            tokenise_whitespace(line, std::back_inserter(tokens));
+            if (tokens.empty() || '#' == tokens.begin()->at(0))
+                continue;
+
+            for (const auto & token : tokens)
+                targets->push_back(std::make_pair(token, ""));
+
+            cout << "Request " << ++request << ": " << join(tokens.begin(), tokens.end(), " ") << endl;
+
+            /* each request gets a fresh Resolver, but the environment, and
+             * so everything its repositories have already loaded, is shared,
+             * as are the answers to the resolver's queries */
+            int request_retcode(0);
+            try
+            {
+                request_retcode = resolve_common(env, cmdline.resolution_options, cmdline.execution_options, cmdline.display_options,
+                        cmdline.graph_jobs_options, cmdline.program_options, nullptr, targets, nullptr, false, query_cache);
+            }
+            catch (const Exception & e)
+            {
+                cout << endl;
+                cerr << "Error:" << endl;
+                cerr << "  * " << e.backtrace("\n  * ") << e.message() << " (" << e.what() << ")" << endl;
+                request_retcode = EXIT_FAILURE;
+            }
+
+            cout << "Request " << request << " result: " << request_retcode << endl << endl;
+            retcode |= request_retcode;
+        }
+
+        return retcode;
+    }
 }
 
 int
@@ -91,13 +162,31 @@ ResolveCommand::run(
     cmdline.resolution_options.apply_shortcuts();
     cmdline.resolution_options.verify(env);
 
+    if (cmdline.a_batch.specified())
+    {
+        if (cmdline.resolution_options.a_execute.specified())
+            throw args::DoHelp("--" + cmdline.a_batch.long_name() + " cannot be used with --"
+                    + cmdline.resolution_options.a_execute.long_name());
+        if (cmdline.program_options.a_execute_resolution_program.specified())
+            throw args::DoHelp("--" + cmdline.a_batch.long_name() + " cannot be used with --"
+                    + cmdline.program_options.a_execute_resolution_program.long_name());
+        if (cmdline.begin_parameters() != cmdline.end_parameters())
+            throw args::DoHelp("--" + cmdline.a_batch.long_name() + " cannot be used with targets on the command line");
+
+        if (cmdline.a_batch.argument() == "-")
+            return resolve_batch(env, cmdline, std::cin);
+
+        SafeIFStream input(FSPath(cmdline.a_batch.argument()));
+        return resolve_batch(env, cmdline, input);
+    }
+
     std::shared_ptr<Sequence<std::pair<std::string, std::string> > > targets(std::make_shared<Sequence<std::pair<std::string, std::string> >>());
     for (ResolveCommandLine::ParametersConstIterator p(cmdline.begin_parameters()), p_end(cmdline.end_parameters()) ;
             p != p_end ; ++p)
         targets->push_back(std::make_pair(*p, ""));
 
     return resolve_common(env, cmdline.resolution_options, cmdline.execution_options, cmdline.display_options,
-            cmdline.graph_jobs_options, cmdline.program_options, nullptr, targets, nullptr, false);
+            cmdline.graph_jobs_options, cmdline.program_options, nullptr, targets, nullptr, false, nullptr);
 }
 
 std::shared_ptr<args::ArgsHandler>
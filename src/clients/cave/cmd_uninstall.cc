@@ -178,7 +178,7 @@ UninstallCommand::run(
     }
 
     return resolve_common(env, *cmdline.resolution_options, *cmdline.execution_options, *cmdline.display_options,
-            *cmdline.graph_jobs_options, *cmdline.program_options, nullptr, targets, targets_cleaned_up, false);
+            *cmdline.graph_jobs_options, *cmdline.program_options, nullptr, targets, targets_cleaned_up, false, nullptr);
 }
 
 std::shared_ptr<args::ArgsHandler>
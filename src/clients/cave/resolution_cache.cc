@@ -0,0 +1,308 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "resolution_cache.hh"
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/make_shared_copy.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_iterator.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/sha256.hh>
+#include <paludis/util/visitor_cast.hh>
+#include <paludis/util/log.hh>
+#include <paludis/resolver/resolved.hh>
+#include <paludis/environment.hh>
+#include <paludis/repository.hh>
+#include <paludis/metadata_key.hh>
+#include <paludis/package_id.hh>
+#include <paludis/generator.hh>
+#include <paludis/selection.hh>
+#include <paludis/filtered_generator.hh>
+#include <paludis/serialise-impl.hh>
+#include <paludis/about.hh>
+
+#include <sstream>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+using namespace paludis;
+using namespace paludis::resolver;
+using namespace cave;
+
+namespace
+{
+    const std::string cache_magic("paludis-resolution-cache");
+
+    std::string digest(const std::string & s)
+    {
+        std::istringstream stream(s);
+        return SHA256(stream).hexsum();
+    }
+
+    void add_stat(std::string & s, const FSPath & f, const FSStat & f_stat)
+    {
+        s.append(stringify(f));
+        if (f_stat.exists())
+            s.append(" " + stringify(f_stat.mtim().seconds()) + "." + stringify(f_stat.mtim().nanoseconds())
+                    + " " + stringify(f_stat.is_regular_file() ? f_stat.file_size() : 0));
+        s.append("\n");
+    }
+
+    /* a depth of -1 means everything */
+    void add_tree_times(std::string & s, const FSPath & f, const int depth)
+    {
+        FSStat f_stat(f);
+        add_stat(s, f, f_stat);
+
+        if (0 != depth && f_stat.is_directory())
+            for (FSIterator d(f, { }), d_end ; d != d_end ; ++d)
+                add_tree_times(s, *d, depth - 1);
+    }
+
+    void add_tree_contents(std::string & s, const FSPath & f)
+    {
+        FSStat f_stat(f);
+        if (f_stat.is_regular_file_or_symlink_to_regular_file())
+        {
+            SafeIFStream stream(f);
+            s.append(stringify(f) + " " + SHA256(stream).hexsum() + "\n");
+        }
+        else if (f_stat.is_directory_or_symlink_to_directory())
+        {
+            s.append(stringify(f) + "/\n");
+            for (FSIterator d(f, { }), d_end ; d != d_end ; ++d)
+                add_tree_contents(s, *d);
+        }
+        else
+            add_stat(s, f, f_stat);
+    }
+
+    std::string make_fingerprint(const std::shared_ptr<Environment> & env, const int reinstall_scm_days)
+    {
+        Context context("When working out whether anything has changed since the last resolution:");
+
+        std::string result("paludis " + stringify(PALUDIS_VERSION) + "\n");
+        result.append("distribution " + env->distribution() + "\n");
+
+        /* the configuration directory in full, and any other files the
+         * environment tells us about, which includes world */
+        for (auto k(env->begin_metadata()), k_end(env->end_metadata()) ; k != k_end ; ++k)
+        {
+            auto path_key(visitor_cast<const MetadataValueKey<FSPath> >(**k));
+            if (! path_key)
+                continue;
+
+            FSPath f(path_key->parse_value());
+            result.append((*k)->raw_name() + " " + stringify(f) + "\n");
+            if (*k == env->config_location_key() || f.stat().is_regular_file_or_symlink_to_regular_file())
+                add_tree_contents(result, f);
+        }
+
+        /* syncing or installing things changes the modification time of
+         * category and package directories, but editing an ebuild in place
+         * only changes the ebuild, which is four levels down with the exheres
+         * layout. profiles can be deep. */
+        for (const auto & repository : env->repositories())
+        {
+            result.append("repository " + stringify(repository->name()) + "\n");
+            if (repository->format_key())
+                result.append("format " + repository->format_key()->parse_value() + "\n");
+
+            if (repository->location_key())
+            {
+                FSPath location(repository->location_key()->parse_value());
+                add_tree_times(result, location, 4);
+                if ((location / "profiles").stat().is_directory())
+                    add_tree_times(result, location / "profiles", -1);
+            }
+        }
+
+        /* --reinstall-scm depends upon how long ago things were installed,
+         * which changes without anything on disk changing. we don't know
+         * which packages the resolver will consider to be scm, so we record
+         * which installed packages are old enough for any of them. */
+        if (-1 != reinstall_scm_days)
+        {
+            result.append("reinstall-scm " + stringify(reinstall_scm_days) + "\n");
+            Timestamp now(Timestamp::now());
+            for (const auto & repository : env->repositories())
+            {
+                if (! repository->installed_root_key())
+                    continue;
+
+                auto ids((*env)[selection::AllVersionsSorted(generator::InRepository(repository->name()))]);
+                for (const auto & id : *ids)
+                    if (id->installed_time_key() &&
+                            (now.seconds() - id->installed_time_key()->parse_value().seconds()) > (24 * 60 * 60 * reinstall_scm_days))
+                        result.append("old " + stringify(*id) + "\n");
+            }
+        }
+
+        return digest(result);
+    }
+
+    std::string make_fingerprint_if_possible(const std::shared_ptr<Environment> & env, const int reinstall_scm_days)
+    {
+        try
+        {
+            return make_fingerprint(env, reinstall_scm_days);
+        }
+        catch (const FSError & e)
+        {
+            Log::get_instance()->message("cave.resolution_cache.no_fingerprint", ll_warning, lc_context)
+                << "Not using the resolution cache: '" << e.message() << "' (" << e.what() << ")";
+            return "";
+        }
+    }
+}
+
+const std::shared_ptr<ResolutionCacheData>
+ResolutionCacheData::deserialise(Deserialisation & d)
+{
+    Deserialisator v(d, "ResolutionCacheData");
+
+    std::shared_ptr<Sequence<std::string> > targets(std::make_shared<Sequence<std::string>>());
+    {
+        Deserialisator vv(*v.find_remove_member("targets"), "c");
+        for (int n(1), n_end(vv.member<int>("count") + 1) ; n != n_end ; ++n)
+            targets->push_back(vv.member<std::string>(stringify(n)));
+    }
+
+    return make_shared_copy(make_named_values<ResolutionCacheData>(
+                n::resolved() = make_shared_copy(Resolved::deserialise(*v.find_remove_member("resolved"))),
+                n::target_set() = v.member<bool>("target_set"),
+                n::targets() = targets
+                ));
+}
+
+void
+ResolutionCacheData::serialise(Serialiser & s) const
+{
+    s.object("ResolutionCacheData")
+        .member(SerialiserFlags<>(), "resolved", *resolved())
+        .member(SerialiserFlags<>(), "target_set", target_set())
+        .member(SerialiserFlags<serialise::might_be_null, serialise::container>(), "targets", targets())
+        ;
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<ResolutionCache>
+    {
+        const std::shared_ptr<Environment> env;
+        const FSPath file;
+        const std::string fingerprint;
+
+        Imp(const std::shared_ptr<Environment> & e, const FSPath & d, const std::string & r, const int s) :
+            env(e),
+            file(d / (digest(r) + ".resolution")),
+            fingerprint(make_fingerprint_if_possible(e, s))
+        {
+        }
+    };
+}
+
+ResolutionCache::ResolutionCache(const std::shared_ptr<Environment> & e, const FSPath & d, const std::string & r,
+        const int s) :
+    _imp(e, d, r, s)
+{
+}
+
+ResolutionCache::~ResolutionCache() = default;
+
+const std::shared_ptr<const ResolutionCacheData>
+ResolutionCache::load() const
+{
+    Context context("When loading cached resolution from '" + stringify(_imp->file) + "':");
+
+    if (_imp->fingerprint.empty() || ! _imp->file.stat().is_regular_file())
+        return nullptr;
+
+    try
+    {
+        SafeIFStream stream(_imp->file);
+
+        std::string magic, fingerprint;
+        if (! std::getline(stream, magic) || magic != cache_magic || ! std::getline(stream, fingerprint))
+            return nullptr;
+
+        if (fingerprint != _imp->fingerprint)
+        {
+            Log::get_instance()->message("cave.resolution_cache.stale", ll_debug, lc_context)
+                << "Not using cached resolution because something has changed";
+            return nullptr;
+        }
+
+        Deserialiser deserialiser(_imp->env.get(), stream);
+        Deserialisation deserialisation("ResolutionCacheData", deserialiser);
+        return ResolutionCacheData::deserialise(deserialisation);
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("cave.resolution_cache.read_failure", ll_warning, lc_context)
+            << "Not using cached resolution: '" << e.message() << "' (" << e.what() << ")";
+        return nullptr;
+    }
+}
+
+void
+ResolutionCache::save(const ResolutionCacheData & data) const
+{
+    Context context("When saving resolution to '" + stringify(_imp->file) + "':");
+
+    if (_imp->fingerprint.empty())
+        return;
+
+    /* write to a temporary file and rename, so that a concurrent reader never
+     * sees a partial entry */
+    FSPath tmp(stringify(_imp->file) + ".tmp." + stringify(::getpid()));
+    try
+    {
+        {
+            SafeOFStream stream(tmp, O_CREAT | O_TRUNC | O_WRONLY, true);
+            stream << cache_magic << std::endl << _imp->fingerprint << std::endl;
+            Serialiser ser(stream, sf_binary);
+            data.serialise(ser);
+        }
+
+        tmp.rename(_imp->file);
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("cave.resolution_cache.write_failure", ll_warning, lc_context)
+            << "Cannot save resolution: '" << e.message() << "' (" << e.what() << ")";
+
+        try
+        {
+            tmp.unlink();
+        }
+        catch (const FSError &)
+        {
+        }
+    }
+}
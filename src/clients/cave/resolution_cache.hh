@@ -0,0 +1,99 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 the Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PALUDIS_GUARD_SRC_CLIENTS_CAVE_RESOLUTION_CACHE_HH
+#define PALUDIS_GUARD_SRC_CLIENTS_CAVE_RESOLUTION_CACHE_HH 1
+
+#include <paludis/util/named_value.hh>
+#include <paludis/util/sequence-fwd.hh>
+#include <paludis/util/fs_path-fwd.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/resolver/resolved-fwd.hh>
+#include <paludis/environment-fwd.hh>
+#include <paludis/serialise-fwd.hh>
+#include <memory>
+#include <string>
+
+namespace paludis
+{
+    namespace n
+    {
+        typedef Name<struct name_resolved> resolved;
+        typedef Name<struct name_target_set> target_set;
+        typedef Name<struct name_targets> targets;
+    }
+
+    namespace cave
+    {
+        /**
+         * What we need to carry on from a cached resolution as if we had
+         * just resolved.
+         */
+        struct ResolutionCacheData
+        {
+            NamedValue<n::resolved, std::shared_ptr<const resolver::Resolved> > resolved;
+            NamedValue<n::target_set, bool> target_set;
+            NamedValue<n::targets, std::shared_ptr<const Sequence<std::string> > > targets;
+
+            void serialise(Serialiser &) const;
+            static const std::shared_ptr<ResolutionCacheData> deserialise(
+                    Deserialisation & d) PALUDIS_ATTRIBUTE((warn_unused_result));
+        };
+
+        /**
+         * Stores resolutions in a directory, one file per distinct request,
+         * alongside a fingerprint of everything other than the request
+         * that could affect the result: the Paludis version, the
+         * environment's configuration files, the modification times of
+         * every repository's top four directory levels and profiles, and,
+         * if scm packages are to be reinstalled after a number of days, which
+         * installed packages are older than that. If the fingerprint is
+         * different, the cached resolution is not used.
+         *
+         * The fingerprint is calculated on construction, so a change made
+         * whilst we are resolving makes the cache entry stale rather than
+         * wrong.
+         */
+        class ResolutionCache
+        {
+            private:
+                Pimp<ResolutionCache> _imp;
+
+            public:
+                ResolutionCache(const std::shared_ptr<Environment> &, const FSPath & directory,
+                        const std::string & request, const int reinstall_scm_days);
+                ~ResolutionCache();
+
+                ResolutionCache(const ResolutionCache &) = delete;
+                ResolutionCache & operator= (const ResolutionCache &) = delete;
+
+                /**
+                 * Our stored resolution, or null if there is not a current
+                 * one.
+                 */
+                const std::shared_ptr<const ResolutionCacheData> load() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * Store a resolution. Failure is logged rather than thrown.
+                 */
+                void save(const ResolutionCacheData &) const;
+        };
+    }
+}
+
+#endif
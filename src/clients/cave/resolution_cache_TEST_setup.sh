@@ -0,0 +1,89 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+mkdir resolution_cache_TEST_dir || exit 1
+cd resolution_cache_TEST_dir || exit 1
+mkdir -p build cache
+
+mkdir -p config/.paludis-resolution-cache-test/repositories
+cat <<END > config/.paludis-resolution-cache-test/specpath.conf
+config-suffix =
+END
+
+cat <<END > config/.paludis-resolution-cache-test/use.conf
+*/* foo
+END
+
+cat <<END > config/.paludis-resolution-cache-test/licenses.conf
+*/* *
+END
+
+cat <<END > config/.paludis-resolution-cache-test/keywords.conf
+*/* test
+END
+
+cat <<END > config/.paludis-resolution-cache-test/general.conf
+world = `pwd`/root/world
+END
+
+cat <<END > config/.paludis-resolution-cache-test/bashrc
+export CHOST="my-chost"
+END
+
+cat <<END > config/.paludis-resolution-cache-test/repositories/repo1.conf
+location = `pwd`/repo1
+cache = /var/empty
+format = e
+names_cache = /var/empty
+profiles = \${location}/profiles/testprofile
+builddir = `pwd`/build
+END
+
+cat <<END > config/.paludis-resolution-cache-test/repositories/installed.conf
+location = `pwd`/root/var/db/pkg
+format = vdb
+names_cache = /var/empty
+builddir = `pwd`/build
+END
+
+mkdir -p root/tmp
+mkdir -p root/var/db/pkg
+mkdir -p root/${SYSCONFDIR}
+touch root/${SYSCONFDIR}/ld.so.conf
+
+mkdir -p repo1/{eclass,distfiles,profiles/testprofile,cat/{a,b}/files} || exit 1
+
+cd repo1 || exit 1
+echo "test-repo-1" > profiles/repo_name || exit 1
+cat <<END > profiles/categories || exit 1
+cat
+END
+cat <<END > profiles/testprofile/make.defaults
+ARCH=test
+USERLAND=test
+KERNEL=test
+USE_EXPAND="USERLAND KERNEL"
+END
+
+cat <<"END" > cat/a/a-1.ebuild || exit 1
+DESCRIPTION="Test a"
+HOMEPAGE="http://paludis.exherbo.org/"
+SRC_URI=""
+SLOT="0"
+IUSE=""
+LICENSE="GPL-2"
+KEYWORDS="test"
+RDEPEND="cat/b"
+END
+
+cat <<"END" > cat/b/b-1.ebuild || exit 1
+DESCRIPTION="Test b"
+HOMEPAGE="http://paludis.exherbo.org/"
+SRC_URI=""
+SLOT="0"
+IUSE=""
+LICENSE="GPL-2"
+KEYWORDS="test"
+RDEPEND=""
+END
+cd ..
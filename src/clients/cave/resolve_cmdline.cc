@@ -93,6 +93,13 @@ ResolveCommandLineResolutionOptions::ResolveCommandLineResolutionOptions(args::A
 
             "never"
             ),
+    a_candidate_jobs(&g_resolution_options, "candidate-jobs", '\0', "The number of candidate packages to consider "
+            "at once when making a decision. Higher values allow metadata for candidates to be generated in "
+            "parallel, but do not change the decisions made. Defaults to 1."),
+    a_resolution_cache(&g_resolution_options, "resolution-cache", '\0', "Store resolutions in the specified "
+            "directory, and reuse a stored resolution rather than resolving again if the same command is run "
+            "when no repository, installed package or configuration file has changed. Useful for regular "
+            "checks for updates, for example from cron."),
 
     g_dependent_options(this, "Dependent Options", "Dependent options. A package is dependent if it "
             "requires (or looks like it might require) a package which is being removed. By default, "
@@ -319,7 +326,15 @@ ResolveCommandLineResolutionOptions::ResolveCommandLineResolutionOptions(args::A
     g_dump_options(this, "Dump Options", "Dump the resolver's state to stdout after completion, or when an "
             "error occurs. For debugging purposes; produces rather a lot of noise."),
     a_dump(&g_dump_options, "dump", '\0', "Dump debug output", true),
-    a_dump_restarts(&g_dump_options, "dump-restarts", '\0', "Dump restarts", true)
+    a_dump_restarts(&g_dump_options, "dump-restarts", '\0', "Dump restarts", true),
+    a_profile(&g_dump_options, "profile", '\0', "Show how long was spent in each part of the resolver, and "
+            "how often various expensive operations were carried out",
+            args::EnumArg::EnumArgOptions
+            ("none",                  "Do not profile")
+            ("table",                 "Show a table")
+            ("json",                  "Show JSON, for use by scripts"),
+            "none"
+            )
 {
 }
 
@@ -397,6 +412,18 @@ ResolveCommandLineExecutionOptions::ResolveCommandLineExecutionOptions(args::Arg
     a_fetch_jobs(&g_jobs_options, "fetch-jobs", 'J', "The number of parallel fetch jobs to launch. If set to 0, fetches "
             "will be carried out sequentially with other jobs. Values higher than 1 are currently treated "
             "as being 1. Defaults to 1, or if --fetch is specified, 0."),
+    a_install_jobs(&g_jobs_options, "install-jobs", '\0', "The number of install and uninstall jobs to run at once. "
+            "If greater than 1, a job is started as soon as every job it depends upon has finished, but only one "
+            "job at a time may merge, and uninstalls are still carried out one at a time and in order. Fetches "
+            "are never carried out sequentially with other jobs in this mode. Defaults to 1."),
+    a_install_load_limit(&g_jobs_options, "install-load-limit", '\0', "If --install-jobs is greater than 1, do "
+            "not start another install job whilst the one minute load average is at least this value, which may be "
+            "fractional."),
+    a_merge_jobs(&g_jobs_options, "merge-jobs", '\0', "The number of threads each merge may use to copy files "
+            "into place. Entries are still recorded, displayed and passed to hooks in the usual order. "
+            "Defaults to 1."),
+    a_strip_jobs(&g_jobs_options, "strip-jobs", '\0', "The number of files each install may strip at once. "
+            "Stripped files are still displayed in the usual order. Defaults to 1."),
 
     g_phase_options(this, "Phase Options", "Options controlling which phases to execute. No sanity checking "
             "is done, allowing you to shoot as many feet off as you desire. Phase names do not have the "
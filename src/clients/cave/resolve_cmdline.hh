@@ -52,6 +52,8 @@ namespace paludis
             args::SwitchArg a_no_override_flags;
             args::StringSetArg a_no_restarts_for;
             args::EnumArg a_promote_binaries;
+            args::IntegerArg a_candidate_jobs;
+            args::StringArg a_resolution_cache;
 
             args::ArgsGroup g_dependent_options;
             args::StringSetArg a_uninstalls_may_break;
@@ -118,6 +120,7 @@ namespace paludis
             args::ArgsGroup g_dump_options;
             args::SwitchArg a_dump;
             args::SwitchArg a_dump_restarts;
+            args::EnumArg a_profile;
 
             void apply_shortcuts();
             void verify(const std::shared_ptr<const Environment> & env);
@@ -138,6 +141,10 @@ namespace paludis
             args::ArgsGroup g_jobs_options;
             args::SwitchArg a_fetch;
             args::IntegerArg a_fetch_jobs;
+            args::IntegerArg a_install_jobs;
+            args::StringArg a_install_load_limit;
+            args::IntegerArg a_merge_jobs;
+            args::IntegerArg a_strip_jobs;
 
             args::ArgsGroup g_phase_options;
             args::StringSetArg a_skip_phase;
@@ -26,6 +26,7 @@
 #include "exceptions.hh"
 #include "command_command_line.hh"
 #include "parse_spec_with_nice_error.hh"
+#include "resolution_cache.hh"
 
 #include <paludis/util/stringify.hh>
 #include <paludis/util/make_named_values.hh>
@@ -57,6 +58,8 @@
 #include <paludis/resolver/reason.hh>
 #include <paludis/resolver/sanitised_dependencies.hh>
 #include <paludis/resolver/suggest_restart.hh>
+#include <paludis/resolver/resolver_profile.hh>
+#include <paludis/resolver/query_cache.hh>
 #include <paludis/resolver/decision.hh>
 #include <paludis/resolver/constraint.hh>
 #include <paludis/resolver/resolver_functions.hh>
@@ -107,6 +110,8 @@
 
 #include <algorithm>
 #include <iostream>
+#include <iomanip>
+#include <sstream>
 #include <cstdlib>
 #include <list>
 #include <map>
@@ -225,11 +230,48 @@ namespace
                     + resolution_options.a_reinstall_scm.long_name() + "'");
     }
 
+    /* everything on the command line that can affect the resolution. display
+     * and execution options are deliberately left out, as are the dump options
+     * (which bypass the cache entirely) and --candidate-jobs (which only
+     * changes how fast we get the same answer). */
+    std::string resolution_cache_request(
+            const ResolveCommandLineResolutionOptions & resolution_options,
+            const std::shared_ptr<const Map<std::string, std::string> > & keys_if_import,
+            const std::shared_ptr<const Sequence<std::pair<std::string, std::string> > > & targets_if_not_purge,
+            const bool purge)
+    {
+        std::string result(purge ? "purge\n" : "resolve\n");
+
+        for (const auto & group : resolution_options)
+        {
+            if (&group == &resolution_options.g_dump_options)
+                continue;
+
+            for (const auto & option : group)
+                if (option->specified() && option != &resolution_options.a_candidate_jobs)
+                {
+                    const std::shared_ptr<const Sequence<std::string> > f(option->forwardable_args());
+                    for (const auto & arg : *f)
+                        result.append("option " + arg + "\n");
+                }
+        }
+
+        if (keys_if_import)
+            for (const auto & kv : *keys_if_import)
+                result.append("import " + kv.first + "=" + kv.second + "\n");
+
+        if (targets_if_not_purge && ! purge)
+            for (const auto & target : *targets_if_not_purge)
+                result.append("target " + target.first + " " + target.second + "\n");
+
+        return result;
+    }
+
     void serialise_resolved(StringListStream & ser_stream, const Resolved & resolved)
     {
         try
         {
-            Serialiser ser(ser_stream);
+            Serialiser ser(ser_stream, sf_binary);
             resolved.serialise(ser);
             ser_stream.nothing_more_to_write();
         }
@@ -394,7 +436,7 @@ namespace
 
     void serialise_job_lists(StringListStream & ser_stream, const JobLists & job_lists)
     {
-        Serialiser ser(ser_stream);
+        Serialiser ser(ser_stream, sf_binary);
         job_lists.serialise(ser);
         ser_stream.nothing_more_to_write();
     }
@@ -588,7 +630,9 @@ namespace
         }
     };
 
-    void display_restarts_if_requested(const std::list<SuggestRestart> & restarts,
+    typedef std::list<std::pair<SuggestRestart, std::shared_ptr<const RestartStatistics> > > Restarts;
+
+    void display_restarts_if_requested(const Restarts & restarts,
             const ResolveCommandLineResolutionOptions & resolution_options)
     {
         if (! resolution_options.a_dump_restarts.specified())
@@ -596,8 +640,9 @@ namespace
 
         std::cout << "Dumping restarts:" << std::endl << std::endl;
 
-        for (const auto & restart : restarts)
+        for (const auto & r : restarts)
         {
+            const SuggestRestart & restart(r.first);
             std::cout << "* " << restart.resolvent() << std::endl;
 
             std::cout << "    Had decided upon ";
@@ -615,11 +660,79 @@ namespace
                 std::cout << ", nothing is fine too";
             std::cout << " " << restart.problematic_constraint()->reason()->accept_returning<std::string>(ShortReasonName());
             std::cout << std::endl;
+
+            if (r.second)
+                std::cout << "    Kept " << r.second->kept_resolutions() << ", redecided " << r.second->redecided_resolutions()
+                    << " and discarded " << r.second->discarded_resolutions() << " resolutions" << std::endl;
+            else
+                std::cout << "    Started again from scratch" << std::endl;
         }
 
         std::cout << std::endl;
     }
 
+    std::string json_string(const std::string & s)
+    {
+        std::string result("\"");
+        for (const auto & c : s)
+        {
+            if ('"' == c || '\\' == c)
+                result.append(1, '\\');
+            result.append(1, c);
+        }
+        return result + "\"";
+    }
+
+    void display_profile_if_requested(const std::shared_ptr<const ResolverProfile> & profile,
+            const ResolveCommandLineResolutionOptions & resolution_options)
+    {
+        if (! profile)
+            return;
+
+        auto timers(profile->timers());
+        auto counters(profile->counters());
+
+        if (resolution_options.a_profile.argument() == "json")
+        {
+            std::cout << "{ \"timers\": [";
+            bool first(true);
+            for (const auto & t : *timers)
+            {
+                std::cout << (first ? " " : ", ") << "{ \"name\": " << json_string(t.name()) << ", \"calls\": " << t.calls()
+                    << ", \"nanoseconds\": " << t.nanoseconds() << " }";
+                first = false;
+            }
+
+            std::cout << " ], \"counters\": {";
+            first = true;
+            for (const auto & c : *counters)
+            {
+                std::cout << (first ? " " : ", ") << json_string(c.name()) << ": " << c.value();
+                first = false;
+            }
+            std::cout << " } }" << std::endl;
+        }
+        else
+        {
+            std::cout << "Resolver profile:" << std::endl << std::endl;
+
+            for (const auto & t : *timers)
+            {
+                std::ostringstream seconds;
+                seconds << std::fixed << std::setprecision(3) << (t.nanoseconds() / 1e9) << "s";
+                std::cout << "    " << std::left << std::setw(40) << t.name() << std::right << std::setw(10) << t.calls()
+                    << " calls " << std::setw(12) << seconds.str() << std::endl;
+            }
+
+            std::cout << std::endl;
+
+            for (const auto & c : *counters)
+                std::cout << "    " << std::left << std::setw(40) << c.name() << std::right << std::setw(10) << c.value() << std::endl;
+
+            std::cout << std::endl;
+        }
+    }
+
     UseExisting use_existing_from_arg(const args::EnumArg & arg, const bool is_set)
     {
         if (arg.argument() == "auto")
@@ -750,6 +863,116 @@ namespace
             return true;
         }
     };
+
+    bool any_dump_requested(const ResolveCommandLineResolutionOptions & resolution_options)
+    {
+        return resolution_options.a_dump.specified() || resolution_options.a_dump_restarts.specified()
+            || resolution_options.a_profile.argument() != "none";
+    }
+
+    const std::shared_ptr<Resolver> make_resolver(
+            const std::shared_ptr<Environment> & env,
+            const ResolverFunctions & resolver_functions,
+            const std::shared_ptr<ResolverProfile> & profile,
+            const std::shared_ptr<QueryCache> & query_cache,
+            const ResolveCommandLineResolutionOptions & resolution_options)
+    {
+        const std::shared_ptr<Resolver> resolver(std::make_shared<Resolver>(env.get(), resolver_functions));
+        resolver->set_profile(profile);
+        resolver->set_query_cache(query_cache);
+        if (resolution_options.a_candidate_jobs.specified())
+            resolver->set_candidate_evaluation_jobs(std::max(1, resolution_options.a_candidate_jobs.argument()));
+        return resolver;
+    }
+
+    const std::shared_ptr<const Resolved> resolve_with_restarts(
+            const std::shared_ptr<Environment> & env,
+            std::shared_ptr<Resolver> & resolver,
+            const ResolverFunctions & resolver_functions,
+            const std::shared_ptr<ResolverProfile> & profile,
+            const std::shared_ptr<QueryCache> & query_cache,
+            const ResolveCommandLineResolutionOptions & resolution_options,
+            const std::shared_ptr<const Sequence<std::pair<std::string, std::string> > > & targets_if_not_purge,
+            const bool purge,
+            ConfirmHelper & confirm_helper,
+            GetInitialConstraintsForHelper & get_initial_constraints_for_helper,
+            bool & is_set,
+            std::shared_ptr<const Sequence<std::string> > & targets_cleaned_up,
+            Restarts & restarts)
+    {
+        {
+            DisplayCallback display_callback("Resolving: ");
+            ScopedNotifierCallback display_callback_holder(env.get(),
+                    NotifierCallbackFunction(std::cref(display_callback)));
+
+            bool first(true), targets_added(false);
+            while (true)
+            {
+                try
+                {
+                    if (purge)
+                    {
+                        resolver->purge();
+                        targets_cleaned_up = std::make_shared<Sequence<std::string>>();
+                    }
+                    else if (! targets_added)
+                    {
+                        targets_cleaned_up = add_resolver_targets(env, resolver, resolution_options, targets_if_not_purge, is_set);
+                        targets_added = true;
+                    }
+
+                    if (first)
+                    {
+                        if (targets_cleaned_up)
+                            for (const auto & target : *targets_cleaned_up)
+                                if ('!' != target.at(0) && std::string::npos != target.find('/'))
+                                {
+                                    PackageDepSpec ts(parse_spec_with_nice_error(target, env.get(), { }, filter::All()));
+                                    if (ts.version_requirements_ptr() && ! ts.version_requirements_ptr()->empty())
+                                    {
+                                        confirm_helper.add_permit_downgrade_spec(ts);
+                                        confirm_helper.add_permit_old_version_spec(ts);
+                                    }
+                                }
+
+                        first = false;
+                    }
+
+                    resolver->resolve();
+                    break;
+                }
+                catch (const SuggestRestart & e)
+                {
+                    display_callback(ResolverRestart());
+                    get_initial_constraints_for_helper.add_suggested_restart(e);
+
+                    /* once the targets are in, only the decisions affected by
+                     * the restart need to be thrown away */
+                    if (targets_added)
+                        restarts.push_back(std::make_pair(e, std::make_shared<RestartStatistics>(resolver->restart(e))));
+                    else
+                    {
+                        restarts.push_back(std::make_pair(e, nullptr));
+                        resolver = make_resolver(env, resolver_functions, profile, query_cache, resolution_options);
+                    }
+
+                    if (restarts.size() > 9000)
+                        throw InternalError(PALUDIS_HERE, "Restarted over nine thousand times. Something's "
+                                "probably gone horribly wrong. Consider using --dump-restarts and having "
+                                "a look.");
+                }
+            }
+        }
+
+        if (! restarts.empty())
+            display_restarts_if_requested(restarts, resolution_options);
+
+        display_profile_if_requested(profile, resolution_options);
+
+        dump_if_requested(env, resolver, resolution_options);
+
+        return resolver->resolved();
+    }
 }
 
 int
@@ -763,7 +986,8 @@ paludis::cave::resolve_common(
         const std::shared_ptr<const Map<std::string, std::string> > & keys_if_import,
         const std::shared_ptr<const Sequence<std::pair<std::string, std::string> > > & targets_if_not_purge,
         const std::shared_ptr<const Sequence<std::string> > & world_specs_if_not_auto,
-        const bool purge)
+        const bool purge,
+        const std::shared_ptr<QueryCache> & query_cache_if_shared)
 {
     int retcode(0);
 
@@ -1087,88 +1311,68 @@ paludis::cave::resolve_common(
                 n::remove_if_dependent_fn() = std::cref(remove_if_dependent_helper)
                 ));
 
-    std::shared_ptr<Resolver> resolver(std::make_shared<Resolver>(env.get(), resolver_functions));
+    std::shared_ptr<ResolverProfile> profile;
+    if (resolution_options.a_profile.argument() != "none")
+        profile = std::make_shared<ResolverProfile>();
+
+    std::shared_ptr<Resolver> resolver(make_resolver(env, resolver_functions, profile, query_cache_if_shared, resolution_options));
     bool is_set(false);
     std::shared_ptr<const Sequence<std::string> > targets_cleaned_up;
-    std::list<SuggestRestart> restarts;
+    std::shared_ptr<const Resolved> resolved;
+    Restarts restarts;
 
-    try
+    std::shared_ptr<ResolutionCache> resolution_cache;
+    if (resolution_options.a_resolution_cache.specified())
     {
+        resolution_cache = std::make_shared<ResolutionCache>(env, FSPath(resolution_options.a_resolution_cache.argument()),
+                resolution_cache_request(resolution_options, keys_if_import, targets_if_not_purge, purge),
+                reinstall_scm_days(resolution_options));
+
+        /* the dumps describe the resolver's run, so they need a real one.
+         * we still save the result for next time. */
+        auto cached(any_dump_requested(resolution_options) ? nullptr : resolution_cache->load());
+        if (cached)
         {
-            DisplayCallback display_callback("Resolving: ");
-            ScopedNotifierCallback display_callback_holder(env.get(),
-                    NotifierCallbackFunction(std::cref(display_callback)));
-
-            bool first(true);
-            while (true)
-            {
-                try
-                {
-                    if (purge)
-                    {
-                        resolver->purge();
-                        targets_cleaned_up = std::make_shared<Sequence<std::string>>();
-                    } else
-                        targets_cleaned_up = add_resolver_targets(env, resolver, resolution_options, targets_if_not_purge, is_set);
-
-                    if (first)
-                    {
-                        if (targets_cleaned_up)
-                            for (const auto & target : *targets_cleaned_up)
-                                if ('!' != target.at(0) && std::string::npos != target.find('/'))
-                                {
-                                    PackageDepSpec ts(parse_spec_with_nice_error(target, env.get(), { }, filter::All()));
-                                    if (ts.version_requirements_ptr() && ! ts.version_requirements_ptr()->empty())
-                                    {
-                                        confirm_helper.add_permit_downgrade_spec(ts);
-                                        confirm_helper.add_permit_old_version_spec(ts);
-                                    }
-                                }
-
-                        first = false;
-                    }
-
-                    resolver->resolve();
-                    break;
-                }
-                catch (const SuggestRestart & e)
-                {
-                    restarts.push_back(e);
-                    display_callback(ResolverRestart());
-                    get_initial_constraints_for_helper.add_suggested_restart(e);
-                    resolver = std::make_shared<Resolver>(env.get(), resolver_functions);
-
-                    if (restarts.size() > 9000)
-                        throw InternalError(PALUDIS_HERE, "Restarted over nine thousand times. Something's "
-                                "probably gone horribly wrong. Consider using --dump-restarts and having "
-                                "a look.");
-                }
-            }
+            resolved = cached->resolved();
+            is_set = cached->target_set();
+            targets_cleaned_up = cached->targets();
         }
+    }
 
-        if (! restarts.empty())
-            display_restarts_if_requested(restarts, resolution_options);
-
-        dump_if_requested(env, resolver, resolution_options);
+    try
+    {
+        if (! resolved)
+        {
+            resolved = resolve_with_restarts(env, resolver, resolver_functions, profile, query_cache_if_shared, resolution_options,
+                    targets_if_not_purge, purge, confirm_helper, get_initial_constraints_for_helper,
+                    is_set, targets_cleaned_up, restarts);
+
+            if (resolution_cache)
+                resolution_cache->save(make_named_values<ResolutionCacheData>(
+                            n::resolved() = resolved,
+                            n::target_set() = is_set,
+                            n::targets() = targets_cleaned_up
+                            ));
+        }
 
-        retcode |= display_resolution(env, resolver->resolved(), resolution_options,
+        retcode |= display_resolution(env, resolved, resolution_options,
                 display_options, program_options, keys_if_import,
                 purge ? std::make_shared<const Sequence<std::pair<std::string, std::string> > >() : targets_if_not_purge);
 
-        retcode |= graph_jobs(env, resolver->resolved(), resolution_options,
+        retcode |= graph_jobs(env, resolved, resolution_options,
                 graph_jobs_options, program_options, keys_if_import,
                 purge ? std::make_shared<const Sequence<std::pair<std::string, std::string> > >() : targets_if_not_purge);
 
         if (! resolution_options.a_ignore_unable_decisions.specified())
-            if (! resolver->resolved()->taken_unable_to_make_decisions()->empty())
+            if (! resolved->taken_unable_to_make_decisions()->empty())
                 retcode |= 1;
 
         bool unconfirmed_but_allow_pretend(false);
-        if (! resolver->resolved()->taken_unconfirmed_decisions()->empty())
+        if (! resolved->taken_unconfirmed_decisions()->empty())
         {
             unconfirmed_but_allow_pretend = true;
-            for (auto c(resolver->resolved()->taken_unconfirmed_decisions()->begin()),
-                    c_end(resolver->resolved()->taken_unconfirmed_decisions()->end()) ;
+            for (auto c(resolved->taken_unconfirmed_decisions()->begin()),
+                    c_end(resolved->taken_unconfirmed_decisions()->end()) ;
                     c != c_end && unconfirmed_but_allow_pretend ; ++c)
                 if ((*c)->required_confirmations_if_any())
                     for (auto r((*c)->required_confirmations_if_any()->begin()),
@@ -1180,15 +1384,15 @@ paludis::cave::resolve_common(
         }
 
         if (! resolution_options.a_ignore_unorderable_jobs.specified())
-            if (! resolver->resolved()->taken_unorderable_decisions()->empty())
+            if (! resolved->taken_unorderable_decisions()->empty())
                 retcode |= 4;
 
         if (0 == retcode || (2 == retcode && unconfirmed_but_allow_pretend))
-            return perform_resolution(env, resolver->resolved(), resolution_options,
+            return perform_resolution(env, resolved, resolution_options,
                     execution_options, program_options, keys_if_import,
                     purge ? std::make_shared<const Sequence<std::pair<std::string, std::string> > >() : targets_if_not_purge,
                     world_specs_if_not_auto ? world_specs_if_not_auto : targets_cleaned_up,
-                    get_removed_if_dependent_names(env.get(), resolver->resolved()),
+                    get_removed_if_dependent_names(env.get(), resolved),
                     is_set, unconfirmed_but_allow_pretend);
     }
     catch (...)
@@ -1196,6 +1400,8 @@ paludis::cave::resolve_common(
         if (! restarts.empty())
             display_restarts_if_requested(restarts, resolution_options);
 
+        display_profile_if_requested(profile, resolution_options);
+
         dump_if_requested(env, resolver, resolution_options);
         throw;
     }
@@ -23,6 +23,7 @@
 #include <paludis/environment-fwd.hh>
 #include <paludis/util/sequence-fwd.hh>
 #include <paludis/util/map-fwd.hh>
+#include <paludis/resolver/query_cache-fwd.hh>
 #include <memory>
 #include "resolve_cmdline.hh"
 
@@ -40,7 +41,8 @@ namespace paludis
                 const std::shared_ptr<const Map<std::string, std::string> > & keys_if_import,
                 const std::shared_ptr<const Sequence<std::pair<std::string, std::string> > > & targets_if_not_purge,
                 const std::shared_ptr<const Sequence<std::string> > & world_specs_if_not_auto,
-                const bool purge
+                const bool purge,
+                const std::shared_ptr<resolver::QueryCache> & query_cache_if_shared
                 ) PALUDIS_ATTRIBUTE((warn_unused_result));
     }
 }